@@ -1,22 +1,257 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
 #include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include "camera.h"
+#include "comparison.h"
+#include "clustered_lighting.h"
+#include "memory_tracker.h"
 #include "mesh.h"
+#include "occlusion.h"
 #include "performance_harness.h"
 #include "renderer.h"
+#include "scenario.h"
 #include "scene.h"
+#include "scene_capture.h"
 #include "shader.h"
+#include "soak_monitor.h"
+#include "trace.h"
 
 using namespace SpatialRender;
 
+static bool HasFlag(int argc, char** argv, char const* flag)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], flag) == 0)
+            return true;
+    }
+    return false;
+}
+
+static char const* GetOption(int argc, char** argv, char const* flag)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], flag) == 0)
+            return argv[i + 1];
+    }
+    return nullptr;
+}
+
+static int GetIntOption(int argc, char** argv, char const* flag, int fallback)
+{
+    char const* value = GetOption(argc, argv, flag);
+    return value ? std::atoi(value) : fallback;
+}
+
+static float GetFloatOption(int argc, char** argv, char const* flag, float fallback)
+{
+    char const* value = GetOption(argc, argv, flag);
+    return value ? (float)std::atof(value) : fallback;
+}
+
+// Applies the command-line scenario overrides to every selected scenario
+static bool ApplyOverrides(int argc, char** argv, std::vector<BenchmarkScenario>& scenarios)
+{
+    for (BenchmarkScenario& scenario : scenarios)
+    {
+        if (char const* mesh = GetOption(argc, argv, "--mesh"))
+        {
+            // "sphere:16" selects a sphere with 16 segments
+            std::string value = mesh;
+            size_t colon      = value.find(':');
+            scenario.mesh     = value.substr(0, colon);
+            if (colon != std::string::npos)
+                scenario.sphere_segments = std::atoi(value.c_str() + colon + 1);
+        }
+        if (HasFlag(argc, argv, "--shared-mesh"))
+            scenario.shared_mesh = true;
+        scenario.shader_count = GetIntOption(argc, argv, "--shaders", scenario.shader_count);
+        scenario.light_count  = GetIntOption(argc, argv, "--lights", scenario.light_count);
+        scenario.frame_count  = GetIntOption(argc, argv, "--frames", scenario.frame_count);
+        if (char const* resolution = GetOption(argc, argv, "--resolution"))
+        {
+            if (!ParseResolution(resolution, scenario.resolution))
+            {
+                std::cerr << "Invalid --resolution, expected a positive WIDTHxHEIGHT" << std::endl;
+                return false;
+            }
+        }
+        if (char const* camera = GetOption(argc, argv, "--camera"))
+        {
+            if (!ParseCameraMotion(camera, scenario.camera_motion))
+            {
+                std::cerr << "Invalid --camera, expected static, orbit or dolly" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // --objects 1000,10000,100000 sweeps every selected scenario
+    if (char const* objects = GetOption(argc, argv, "--objects"))
+    {
+        std::vector<BenchmarkScenario> expanded;
+        for (BenchmarkScenario const& scenario : scenarios)
+        {
+            std::stringstream list(objects);
+            std::string count;
+            while (std::getline(list, count, ','))
+            {
+                BenchmarkScenario copy = scenario;
+                copy.object_count      = std::atoi(count.c_str());
+                copy.name += "/objects=" + std::to_string(copy.object_count);
+                expanded.push_back(copy);
+            }
+        }
+        scenarios = expanded;
+    }
+    return true;
+}
+
+static std::string DescribeMesh(BenchmarkScenario const& scenario)
+{
+    if (!scenario.capture.empty())
+        return "captured";
+    if (scenario.mesh == "sphere")
+        return "sphere" + std::to_string(scenario.sphere_segments);
+    return scenario.mesh;
+}
+
+static char const* DescribeCamera(BenchmarkScenario const& scenario)
+{
+    return scenario.capture.empty() ? GetCameraMotionName(scenario.camera_motion) : "captured";
+}
+
+// Capture scenarios take their object, light and shader counts, resolution and
+// frame count from the file; command-line overrides applied afterwards still win
+static bool LoadCaptures(std::vector<BenchmarkScenario>& scenarios,
+                         std::map<std::string, SceneCapture>& captures)
+{
+    for (BenchmarkScenario& scenario : scenarios)
+    {
+        if (scenario.capture.empty())
+            continue;
+        auto [entry, added] = captures.try_emplace(scenario.capture);
+        if (added && !entry->second.Load(scenario.capture))
+            return false;
+
+        SceneCapture const& capture = entry->second;
+        scenario.object_count       = (int)capture.GetObjectCount();
+        scenario.light_count        = (int)capture.GetLightCount();
+        scenario.shader_count       = (int)capture.GetShaderCount();
+        if (capture.GetWidth() > 0 && capture.GetHeight() > 0)
+            scenario.resolution = {capture.GetWidth(), capture.GetHeight()};
+        if (capture.GetFrameCount() > 0)
+            scenario.frame_count = (int)capture.GetFrameCount();
+    }
+    return true;
+}
+
+// Compares results against the --compare baseline; returns the exit code
+static int RunComparison(int argc, char** argv, std::vector<BenchmarkResult> const& current)
+{
+    std::vector<BenchmarkResult> baseline;
+    if (!LoadSummaryResults(GetOption(argc, argv, "--compare"), baseline))
+        return -1;
+
+    ComparisonConfig config;
+    config.threshold_percent = GetFloatOption(argc, argv, "--threshold", 5.0f);
+    config.alpha             = GetFloatOption(argc, argv, "--alpha", 0.05f);
+
+    ComparisonReport report = CompareResults(baseline, current, config);
+    PrintComparison(report, std::cout);
+    SaveComparison(report, "benchmarks/results/benchmark_comparison.json");
+    return ComparisonExitCode(report);
+}
+
 int main(int argc, char** argv)
 {
+    // --compare BASELINE --current SUMMARY compares two saved runs without rendering
+    if (GetOption(argc, argv, "--compare") && GetOption(argc, argv, "--current"))
+    {
+        std::vector<BenchmarkResult> current;
+        if (!LoadSummaryResults(GetOption(argc, argv, "--current"), current))
+            return -1;
+        return RunComparison(argc, argv, current);
+    }
+
+    std::vector<BenchmarkScenario> scenarios = DefaultScenarios();
+    if (char const* path = GetOption(argc, argv, "--scenarios"))
+    {
+        if (!LoadScenarios(path, scenarios))
+            return -1;
+    }
+
+    // Soak mode renders one scene for a long time in constant memory
+    SoakConfig soak_config;
+    soak_config.duration_s          = GetFloatOption(argc, argv, "--soak", 0.0f);
+    soak_config.snapshot_interval_s = GetFloatOption(argc, argv, "--soak-interval", 60.0f);
+    bool const soak                 = soak_config.duration_s > 0.0;
+    if (soak && !GetOption(argc, argv, "--scenarios"))
+    {
+        BenchmarkScenario scenario;
+        scenario.object_count = GetIntOption(argc, argv, "--soak-objects", 100);
+        scenario.name         = "soak/objects=" + std::to_string(scenario.object_count);
+        scenarios             = {scenario};
+    }
+
+    char const* filter = GetOption(argc, argv, "--filter");
+    scenarios          = FilterScenarios(scenarios, filter ? filter : "");
+
+    // --replay CAPTURE benchmarks a recorded scene and camera path on its own
+    if (char const* replay = GetOption(argc, argv, "--replay"))
+    {
+        BenchmarkScenario scenario;
+        scenario.name    = "replay/" + std::filesystem::path(replay).stem().string();
+        scenario.capture = replay;
+        scenarios        = {scenario};
+    }
+    std::map<std::string, SceneCapture> captures;
+    if (!LoadCaptures(scenarios, captures) || !ApplyOverrides(argc, argv, scenarios))
+        return -1;
+    if (soak && scenarios.size() > 1)
+        scenarios.resize(1);
+
+    if (HasFlag(argc, argv, "--list-scenarios"))
+    {
+        for (BenchmarkScenario const& scenario : scenarios)
+        {
+            std::cout << scenario.name << ": " << scenario.object_count << " x "
+                      << DescribeMesh(scenario) << (scenario.shared_mesh ? " (shared)" : "")
+                      << ", " << scenario.shader_count << " shaders, " << scenario.light_count
+                      << " lights, " << scenario.resolution.x << "x" << scenario.resolution.y
+                      << ", camera " << DescribeCamera(scenario) << std::endl;
+        }
+        return 0;
+    }
+    if (scenarios.empty())
+    {
+        std::cerr << "No scenarios selected" << std::endl;
+        return -1;
+    }
+
+    // Chrome trace of the measured frames of every scenario
+    char const* trace_path = GetOption(argc, argv, "--trace");
+#if !defined(SPATIALRENDER_TRACING)
+    if (trace_path)
+        std::cerr << "--trace needs a build with ENABLE_TRACING=ON; no zones will be recorded"
+                  << std::endl;
+#endif
+    if (trace_path)
+        Tracer::Get().SetThreadName("Main");
+
     if (!glfwInit())
     {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -28,10 +263,9 @@ int main(int argc, char** argv)
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);  // Headless benchmarking
 
-    int const width  = 1920;
-    int const height = 1080;
-
-    GLFWwindow* window = glfwCreateWindow(width, height, "Benchmark", nullptr, nullptr);
+    glm::ivec2 const first_resolution = scenarios.front().resolution;
+    GLFWwindow* window                = glfwCreateWindow(
+        first_resolution.x, first_resolution.y, "Benchmark", nullptr, nullptr);
     if (!window)
     {
         std::cerr << "Failed to create GLFW window" << std::endl;
@@ -42,69 +276,237 @@ int main(int argc, char** argv)
     glfwMakeContextCurrent(window);
     glfwSwapInterval(0);  // Disable VSync for benchmarking
 
-    Renderer renderer(width, height);
-    if (!renderer.Initialize())
-    {
-        std::cerr << "Failed to initialize renderer" << std::endl;
-        return -1;
-    }
+    int const view_count =
+        std::clamp(GetIntOption(argc, argv, "--views", 1), 1, Renderer::kMaxViews);
+    float const target_frame_ms = GetFloatOption(argc, argv, "--dynamic-res", 0.0f);
 
-    // Load shader
-    auto shader = std::make_shared<Shader>();
-    if (!shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"))
-    {
-        std::cerr << "Failed to load shaders" << std::endl;
-        return -1;
-    }
+    // Each scenario gets a renderer sized to its resolution
+    auto create_renderer = [&](glm::ivec2 resolution) -> std::unique_ptr<Renderer> {
+        auto renderer = std::make_unique<Renderer>(resolution.x, resolution.y);
+        if (!renderer->Initialize())
+        {
+            std::cerr << "Failed to initialize renderer" << std::endl;
+            return nullptr;
+        }
+        renderer->SetOcclusionCulling(HasFlag(argc, argv, "--occlusion"));
+        renderer->SetDepthSorting(!HasFlag(argc, argv, "--no-depth-sort"));
+        renderer->SetDepthPrepass(HasFlag(argc, argv, "--depth-prepass"));
+        renderer->SetRetainedMode(HasFlag(argc, argv, "--retained"));
+        renderer->SetFramesInFlight(GetIntOption(argc, argv, "--frames-in-flight", 2));
+        if (target_frame_ms > 0.0f)
+        {
+            renderer->SetDynamicResolution(true, target_frame_ms);
+        }
+        return renderer;
+    };
+
+    // Separate programs built from the same source, one per scenario shader slot
+    std::vector<std::shared_ptr<Shader>> shaders;
+    auto load_shaders = [&](int count) {
+        while ((int)shaders.size() < std::max(count, 1))
+        {
+            auto shader = std::make_shared<Shader>();
+            if (!shader->LoadFromFiles("shaders/compiled/basic.vert",
+                                       "shaders/compiled/basic.frag"))
+            {
+                std::cerr << "Failed to load shaders" << std::endl;
+                return false;
+            }
+            shaders.push_back(shader);
+        }
+        return true;
+    };
+
+    // --capture PATH records the first scenario's scene and measured camera path
+    char const* capture_path = GetOption(argc, argv, "--capture");
 
     // Create performance harness
     PerformanceHarness harness;
 
-    // Benchmark different scene complexities
-    std::vector<int> object_counts = {1, 10, 50, 100, 500};
-
-    for (int obj_count : object_counts)
+    for (BenchmarkScenario const& scenario : scenarios)
     {
-        std::cout << "Benchmarking scene with " << obj_count << " objects..." << std::endl;
+        std::cout << "Benchmarking " << scenario.name << " (" << scenario.object_count << " x "
+                  << DescribeMesh(scenario) << ")..." << std::endl;
+
+        // Peaks cover this scenario's scene, renderer and shaders
+        MemoryTracker& memory = MemoryTracker::Get();
+        memory.ResetPeaks();
+
+        int const width  = scenario.resolution.x;
+        int const height = scenario.resolution.y;
+        glfwSetWindowSize(window, width, height);
+
+        // Replays bring their own shaders
+        SceneCapture const* replay =
+            scenario.capture.empty() ? nullptr : &captures.at(scenario.capture);
+        std::unique_ptr<Renderer> renderer_ptr = create_renderer(scenario.resolution);
+        if (!renderer_ptr || (!replay && !load_shaders(scenario.shader_count)))
+            return -1;
+        Renderer& renderer = *renderer_ptr;
+
+        std::vector<std::string> features;
+        if (renderer.IsOcclusionCullingEnabled())
+            features.push_back("occlusion_culling");
+        if (renderer.IsDepthSortingEnabled())
+            features.push_back("depth_sorting");
+        if (renderer.IsDepthPrepassEnabled())
+            features.push_back("depth_prepass");
+        if (renderer.IsRetainedModeEnabled())
+            features.push_back("retained_mode");
+        if (scenario.light_count > 0)
+            features.push_back("clustered_lights");
+        if (view_count > 1)
+            features.push_back("multi_view");
+        if (renderer.IsDynamicResolutionEnabled())
+            features.push_back("dynamic_resolution");
+        if (scenario.shared_mesh)
+            features.push_back("shared_mesh");
+        if (replay)
+            features.push_back("scene_replay");
 
         Scene scene;
-        for (int i = 0; i < obj_count; ++i)
+        if (replay)
+        {
+            if (!replay->BuildScene(scene))
+                return -1;
+        }
+        else
         {
-            auto cube           = std::shared_ptr<Mesh>(CreateCubeMesh());
-            glm::mat4 transform = glm::mat4(1.0f);
-            transform =
-                glm::translate(transform,
-                               glm::vec3((i % 10) * 0.5f - 2.5f, (i / 10) * 0.5f - 2.5f, 0.0f));
-            scene.AddObject(cube, shader, transform, glm::vec3(0.8f, 0.2f, 0.2f));
+            std::vector<std::shared_ptr<Shader>> scenario_shaders(
+                shaders.begin(), shaders.begin() + std::max(scenario.shader_count, 1));
+            BuildScenarioScene(scenario, scenario_shaders, scene);
         }
 
         Camera camera;
         camera.SetPerspective(45.0f, (float)width / (float)height, 0.1f, 100.0f);
-        camera.SetPosition(glm::vec3(0.0f, 0.0f, 5.0f));
+
+        // Eyes 64 mm apart, each filling an equal slice of the framebuffer
+        std::vector<Camera> eyes(view_count);
+        for (int v = 0; v < view_count; ++v)
+        {
+            eyes[v].SetPerspective(
+                45.0f, (float)width / (float)(height * view_count), 0.1f, 100.0f);
+        }
+
+        // A replay follows the captured cameras, whatever --views says
+        std::vector<Camera> replay_cameras;
+        int frame_index   = 0;
+        auto render_scene = [&]() {
+            if (replay)
+            {
+                replay->GetFrame(frame_index, replay_cameras);
+                if (replay_cameras.size() > 1)
+                    renderer.RenderSceneMultiView(scene, replay_cameras);
+                else if (!replay_cameras.empty())
+                    renderer.RenderScene(scene, replay_cameras[0]);
+            }
+            else if (view_count > 1)
+            {
+                for (int v = 0; v < view_count; ++v)
+                {
+                    float offset = ((float)v - (view_count - 1) * 0.5f) * 0.064f;
+                    PlaceScenarioCamera(scenario, frame_index, offset, eyes[v]);
+                }
+                renderer.RenderSceneMultiView(scene, eyes);
+            }
+            else
+            {
+                PlaceScenarioCamera(scenario, frame_index, 0.0f, camera);
+                renderer.RenderScene(scene, camera);
+            }
+            ++frame_index;
+        };
 
         // Warmup
-        for (int i = 0; i < 10; ++i)
+        for (int i = 0; i < scenario.warmup_frames; ++i)
         {
             renderer.BeginFrame();
             renderer.Clear();
-            renderer.RenderScene(scene, camera);
+            render_scene();
             renderer.EndFrame();
             glfwSwapBuffers(window);
         }
 
+        if (soak)
+        {
+            SoakMonitor monitor(soak_config);
+            monitor.Start();
+
+            while (!monitor.IsFinished())
+            {
+                auto frame_start = std::chrono::high_resolution_clock::now();
+
+                renderer.BeginFrame();
+                renderer.Clear();
+                auto render_start = std::chrono::high_resolution_clock::now();
+                render_scene();
+                auto render_end = std::chrono::high_resolution_clock::now();
+                renderer.EndFrame();
+                glfwSwapBuffers(window);
+
+                auto frame_end = std::chrono::high_resolution_clock::now();
+                monitor.RecordFrame(
+                    std::chrono::duration<double, std::micro>(frame_end - frame_start).count(),
+                    std::chrono::duration<double, std::micro>(render_end - render_start).count());
+
+                if (monitor.IsSnapshotDue())
+                {
+                    SoakSnapshot const& snapshot = monitor.TakeSnapshot();
+                    std::cout << "  [" << (int)snapshot.elapsed_s << " s] p50 "
+                              << snapshot.window_frame_time.p50 << " μs, p99 "
+                              << snapshot.window_frame_time.p99 << " μs, drift "
+                              << snapshot.drift_percent << "%, RSS " << snapshot.rss_kb
+                              << " KB, GPU free " << snapshot.gpu_memory_available_kb << " KB"
+                              << std::endl;
+
+                    // Rewritten every snapshot so an aborted run keeps its data
+                    monitor.Save("benchmarks/results/soak.json");
+                }
+            }
+            monitor.TakeSnapshot();
+            monitor.Save("benchmarks/results/soak.json");
+
+            std::cout << "  Frames: " << monitor.GetFrameStats().GetCount() << ", mean "
+                      << monitor.GetFrameStats().GetMean() << " μs, stddev "
+                      << monitor.GetFrameStats().GetStdDev() << " μs" << std::endl;
+            std::cout << "  Drift: " << monitor.GetFrameTimeDriftPerHour() << " μs/h, RSS growth "
+                      << monitor.GetRssGrowthKbPerHour() << " KB/h" << std::endl;
+            continue;
+        }
+
+        // Measured frames of a replay start at the first captured frame
+        if (replay)
+            frame_index = 0;
+        std::unique_ptr<SceneCapture> recording;
+        if (capture_path && &scenario == &scenarios.front())
+        {
+            recording = std::make_unique<SceneCapture>();
+            recording->CaptureScene(scene);
+            recording->SetResolution(width, height);
+        }
+
         // Benchmark
-        int const frame_count = 100;
+        int const frame_count = std::max(scenario.frame_count, 1);
         harness.StartBenchmark();
+        double scale_sum = 0.0;
+        float scale_min  = 1.0f;
+        Tracer::Get().SetEnabled(trace_path != nullptr);
 
         for (int i = 0; i < frame_count; ++i)
         {
+            if (trace_path)
+                Tracer::Get().Collect();
+
+            SR_TRACE_ZONE("Frame");
             auto frame_start = std::chrono::high_resolution_clock::now();
 
             renderer.BeginFrame();
             renderer.Clear();
+            scale_sum += renderer.GetRenderScale();
+            scale_min = std::min(scale_min, renderer.GetRenderScale());
 
             auto render_start = std::chrono::high_resolution_clock::now();
-            renderer.RenderScene(scene, camera);
+            render_scene();
             auto render_end = std::chrono::high_resolution_clock::now();
 
             renderer.EndFrame();
@@ -112,6 +514,16 @@ int main(int argc, char** argv)
 
             auto frame_end = std::chrono::high_resolution_clock::now();
 
+            if (recording)
+            {
+                if (replay)
+                    recording->AddFrame(replay_cameras.data(), replay_cameras.size());
+                else if (view_count > 1)
+                    recording->AddFrame(eyes.data(), eyes.size());
+                else
+                    recording->AddFrame(camera);
+            }
+
             auto frame_time =
                 std::chrono::duration_cast<std::chrono::microseconds>(frame_end - frame_start)
                     .count();
@@ -119,30 +531,131 @@ int main(int argc, char** argv)
                 std::chrono::duration_cast<std::chrono::microseconds>(render_end - render_start)
                     .count();
 
-            harness.RecordFrame(frame_time, render_time);
+            // Time BeginFrame() spent waiting for the GPU to free a frame slot
+            harness.RecordFrame(frame_time, render_time, renderer.GetFrameWaitMs() * 1000.0);
+            harness.RecordRenderStats(renderer.GetRenderStats());
         }
 
+        Tracer::Get().SetEnabled(false);
         harness.EndBenchmark();
 
+        if (recording && recording->Save(capture_path))
+        {
+            std::cout << "  Saved capture: " << capture_path << " ("
+                      << recording->GetObjectCount() << " objects, "
+                      << recording->GetFrameCount() << " frames)" << std::endl;
+        }
+
         BenchmarkResult result  = harness.GetResult();
-        result.scene_complexity = obj_count;
+        result.scenario         = scenario.name;
+        result.scene_complexity = (int)scene.GetObjectCount();
+        result.mesh             = DescribeMesh(scenario);
+        result.shader_count     = replay ? (int)replay->GetShaderCount() : scenario.shader_count;
+        result.camera_motion    = DescribeCamera(scenario);
+        result.light_count      = (int)scene.GetLights().size();
+        result.view_count       = replay_cameras.empty() ? view_count : (int)replay_cameras.size();
+        result.frames_in_flight = renderer.GetFramesInFlight();
+        result.render_scale     = scale_sum / frame_count;
+        result.min_render_scale = scale_min;
         result.resolution       = {width, height};
+        result.features         = features;
+        result.gpu_memory       = memory.GetGpuUsage();
+        result.cpu_memory       = memory.GetCpuUsage();
+        result.device_memory    = QueryDeviceMemory();
+        for (size_t c = 0; c < (size_t)MemoryCategory::Count; ++c)
+        {
+            MemoryUsage usage = memory.GetUsage((MemoryCategory)c);
+            if (usage.peakBytes > 0)
+                result.memory_by_category[GetMemoryCategoryName((MemoryCategory)c)] = usage;
+        }
 
         std::cout << "  FPS: " << result.avg_fps << std::endl;
         std::cout << "  Avg Frame Time: " << result.avg_frame_time_us << " μs" << std::endl;
         std::cout << "  Avg Render Time: " << result.avg_render_time_us << " μs" << std::endl;
         std::cout << "  Frame Variance: " << result.frame_variance << std::endl;
+        FrameStatistics const& stats = result.statistics;
+        std::cout << "  Frame Time p50/p99/p99.9/max: " << stats.frame_time.p50 << " / "
+                  << stats.frame_time.p99 << " / " << stats.frame_time.p999 << " / "
+                  << stats.frame_time.max << " μs" << std::endl;
+        std::cout << "  1% Low FPS: " << stats.one_percent_low_fps << " (" << stats.warmup_frames
+                  << " slow-start frames, " << stats.outlier_frames.size() << " outliers)"
+                  << std::endl;
+        std::cout << "  Sync Wait: " << result.avg_sync_wait_us << " μs avg, "
+                  << result.max_sync_wait_us << " μs max (" << result.frames_in_flight
+                  << " frames in flight)" << std::endl;
+        if (renderer.IsDynamicResolutionEnabled())
+        {
+            std::cout << "  Render Scale: " << result.render_scale << " avg, "
+                      << result.min_render_scale << " min, GPU " << renderer.GetGpuFrameMs()
+                      << " ms" << std::endl;
+        }
+
+        GLStateStats const& state_stats = renderer.GetStateStats();
+        std::cout << "  GL State Calls (last frame): " << state_stats.issuedCalls << " issued, "
+                  << state_stats.elidedCalls << " elided" << std::endl;
+
+        RenderStats const& render_stats = result.mean_render_stats;
+        std::cout << "  Per Frame: " << render_stats.drawCalls << " draws, "
+                  << render_stats.triangles << " triangles, " << render_stats.programSwitches
+                  << " program switches, " << render_stats.vertexArrayBinds << " VAO binds, "
+                  << render_stats.uniformUploads << " uniforms, "
+                  << render_stats.bufferBytesUploaded << " bytes uploaded, "
+                  << render_stats.objectsCulled << " culled, "
+                  << render_stats.frameAllocatorHighWater << " scratch bytes" << std::endl;
+
+        std::cout << "  Memory: GPU " << result.gpu_memory.liveBytes / 1024 << " KiB ("
+                  << result.gpu_memory.peakBytes / 1024 << " KiB peak), CPU "
+                  << result.cpu_memory.liveBytes / 1024 << " KiB ("
+                  << result.cpu_memory.peakBytes / 1024 << " KiB peak)";
+        if (result.device_memory.available)
+            std::cout << ", device " << result.device_memory.freeKb << " KiB free";
+        std::cout << std::endl;
+        if (HasFlag(argc, argv, "--memory-dump"))
+            memory.Dump(std::cout);
+
+        if (renderer.IsOcclusionCullingEnabled())
+        {
+            OcclusionStats const& occlusion = renderer.GetOcclusionStats();
+            std::cout << "  Occlusion (last frame): " << occlusion.occlusionCulled << " occluded, "
+                      << occlusion.frustumCulled << " outside frustum, "
+                      << occlusion.rasterizeMs << " ms raster, " << occlusion.testMs << " ms test"
+                      << std::endl;
+        }
+        if (result.light_count > 0)
+        {
+            LightingStats const& lighting = renderer.GetLightingStats();
+            std::cout << "  Lights (last frame): " << lighting.visibleLights << " visible, "
+                      << lighting.occupiedClusters << " clusters, " << lighting.lightIndices
+                      << " indices, " << lighting.droppedLights << " dropped, " << lighting.binMs
+                      << " ms binning" << std::endl;
+            if (render_stats.lightsDropped > 0)
+            {
+                std::cout << "  Warning: " << render_stats.lightsDropped
+                          << " light entries per frame exceeded the cluster limit of "
+                          << LightClusterGrid::kMaxLightsPerCluster << std::endl;
+            }
+        }
         std::cout << std::endl;
 
         harness.SaveResult("benchmarks/results", result);
     }
 
     // Save summary
-    harness.SaveSummary("benchmarks/results/benchmark_summary.json");
+    if (!soak)
+        harness.SaveSummary("benchmarks/results/benchmark_summary.json");
 
-    renderer.Shutdown();
+    shaders.clear();
     glfwDestroyWindow(window);
     glfwTerminate();
 
+    if (trace_path && Tracer::Get().ExportChromeTrace(trace_path))
+    {
+        std::cout << "Saved trace: " << trace_path << " (" << Tracer::Get().GetEventCount()
+                  << " events, " << Tracer::Get().GetDroppedCount() << " dropped)" << std::endl;
+    }
+
+    if (!soak && GetOption(argc, argv, "--compare"))
+        return RunComparison(argc, argv, harness.GetResults());
+
     return 0;
 }
@@ -0,0 +1,214 @@
+#include "comparison.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+#include <nlohmann/json.hpp>
+
+using json   = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace SpatialRender
+{
+
+bool LoadSummaryResults(std::string const& path, std::vector<BenchmarkResult>& results)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open benchmark summary: " << path << std::endl;
+        return false;
+    }
+
+    json summary = json::parse(file, nullptr, false);
+    if (summary.is_discarded() || !summary.contains("results"))
+    {
+        std::cerr << "Invalid benchmark summary: " << path << std::endl;
+        return false;
+    }
+
+    results.clear();
+    for (json const& r : summary["results"])
+    {
+        BenchmarkResult result{};
+        result.scenario           = r.value("scenario", std::string());
+        result.scene_complexity   = r.value("scene_complexity", 0);
+        result.avg_fps            = r.value("avg_fps", 0.0);
+        result.avg_frame_time_us  = r.value("avg_frame_time_us", 0.0);
+        result.avg_render_time_us = r.value("avg_render_time_us", 0.0);
+        result.frame_times        = r.value("frame_times", std::vector<double>());
+        result.render_times       = r.value("render_times", std::vector<double>());
+        result.statistics         = AnalyzeFrames(result.frame_times, result.render_times);
+        results.push_back(result);
+    }
+    return true;
+}
+
+static std::string MatchKey(BenchmarkResult const& result)
+{
+    if (!result.scenario.empty())
+        return result.scenario;
+    return std::to_string(result.scene_complexity) + " objects";
+}
+
+static MetricDelta MakeDelta(char const* name, double baseline, double current)
+{
+    double delta = baseline != 0.0 ? (current / baseline - 1.0) * 100.0 : 0.0;
+    return {name, baseline, current, delta};
+}
+
+static ScenarioComparison CompareScenario(BenchmarkResult const& baseline,
+                                          BenchmarkResult const& current,
+                                          ComparisonConfig const& config)
+{
+    ScenarioComparison comparison;
+    comparison.scenario = MatchKey(current);
+
+    FrameStatistics const& b = baseline.statistics;
+    FrameStatistics const& c = current.statistics;
+
+    // Every measured frame: a stall is exactly what the comparison should see
+    std::vector<double> const& baseFrames = baseline.frame_times;
+    std::vector<double> const& currFrames = current.frame_times;
+    if (baseFrames.empty() || currFrames.empty())
+    {
+        // Old summaries carry no samples: report the means without a verdict
+        comparison.metrics.push_back(MakeDelta(
+            "mean_frame_time_us", baseline.avg_frame_time_us, current.avg_frame_time_us));
+        return comparison;
+    }
+
+    auto mean = [](std::vector<double> const& values) {
+        return std::accumulate(values.begin(), values.end(), 0.0) / (double)values.size();
+    };
+    MetricDelta const median = MakeDelta("p50_frame_time_us", b.frame_time.p50, c.frame_time.p50);
+    comparison.metrics.push_back(
+        MakeDelta("mean_frame_time_us", mean(baseFrames), mean(currFrames)));
+    comparison.metrics.push_back(median);
+    comparison.metrics.push_back(
+        MakeDelta("p99_frame_time_us", b.frame_time.p99, c.frame_time.p99));
+    comparison.metrics.push_back(
+        MakeDelta("p50_render_time_us", b.render_time.p50, c.render_time.p50));
+    comparison.metrics.push_back(
+        MakeDelta("one_percent_low_fps", b.one_percent_low_fps, c.one_percent_low_fps));
+
+    comparison.test        = MannWhitneyU(baseFrames, currFrames);
+    comparison.mean_delta  = BootstrapMeanDeltaCI(baseFrames, currFrames);
+    comparison.significant = comparison.test.p_value < config.alpha;
+
+    comparison.regression =
+        comparison.significant && median.delta_percent > config.threshold_percent;
+    comparison.improvement =
+        comparison.significant && median.delta_percent < -config.threshold_percent;
+    return comparison;
+}
+
+ComparisonReport CompareResults(std::vector<BenchmarkResult> const& baseline,
+                                std::vector<BenchmarkResult> const& current,
+                                ComparisonConfig const& config)
+{
+    ComparisonReport report;
+    report.config = config;
+
+    for (BenchmarkResult const& base : baseline)
+    {
+        std::string key = MatchKey(base);
+        auto match      = std::find_if(current.begin(), current.end(), [&](auto const& r) {
+            return MatchKey(r) == key;
+        });
+        if (match == current.end())
+        {
+            report.missing.push_back(key);
+            continue;
+        }
+
+        report.scenarios.push_back(CompareScenario(base, *match, config));
+        if (report.scenarios.back().regression)
+            ++report.regressions;
+    }
+    return report;
+}
+
+int ComparisonExitCode(ComparisonReport const& report)
+{
+    return report.regressions > 0 || !report.missing.empty() ? 1 : 0;
+}
+
+void PrintComparison(ComparisonReport const& report, std::ostream& out)
+{
+    out << "Comparison against baseline (threshold " << report.config.threshold_percent
+        << "%, alpha " << report.config.alpha << ")" << std::endl;
+
+    for (ScenarioComparison const& s : report.scenarios)
+    {
+        char const* verdict = s.regression ? "REGRESSION" : s.improvement ? "improved" : "ok";
+        out << "  " << s.scenario << ": " << verdict;
+        if (s.metrics.size() > 1)
+        {
+            out << " (p = " << s.test.p_value << ", P(slower) = " << s.test.probability
+                << ", mean " << std::showpos << std::fixed << std::setprecision(1)
+                << s.mean_delta.low << "%.." << s.mean_delta.high << "% at "
+                << std::noshowpos << (int)(s.mean_delta.confidence * 100.0) << "%)"
+                << std::defaultfloat << std::setprecision(6);
+        }
+        out << std::endl;
+
+        for (MetricDelta const& m : s.metrics)
+        {
+            out << "    " << std::left << std::setw(22) << m.name << std::right << m.baseline
+                << " -> " << m.current << " (" << std::showpos << std::fixed
+                << std::setprecision(1) << m.delta_percent << "%)" << std::noshowpos
+                << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+    for (std::string const& name : report.missing)
+    {
+        out << "  " << name << ": MISSING from current run" << std::endl;
+    }
+    out << report.regressions << " regression(s), " << report.missing.size()
+        << " missing scenario(s)" << std::endl;
+}
+
+void SaveComparison(ComparisonReport const& report, std::string const& path)
+{
+    json j;
+    j["threshold_percent"] = report.config.threshold_percent;
+    j["alpha"]             = report.config.alpha;
+    j["regressions"]       = report.regressions;
+    j["missing"]           = report.missing;
+
+    json scenarios = json::array();
+    for (ScenarioComparison const& s : report.scenarios)
+    {
+        json metrics = json::object();
+        for (MetricDelta const& m : s.metrics)
+        {
+            metrics[m.name] = {{"baseline", m.baseline},
+                               {"current", m.current},
+                               {"delta_percent", m.delta_percent}};
+        }
+        scenarios.push_back({{"scenario", s.scenario},
+                             {"metrics", metrics},
+                             {"p_value", s.test.p_value},
+                             {"probability_slower", s.test.probability},
+                             {"mean_delta_ci", {{"low", s.mean_delta.low},
+                                                {"high", s.mean_delta.high},
+                                                {"confidence", s.mean_delta.confidence}}},
+                             {"significant", s.significant},
+                             {"regression", s.regression},
+                             {"improvement", s.improvement}});
+    }
+    j["scenarios"] = scenarios;
+
+    fs::create_directories(fs::path(path).parent_path());
+    std::ofstream file(path);
+    file << std::setw(2) << j << std::endl;
+
+    std::cout << "Saved benchmark comparison: " << path << std::endl;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "performance_harness.h"
+#include "statistics.h"
+
+namespace SpatialRender
+{
+
+struct ComparisonConfig
+{
+    double threshold_percent = 5.0;   // median frame time growth that counts as a regression
+    double alpha             = 0.05;  // significance level of the Mann-Whitney test
+};
+
+struct MetricDelta
+{
+    std::string name;
+    double baseline;
+    double current;
+    double delta_percent;
+};
+
+struct ScenarioComparison
+{
+    std::string scenario;
+    std::vector<MetricDelta> metrics;
+    MannWhitneyResult test;         // on all measured frame times
+    ConfidenceInterval mean_delta;  // relative change of the mean frame time, percent
+    bool significant = false;
+    bool regression  = false;
+    bool improvement = false;
+};
+
+struct ComparisonReport
+{
+    ComparisonConfig config;
+    std::vector<ScenarioComparison> scenarios;
+    std::vector<std::string> missing;  // baseline scenarios absent from the current run
+    size_t regressions = 0;
+};
+
+// Reads the results of a summary written by PerformanceHarness::SaveSummary.
+// Frame statistics are recomputed from the stored samples.
+bool LoadSummaryResults(std::string const& path, std::vector<BenchmarkResult>& results);
+
+// Matches runs by scenario name, or by object count for unnamed runs. A
+// scenario regresses when its median frame time grows by more than the
+// threshold and the frame time distributions differ significantly.
+ComparisonReport CompareResults(std::vector<BenchmarkResult> const& baseline,
+                                std::vector<BenchmarkResult> const& current,
+                                ComparisonConfig const& config = ComparisonConfig());
+
+// 1 if any scenario regressed or a baseline scenario did not run (a crash or
+// a filter must not hide a regression), otherwise 0
+int ComparisonExitCode(ComparisonReport const& report);
+
+void PrintComparison(ComparisonReport const& report, std::ostream& out);
+void SaveComparison(ComparisonReport const& report, std::string const& path);
+
+}  // namespace SpatialRender
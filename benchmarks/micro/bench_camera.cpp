@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include "camera.h"
+
+using namespace SpatialRender;
+
+static Camera MakeCamera()
+{
+    Camera camera;
+    camera.SetPerspective(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(1.0f, 2.0f, 5.0f));
+    camera.SetTarget(glm::vec3(0.0f));
+    return camera;
+}
+
+static void BM_CameraViewMatrix(benchmark::State& state)
+{
+    Camera camera = MakeCamera();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(camera.GetViewMatrix());
+    }
+}
+BENCHMARK(BM_CameraViewMatrix);
+
+static void BM_CameraProjectionMatrix(benchmark::State& state)
+{
+    Camera camera = MakeCamera();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(camera.GetProjectionMatrix());
+    }
+}
+BENCHMARK(BM_CameraProjectionMatrix);
+
+static void BM_CameraViewProjectionMatrix(benchmark::State& state)
+{
+    Camera camera = MakeCamera();
+    float x       = 0.0f;
+    for (auto _ : state)
+    {
+        // Moving the camera keeps the result from being hoisted out of the loop
+        camera.SetPosition(glm::vec3(x, 2.0f, 5.0f));
+        x += 1e-4f;
+        benchmark::DoNotOptimize(camera.GetViewProjectionMatrix());
+    }
+}
+BENCHMARK(BM_CameraViewProjectionMatrix);
+
+static void BM_CameraFrustum(benchmark::State& state)
+{
+    Camera camera = MakeCamera();
+    float x       = 0.0f;
+    for (auto _ : state)
+    {
+        camera.SetPosition(glm::vec3(x, 2.0f, 5.0f));
+        x += 1e-4f;
+        benchmark::DoNotOptimize(camera.GetFrustum());
+    }
+}
+BENCHMARK(BM_CameraFrustum);
+
+// Shadow cascades and cubemap faces: every camera moves every frame
+static void BM_CameraSetUpdate(benchmark::State& state)
+{
+    CameraSet set;
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        set.Add(MakeCamera());
+    }
+
+    float x = 0.0f;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < set.GetCount(); ++i)
+        {
+            set.GetCamera(i).SetPosition(glm::vec3(x + (float)i, 2.0f, 5.0f));
+        }
+        x += 1e-4f;
+        set.Update();
+        benchmark::DoNotOptimize(set.GetCamera(0).GetFrustum());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CameraSetUpdate)->Arg(4)->Arg(6)->Arg(64);
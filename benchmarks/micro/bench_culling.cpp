@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "culling.h"
+#include "mesh.h"
+#include "occlusion.h"
+#include "scene.h"
+
+using namespace SpatialRender;
+
+static glm::mat4 MakeViewProj()
+{
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view =
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return proj * view;
+}
+
+// Objects on a square grid around the origin, roughly half inside the frustum
+static std::vector<glm::mat4> MakeTransforms(size_t count)
+{
+    std::vector<glm::mat4> transforms(count);
+    int side = 1;
+    while ((size_t)(side * side) < count)
+    {
+        ++side;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        float x       = ((float)(i % side) / side - 0.5f) * 12.0f;
+        float y       = ((float)(i / side) / side - 0.5f) * 12.0f;
+        transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+    }
+    return transforms;
+}
+
+static void BM_FrustumFromMatrix(benchmark::State& state)
+{
+    glm::mat4 viewProj = MakeViewProj();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Frustum::FromMatrix(viewProj));
+    }
+}
+BENCHMARK(BM_FrustumFromMatrix);
+
+// The per-object work of the renderer's frustum culling pass
+static void BM_FrustumCullTransformedBounds(benchmark::State& state)
+{
+    AABB bounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+    std::vector<glm::mat4> transforms = MakeTransforms((size_t)state.range(0));
+    Frustum frustum                   = Frustum::FromMatrix(MakeViewProj());
+
+    for (auto _ : state)
+    {
+        size_t visible = 0;
+        for (glm::mat4 const& transform : transforms)
+        {
+            visible += frustum.Intersects(bounds.Transformed(transform)) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(visible);
+    }
+    state.SetItemsProcessed(state.iterations() * transforms.size());
+}
+BENCHMARK(BM_FrustumCullTransformedBounds)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_OcclusionCull(benchmark::State& state)
+{
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+
+    // A wall of occluders in front of the object grid
+    Scene scene;
+    for (int i = 0; i < 4; ++i)
+    {
+        glm::mat4 wall = glm::translate(glm::mat4(1.0f), glm::vec3(i - 1.5f, 0.0f, 2.0f));
+        scene.AddObject(cube, nullptr, glm::scale(wall, glm::vec3(1.0f, 3.0f, 0.1f)));
+        scene.SetOccluder(scene.GetObjectCount() - 1, true);
+    }
+    for (glm::mat4 const& transform : MakeTransforms((size_t)state.range(0)))
+    {
+        scene.AddObject(cube, nullptr, transform);
+    }
+
+    OcclusionCuller culler;
+    glm::mat4 viewProj = MakeViewProj();
+    for (auto _ : state)
+    {
+        culler.Cull(scene.GetObjects(), viewProj);
+        benchmark::DoNotOptimize(culler.GetVisibility().data());
+    }
+    state.SetItemsProcessed(state.iterations() * scene.GetObjectCount());
+}
+BENCHMARK(BM_OcclusionCull)->RangeMultiplier(10)->Range(100, 10000)->UseRealTime();
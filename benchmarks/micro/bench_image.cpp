@@ -0,0 +1,23 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "image_utils.h"
+
+using namespace SpatialRender;
+
+// The CPU half of Renderer::CaptureFramebuffer
+static void BM_FlipRowsVertically(benchmark::State& state)
+{
+    int width  = (int)state.range(0);
+    int height = (int)state.range(1);
+    std::vector<uint8_t> pixels((size_t)width * height * 4, 0x7f);
+
+    for (auto _ : state)
+    {
+        FlipRowsVertically(pixels.data(), width, height, 4);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * pixels.size());
+}
+BENCHMARK(BM_FlipRowsVertically)->Args({256, 256})->Args({1920, 1080})->Args({3840, 2160});
@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "clustered_lighting.h"
+
+using namespace SpatialRender;
+
+static void BM_LightClusterBuild(benchmark::State& state)
+{
+    std::vector<Light> lights;
+    for (int i = 0; i < state.range(0); ++i)
+    {
+        Light light;
+        light.position = glm::vec3((float)((i * 37) % 101) / 100.0f * 6.0f - 3.0f,
+                                   (float)((i * 61) % 103) / 102.0f * 6.0f - 3.0f,
+                                   (float)((i * 17) % 13) / 12.0f * 1.5f);
+        light.range    = 0.75f;
+        lights.push_back(light);
+    }
+
+    glm::mat4 view =
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    LightClusterGrid grid;
+    for (auto _ : state)
+    {
+        grid.Build(lights, view, proj, 0.1f, 100.0f);
+        benchmark::DoNotOptimize(grid.GetLightIndices().data());
+    }
+    state.SetItemsProcessed(state.iterations() * lights.size());
+}
+BENCHMARK(BM_LightClusterBuild)->RangeMultiplier(4)->Range(16, 4096)->UseRealTime();
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "mesh.h"
+#include "procedural.h"
+
+using namespace SpatialRender;
+
+// Generation only: meshes are never uploaded, so no GL context is needed
+
+static void BM_CreateCubeMesh(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::unique_ptr<Mesh> mesh(CreateCubeMesh());
+        benchmark::DoNotOptimize(mesh.get());
+    }
+}
+BENCHMARK(BM_CreateCubeMesh);
+
+static void BM_CreateSphereMesh(benchmark::State& state)
+{
+    int segments = (int)state.range(0);
+    for (auto _ : state)
+    {
+        std::unique_ptr<Mesh> mesh(CreateSphereMesh(segments));
+        benchmark::DoNotOptimize(mesh.get());
+    }
+    state.SetItemsProcessed(state.iterations() * (segments + 1) * (segments + 1));
+}
+BENCHMARK(BM_CreateSphereMesh)->RangeMultiplier(2)->Range(8, 256);
+
+// Reuses one MeshData, so this measures generation rather than allocation
+static void BM_GenerateSphere(benchmark::State& state)
+{
+    int segments = (int)state.range(0);
+    MeshData data;
+    for (auto _ : state)
+    {
+        GenerateSphere(data, 1.0f, segments, segments / 2);
+        benchmark::DoNotOptimize(data.vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * data.vertices.size());
+}
+BENCHMARK(BM_GenerateSphere)->RangeMultiplier(4)->Range(16, 4096)->UseRealTime();
+
+static void BM_GenerateIcosphere(benchmark::State& state)
+{
+    MeshData data;
+    for (auto _ : state)
+    {
+        GenerateIcosphere(data, 1.0f, (int)state.range(0));
+        benchmark::DoNotOptimize(data.vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * data.vertices.size());
+}
+BENCHMARK(BM_GenerateIcosphere)->DenseRange(1, 7, 2)->UseRealTime();
+
+static void BM_MeshSetVertices(benchmark::State& state)
+{
+    std::unique_ptr<Mesh> source(CreateSphereMesh((int)state.range(0)));
+    std::vector<Vertex> const& vertices = source->GetVertices();
+
+    Mesh mesh;
+    for (auto _ : state)
+    {
+        mesh.SetVertices(vertices);
+        benchmark::DoNotOptimize(mesh.GetBounds());
+    }
+    state.SetBytesProcessed(state.iterations() * vertices.size() * sizeof(Vertex));
+}
+BENCHMARK(BM_MeshSetVertices)->RangeMultiplier(4)->Range(8, 256);
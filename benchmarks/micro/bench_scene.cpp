@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "mesh.h"
+#include "scene.h"
+
+using namespace SpatialRender;
+
+static void BM_SceneAddObject(benchmark::State& state)
+{
+    auto mesh     = std::shared_ptr<Mesh>(CreateCubeMesh());
+    size_t count  = (size_t)state.range(0);
+    glm::mat4 xf  = glm::mat4(1.0f);
+    glm::vec3 rgb = glm::vec3(0.8f, 0.2f, 0.2f);
+
+    for (auto _ : state)
+    {
+        Scene scene;
+        for (size_t i = 0; i < count; ++i)
+        {
+            scene.AddObject(mesh, nullptr, xf, rgb);
+        }
+        benchmark::DoNotOptimize(scene.GetObjects().data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SceneAddObject)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_SceneAddPointLight(benchmark::State& state)
+{
+    size_t count = (size_t)state.range(0);
+    for (auto _ : state)
+    {
+        Scene scene;
+        for (size_t i = 0; i < count; ++i)
+        {
+            scene.AddPointLight(glm::vec3((float)i, 0.0f, 0.0f), glm::vec3(1.0f), 1.0f, 1.0f);
+        }
+        benchmark::DoNotOptimize(scene.GetLights().data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SceneAddPointLight)->RangeMultiplier(10)->Range(100, 10000);
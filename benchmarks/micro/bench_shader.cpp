@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "shader.h"
+
+using namespace SpatialRender;
+
+// Uniform uploads need a current context: a hidden 1x1 window is created on
+// first use, and the benchmarks are skipped when that fails (no display).
+static bool EnsureContext()
+{
+    static bool ready = [] {
+        if (!glfwInit())
+            return false;
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow* window = glfwCreateWindow(1, 1, "microbench", nullptr, nullptr);
+        if (!window)
+            return false;
+
+        glfwMakeContextCurrent(window);
+        glewExperimental = GL_TRUE;
+        return glewInit() == GLEW_OK;
+    }();
+    return ready;
+}
+
+static char const* kVertexSource = R"(
+#version 330 core
+layout(location = 0) in vec3 a_position;
+uniform mat4 u_model;
+uniform mat4 u_viewProj;
+uniform mat4 u_views[4];
+void main()
+{
+    gl_Position = u_viewProj * u_views[gl_InstanceID & 3] * u_model * vec4(a_position, 1.0);
+}
+)";
+
+static char const* kFragmentSource = R"(
+#version 330 core
+uniform vec3 u_color;
+uniform float u_alpha;
+out vec4 fragColor;
+void main()
+{
+    fragColor = vec4(u_color, u_alpha);
+}
+)";
+
+// Fixtures live in a static registry that outlasts the GL state cache and
+// memory tracker, so the shader is released in TearDown() instead of with it
+class ShaderFixture : public benchmark::Fixture
+{
+ public:
+    void SetUp(benchmark::State& state) override
+    {
+        shader = std::make_unique<Shader>();
+        if (!EnsureContext() || !shader->LoadFromSource(kVertexSource, kFragmentSource))
+        {
+            state.SkipWithError("No OpenGL context");
+            return;
+        }
+        shader->Use();
+    }
+
+    void TearDown(benchmark::State&) override { shader.reset(); }
+
+    std::unique_ptr<Shader> shader;
+};
+
+BENCHMARK_F(ShaderFixture, SetUniformMat4)(benchmark::State& state)
+{
+    glm::mat4 model(1.0f);
+    for (auto _ : state)
+    {
+        model[3][0] += 1e-4f;
+        shader->SetUniform("u_model", model);
+    }
+}
+
+BENCHMARK_F(ShaderFixture, SetUniformMat4Array)(benchmark::State& state)
+{
+    glm::mat4 views[4] = {glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f)};
+    for (auto _ : state)
+    {
+        views[0][3][0] += 1e-4f;
+        shader->SetUniform("u_views", views, 4);
+    }
+}
+
+BENCHMARK_F(ShaderFixture, SetUniformVec3)(benchmark::State& state)
+{
+    glm::vec3 color(0.5f);
+    for (auto _ : state)
+    {
+        color.x += 1e-4f;
+        shader->SetUniform("u_color", color);
+    }
+}
+
+// Name lookup cost of a uniform the program does not have
+BENCHMARK_F(ShaderFixture, SetUniformMissing)(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        shader->SetUniform("u_missing", 1.0f);
+    }
+}
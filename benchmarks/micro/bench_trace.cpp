@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include "trace.h"
+
+using namespace SpatialRender;
+
+// Cost of one zone while the tracer is off: a relaxed load and a branch
+static void BM_TraceZoneDisabled(benchmark::State& state)
+{
+    Tracer::Get().SetEnabled(false);
+    for (auto _ : state)
+    {
+        TraceZone zone("Disabled");
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_TraceZoneDisabled);
+
+// Two clock reads and a ring write; collected every 4096 zones to stay unsaturated
+static void BM_TraceZoneEnabled(benchmark::State& state)
+{
+    Tracer::Get().SetEnabled(true);
+    int count = 0;
+    for (auto _ : state)
+    {
+        {
+            TraceZone zone("Enabled");
+        }
+        if (++count == 4096)
+        {
+            state.PauseTiming();
+            Tracer::Get().Clear();
+            count = 0;
+            state.ResumeTiming();
+        }
+    }
+    Tracer::Get().SetEnabled(false);
+    Tracer::Get().Clear();
+}
+BENCHMARK(BM_TraceZoneEnabled);
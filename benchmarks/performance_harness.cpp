@@ -1,10 +1,13 @@
 #include "performance_harness.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <utility>
 
 #include <nlohmann/json.hpp>
 
@@ -14,7 +17,94 @@ namespace fs = std::filesystem;
 namespace SpatialRender
 {
 
-PerformanceHarness::PerformanceHarness() : m_benchmarking(false)
+// JSON key for every RenderStats counter
+static constexpr std::pair<char const*, uint64_t RenderStats::*> kRenderCounters[] = {
+    {"draw_calls", &RenderStats::drawCalls},
+    {"triangles", &RenderStats::triangles},
+    {"vertices", &RenderStats::vertices},
+    {"program_switches", &RenderStats::programSwitches},
+    {"vao_binds", &RenderStats::vertexArrayBinds},
+    {"uniform_uploads", &RenderStats::uniformUploads},
+    {"buffer_bytes_uploaded", &RenderStats::bufferBytesUploaded},
+    {"objects_submitted", &RenderStats::objectsSubmitted},
+    {"objects_culled", &RenderStats::objectsCulled},
+    {"scenes_replayed", &RenderStats::scenesReplayed},
+    {"lights_dropped", &RenderStats::lightsDropped},
+    {"frame_allocator_high_water_bytes", &RenderStats::frameAllocatorHighWater},
+};
+
+static json RenderStatsToJson(RenderStats const& mean, RenderStats const& max)
+{
+    json j;
+    for (auto const& [key, counter] : kRenderCounters)
+    {
+        j[key] = {{"mean", mean.*counter}, {"max", max.*counter}};
+    }
+    return j;
+}
+
+static json MemoryUsageToJson(MemoryUsage const& usage)
+{
+    return {{"bytes", usage.liveBytes},
+            {"peak_bytes", usage.peakBytes},
+            {"allocations", usage.allocations}};
+}
+
+static json MemoryToJson(BenchmarkResult const& result)
+{
+    json j;
+    j["gpu"] = MemoryUsageToJson(result.gpu_memory);
+    j["cpu"] = MemoryUsageToJson(result.cpu_memory);
+
+    json categories = json::object();
+    for (auto const& [name, usage] : result.memory_by_category)
+    {
+        categories[name] = MemoryUsageToJson(usage);
+    }
+    j["categories"] = categories;
+
+    if (result.device_memory.available)
+    {
+        j["device_total_kb"] = result.device_memory.totalKb;
+        j["device_free_kb"]  = result.device_memory.freeKb;
+    }
+    return j;
+}
+
+static json PercentilesToJson(PercentileSummary const& p)
+{
+    return {{"p50", p.p50}, {"p90", p.p90}, {"p99", p.p99}, {"p99_9", p.p999}, {"max", p.max}};
+}
+
+static json StatisticsToJson(FrameStatistics const& stats, bool include_histogram)
+{
+    json j;
+    j["sample_count"]        = stats.sample_count;
+    j["warmup_frames"]       = stats.warmup_frames;
+    j["outlier_count"]       = stats.outlier_frames.size();
+    j["frame_time_us"]       = PercentilesToJson(stats.frame_time);
+    j["render_time_us"]      = PercentilesToJson(stats.render_time);
+    j["one_percent_low_fps"] = stats.one_percent_low_fps;
+    j["mean_frame_time_ci"]  = {{"low", stats.mean_frame_time.low},
+                                {"high", stats.mean_frame_time.high},
+                                {"confidence", stats.mean_frame_time.confidence}};
+    if (include_histogram)
+    {
+        j["outlier_frames"] = stats.outlier_frames;
+
+        json buckets = json::array();
+        for (auto const& bucket : stats.histogram)
+        {
+            buckets.push_back({{"lower_us", bucket.lower},
+                               {"upper_us", bucket.upper},
+                               {"count", bucket.count}});
+        }
+        j["frame_time_histogram"] = buckets;
+    }
+    return j;
+}
+
+PerformanceHarness::PerformanceHarness() : m_render_frames(0), m_benchmarking(false)
 {}
 
 PerformanceHarness::~PerformanceHarness()
@@ -25,17 +115,37 @@ void PerformanceHarness::StartBenchmark()
     m_current_result = BenchmarkResult();
     m_current_result.frame_times.clear();
     m_current_result.render_times.clear();
+    m_current_result.sync_wait_times.clear();
+    m_render_totals   = RenderStats();
+    m_render_frames   = 0;
     m_benchmark_start = std::chrono::high_resolution_clock::now();
     m_benchmarking    = true;
 }
 
-void PerformanceHarness::RecordFrame(double frame_time_us, double render_time_us)
+void PerformanceHarness::RecordFrame(double frame_time_us,
+                                     double render_time_us,
+                                     double sync_wait_us)
 {
     if (!m_benchmarking)
         return;
 
     m_current_result.frame_times.push_back(frame_time_us);
     m_current_result.render_times.push_back(render_time_us);
+    m_current_result.sync_wait_times.push_back(sync_wait_us);
+}
+
+void PerformanceHarness::RecordRenderStats(RenderStats const& stats)
+{
+    if (!m_benchmarking)
+        return;
+
+    for (auto const& [key, counter] : kRenderCounters)
+    {
+        m_render_totals.*counter += stats.*counter;
+        m_current_result.max_render_stats.*counter =
+            std::max(m_current_result.max_render_stats.*counter, stats.*counter);
+    }
+    ++m_render_frames;
 }
 
 void PerformanceHarness::EndBenchmark()
@@ -48,6 +158,8 @@ void PerformanceHarness::EndBenchmark()
     // Calculate statistics
     double total_frame_time  = 0.0;
     double total_render_time = 0.0;
+    double total_sync_wait   = 0.0;
+    double max_sync_wait     = 0.0;
 
     for (double ft : m_current_result.frame_times)
     {
@@ -57,11 +169,18 @@ void PerformanceHarness::EndBenchmark()
     {
         total_render_time += rt;
     }
+    for (double wt : m_current_result.sync_wait_times)
+    {
+        total_sync_wait += wt;
+        max_sync_wait = std::max(max_sync_wait, wt);
+    }
 
     size_t frame_count                  = m_current_result.frame_times.size();
     m_current_result.avg_frame_time_us  = total_frame_time / frame_count;
     m_current_result.avg_render_time_us = total_render_time / frame_count;
     m_current_result.avg_fps            = 1000000.0 / m_current_result.avg_frame_time_us;
+    m_current_result.avg_sync_wait_us   = total_sync_wait / frame_count;
+    m_current_result.max_sync_wait_us   = max_sync_wait;
 
     // Calculate variance
     double variance = 0.0;
@@ -72,7 +191,18 @@ void PerformanceHarness::EndBenchmark()
     }
     m_current_result.frame_variance = variance / frame_count;
 
-    m_all_results.push_back(m_current_result);
+    m_current_result.statistics =
+        AnalyzeFrames(m_current_result.frame_times, m_current_result.render_times);
+
+    if (m_render_frames > 0)
+    {
+        for (auto const& [key, counter] : kRenderCounters)
+        {
+            m_current_result.mean_render_stats.*counter =
+                (m_render_totals.*counter + m_render_frames / 2) / m_render_frames;
+        }
+    }
+
     m_benchmarking = false;
 }
 
@@ -80,23 +210,51 @@ void PerformanceHarness::SaveResult(std::string const& directory, BenchmarkResul
 {
     fs::create_directories(directory);
 
-    std::string filename =
-        directory + "/benchmark_" + std::to_string(result.scene_complexity) + "_objects.json";
+    // Scenario names may contain '/' and '='; keep file names portable
+    std::string name = result.scenario;
+    for (char& c : name)
+    {
+        if (!std::isalnum((unsigned char)c) && c != '-' && c != '.')
+            c = '_';
+    }
+    if (name.empty())
+        name = std::to_string(result.scene_complexity) + "_objects";
+    std::string filename = directory + "/benchmark_" + name + ".json";
 
     json j;
     j["avg_fps"]            = result.avg_fps;
     j["avg_frame_time_us"]  = result.avg_frame_time_us;
     j["avg_render_time_us"] = result.avg_render_time_us;
     j["frame_variance"]     = result.frame_variance;
+    j["avg_sync_wait_us"]   = result.avg_sync_wait_us;
+    j["max_sync_wait_us"]   = result.max_sync_wait_us;
+    j["frames_in_flight"]   = result.frames_in_flight;
+    j["scenario"]           = result.scenario;
     j["scene_complexity"]   = result.scene_complexity;
+    j["mesh"]               = result.mesh;
+    j["shader_count"]       = result.shader_count;
+    j["camera_motion"]      = result.camera_motion;
+    j["light_count"]        = result.light_count;
+    j["view_count"]         = result.view_count;
+    j["render_scale"]       = result.render_scale;
+    j["min_render_scale"]   = result.min_render_scale;
     j["resolution"]         = {{"width", result.resolution.x}, {"height", result.resolution.y}};
+    j["features"]           = result.features;
+    j["statistics"]         = StatisticsToJson(result.statistics, true);
+    j["render_stats"]       = RenderStatsToJson(result.mean_render_stats, result.max_render_stats);
+    j["memory"]             = MemoryToJson(result);
     j["frame_times"]        = result.frame_times;
     j["render_times"]       = result.render_times;
+    j["sync_wait_times"]    = result.sync_wait_times;
 
     std::ofstream file(filename);
     file << std::setw(2) << j << std::endl;
 
     std::cout << "Saved benchmark result: " << filename << std::endl;
+
+    // Recorded here rather than in EndBenchmark so the summary sees the run
+    // parameters the caller fills in after the benchmark ends
+    m_all_results.push_back(result);
 }
 
 void PerformanceHarness::SaveSummary(std::string const& path)
@@ -108,11 +266,25 @@ void PerformanceHarness::SaveSummary(std::string const& path)
     for (auto const& result : m_all_results)
     {
         json r;
+        r["scenario"]           = result.scenario;
         r["scene_complexity"]   = result.scene_complexity;
+        r["mesh"]               = result.mesh;
+        r["shader_count"]       = result.shader_count;
         r["avg_fps"]            = result.avg_fps;
         r["avg_frame_time_us"]  = result.avg_frame_time_us;
         r["avg_render_time_us"] = result.avg_render_time_us;
         r["frame_variance"]     = result.frame_variance;
+        r["avg_sync_wait_us"]   = result.avg_sync_wait_us;
+        r["light_count"]        = result.light_count;
+        r["view_count"]         = result.view_count;
+        r["render_scale"]       = result.render_scale;
+        r["features"]           = result.features;
+        r["statistics"]         = StatisticsToJson(result.statistics, false);
+        r["render_stats"]       = RenderStatsToJson(result.mean_render_stats,
+                                                    result.max_render_stats);
+        r["memory"]             = MemoryToJson(result);
+        r["frame_times"]        = result.frame_times;  // samples for baseline comparison
+        r["render_times"]       = result.render_times;
         results_array.push_back(r);
     }
     summary["results"] = results_array;
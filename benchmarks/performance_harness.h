@@ -1,11 +1,17 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <map>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "memory_tracker.h"
+#include "render_stats.h"
+#include "statistics.h"
+
 namespace SpatialRender
 {
 
@@ -15,10 +21,30 @@ struct BenchmarkResult
     double avg_frame_time_us;
     double avg_render_time_us;
     double frame_variance;
-    int scene_complexity;
+    double avg_sync_wait_us;  // CPU time blocked waiting for a free frame slot
+    double max_sync_wait_us;
+    int frames_in_flight;
+    std::string scenario;  // scenario name, including swept parameters
+    int scene_complexity;  // object count
+    std::string mesh;      // "cube" or "sphere<segments>"
+    int shader_count;
+    std::string camera_motion;
+    int light_count;
+    int view_count;           // cameras rendered per frame
+    double render_scale;      // mean dynamic resolution scale, 1 when disabled
+    double min_render_scale;
     glm::ivec2 resolution;
+    std::vector<std::string> features;  // renderer options enabled for the run
     std::vector<double> frame_times;
     std::vector<double> render_times;
+    std::vector<double> sync_wait_times;
+    FrameStatistics statistics;  // percentiles, histogram and CI over all measured frames
+    RenderStats mean_render_stats;  // per-frame renderer counters, rounded mean
+    RenderStats max_render_stats;
+    MemoryUsage gpu_memory;  // tracked at the end of the run; peak since scenario start
+    MemoryUsage cpu_memory;
+    std::map<std::string, MemoryUsage> memory_by_category;
+    DeviceMemoryInfo device_memory;
 };
 
 class PerformanceHarness
@@ -28,17 +54,22 @@ class PerformanceHarness
     ~PerformanceHarness();
 
     void StartBenchmark();
-    void RecordFrame(double frame_time_us, double render_time_us);
+    void RecordFrame(double frame_time_us, double render_time_us, double sync_wait_us = 0.0);
+    void RecordRenderStats(RenderStats const& stats);
     void EndBenchmark();
 
     BenchmarkResult GetResult() const { return m_current_result; }
+    std::vector<BenchmarkResult> const& GetResults() const { return m_all_results; }
 
+    // Writes the per-run JSON and adds the result to the summary
     void SaveResult(std::string const& directory, BenchmarkResult const& result);
     void SaveSummary(std::string const& path);
 
  private:
     BenchmarkResult m_current_result;
     std::vector<BenchmarkResult> m_all_results;
+    RenderStats m_render_totals;
+    size_t m_render_frames;
     std::chrono::high_resolution_clock::time_point m_benchmark_start;
     bool m_benchmarking;
 };
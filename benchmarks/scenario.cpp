@@ -0,0 +1,313 @@
+#include "scenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+#include "camera.h"
+#include "mesh.h"
+#include "scene.h"
+
+using json = nlohmann::json;
+
+namespace SpatialRender
+{
+
+// Frames per orbit or dolly cycle
+static constexpr int kMotionPeriod = 240;
+
+std::vector<BenchmarkScenario> DefaultScenarios()
+{
+    std::vector<BenchmarkScenario> scenarios;
+    for (int count : {1, 10, 50, 100, 500})
+    {
+        BenchmarkScenario scenario;
+        scenario.name         = "cubes/objects=" + std::to_string(count);
+        scenario.object_count = count;
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
+
+char const* GetCameraMotionName(CameraMotion motion)
+{
+    switch (motion)
+    {
+        case CameraMotion::Orbit:
+            return "orbit";
+        case CameraMotion::Dolly:
+            return "dolly";
+        default:
+            return "static";
+    }
+}
+
+bool ParseCameraMotion(std::string const& name, CameraMotion& motion)
+{
+    for (CameraMotion candidate : {CameraMotion::Static, CameraMotion::Orbit, CameraMotion::Dolly})
+    {
+        if (name == GetCameraMotionName(candidate))
+        {
+            motion = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseResolution(std::string const& text, glm::ivec2& resolution)
+{
+    int width  = 0;
+    int height = 0;
+    if (std::sscanf(text.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+        return false;
+
+    resolution = {width, height};
+    return true;
+}
+
+// Applies one key of a scenario object; unknown keys are reported and rejected
+static bool ApplyField(std::string const& key, json const& value, BenchmarkScenario& scenario)
+{
+    try
+    {
+        if (key == "name")
+            scenario.name = value.get<std::string>();
+        else if (key == "objects")
+            scenario.object_count = value.get<int>();
+        else if (key == "shared_mesh")
+            scenario.shared_mesh = value.get<bool>();
+        else if (key == "mesh")
+            scenario.mesh = value.get<std::string>();
+        else if (key == "sphere_segments")
+            scenario.sphere_segments = value.get<int>();
+        else if (key == "shaders")
+            scenario.shader_count = value.get<int>();
+        else if (key == "lights")
+            scenario.light_count = value.get<int>();
+        else if (key == "resolution")
+            return ParseResolution(value.get<std::string>(), scenario.resolution);
+        else if (key == "camera")
+            return ParseCameraMotion(value.get<std::string>(), scenario.camera_motion);
+        else if (key == "camera_distance")
+            scenario.camera_distance = value.get<float>();
+        else if (key == "warmup_frames")
+            scenario.warmup_frames = value.get<int>();
+        else if (key == "frames")
+            scenario.frame_count = value.get<int>();
+        else if (key == "capture")
+            scenario.capture = value.get<std::string>();
+        else
+            return false;
+    }
+    catch (json::exception const&)
+    {
+        return false;
+    }
+    return true;
+}
+
+static std::string ValueLabel(json const& value)
+{
+    return value.is_string() ? value.get<std::string>() : value.dump();
+}
+
+static bool ExpandScenario(json const& entry,
+                           BenchmarkScenario const& defaults,
+                           std::vector<BenchmarkScenario>& scenarios)
+{
+    BenchmarkScenario base = defaults;
+    std::vector<std::pair<std::string, json>> sweeps;
+    for (auto const& [key, value] : entry.items())
+    {
+        if (value.is_array() && !value.empty())
+        {
+            sweeps.emplace_back(key, value);
+        }
+        else if (!ApplyField(key, value, base))
+        {
+            std::cerr << "Invalid scenario field '" << key << "': " << value.dump() << std::endl;
+            return false;
+        }
+    }
+    if (base.name.empty())
+    {
+        std::cerr << "Scenario without a name: " << entry.dump() << std::endl;
+        return false;
+    }
+
+    // Odometer over the swept keys, last key varying fastest
+    std::vector<size_t> position(sweeps.size(), 0);
+    while (true)
+    {
+        BenchmarkScenario scenario = base;
+        for (size_t k = 0; k < sweeps.size(); ++k)
+        {
+            json const& value = sweeps[k].second[position[k]];
+            if (!ApplyField(sweeps[k].first, value, scenario))
+            {
+                std::cerr << "Invalid scenario field '" << sweeps[k].first << "': " << value.dump()
+                          << std::endl;
+                return false;
+            }
+            scenario.name += "/" + sweeps[k].first + "=" + ValueLabel(value);
+        }
+        scenarios.push_back(scenario);
+
+        size_t k = sweeps.size();
+        while (k > 0 && ++position[k - 1] == sweeps[k - 1].second.size())
+        {
+            position[--k] = 0;
+        }
+        if (k == 0)
+            break;
+    }
+    return true;
+}
+
+bool LoadScenarios(std::string const& path, std::vector<BenchmarkScenario>& scenarios)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open scenario file: " << path << std::endl;
+        return false;
+    }
+
+    json document = json::parse(file, nullptr, false);
+    if (document.is_discarded() || !document.contains("scenarios"))
+    {
+        std::cerr << "Invalid scenario file: " << path << std::endl;
+        return false;
+    }
+
+    BenchmarkScenario defaults;
+    defaults.name.clear();
+    if (document.contains("defaults"))
+    {
+        for (auto const& [key, value] : document["defaults"].items())
+        {
+            if (!ApplyField(key, value, defaults))
+            {
+                std::cerr << "Invalid default '" << key << "': " << value.dump() << std::endl;
+                return false;
+            }
+        }
+    }
+
+    scenarios.clear();
+    for (json const& entry : document["scenarios"])
+    {
+        if (!ExpandScenario(entry, defaults, scenarios))
+            return false;
+    }
+    return true;
+}
+
+static bool MatchesGlob(char const* name, char const* pattern)
+{
+    if (*pattern == '\0')
+        return *name == '\0';
+    if (*pattern == '*')
+        return MatchesGlob(name, pattern + 1) || (*name != '\0' && MatchesGlob(name + 1, pattern));
+    if (*name != '\0' && (*pattern == '?' || *pattern == *name))
+        return MatchesGlob(name + 1, pattern + 1);
+    return false;
+}
+
+bool MatchesFilter(std::string const& name, std::string const& filter)
+{
+    if (filter.empty())
+        return true;
+
+    size_t start = 0;
+    while (start <= filter.size())
+    {
+        size_t end = std::min(filter.find(',', start), filter.size());
+        if (MatchesGlob(name.c_str(), filter.substr(start, end - start).c_str()))
+            return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+std::vector<BenchmarkScenario> FilterScenarios(std::vector<BenchmarkScenario> const& scenarios,
+                                               std::string const& filter)
+{
+    std::vector<BenchmarkScenario> selected;
+    std::copy_if(scenarios.begin(),
+                 scenarios.end(),
+                 std::back_inserter(selected),
+                 [&](BenchmarkScenario const& s) { return MatchesFilter(s.name, filter); });
+    return selected;
+}
+
+static std::unique_ptr<Mesh> CreateScenarioMesh(BenchmarkScenario const& scenario)
+{
+    if (scenario.mesh == "sphere")
+        return CreateSphereMesh(scenario.sphere_segments);
+    return CreateCubeMesh();
+}
+
+void BuildScenarioScene(BenchmarkScenario const& scenario,
+                        std::vector<std::shared_ptr<Shader>> const& shaders,
+                        Scene& scene)
+{
+    std::shared_ptr<Mesh> shared;
+    if (scenario.shared_mesh)
+    {
+        shared = std::shared_ptr<Mesh>(CreateScenarioMesh(scenario));
+    }
+
+    // Rows of at least ten, so up to 100 objects keep the original layout
+    int columns =
+        std::max(10, (int)std::ceil(std::sqrt((double)std::max(scenario.object_count, 1))));
+    for (int i = 0; i < scenario.object_count; ++i)
+    {
+        auto mesh = shared ? shared : std::shared_ptr<Mesh>(CreateScenarioMesh(scenario));
+        glm::vec3 position((i % columns) * 0.5f - 2.5f, (i / columns) * 0.5f - 2.5f, 0.0f);
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+        scene.AddObject(mesh, shaders[i % shaders.size()], transform, glm::vec3(0.8f, 0.2f, 0.2f));
+    }
+
+    // Small point lights scattered in front of the object grid
+    for (int i = 0; i < scenario.light_count; ++i)
+    {
+        float x = (float)((i * 37) % 101) / 100.0f * 6.0f - 3.0f;
+        float y = (float)((i * 61) % 103) / 102.0f * 6.0f - 3.0f;
+        float z = (float)((i * 17) % 13) / 12.0f * 1.5f;
+        glm::vec3 color(0.0f);
+        color[i % 3] = 1.0f;
+        scene.AddPointLight(glm::vec3(x, y, z), color, 1.0f, 0.75f);
+    }
+}
+
+void PlaceScenarioCamera(BenchmarkScenario const& scenario,
+                         int frame,
+                         float eyeOffset,
+                         Camera& camera)
+{
+    float phase    = (float)(frame % kMotionPeriod) / (float)kMotionPeriod * 6.2831853f;
+    float distance = scenario.camera_distance;
+
+    glm::vec3 forward(0.0f, 0.0f, -1.0f);
+    if (scenario.camera_motion == CameraMotion::Orbit)
+    {
+        forward = glm::vec3(-std::sin(phase), 0.0f, -std::cos(phase));
+    }
+    else if (scenario.camera_motion == CameraMotion::Dolly)
+    {
+        distance *= 1.0f + 0.5f * std::sin(phase);
+    }
+
+    glm::vec3 right    = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 position = -forward * distance + right * eyeOffset;
+    camera.SetPosition(position);
+    camera.SetTarget(position + forward * distance);
+}
+
+}  // namespace SpatialRender
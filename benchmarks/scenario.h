@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace SpatialRender
+{
+
+class Camera;
+class Scene;
+class Shader;
+
+enum class CameraMotion
+{
+    Static,
+    Orbit,  // circles the scene centre once every kMotionPeriod frames
+    Dolly   // moves towards and away from the scene along the view axis
+};
+
+struct BenchmarkScenario
+{
+    std::string name;
+    int object_count           = 100;
+    bool shared_mesh           = false;   // one mesh for every object instead of one each
+    std::string mesh           = "cube";  // "cube" or "sphere"
+    int sphere_segments        = 32;
+    int shader_count           = 1;  // objects cycle through this many separate programs
+    int light_count            = 0;
+    glm::ivec2 resolution      = {1920, 1080};
+    CameraMotion camera_motion = CameraMotion::Static;
+    float camera_distance      = 5.0f;
+    int warmup_frames          = 10;
+    int frame_count            = 100;
+    std::string capture;  // replay this scene capture instead of building a scene
+};
+
+// The sweep the benchmark ran before scenarios existed: 1 to 500 cubes
+std::vector<BenchmarkScenario> DefaultScenarios();
+
+// Reads a scenario file of the form
+//   {"defaults": {...}, "scenarios": [{"name": "...", ...}, ...]}
+// Any of objects, sphere_segments, shaders, lights, resolution, shared_mesh,
+// mesh and camera may be an array; the scenario then expands to the cartesian
+// product, each copy named "<name>/<key>=<value>" for the swept keys. A
+// "capture" key names a SceneCapture file that replaces the generated scene
+// and camera motion.
+bool LoadScenarios(std::string const& path, std::vector<BenchmarkScenario>& scenarios);
+
+// Comma-separated glob patterns with * and ?; an empty filter keeps everything
+bool MatchesFilter(std::string const& name, std::string const& filter);
+std::vector<BenchmarkScenario> FilterScenarios(std::vector<BenchmarkScenario> const& scenarios,
+                                               std::string const& filter);
+
+char const* GetCameraMotionName(CameraMotion motion);
+bool ParseCameraMotion(std::string const& name, CameraMotion& motion);
+// "WIDTHxHEIGHT" with both sides positive
+bool ParseResolution(std::string const& text, glm::ivec2& resolution);
+
+// Fills scene with the scenario's objects and lights, cycling through shaders
+void BuildScenarioScene(BenchmarkScenario const& scenario,
+                        std::vector<std::shared_ptr<Shader>> const& shaders,
+                        Scene& scene);
+
+// Positions a camera for the given frame; eyeOffset shifts it sideways
+void PlaceScenarioCamera(BenchmarkScenario const& scenario,
+                         int frame,
+                         float eyeOffset,
+                         Camera& camera);
+
+}  // namespace SpatialRender
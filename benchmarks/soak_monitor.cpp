@@ -0,0 +1,190 @@
+#include "soak_monitor.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "memory_tracker.h"
+
+using json   = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace SpatialRender
+{
+
+SoakMonitor::SoakMonitor(SoakConfig const& config) :
+    m_config(config),
+    m_last_snapshot_s(0.0),
+    m_window(config.window_frames)
+{
+    m_start = std::chrono::steady_clock::now();
+}
+
+void SoakMonitor::Start()
+{
+    m_start           = std::chrono::steady_clock::now();
+    m_last_snapshot_s = 0.0;
+    m_frame_stats.Reset();
+    m_render_stats.Reset();
+    m_histogram.Clear();
+    m_window.Clear();
+    m_window_stats.Reset();
+    m_snapshots.clear();
+}
+
+void SoakMonitor::RecordFrame(double frame_time_us, double render_time_us)
+{
+    m_frame_stats.Add(frame_time_us);
+    m_render_stats.Add(render_time_us);
+    m_histogram.Record(frame_time_us);
+    m_window.Add(frame_time_us);
+    m_window_stats.Add(frame_time_us);
+}
+
+double SoakMonitor::GetElapsedSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+bool SoakMonitor::IsSnapshotDue() const
+{
+    return GetElapsedSeconds() - m_last_snapshot_s >= m_config.snapshot_interval_s;
+}
+
+bool SoakMonitor::IsFinished() const
+{
+    return GetElapsedSeconds() >= m_config.duration_s;
+}
+
+SoakSnapshot const& SoakMonitor::TakeSnapshot(double elapsed_s)
+{
+    SoakSnapshot snapshot;
+    snapshot.elapsed_s               = elapsed_s;
+    snapshot.frame_count             = m_frame_stats.GetCount();
+    snapshot.window_frame_time       = m_window.Compute();
+    snapshot.window_mean_us          = m_window_stats.GetMean();
+    snapshot.rss_kb                  = QueryProcessRssKb();
+    snapshot.gpu_memory_available_kb = QueryGpuMemoryAvailableKb();
+
+    double reference = m_snapshots.empty() ? snapshot.window_frame_time.p50
+                                           : m_snapshots.front().window_frame_time.p50;
+    snapshot.drift_percent =
+        reference > 0.0 ? (snapshot.window_frame_time.p50 / reference - 1.0) * 100.0 : 0.0;
+
+    // The mean covers frames since the previous snapshot
+    m_window_stats.Reset();
+    m_last_snapshot_s = snapshot.elapsed_s;
+    m_snapshots.push_back(snapshot);
+    return m_snapshots.back();
+}
+
+template <typename Value>
+static double SlopePerHour(std::vector<SoakSnapshot> const& snapshots, Value value)
+{
+    double n = 0.0, sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    for (SoakSnapshot const& snapshot : snapshots)
+    {
+        double y = value(snapshot);
+        if (y < 0.0)
+            continue;
+
+        double x = snapshot.elapsed_s / 3600.0;
+        n += 1.0;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+
+    double denominator = n * sumXX - sumX * sumX;
+    if (n < 2.0 || denominator <= 0.0)
+        return 0.0;
+    return (n * sumXY - sumX * sumY) / denominator;
+}
+
+double SoakMonitor::GetFrameTimeDriftPerHour() const
+{
+    return SlopePerHour(m_snapshots,
+                        [](SoakSnapshot const& s) { return s.window_frame_time.p50; });
+}
+
+double SoakMonitor::GetRssGrowthKbPerHour() const
+{
+    return SlopePerHour(m_snapshots, [](SoakSnapshot const& s) { return (double)s.rss_kb; });
+}
+
+void SoakMonitor::Save(std::string const& path) const
+{
+    json j;
+    j["duration_s"]                   = GetElapsedSeconds();
+    j["snapshot_interval_s"]          = m_config.snapshot_interval_s;
+    j["window_frames"]                = m_config.window_frames;
+    j["frame_count"]                  = m_frame_stats.GetCount();
+    j["frame_time_us"]                = {{"mean", m_frame_stats.GetMean()},
+                                         {"stddev", m_frame_stats.GetStdDev()},
+                                         {"min", m_frame_stats.GetMin()},
+                                         {"max", m_frame_stats.GetMax()},
+                                         {"p50", m_histogram.ValueAtPercentile(50.0)},
+                                         {"p99", m_histogram.ValueAtPercentile(99.0)},
+                                         {"p99_9", m_histogram.ValueAtPercentile(99.9)}};
+    j["render_time_us"]               = {{"mean", m_render_stats.GetMean()},
+                                         {"stddev", m_render_stats.GetStdDev()},
+                                         {"max", m_render_stats.GetMax()}};
+    j["frame_time_drift_us_per_hour"] = GetFrameTimeDriftPerHour();
+    j["rss_growth_kb_per_hour"]       = GetRssGrowthKbPerHour();
+
+    json snapshots = json::array();
+    for (SoakSnapshot const& s : m_snapshots)
+    {
+        snapshots.push_back({{"elapsed_s", s.elapsed_s},
+                             {"frame_count", s.frame_count},
+                             {"window_mean_us", s.window_mean_us},
+                             {"window_p50_us", s.window_frame_time.p50},
+                             {"window_p99_us", s.window_frame_time.p99},
+                             {"window_max_us", s.window_frame_time.max},
+                             {"drift_percent", s.drift_percent},
+                             {"rss_kb", s.rss_kb},
+                             {"gpu_memory_available_kb", s.gpu_memory_available_kb}});
+    }
+    j["snapshots"] = snapshots;
+
+    json histogram = json::array();
+    for (auto const& bucket : m_histogram.GetNonEmptyBuckets())
+    {
+        histogram.push_back(
+            {{"lower_us", bucket.lower}, {"upper_us", bucket.upper}, {"count", bucket.count}});
+    }
+    j["frame_time_histogram"] = histogram;
+
+    fs::create_directories(fs::path(path).parent_path());
+    std::ofstream file(path);
+    file << std::setw(2) << j << std::endl;
+}
+
+int64_t QueryProcessRssKb()
+{
+#if defined(__linux__)
+    // Second field of statm is the resident page count
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    if (statm >> size >> resident)
+    {
+        return resident * (int64_t)sysconf(_SC_PAGESIZE) / 1024;
+    }
+#endif
+    return -1;
+}
+
+int64_t QueryGpuMemoryAvailableKb()
+{
+    return QueryDeviceMemory().freeKb;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "statistics.h"
+
+namespace SpatialRender
+{
+
+struct SoakConfig
+{
+    double duration_s          = 3600.0;
+    double snapshot_interval_s = 60.0;
+    size_t window_frames       = 1000;  // samples behind each windowed percentile
+};
+
+struct SoakSnapshot
+{
+    double elapsed_s;
+    uint64_t frame_count;
+    PercentileSummary window_frame_time;  // μs, most recent window_frames frames
+    double window_mean_us;                // frames since the previous snapshot
+    double drift_percent;                 // window p50 relative to the first snapshot
+    int64_t rss_kb;                       // -1 when unavailable
+    int64_t gpu_memory_available_kb;      // -1 when the driver cannot report it
+};
+
+// Constant-memory statistics for long benchmark runs. Frames feed running
+// totals, a fixed-size histogram and a sliding window; nothing is kept per
+// frame. A snapshot of the window, process RSS and free GPU memory is taken
+// every snapshot_interval_s so drift and leaks show up as trends.
+class SoakMonitor
+{
+ public:
+    explicit SoakMonitor(SoakConfig const& config = SoakConfig());
+
+    void Start();
+    void RecordFrame(double frame_time_us, double render_time_us);
+
+    bool IsSnapshotDue() const;
+    bool IsFinished() const;
+    double GetElapsedSeconds() const;
+
+    SoakSnapshot const& TakeSnapshot() { return TakeSnapshot(GetElapsedSeconds()); }
+    // Stamps the snapshot with elapsed_s instead of the run clock
+    SoakSnapshot const& TakeSnapshot(double elapsed_s);
+
+    SoakConfig const& GetConfig() const { return m_config; }
+    RunningStats const& GetFrameStats() const { return m_frame_stats; }
+    RunningStats const& GetRenderStats() const { return m_render_stats; }
+    LogHistogram const& GetHistogram() const { return m_histogram; }
+    std::vector<SoakSnapshot> const& GetSnapshots() const { return m_snapshots; }
+
+    // Least-squares slopes across the snapshots, per hour of run time
+    double GetFrameTimeDriftPerHour() const;
+    double GetRssGrowthKbPerHour() const;
+
+    void Save(std::string const& path) const;
+
+ private:
+    SoakConfig m_config;
+    std::chrono::steady_clock::time_point m_start;
+    double m_last_snapshot_s;
+
+    RunningStats m_frame_stats;
+    RunningStats m_render_stats;
+    LogHistogram m_histogram;
+    WindowedPercentiles m_window;
+    RunningStats m_window_stats;
+    std::vector<SoakSnapshot> m_snapshots;
+};
+
+// Resident set size of this process, or -1 when the platform is unsupported
+int64_t QueryProcessRssKb();
+
+// Free video memory from GL_NVX_gpu_memory_info or GL_ATI_meminfo, or -1.
+// Requires a current GL context.
+int64_t QueryGpuMemoryAvailableKb();
+
+}  // namespace SpatialRender
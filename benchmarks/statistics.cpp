@@ -0,0 +1,401 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace SpatialRender
+{
+
+LogHistogram::LogHistogram(double lowest, double highest, int sub_buckets) :
+    m_lowest(std::max(lowest, 1e-9)),
+    m_sub_buckets(std::max(sub_buckets, 1)),
+    m_total(0)
+{
+    int octaves = (int)std::ceil(std::log2(std::max(highest / m_lowest, 2.0)));
+    m_counts.assign((size_t)octaves * m_sub_buckets + 1, 0);
+}
+
+size_t LogHistogram::BucketIndex(double value) const
+{
+    if (!(value > m_lowest))
+        return 0;
+
+    // Octave from the exponent, linear position inside it from the mantissa
+    int exponent    = 0;
+    double mantissa = std::frexp(value / m_lowest, &exponent);  // [0.5, 1)
+    size_t octave   = (size_t)(exponent - 1);
+    size_t sub      = (size_t)((mantissa * 2.0 - 1.0) * m_sub_buckets);
+    sub             = std::min(sub, (size_t)m_sub_buckets - 1);
+    return std::min(octave * m_sub_buckets + sub, m_counts.size() - 1);
+}
+
+double LogHistogram::BucketLower(size_t index) const
+{
+    size_t octave = index / m_sub_buckets;
+    size_t sub    = index % m_sub_buckets;
+    return m_lowest * std::ldexp(1.0 + (double)sub / m_sub_buckets, (int)octave);
+}
+
+void LogHistogram::Record(double value)
+{
+    ++m_counts[BucketIndex(value)];
+    ++m_total;
+}
+
+void LogHistogram::Clear()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_total = 0;
+}
+
+double LogHistogram::ValueAtPercentile(double percentile) const
+{
+    if (m_total == 0)
+        return 0.0;
+
+    double rank     = std::clamp(percentile, 0.0, 100.0) / 100.0 * (double)m_total;
+    uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(rank));
+    uint64_t seen   = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i)
+    {
+        seen += m_counts[i];
+        if (seen >= target)
+            return BucketLower(i + 1);
+    }
+    return BucketLower(m_counts.size());
+}
+
+std::vector<LogHistogram::Bucket> LogHistogram::GetNonEmptyBuckets() const
+{
+    std::vector<Bucket> buckets;
+    for (size_t i = 0; i < m_counts.size(); ++i)
+    {
+        if (m_counts[i] != 0)
+        {
+            buckets.push_back({i == 0 ? 0.0 : BucketLower(i), BucketLower(i + 1), m_counts[i]});
+        }
+    }
+    return buckets;
+}
+
+void RunningStats::Add(double value)
+{
+    ++m_count;
+    double delta = value - m_mean;
+    m_mean += delta / (double)m_count;
+    m_m2 += delta * (value - m_mean);
+
+    m_min = m_count == 1 ? value : std::min(m_min, value);
+    m_max = m_count == 1 ? value : std::max(m_max, value);
+}
+
+double RunningStats::GetStdDev() const
+{
+    return std::sqrt(GetVariance());
+}
+
+WindowedPercentiles::WindowedPercentiles(size_t capacity) :
+    m_values(std::max<size_t>(capacity, 1), 0.0),
+    m_next(0),
+    m_size(0)
+{
+    m_sorted.reserve(m_values.size());
+}
+
+void WindowedPercentiles::Add(double value)
+{
+    m_values[m_next] = value;
+    m_next           = (m_next + 1) % m_values.size();
+    m_size           = std::min(m_size + 1, m_values.size());
+}
+
+void WindowedPercentiles::Clear()
+{
+    m_next = 0;
+    m_size = 0;
+}
+
+PercentileSummary WindowedPercentiles::Compute() const
+{
+    PercentileSummary summary;
+    if (m_size == 0)
+        return summary;
+
+    // Order within the window does not matter, only which samples are in it
+    m_sorted.assign(m_values.begin(), m_values.begin() + m_size);
+    std::sort(m_sorted.begin(), m_sorted.end());
+    summary.p50  = PercentileOfSorted(m_sorted, 50.0);
+    summary.p90  = PercentileOfSorted(m_sorted, 90.0);
+    summary.p99  = PercentileOfSorted(m_sorted, 99.0);
+    summary.p999 = PercentileOfSorted(m_sorted, 99.9);
+    summary.max  = m_sorted.back();
+    return summary;
+}
+
+double PercentileOfSorted(std::vector<double> const& sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    double position = std::clamp(percentile, 0.0, 100.0) / 100.0 * (double)(sorted.size() - 1);
+    size_t lower    = (size_t)position;
+    size_t upper    = std::min(lower + 1, sorted.size() - 1);
+    double fraction = position - (double)lower;
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+PercentileSummary ComputePercentiles(std::vector<double> const& values)
+{
+    PercentileSummary summary;
+    if (values.empty())
+        return summary;
+
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    summary.p50  = PercentileOfSorted(sorted, 50.0);
+    summary.p90  = PercentileOfSorted(sorted, 90.0);
+    summary.p99  = PercentileOfSorted(sorted, 99.0);
+    summary.p999 = PercentileOfSorted(sorted, 99.9);
+    summary.max  = sorted.back();
+    return summary;
+}
+
+double OnePercentLowFps(std::vector<double> const& frame_times_us)
+{
+    if (frame_times_us.empty())
+        return 0.0;
+
+    std::vector<double> sorted(frame_times_us);
+    std::sort(sorted.begin(), sorted.end(), std::greater<double>());
+
+    size_t count = std::max<size_t>(1, sorted.size() / 100);
+    double total = std::accumulate(sorted.begin(), sorted.begin() + count, 0.0);
+    return total > 0.0 ? 1000000.0 * (double)count / total : 0.0;
+}
+
+ConfidenceInterval BootstrapMeanCI(std::vector<double> const& values,
+                                   double confidence,
+                                   int resamples,
+                                   uint64_t seed)
+{
+    ConfidenceInterval interval;
+    interval.confidence = confidence;
+    if (values.empty() || resamples <= 0)
+        return interval;
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+
+    std::vector<double> means(resamples);
+    for (double& mean : means)
+    {
+        double total = 0.0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            total += values[pick(rng)];
+        }
+        mean = total / (double)values.size();
+    }
+    std::sort(means.begin(), means.end());
+
+    double tail   = (1.0 - confidence) * 0.5 * 100.0;
+    interval.low  = PercentileOfSorted(means, tail);
+    interval.high = PercentileOfSorted(means, 100.0 - tail);
+    return interval;
+}
+
+std::vector<size_t> DetectOutliers(std::vector<double> const& values, double k)
+{
+    std::vector<size_t> outliers;
+    if (values.size() < 4)
+        return outliers;
+
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    double q1  = PercentileOfSorted(sorted, 25.0);
+    double q3  = PercentileOfSorted(sorted, 75.0);
+    double iqr = q3 - q1;
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i] < q1 - k * iqr || values[i] > q3 + k * iqr)
+        {
+            outliers.push_back(i);
+        }
+    }
+    return outliers;
+}
+
+size_t DetectWarmup(std::vector<double> const& values)
+{
+    constexpr size_t kBatch = 5;
+    size_t batchCount       = values.size() / kBatch;
+    if (batchCount < 4)
+        return 0;
+
+    std::vector<double> batches(batchCount);
+    for (size_t b = 0; b < batchCount; ++b)
+    {
+        double total = 0.0;
+        for (size_t i = 0; i < kBatch; ++i)
+        {
+            total += values[b * kBatch + i];
+        }
+        batches[b] = total / kBatch;
+    }
+
+    // Suffix sums give the mean and squared deviation of every tail in O(n)
+    std::vector<double> sum(batchCount + 1, 0.0);
+    std::vector<double> sumSq(batchCount + 1, 0.0);
+    for (size_t b = batchCount; b-- > 0;)
+    {
+        sum[b]   = sum[b + 1] + batches[b];
+        sumSq[b] = sumSq[b + 1] + batches[b] * batches[b];
+    }
+
+    size_t best      = 0;
+    double bestScore = 0.0;
+    for (size_t d = 0; d <= batchCount / 10; ++d)
+    {
+        double n        = (double)(batchCount - d);
+        double mean     = sum[d] / n;
+        double deviance = std::max(sumSq[d] - n * mean * mean, 0.0);
+        double score    = deviance / (n * n);
+        if (d == 0 || score < bestScore)
+        {
+            best      = d;
+            bestScore = score;
+        }
+    }
+    return best * kBatch;
+}
+
+MannWhitneyResult MannWhitneyU(std::vector<double> const& first,
+                               std::vector<double> const& second)
+{
+    MannWhitneyResult result;
+    size_t n1 = first.size();
+    size_t n2 = second.size();
+    if (n1 == 0 || n2 == 0)
+        return result;
+
+    std::vector<std::pair<double, bool>> pooled;
+    pooled.reserve(n1 + n2);
+    for (double value : first)
+    {
+        pooled.emplace_back(value, false);
+    }
+    for (double value : second)
+    {
+        pooled.emplace_back(value, true);
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    // Average ranks over ties and accumulate the tie correction term
+    double rankSum = 0.0;
+    double ties    = 0.0;
+    for (size_t i = 0; i < pooled.size();)
+    {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first)
+        {
+            ++j;
+        }
+        double rank = (double)(i + j + 1) * 0.5;
+        for (size_t k = i; k < j; ++k)
+        {
+            if (pooled[k].second)
+                rankSum += rank;
+        }
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double a   = (double)n1;
+    double b   = (double)n2;
+    double n   = a + b;
+    result.u   = rankSum - b * (b + 1.0) * 0.5;
+    double mu  = a * b * 0.5;
+    double var = a * b / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+
+    result.probability = result.u / (a * b);
+    if (var > 0.0)
+    {
+        double diff    = result.u - mu;
+        double shifted = std::max(std::abs(diff) - 0.5, 0.0);  // continuity correction
+        result.z       = (diff < 0.0 ? -shifted : shifted) / std::sqrt(var);
+        result.p_value = std::erfc(std::abs(result.z) / std::sqrt(2.0));
+    }
+    return result;
+}
+
+ConfidenceInterval BootstrapMeanDeltaCI(std::vector<double> const& baseline,
+                                        std::vector<double> const& current,
+                                        double confidence,
+                                        int resamples,
+                                        uint64_t seed)
+{
+    ConfidenceInterval interval;
+    interval.confidence = confidence;
+    if (baseline.empty() || current.empty() || resamples <= 0)
+        return interval;
+
+    std::mt19937_64 rng(seed);
+    auto resampleMean = [&](std::vector<double> const& values) {
+        std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+        double total = 0.0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            total += values[pick(rng)];
+        }
+        return total / (double)values.size();
+    };
+
+    std::vector<double> deltas;
+    deltas.reserve(resamples);
+    for (int r = 0; r < resamples; ++r)
+    {
+        double base = resampleMean(baseline);
+        double curr = resampleMean(current);
+        if (base > 0.0)
+            deltas.push_back((curr / base - 1.0) * 100.0);
+    }
+    if (deltas.empty())
+        return interval;
+    std::sort(deltas.begin(), deltas.end());
+
+    double tail   = (1.0 - confidence) * 0.5 * 100.0;
+    interval.low  = PercentileOfSorted(deltas, tail);
+    interval.high = PercentileOfSorted(deltas, 100.0 - tail);
+    return interval;
+}
+
+FrameStatistics AnalyzeFrames(std::vector<double> const& frame_times_us,
+                              std::vector<double> const& render_times_us)
+{
+    FrameStatistics stats;
+    stats.warmup_frames  = DetectWarmup(frame_times_us);
+    stats.outlier_frames = DetectOutliers(frame_times_us);
+
+    stats.sample_count = frame_times_us.size();
+    stats.frame_time   = ComputePercentiles(frame_times_us);
+    if (render_times_us.size() == frame_times_us.size())
+    {
+        stats.render_time = ComputePercentiles(render_times_us);
+    }
+    stats.one_percent_low_fps = OnePercentLowFps(frame_times_us);
+    stats.mean_frame_time     = BootstrapMeanCI(frame_times_us);
+
+    LogHistogram histogram;
+    for (double frame : frame_times_us)
+    {
+        histogram.Record(frame);
+    }
+    stats.histogram = histogram.GetNonEmptyBuckets();
+    return stats;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SpatialRender
+{
+
+struct PercentileSummary
+{
+    double p50  = 0.0;
+    double p90  = 0.0;
+    double p99  = 0.0;
+    double p999 = 0.0;
+    double max  = 0.0;
+};
+
+struct ConfidenceInterval
+{
+    double low        = 0.0;
+    double high       = 0.0;
+    double confidence = 0.0;
+};
+
+// Log-bucketed histogram in the style of HdrHistogram: every power of two is
+// split into a fixed number of linear sub-buckets, so the relative error of a
+// bucket is bounded (~3% with 32 sub-buckets) across the whole value range.
+class LogHistogram
+{
+ public:
+    struct Bucket
+    {
+        double lower;
+        double upper;
+        uint64_t count;
+    };
+
+    // Values below lowest go to the first bucket, above highest to the last
+    explicit LogHistogram(double lowest = 1.0, double highest = 1.0e8, int sub_buckets = 32);
+
+    void Record(double value);
+    void Clear();
+
+    uint64_t GetTotalCount() const { return m_total; }
+
+    // Upper edge of the bucket holding the given percentile (0-100)
+    double ValueAtPercentile(double percentile) const;
+
+    std::vector<Bucket> GetNonEmptyBuckets() const;
+
+ private:
+    size_t BucketIndex(double value) const;
+    double BucketLower(size_t index) const;
+
+    double m_lowest;
+    int m_sub_buckets;
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total;
+};
+
+// Welford's online mean and variance in constant memory
+class RunningStats
+{
+ public:
+    void Add(double value);
+    void Reset() { *this = RunningStats(); }
+
+    uint64_t GetCount() const { return m_count; }
+    double GetMean() const { return m_mean; }
+    double GetVariance() const { return m_count > 1 ? m_m2 / (double)(m_count - 1) : 0.0; }
+    double GetStdDev() const;
+    double GetMin() const { return m_min; }
+    double GetMax() const { return m_max; }
+
+ private:
+    uint64_t m_count = 0;
+    double m_mean    = 0.0;
+    double m_m2      = 0.0;
+    double m_min     = 0.0;
+    double m_max     = 0.0;
+};
+
+// Percentiles over the most recent capacity samples, kept in a ring buffer
+class WindowedPercentiles
+{
+ public:
+    explicit WindowedPercentiles(size_t capacity = 1000);
+
+    void Add(double value);
+    void Clear();
+
+    size_t GetSize() const { return m_size; }
+    size_t GetCapacity() const { return m_values.size(); }
+
+    PercentileSummary Compute() const;
+
+ private:
+    std::vector<double> m_values;
+    mutable std::vector<double> m_sorted;
+    size_t m_next;
+    size_t m_size;
+};
+
+// Percentile of already sorted values, linearly interpolated (0-100)
+double PercentileOfSorted(std::vector<double> const& sorted, double percentile);
+
+PercentileSummary ComputePercentiles(std::vector<double> const& values);
+
+// Average FPS over the slowest 1% of frames (at least one frame)
+double OnePercentLowFps(std::vector<double> const& frame_times_us);
+
+// Percentile bootstrap of the mean; deterministic for a given seed
+ConfidenceInterval BootstrapMeanCI(std::vector<double> const& values,
+                                   double confidence = 0.95,
+                                   int resamples     = 1000,
+                                   uint64_t seed     = 1);
+
+// Indices of values outside Tukey's fences, k * IQR beyond the quartiles
+std::vector<size_t> DetectOutliers(std::vector<double> const& values, double k = 1.5);
+
+// Length of a slow start, chosen with the MSER-5 rule: the truncation point
+// minimising the standard error of the remaining batch means. Only the first
+// tenth of the run is considered, so a later hitch is never taken for warm-up.
+size_t DetectWarmup(std::vector<double> const& values);
+
+struct MannWhitneyResult
+{
+    double u           = 0.0;  // pairs where the second sample is larger, ties count half
+    double z           = 0.0;
+    double p_value     = 1.0;  // two-sided, normal approximation with tie correction
+    double probability = 0.5;  // P(second > first); 0.5 means no shift
+};
+
+// Rank-sum test for a shift between two independent samples. Makes no
+// assumption about the shape of the distributions, which suits skewed,
+// long-tailed frame times.
+MannWhitneyResult MannWhitneyU(std::vector<double> const& first,
+                               std::vector<double> const& second);
+
+// Bootstrap interval for the relative change of the mean, in percent
+ConfidenceInterval BootstrapMeanDeltaCI(std::vector<double> const& baseline,
+                                        std::vector<double> const& current,
+                                        double confidence = 0.95,
+                                        int resamples     = 1000,
+                                        uint64_t seed     = 1);
+
+struct FrameStatistics
+{
+    size_t sample_count  = 0;  // frames analysed: every measured frame
+    size_t warmup_frames = 0;  // detected slow start, reported but not excluded
+    std::vector<size_t> outlier_frames;  // indices into the full run
+    PercentileSummary frame_time;
+    PercentileSummary render_time;
+    double one_percent_low_fps = 0.0;
+    ConfidenceInterval mean_frame_time;
+    std::vector<LogHistogram::Bucket> histogram;
+};
+
+// Tail statistics over every measured frame. The benchmark runs its own
+// warm-up frames first, and dropping more would hide stalls.
+FrameStatistics AnalyzeFrames(std::vector<double> const& frame_times_us,
+                              std::vector<double> const& render_times_us);
+
+}  // namespace SpatialRender
@@ -1,11 +1,20 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "culling.h"
+
 namespace SpatialRender
 {
 
+// Matrices, inverses and the frustum are cached and rebuilt on first use after
+// a setter changes them. The getters fill the cache, so call UpdateCache()
+// before sharing a const camera between threads.
 class Camera
 {
  public:
@@ -19,15 +28,62 @@ class Camera
     void SetPerspective(float fov, float aspect, float near, float far);
     void SetOrthographic(float left, float right, float bottom, float top, float near, float far);
 
-    glm::mat4 GetViewMatrix() const;
-    glm::mat4 GetProjectionMatrix() const;
-    glm::mat4 GetViewProjectionMatrix() const;
+    // Perspective only: map the near plane to depth 1 and infinity to 0 for a
+    // [0, 1] clip depth range (glClipControl). The far distance is kept for
+    // GetFrustumCorners() but no longer clips.
+    void SetReversedZ(bool reversedZ);
+
+    glm::mat4 const& GetViewMatrix() const;
+    glm::mat4 const& GetProjectionMatrix() const;
+    glm::mat4 const& GetViewProjectionMatrix() const;
+    glm::mat4 const& GetInverseViewMatrix() const;
+    glm::mat4 const& GetInverseProjectionMatrix() const;
+    glm::mat4 const& GetInverseViewProjectionMatrix() const;
+
+    Frustum const& GetFrustum() const;
+    // World-space corners: near then far, each bottom-left, bottom-right,
+    // top-right, top-left
+    std::array<glm::vec3, 8> const& GetFrustumCorners() const;
+
+    void UpdateCache() const;
 
     glm::vec3 GetPosition() const { return m_position; }
     glm::vec3 GetTarget() const { return m_target; }
     glm::vec3 GetUp() const { return m_up; }
 
+    float GetFov() const { return m_fov; }
+    float GetAspect() const { return m_aspect; }
+    float GetNear() const { return m_near; }
+    float GetFar() const { return m_far; }
+    bool IsOrthographic() const { return m_orthographic; }
+    // Left, right, bottom and top of the orthographic volume
+    glm::vec4 GetOrthographicBounds() const
+    {
+        return glm::vec4(m_orthoLeft, m_orthoRight, m_orthoBottom, m_orthoTop);
+    }
+    bool IsReversedZ() const { return m_reversedZ && !m_orthographic; }
+
  private:
+    friend class CameraSet;
+
+    enum DirtyFlags : uint8_t
+    {
+        ViewDirty           = 1 << 0,
+        ProjectionDirty     = 1 << 1,
+        ViewProjectionDirty = 1 << 2,
+        InverseDirty        = 1 << 3,
+        FrustumDirty        = 1 << 4,
+        CornersDirty        = 1 << 5,
+
+        DerivedDirty      = ViewProjectionDirty | InverseDirty | FrustumDirty | CornersDirty,
+        ViewChanged       = ViewDirty | DerivedDirty,
+        ProjectionChanged = ProjectionDirty | DerivedDirty,
+    };
+
+    glm::mat4 BuildProjection() const;
+    // Replaces the near and far planes extracted for a [-1, 1] depth range
+    void FixReversedZPlanes(Frustum& frustum) const;
+
     glm::vec3 m_position;
     glm::vec3 m_target;
     glm::vec3 m_up;
@@ -38,7 +94,46 @@ class Camera
     float m_far;
 
     bool m_orthographic;
+    bool m_reversedZ;
     float m_orthoLeft, m_orthoRight, m_orthoBottom, m_orthoTop;
+
+    mutable uint8_t m_dirty;
+    mutable glm::mat4 m_view;
+    mutable glm::mat4 m_projection;
+    mutable glm::mat4 m_viewProjection;
+    mutable glm::mat4 m_inverseView;
+    mutable glm::mat4 m_inverseProjection;
+    mutable glm::mat4 m_inverseViewProjection;
+    mutable Frustum m_frustum;
+    mutable std::array<glm::vec3, 8> m_frustumCorners;
+};
+
+// Cameras evaluated together: shadow cascades, cubemap faces, split views.
+// Update() rebuilds the view, projection, view-projection and frustum of every
+// changed camera four at a time with SSE2; inverses and corners stay lazy.
+class CameraSet
+{
+ public:
+    size_t Add(Camera const& camera);
+    // Six 90 degree views around a point in the usual cubemap face order
+    // (+X, -X, +Y, -Y, +Z, -Z); returns the index of the first
+    size_t AddCubemapFaces(glm::vec3 const& position, float near, float far);
+    void Clear() { m_cameras.clear(); }
+
+    // Setters on the returned camera mark it for the next Update()
+    Camera& GetCamera(size_t index) { return m_cameras[index]; }
+    Camera const& GetCamera(size_t index) const { return m_cameras[index]; }
+    std::vector<Camera> const& GetCameras() const { return m_cameras; }
+    size_t GetCount() const { return m_cameras.size(); }
+
+    void Update();
+
+ private:
+    // One camera per SSE2 lane; a short batch repeats its last camera
+    static void UpdateFour(Camera* const* cameras);
+
+    std::vector<Camera> m_cameras;
+    std::vector<Camera*> m_pending;
 };
 
 }  // namespace SpatialRender
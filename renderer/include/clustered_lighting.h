@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "frame_sync.h"
+#include "scene.h"
+
+namespace SpatialRender
+{
+
+class Camera;
+class Shader;
+
+struct LightingStats
+{
+    size_t lights           = 0;
+    size_t visibleLights    = 0;
+    size_t occupiedClusters = 0;
+    size_t lightIndices     = 0;
+    size_t droppedLights    = 0;  // cluster entries past kMaxLightsPerCluster
+    double binMs            = 0.0;
+};
+
+// Froxel grid for clustered forward shading: kTilesX x kTilesY screen tiles,
+// each cut into kSlices depth slices spaced exponentially between the near and
+// far planes. A light is added to every cluster touched by the screen rectangle
+// and depth range of its bounding sphere. Slices are binned in parallel.
+class LightClusterGrid
+{
+ public:
+    static constexpr uint32_t kTilesX              = 16;
+    static constexpr uint32_t kTilesY              = 9;
+    static constexpr uint32_t kSlices              = 24;
+    static constexpr uint32_t kClusterCount        = kTilesX * kTilesY * kSlices;
+    static constexpr uint32_t kMaxLightsPerCluster = 128;
+    static constexpr uint32_t kTexelsPerLight      = 4;
+
+    LightClusterGrid();
+
+    void Build(std::vector<Light> const& lights,
+               glm::mat4 const& view,
+               glm::mat4 const& projection,
+               float nearPlane,
+               float farPlane);
+
+    static uint32_t GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice)
+    {
+        return (slice * kTilesY + tileY) * kTilesX + tileX;
+    }
+
+    // Slice containing a positive view-space depth
+    uint32_t GetSlice(float viewDepth) const;
+
+    uint32_t GetClusterLightCount(uint32_t cluster) const { return m_clusterData[cluster * 2 + 1]; }
+    uint32_t const* GetClusterLights(uint32_t cluster) const
+    {
+        return m_lightIndices.data() + m_clusterData[cluster * 2];
+    }
+
+    // GPU layout: kTexelsPerLight vec4s per light, an (offset, count) pair per
+    // cluster and the flattened per-cluster light index lists
+    std::vector<glm::vec4> const& GetLightData() const { return m_lightData; }
+    std::vector<uint32_t> const& GetClusterData() const { return m_clusterData; }
+    std::vector<uint32_t> const& GetLightIndices() const { return m_lightIndices; }
+
+    // slice = log(viewDepth) * x - y
+    glm::vec2 GetDepthParams() const { return m_depthParams; }
+
+    LightingStats const& GetStats() const { return m_stats; }
+
+ private:
+    struct LightRange
+    {
+        uint32_t tileMin[2];
+        uint32_t tileMax[2];
+        uint32_t sliceMin;
+        uint32_t sliceMax;
+        bool visible;
+    };
+
+    void ComputeRange(Light const& light,
+                      glm::mat4 const& view,
+                      glm::mat4 const& projection,
+                      LightRange& range) const;
+    void BinSlice(uint32_t slice);
+
+    float m_near;
+    float m_far;
+    glm::vec2 m_depthParams;
+
+    std::vector<LightRange> m_ranges;
+    std::array<std::vector<uint32_t>, kSlices> m_sliceIndices;
+    std::array<uint32_t, kSlices> m_sliceDropped;
+
+    std::vector<glm::vec4> m_lightData;
+    std::vector<uint32_t> m_clusterData;
+    std::vector<uint32_t> m_lightIndices;
+
+    LightingStats m_stats;
+};
+
+// Owns the buffer textures that carry a LightClusterGrid to the shaders. Uses
+// texture buffers rather than SSBOs so it runs on the GL 3.3 baseline. There
+// is one set of buffers per frames-in-flight slot, so an upload never touches
+// storage the GPU may still be reading.
+class ClusteredLighting
+{
+ public:
+    // High units keep material textures on the low ones
+    static constexpr GLuint kLightDataUnit   = 13;
+    static constexpr GLuint kClusterDataUnit = 14;
+    static constexpr GLuint kLightIndexUnit  = 15;
+
+    ClusteredLighting();
+    ~ClusteredLighting();
+
+    ClusteredLighting(ClusteredLighting const&)            = delete;
+    ClusteredLighting& operator=(ClusteredLighting const&) = delete;
+
+    bool Initialize();
+    void Shutdown();
+
+    // Bins the scene's lights once per view and uploads the result. Views are
+    // assumed to sit side by side across the viewport, in camera order.
+    void Update(Scene const& scene, Camera const* cameras, size_t viewCount, int frameSlot);
+
+    // Binds the buffers and sets the cluster uniforms on a program in use
+    void Apply(Shader& shader, int viewportWidth, int viewportHeight);
+
+    LightClusterGrid const& GetGrid(size_t view = 0) const { return m_grids[view]; }
+    LightingStats const& GetStats() const { return m_grids[0].GetStats(); }
+    // Summed over the views of the last Update()
+    size_t GetDroppedLights() const;
+
+ private:
+    struct TextureBuffer
+    {
+        GLuint buffer   = 0;
+        GLuint texture  = 0;
+        size_t capacity = 0;
+    };
+
+    struct FrameBuffers
+    {
+        TextureBuffer lightData;
+        TextureBuffer clusterData;
+        TextureBuffer lightIndices;
+    };
+
+    static bool CreateTextureBuffer(TextureBuffer& tb, GLenum format);
+    static void Upload(TextureBuffer& tb, void const* data, size_t bytes);
+    static void Release(TextureBuffer& tb);
+
+    std::vector<LightClusterGrid> m_grids;
+    std::vector<uint32_t> m_clusterScratch;
+    std::vector<uint32_t> m_indexScratch;
+
+    std::array<FrameBuffers, FrameSync::kMaxFramesInFlight> m_frames;
+    int m_frameSlot;
+    int m_viewCount;
+    int m_lightCount;
+    bool m_initialized;
+};
+
+}  // namespace SpatialRender
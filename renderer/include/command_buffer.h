@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace SpatialRender
+{
+
+class Shader;
+
+// A recorded draw stream with everything resolved: program and object names,
+// uniform locations and values, and draw parameters, packed back to back into
+// one byte array. Execute() issues the same calls through GLStateCache without
+// looking at the scene, meshes or uniform names that produced them.
+//
+// Per-frame values are not recorded. ApplyFrameConstants() marks where a
+// program takes them, and Execute() hands that program to a callback which
+// sets the current views, lighting and instance bindings.
+class CommandBuffer
+{
+ public:
+    using FrameConstantsFunction = std::function<void(Shader&)>;
+
+    CommandBuffer();
+
+    void Clear();
+    bool IsEmpty() const { return m_data.empty(); }
+    size_t GetCommandCount() const { return m_commandCount; }
+    size_t GetBytes() const { return m_data.size(); }
+
+    void UseProgram(Shader& shader);
+    // The shader must outlive the recording
+    void ApplyFrameConstants(Shader& shader);
+
+    // Locations are resolved now; uniforms the program lacks are not recorded.
+    // The program must be the one recorded last with UseProgram().
+    void SetUniform(Shader& shader, std::string const& name, int value);
+    void SetUniform(Shader& shader, std::string const& name, glm::vec3 const& value);
+    void SetUniform(Shader& shader, std::string const& name, glm::mat4 const& value);
+
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    void BindVertexArray(GLuint vao);
+    void DrawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, GLsizei instanceCount);
+
+    void Enable(GLenum cap);
+    void Disable(GLenum cap);
+    void DepthFunc(GLenum func);
+    void DepthMask(GLboolean enabled);
+    void ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a);
+
+    void Execute(FrameConstantsFunction const& applyFrameConstants) const;
+
+ private:
+    enum class Op : uint8_t
+    {
+        UseProgram,
+        ApplyFrameConstants,
+        Uniform1i,
+        Uniform3f,
+        UniformMatrix4f,
+        BindTexture,
+        BindVertexArray,
+        DrawArrays,
+        DrawElements,
+        Enable,
+        Disable,
+        DepthFunc,
+        DepthMask,
+        ColorMask
+    };
+
+    template <typename T>
+    void Write(Op op, T const& payload);
+
+    std::vector<uint8_t> m_data;
+    size_t m_commandCount;
+};
+
+}  // namespace SpatialRender
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace SpatialRender
+{
+
+// Axis-aligned bounding box. A default-constructed box is empty.
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    AABB() :
+        min(std::numeric_limits<float>::max()),
+        max(-std::numeric_limits<float>::max())
+    {}
+    AABB(glm::vec3 const& minPoint, glm::vec3 const& maxPoint) : min(minPoint), max(maxPoint) {}
+
+    bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+    void Expand(glm::vec3 const& point);
+
+    // Bounds of this box after an affine transform
+    AABB Transformed(glm::mat4 const& transform) const;
+};
+
+// Six clip planes (left, right, bottom, top, near, far) with normals pointing inward
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes;
+
+    static Frustum FromMatrix(glm::mat4 const& viewProj);
+
+    // Conservative: may report intersection for boxes just outside a corner
+    bool Intersects(AABB const& box) const;
+};
+
+}  // namespace SpatialRender
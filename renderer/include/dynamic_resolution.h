@@ -0,0 +1,49 @@
+#pragma once
+
+namespace SpatialRender
+{
+
+struct ResolutionControllerConfig
+{
+    float targetFrameMs = 16.6f;
+    float minScale      = 0.5f;
+    float maxScale      = 1.0f;
+
+    // Gains of the incremental PID on the relative frame-time error
+    float kp = 0.25f;
+    float ki = 0.15f;
+    float kd = 0.05f;
+
+    float deadband = 0.05f;   // relative error treated as on target
+    float minStep  = 0.025f;  // smaller scale changes are held back
+};
+
+// Picks the per-axis render scale for the next frame from measured GPU frame
+// time. The controller works in velocity form, so clamping the scale cannot
+// wind up the integral term. The deadband and minimum step keep the target
+// from being resized on every small fluctuation.
+class ResolutionController
+{
+ public:
+    explicit ResolutionController(
+        ResolutionControllerConfig const& config = ResolutionControllerConfig());
+
+    // Feeds one measurement and returns the scale to render the next frame at
+    float Update(float gpuFrameMs);
+
+    void Reset(float scale = 1.0f);
+
+    float GetScale() const { return m_scale; }
+    ResolutionControllerConfig const& GetConfig() const { return m_config; }
+    void SetConfig(ResolutionControllerConfig const& config);
+
+ private:
+    float Clamp(float scale) const;
+
+    ResolutionControllerConfig m_config;
+    float m_scale;
+    float m_desiredScale;
+    float m_error[2];  // previous two errors, newest first
+};
+
+}  // namespace SpatialRender
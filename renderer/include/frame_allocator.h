@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SpatialRender
+{
+
+// Bump allocator for scratch data that lives until the next Reset(). Memory is
+// handed out from blocks owned by the arena and is never freed individually.
+// When a frame overflows the first block, Reset() merges the blocks into one
+// large enough for that frame, so a steady frame loop stops calling malloc.
+// Not thread-safe; each thread uses its own arena.
+class LinearArena
+{
+ public:
+    explicit LinearArena(size_t initialCapacity = 64 * 1024);
+    ~LinearArena();
+
+    LinearArena(LinearArena const&)            = delete;
+    LinearArena& operator=(LinearArena const&) = delete;
+
+    // alignment must be a power of two
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void Reset();
+
+    // Bytes consumed since the last Reset(), including alignment padding and
+    // the unused tails of blocks that overflowed
+    size_t GetUsedBytes() const { return m_used; }
+    size_t GetCapacity() const { return m_capacity; }
+    // Blocks requested from the system over the arena's lifetime
+    uint64_t GetSystemAllocations() const { return m_systemAllocations; }
+
+ private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size;
+    };
+
+    void AddBlock(size_t size);
+
+    std::vector<Block> m_blocks;
+    size_t m_initialCapacity;
+    size_t m_offset;  // into the last block
+    size_t m_used;
+    size_t m_capacity;
+    uint64_t m_systemAllocations;
+};
+
+// Standard allocator over a LinearArena, for containers that live no longer
+// than the arena's current frame. deallocate() is a no-op, so reserve() up
+// front instead of growing.
+template <typename T>
+class ArenaAllocator
+{
+ public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) : m_arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U> const& other) : m_arena(other.GetArena())
+    {}
+
+    T* allocate(size_t count) { return m_arena->AllocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    LinearArena* GetArena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(ArenaAllocator<U> const& other) const
+    {
+        return m_arena == other.GetArena();
+    }
+
+ private:
+    LinearArena* m_arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// Per-frame scratch memory owned by the Renderer and reset in BeginFrame().
+// There is one arena per ThreadPool thread, so worker jobs allocate from
+// GetThreadArena() without locking. Reset() must not race with jobs that are
+// still allocating.
+class FrameAllocator
+{
+ public:
+    // threadCount 0 uses the global pool's thread count; it must cover every
+    // thread index that allocates
+    explicit FrameAllocator(unsigned threadCount = 0, size_t arenaCapacity = 256 * 1024);
+
+    // Arena of the calling ThreadPool thread
+    LinearArena& GetThreadArena();
+    LinearArena& GetArena(unsigned threadIndex) { return *m_arenas[threadIndex]; }
+    unsigned GetArenaCount() const { return (unsigned)m_arenas.size(); }
+
+    template <typename T>
+    ArenaAllocator<T> MakeAllocator()
+    {
+        return ArenaAllocator<T>(GetThreadArena());
+    }
+
+    void Reset();
+
+    // Bytes used by all arenas since the last Reset(); arenas only grow within
+    // a frame, so this is the frame's high-water mark
+    size_t GetHighWater() const;
+    size_t GetPeakHighWater() const { return m_peakHighWater; }
+    size_t GetCapacity() const;
+    uint64_t GetSystemAllocations() const;
+
+ private:
+    std::vector<std::unique_ptr<LinearArena>> m_arenas;
+    size_t m_peakHighWater;
+};
+
+}  // namespace SpatialRender
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace SpatialRender
+{
+
+using FrameGraphResource = uint32_t;
+
+constexpr FrameGraphResource kInvalidFrameGraphResource = 0xFFFFFFFFu;
+
+struct RenderTargetDesc
+{
+    int width     = 0;
+    int height    = 0;
+    GLenum format = GL_RGBA8;  // sized; depth formats become the depth attachment
+
+    bool operator==(RenderTargetDesc const& other) const = default;
+};
+
+bool IsDepthFormat(GLenum format);
+// 0 for formats the pool cannot create
+size_t GetRenderTargetBytes(RenderTargetDesc const& desc);
+
+// Textures and framebuffers behind transient frame graph resources, kept
+// across frames. A texture released mid-frame goes to the next resource with
+// the same description, which is how resources whose lifetimes do not overlap
+// share memory; GL 3.3 has no way to alias storage of different shapes.
+class RenderTargetPool
+{
+ public:
+    static constexpr size_t kMaxColorAttachments = 4;
+
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+
+    RenderTargetPool(RenderTargetPool const&)            = delete;
+    RenderTargetPool& operator=(RenderTargetPool const&) = delete;
+
+    // Returns a free texture matching desc, creating one if needed; 0 on failure
+    GLuint Acquire(RenderTargetDesc const& desc);
+    void Release(GLuint texture);
+
+    // Framebuffer with these attachments, created on first use
+    GLuint GetFramebuffer(GLuint const* colors, size_t colorCount, GLuint depth);
+
+    // Deletes textures that no resource used since the previous call, and the
+    // framebuffers that referenced them
+    void Trim();
+    void Shutdown();
+
+    size_t GetTextureCount() const { return m_textures.size(); }
+    size_t GetBytes() const;
+
+ private:
+    struct PooledTexture
+    {
+        GLuint texture;
+        RenderTargetDesc desc;
+        bool inUse;
+        bool used;  // since the last Trim()
+    };
+
+    struct CachedFramebuffer
+    {
+        std::array<GLuint, kMaxColorAttachments> colors;
+        GLuint depth;
+        GLuint framebuffer;
+    };
+
+    std::vector<PooledTexture> m_textures;
+    std::vector<CachedFramebuffer> m_framebuffers;
+};
+
+struct FrameGraphStats
+{
+    uint32_t passesDeclared   = 0;
+    uint32_t passesCulled     = 0;  // nothing reached the output or a side effect
+    uint32_t transientTargets = 0;  // resources created by passes that ran
+    uint32_t textures         = 0;  // pool textures backing them
+    uint64_t transientBytes   = 0;  // of those textures
+    uint64_t unaliasedBytes   = 0;  // if every resource had its own texture
+    uint32_t targetSwitches   = 0;  // framebuffer changes between passes
+};
+
+// Per-frame render pass graph. Passes declare the targets they create, read
+// (sample) and write (render into); the graph drops passes whose results never
+// reach an imported target or a side effect, orders the rest so every read sees
+// the latest earlier write, and backs transient targets with pool textures that
+// are handed on once their last reader has run.
+//
+// Declaration order is submission order: a read sees the nearest write declared
+// before it. Among passes that are free to go next, one that renders into the
+// same framebuffer as the previous pass is preferred, then declaration order.
+class FrameGraph
+{
+ public:
+    class PassBuilder
+    {
+     public:
+        // A new transient target; undefined until a pass writes it
+        FrameGraphResource Create(std::string const& name, RenderTargetDesc const& desc);
+        // Sampled by the pass
+        FrameGraphResource Read(FrameGraphResource resource);
+        // Attached to the pass's framebuffer, on top of what earlier writers left
+        FrameGraphResource Write(FrameGraphResource resource);
+        // Keeps the pass even if nothing reads what it writes
+        void SetSideEffect();
+
+     private:
+        friend class FrameGraph;
+
+        PassBuilder(FrameGraph& graph, size_t pass) : m_graph(graph), m_pass(pass) {}
+
+        FrameGraph& m_graph;
+        size_t m_pass;
+    };
+
+    class PassContext
+    {
+     public:
+        // Texture behind a resource the pass reads
+        GLuint GetTexture(FrameGraphResource resource) const;
+        // Size of the framebuffer the pass renders into; the viewport is set to it
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+
+     private:
+        friend class FrameGraph;
+
+        PassContext(FrameGraph const& graph, int width, int height) :
+            m_graph(graph),
+            m_width(width),
+            m_height(height)
+        {}
+
+        FrameGraph const& m_graph;
+        int m_width;
+        int m_height;
+    };
+
+    using SetupFunction   = std::function<void(PassBuilder&)>;
+    using ExecuteFunction = std::function<void(PassContext const&)>;
+
+    explicit FrameGraph(RenderTargetPool& pool);
+
+    FrameGraph(FrameGraph const&)            = delete;
+    FrameGraph& operator=(FrameGraph const&) = delete;
+
+    // An existing framebuffer, such as the renderer's output. Passes that write
+    // imported targets are the roots culling starts from.
+    FrameGraphResource Import(std::string const& name, GLuint framebuffer, int width, int height);
+
+    // Runs setup immediately, so its handles are available to later passes
+    void AddPass(std::string const& name, SetupFunction const& setup, ExecuteFunction execute);
+
+    // Culls, orders and assigns textures. Fails on a read of a transient target
+    // nothing wrote, a pass that reads what it writes, or a pass whose writes
+    // cannot form one framebuffer: an imported target alongside others, more
+    // than kMaxColorAttachments colors or one depth, or mismatched sizes.
+    bool Compile();
+    // Compiles if needed, then runs the passes. Leaves the last pass's
+    // framebuffer bound.
+    bool Execute();
+    // Forgets passes and resources; the pool keeps its textures
+    void Reset();
+
+    FrameGraphStats const& GetStats() const { return m_stats; }
+    // Passes in execution order after Compile(), culled ones left out
+    std::vector<std::string> GetExecutionOrder() const;
+    bool IsCulled(std::string const& pass) const;
+    // Pool texture assigned to a transient resource by Compile()
+    GLuint GetTexture(FrameGraphResource resource) const { return m_resources[resource].texture; }
+
+ private:
+    struct Resource
+    {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported;
+        GLuint framebuffer;  // imported only
+        GLuint texture;      // transient only, once compiled
+        int firstUse;  // positions in m_order
+        int lastUse;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteFunction execute;
+        std::vector<FrameGraphResource> reads;
+        std::vector<FrameGraphResource> writes;
+        std::vector<size_t> producers;  // passes whose output this one consumes
+        std::vector<size_t> after;      // every pass that must run first
+        bool sideEffect;
+        bool culled;
+    };
+
+    bool Link();
+    void Cull();
+    void Schedule();
+    void Allocate();
+    bool SameTarget(Pass const& a, Pass const& b) const;
+    void ReleaseTextures();
+
+    RenderTargetPool& m_pool;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<size_t> m_order;
+    bool m_compiled;
+    FrameGraphStats m_stats;
+};
+
+}  // namespace SpatialRender
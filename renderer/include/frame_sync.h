@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+namespace SpatialRender
+{
+
+// Bounds how far the CPU may run ahead of the GPU. Every frame ends with a
+// fence in its slot of an N-entry ring; starting a frame waits only for the
+// fence of the frame that last used the same slot, i.e. N frames back. Per-frame
+// resources indexed by GetFrameSlot() are then safe to overwrite.
+class FrameSync
+{
+ public:
+    static constexpr int kMaxFramesInFlight = 4;
+
+    explicit FrameSync(int framesInFlight = 2);
+
+    FrameSync(FrameSync const&)            = delete;
+    FrameSync& operator=(FrameSync const&) = delete;
+
+    // Drains the ring before changing its size
+    void SetFramesInFlight(int count);
+    int GetFramesInFlight() const { return m_framesInFlight; }
+
+    // Waits for the slot's previous frame, then returns the slot to use
+    int BeginFrame();
+    void EndFrame();
+
+    // Blocks until every submitted frame has finished and releases the fences.
+    // Must be called while the context is still current.
+    void WaitIdle();
+
+    int GetFrameSlot() const { return m_slot; }
+    uint64_t GetFrameIndex() const { return m_frameIndex; }
+
+    // CPU time spent blocked in the last BeginFrame()
+    double GetLastWaitMs() const { return m_lastWaitMs; }
+
+ private:
+    void Wait(int slot);
+
+    std::array<GLsync, kMaxFramesInFlight> m_fences;
+    int m_framesInFlight;
+    int m_slot;
+    uint64_t m_frameIndex;
+    double m_lastWaitMs;
+};
+
+}  // namespace SpatialRender
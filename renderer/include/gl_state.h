@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+namespace SpatialRender
+{
+
+// Per-frame counters of state-changing GL calls and of the work submitted
+// through the cache
+struct GLStateStats
+{
+    uint64_t issuedCalls = 0;
+    uint64_t elidedCalls = 0;
+
+    uint64_t programSwitches  = 0;  // issued UseProgram calls
+    uint64_t vertexArrayBinds = 0;  // issued BindVertexArray calls
+    uint64_t drawCalls        = 0;
+    uint64_t triangles        = 0;  // summed over instances
+    uint64_t vertices         = 0;  // summed over instances
+    uint64_t uniformUploads   = 0;
+    uint64_t bufferBytes      = 0;  // data passed to BufferData and BufferSubData
+};
+
+// Shadow copy of the GL binding and enable state for the current context.
+// All binds and enables in the renderer go through this cache so that calls
+// which would not change driver state are dropped before reaching the driver.
+// Raw GL calls that change tracked state must be followed by Invalidate().
+class GLStateCache
+{
+ public:
+    static GLStateCache& Get();
+
+    // Forget all tracked state; the next call of every kind is issued
+    void Invalidate();
+
+    void ResetStats();
+    GLStateStats const& GetStats() const { return m_stats; }
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindFramebuffer(GLenum target, GLuint framebuffer);
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    void Enable(GLenum cap);
+    void Disable(GLenum cap);
+    void DepthFunc(GLenum func);
+    void DepthMask(GLboolean enabled);
+    void ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a);
+    void CullFace(GLenum mode);
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+
+    // Counted pass-throughs; an instance count above one issues the instanced form
+    void DrawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount = 1);
+    void DrawElements(GLenum mode,
+                      GLsizei count,
+                      GLenum type,
+                      void const* indices,
+                      GLsizei instanceCount = 1);
+    void BufferData(GLenum target, GLsizeiptr size, void const* data, GLenum usage);
+    void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void const* data);
+
+    // Uniforms are set directly on the program; callers report each upload
+    void CountUniformUpload() { ++m_stats.uniformUploads; }
+
+    // Deleting through the cache keeps it from eliding a bind of a recycled name
+    void DeleteProgram(GLuint program);
+    void DeleteVertexArray(GLuint vao);
+    void DeleteBuffer(GLuint buffer);
+    void DeleteFramebuffer(GLuint framebuffer);
+    void DeleteTexture(GLuint texture);
+
+    GLuint GetProgram() const { return m_program; }
+    GLuint GetVertexArray() const { return m_vertexArray; }
+
+ private:
+    GLStateCache();
+
+    // Returns true if the call must be issued and records the new value
+    template <typename T>
+    bool Update(T& cached, T const& value);
+    void SetEnabled(GLenum cap, bool enabled);
+    void CountDraw(GLenum mode, GLsizei count, GLsizei instanceCount);
+
+    static constexpr GLuint kUnknown = 0xFFFFFFFFu;
+
+    enum BufferSlot
+    {
+        kArrayBuffer,
+        kElementArrayBuffer,
+        kUniformBuffer,
+        kTextureBuffer,
+        kPixelPackBuffer,
+        kPixelUnpackBuffer,
+        kCopyReadBuffer,
+        kCopyWriteBuffer,
+        kBufferSlotCount
+    };
+    static int GetBufferSlot(GLenum target);
+
+    static constexpr GLuint kTrackedTextureUnits = 16;
+    enum TextureSlot
+    {
+        kTarget2D,
+        kTarget2DArray,
+        kTargetBuffer,
+        kTextureSlotCount
+    };
+    static int GetTextureSlot(GLenum target);
+
+    struct CapState
+    {
+        GLenum cap;
+        int8_t enabled;  // -1 = unknown
+    };
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    std::array<GLuint, kBufferSlotCount> m_buffers;
+    GLuint m_drawFramebuffer;
+    GLuint m_readFramebuffer;
+    GLuint m_activeTextureUnit;
+    std::array<std::array<GLuint, kTextureSlotCount>, kTrackedTextureUnits> m_textures;
+
+    std::array<CapState, 8> m_caps;
+    GLenum m_depthFunc;
+    GLint m_depthMask;
+    std::array<GLint, 4> m_colorMask;
+    GLenum m_cullFace;
+    std::array<GLint, 4> m_viewport;
+    std::array<GLfloat, 4> m_clearColor;
+
+    GLStateStats m_stats;
+};
+
+}  // namespace SpatialRender
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+
+#include <GL/glew.h>
+
+#include "frame_sync.h"
+
+namespace SpatialRender
+{
+
+// GPU duration of a frame, measured with one GL_TIME_ELAPSED query per
+// frames-in-flight slot. A slot's result is read back when the slot is reused,
+// after FrameSync has waited on its fence, so reading never stalls.
+class GpuTimer
+{
+ public:
+    static constexpr int kSlotCount = FrameSync::kMaxFramesInFlight;
+
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(GpuTimer const&)            = delete;
+    GpuTimer& operator=(GpuTimer const&) = delete;
+
+    bool Initialize();
+    void Shutdown();
+
+    // Collects the slot's previous result, then starts a new span in it.
+    // Spans may not nest.
+    void Begin(int slot);
+    void End();
+
+    // Returns true and the newest duration if one was collected since last call
+    bool Poll(double& milliseconds);
+
+ private:
+    std::array<GLuint, kSlotCount> m_queries;
+    std::array<bool, kSlotCount> m_issued;
+    int m_activeSlot;  // -1 when no span is open
+    double m_latestMs;
+    bool m_hasResult;
+    bool m_initialized;
+};
+
+}  // namespace SpatialRender
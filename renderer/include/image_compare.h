@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SpatialRender
+{
+
+// Tightly packed RGBA8 pixels, top row first
+struct ImageView
+{
+    uint8_t const* pixels = nullptr;
+    int width             = 0;
+    int height            = 0;
+};
+
+struct ImageCompareOptions
+{
+    int channelTolerance      = 2;  // largest per-channel difference that still matches
+    bool compareAlpha         = false;
+    double maxMismatchPercent = 0.1;  // of all pixels
+    double minSsim            = 0.98;
+};
+
+struct ImageCompareResult
+{
+    bool passed            = false;
+    bool sizeMatches       = false;
+    uint64_t mismatched    = 0;  // pixels with any channel beyond the tolerance
+    double mismatchPercent = 0.0;
+    int maxChannelDelta    = 0;
+    double mse             = 0.0;  // over the compared channels
+    double psnr            = 0.0;  // dB; infinite for identical images
+    double ssim            = 0.0;  // mean SSIM of the luma over 8x8 windows
+};
+
+// Compares two images with SSE2 kernels where available. Images of different
+// sizes fail without being resampled.
+ImageCompareResult CompareImages(ImageView const& actual,
+                                 ImageView const& expected,
+                                 ImageCompareOptions const& options = ImageCompareOptions());
+
+// Mismatched pixels in red over a dimmed copy of the expected image
+void BuildDiffImage(ImageView const& actual,
+                    ImageView const& expected,
+                    int channelTolerance,
+                    std::vector<uint8_t>& diff);
+
+// PNG helpers; pixels are RGBA8
+bool LoadImageRGBA(std::string const& path, std::vector<uint8_t>& pixels, int& width, int& height);
+bool SaveImageRGBA(std::string const& path, ImageView const& image);
+
+}  // namespace SpatialRender
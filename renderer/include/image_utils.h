@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace SpatialRender
+{
+
+// Reverses the row order of a tightly packed image in place. glReadPixels
+// returns rows bottom-up; image files and comparisons expect them top-down.
+void FlipRowsVertically(uint8_t* pixels, int width, int height, int channels);
+
+}  // namespace SpatialRender
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "frame_sync.h"
+#include "texture.h"
+
+namespace SpatialRender
+{
+
+class Shader;
+
+using MaterialId = uint32_t;
+
+constexpr MaterialId kNoMaterial = 0xFFFFFFFFu;
+
+struct Material
+{
+    glm::vec3 color = glm::vec3(1.0f);
+    int32_t texture = -1;  // handle from MaterialLibrary::AddTexture(), -1 for none
+};
+
+// Materials and the texture arrays they sample. The table reaches the shaders
+// as a buffer texture with one texel per material (color, then array layer or
+// -1), so a draw looks each instance's material up by ID instead of taking
+// per-object uniforms. Objects whose materials share a texture array, program
+// and mesh can therefore go out as one instanced draw.
+class MaterialLibrary
+{
+ public:
+    // Low units are for material textures; lighting and instances take the high ones
+    static constexpr GLuint kTextureArrayUnit  = 1;
+    static constexpr GLuint kMaterialTableUnit = 12;
+    static constexpr int kLayersPerArray       = 64;
+
+    MaterialLibrary();
+    ~MaterialLibrary();
+
+    MaterialLibrary(MaterialLibrary const&)            = delete;
+    MaterialLibrary& operator=(MaterialLibrary const&) = delete;
+
+    // Copies image into the first array of matching format and size with a
+    // free layer, creating one if needed. Returns a texture handle for
+    // Material::texture, or -1. Needs a current context.
+    int32_t AddTexture(TextureImage const& image);
+
+    MaterialId AddMaterial(Material const& material);
+    void SetMaterial(MaterialId id, Material const& material);
+    Material const& GetMaterial(MaterialId id) const { return m_materials[id]; }
+    size_t GetMaterialCount() const { return m_materials.size(); }
+    // Incremented by every material change
+    uint64_t GetRevision() const { return m_revision; }
+
+    // Index of the array a material samples, -1 if it is untextured
+    int GetTextureArrayIndex(MaterialId id) const;
+    size_t GetTextureArrayCount() const { return m_arrays.size(); }
+    TextureArray const& GetTextureArray(size_t index) const { return *m_arrays[index]; }
+
+    static int32_t MakeTextureHandle(int arrayIndex, int layer) { return arrayIndex << 16 | layer; }
+    static int GetArrayIndex(int32_t texture) { return texture < 0 ? -1 : texture >> 16; }
+    static int GetLayer(int32_t texture) { return texture < 0 ? -1 : texture & 0xFFFF; }
+
+    // Packs one material into its table texel
+    static glm::vec4 PackMaterial(Material const& material);
+
+    // Uploads the table if it changed. Edits are expected to be rare, so there
+    // is a single buffer rather than one per frame in flight.
+    void Update();
+    // Binds the table and sets the material samplers on a program in use
+    void Apply(Shader& shader);
+    // -1 leaves the unit alone; untextured materials never sample it
+    void BindTextureArray(int index);
+
+    // Releases the table and texture arrays and forgets every material
+    void Shutdown();
+
+ private:
+    std::vector<Material> m_materials;
+    std::vector<std::unique_ptr<TextureArray>> m_arrays;
+    std::vector<glm::vec4> m_tableScratch;
+
+    GLuint m_tableBuffer;
+    GLuint m_tableTexture;
+    size_t m_tableCapacity;
+    bool m_dirty;
+    uint64_t m_revision;
+};
+
+// Per-instance data of batched draws: kTexelsPerInstance RGBA32F texels each,
+// the three rows of an affine model matrix and then the material ID's bits.
+// One buffer texture per frames-in-flight slot, like the light clusters. The
+// instance count per frame is bounded by GL_MAX_TEXTURE_BUFFER_SIZE, at least
+// 16384 instances on GL 3.3 and far more on desktop drivers.
+class InstanceBuffer
+{
+ public:
+    static constexpr GLuint kUnit              = 11;
+    static constexpr size_t kTexelsPerInstance = 4;
+
+    InstanceBuffer();
+    ~InstanceBuffer();
+
+    InstanceBuffer(InstanceBuffer const&)            = delete;
+    InstanceBuffer& operator=(InstanceBuffer const&) = delete;
+
+    bool Initialize();
+    void Shutdown();
+
+    // Starts a new list for the frame slot
+    void Begin(int frameSlot);
+    // Returns the instance's index
+    uint32_t Add(glm::mat4 const& model, MaterialId material);
+    // Fails, keeping nothing, if the instances exceed the buffer texture limit
+    bool Upload();
+    // Packed instances of the current list, for Restore() in a later frame
+    std::vector<glm::vec4> const& GetTexels() const { return m_data; }
+    // Replaces the list with texels from GetTexels()
+    void Restore(std::vector<glm::vec4> const& texels);
+    // Binds the slot's buffer and sets u_instanceData on a program in use
+    void Apply(Shader& shader);
+
+    size_t GetCount() const { return m_data.size() / kTexelsPerInstance; }
+
+    static void PackInstance(glm::mat4 const& model, MaterialId material, glm::vec4* texels);
+
+ private:
+    struct SlotBuffer
+    {
+        GLuint buffer   = 0;
+        GLuint texture  = 0;
+        size_t capacity = 0;
+    };
+
+    std::array<SlotBuffer, FrameSync::kMaxFramesInFlight> m_slots;
+    std::vector<glm::vec4> m_data;
+    int m_frameSlot;
+    size_t m_maxTexels;
+    bool m_initialized;
+};
+
+}  // namespace SpatialRender
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SpatialRender
+{
+
+enum class MemoryCategory
+{
+    VertexBuffer,
+    IndexBuffer,
+    TextureBuffer,  // buffer objects sampled through buffer textures
+    Texture,
+    Renderbuffer,
+    ShaderProgram,  // driver program binaries, where the size can be queried
+    MeshData,       // CPU copies of vertices and indices
+    FrameArena,     // per-frame scratch arenas, including framebuffer readbacks
+    StagingBuffer,  // pixel-unpack buffers used to stream texture levels
+    TextureData,    // CPU copies of texture mip chains
+    RenderTarget,   // pooled frame graph targets shared by transient resources
+    Count
+};
+
+// Namespace of an allocation id: a GL object name or, for Host, an address
+enum class MemoryResource
+{
+    Buffer,
+    Texture,
+    Renderbuffer,
+    Program,
+    Host
+};
+
+char const* GetMemoryCategoryName(MemoryCategory category);
+bool IsGpuMemoryCategory(MemoryCategory category);
+
+struct MemoryAllocation
+{
+    MemoryResource resource;
+    uint64_t id;
+    MemoryCategory category;
+    std::string owner;
+    size_t bytes;
+};
+
+struct MemoryUsage
+{
+    size_t liveBytes   = 0;
+    size_t peakBytes   = 0;
+    size_t allocations = 0;  // live
+};
+
+// Video memory as reported by GL_NVX_gpu_memory_info or GL_ATI_meminfo
+struct DeviceMemoryInfo
+{
+    bool available  = false;
+    int64_t totalKb = -1;  // dedicated video memory, NVX only
+    int64_t freeKb  = -1;
+};
+
+// Bookkeeping of the GPU and CPU memory owned by renderer resources, by
+// category and owner. Allocations are keyed by resource kind and id; recording
+// an existing key replaces it, so reallocating a buffer store is one call.
+// Thread-safe, but meant for load and resize paths rather than per-draw work.
+class MemoryTracker
+{
+ public:
+    static MemoryTracker& Get();
+
+    void Record(MemoryResource resource,
+                uint64_t id,
+                MemoryCategory category,
+                std::string const& owner,
+                size_t bytes);
+    void Release(MemoryResource resource, uint64_t id);
+
+    MemoryUsage GetUsage(MemoryCategory category) const;
+    MemoryUsage GetGpuUsage() const;
+    MemoryUsage GetCpuUsage() const;
+
+    // Live allocations, largest first
+    std::vector<MemoryAllocation> GetAllocations() const;
+
+    // Totals per category followed by every live allocation
+    void Dump(std::ostream& out) const;
+
+    // Restarts the peaks from the live totals
+    void ResetPeaks();
+    void Clear();
+
+ private:
+    MemoryTracker() = default;
+
+    void Add(MemoryCategory category, size_t bytes);
+    void Remove(MemoryCategory category, size_t bytes);
+
+    mutable std::mutex m_mutex;
+    std::map<std::pair<MemoryResource, uint64_t>, MemoryAllocation> m_allocations;
+    std::array<MemoryUsage, (size_t)MemoryCategory::Count> m_categories;
+    MemoryUsage m_gpu;
+    MemoryUsage m_cpu;
+};
+
+// Needs a current context; available is false when neither extension is exposed
+DeviceMemoryInfo QueryDeviceMemory();
+
+}  // namespace SpatialRender
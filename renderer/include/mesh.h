@@ -1,15 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "culling.h"
 #include "renderer.h"
 
 namespace SpatialRender
 {
 
+class CommandBuffer;
+
 class Mesh
 {
  public:
@@ -17,29 +22,62 @@ class Mesh
     ~Mesh();
 
     void SetVertices(std::vector<Vertex> const& vertices);
+    void SetVertices(std::vector<Vertex>&& vertices);
     void SetIndices(std::vector<unsigned int> const& indices);
+    void SetIndices(std::vector<unsigned int>&& indices);
 
     void Upload();
-    void Render();
+    // instanceCount > 1 issues an instanced draw (one instance per view)
+    void Render(int instanceCount = 1);
     void Cleanup();
 
+    // Draws with a position-only vertex stream, for depth-only passes
+    void RenderDepthOnly(int instanceCount = 1);
+
+    // Record the binds and draw of Render() and RenderDepthOnly(); buffers
+    // are uploaded now, so replaying needs no access to the mesh
+    void Record(CommandBuffer& commands, int instanceCount = 1);
+    void RecordDepthOnly(CommandBuffer& commands, int instanceCount = 1);
+
     size_t GetVertexCount() const { return m_vertices.size(); }
     size_t GetIndexCount() const { return m_indices.size(); }
 
+    std::vector<Vertex> const& GetVertices() const { return m_vertices; }
+    std::vector<unsigned int> const& GetIndices() const { return m_indices; }
+
+    // Object-space bounds of the vertex positions
+    AABB const& GetBounds() const { return m_bounds; }
+
+    GLuint GetVertexArray() const { return m_VAO; }
+    // Changes whenever the data or the GL objects a recorded draw uses change
+    uint64_t GetRevision() const { return m_revision; }
+
  private:
+    void UploadPositionStream();
+    void ReleasePositionStream();
+    void Draw(int instanceCount);
+    void RecordDraw(CommandBuffer& commands, int instanceCount);
+    void TrackHostMemory();
+
     std::vector<Vertex> m_vertices;
     std::vector<unsigned int> m_indices;
+    AABB m_bounds;
 
     GLuint m_VAO;
     GLuint m_VBO;
     GLuint m_EBO;
 
+    // Tightly packed positions sharing m_EBO, created on first depth-only draw
+    GLuint m_depthVAO;
+    GLuint m_positionVBO;
+
     bool m_uploaded;
+    uint64_t m_revision;
 };
 
-// Factory functions for common meshes
-Mesh* CreateCubeMesh();
-Mesh* CreateSphereMesh(int segments = 32);
-Mesh* CreatePlaneMesh(float width = 1.0f, float height = 1.0f);
+// Factory functions for common meshes; procedural.h has more surfaces
+std::unique_ptr<Mesh> CreateCubeMesh();
+std::unique_ptr<Mesh> CreateSphereMesh(int segments = 32);
+std::unique_ptr<Mesh> CreatePlaneMesh(float width = 1.0f, float height = 1.0f);
 
 }  // namespace SpatialRender
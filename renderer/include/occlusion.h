@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "culling.h"
+#include "scene.h"
+
+namespace SpatialRender
+{
+
+struct OcclusionStats
+{
+    size_t occluders         = 0;
+    size_t occluderTriangles = 0;
+    size_t objectsTested     = 0;
+    size_t frustumCulled     = 0;
+    size_t occlusionCulled   = 0;
+    double rasterizeMs       = 0.0;
+    double testMs            = 0.0;
+};
+
+// CPU software occlusion culling. Objects flagged as occluders are rasterized
+// into a low-resolution depth buffer, split into horizontal bands that are
+// filled in parallel. A per-tile max-depth level (HiZ) lets most occludee tests
+// finish without touching individual pixels.
+class OcclusionCuller
+{
+ public:
+    // Width must be a multiple of kTileWidth and height of kTileHeight
+    OcclusionCuller(int width = 256, int height = 144);
+
+    static constexpr int kTileWidth  = 8;
+    static constexpr int kTileHeight = 4;
+
+    // Rasterizes occluders and tests every object against the result
+    void Cull(std::vector<SceneObject> const& objects, glm::mat4 const& viewProj);
+
+    // One entry per object passed to the last Cull(); 0 = culled
+    std::vector<uint8_t> const& GetVisibility() const { return m_visibility; }
+    bool IsVisible(size_t index) const
+    {
+        return index < m_visibility.size() && m_visibility[index] != 0;
+    }
+
+    OcclusionStats const& GetStats() const { return m_stats; }
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+    // Depth in [0, 1] of the nearest occluder at a buffer pixel (y up)
+    float GetDepth(int x, int y) const { return m_depth[y * m_width + x]; }
+
+ private:
+    enum class TestResult
+    {
+        Visible,
+        FrustumCulled,
+        Occluded
+    };
+
+    struct ScreenTriangle
+    {
+        glm::vec3 v[3];  // buffer-space x, y and depth in [0, 1]
+        float minY;
+        float maxY;
+    };
+
+    void SetupOccluders(std::vector<SceneObject> const& objects, glm::mat4 const& viewProj);
+    void RasterizeBand(int tileRowBegin, int tileRowEnd);
+    void RasterizeTriangle(ScreenTriangle const& tri, int rowBegin, int rowEnd);
+    TestResult TestBounds(AABB const& worldBounds,
+                          glm::mat4 const& viewProj,
+                          Frustum const& frustum) const;
+
+    int m_width;
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+
+    std::vector<float> m_depth;
+    std::vector<float> m_tileMaxDepth;
+    std::vector<ScreenTriangle> m_triangles;
+    std::vector<glm::vec4> m_clipScratch;  // kept so setup does not allocate each frame
+    std::vector<uint8_t> m_visibility;
+
+    OcclusionStats m_stats;
+};
+
+}  // namespace SpatialRender
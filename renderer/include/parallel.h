@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SpatialRender
+{
+
+// Fixed set of worker threads for data-parallel CPU stages (culling, binning,
+// geometry generation). The calling thread participates in every Run(), so a
+// pool with zero workers degrades to a plain serial loop.
+class ThreadPool
+{
+ public:
+    // workerCount < 0 picks hardware_concurrency() - 1
+    explicit ThreadPool(int workerCount = -1);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    static ThreadPool& Global();
+
+    // Index of the calling thread within the pool; 0 for any non-worker thread
+    static unsigned CurrentThreadIndex();
+
+    // Number of threads that execute tasks, including the caller
+    unsigned GetThreadCount() const { return (unsigned)m_workers.size() + 1; }
+
+    // Runs task(taskIndex, threadIndex) for every taskIndex in [0, taskCount)
+    // and blocks until all have finished. threadIndex is in [0, GetThreadCount())
+    // and is stable for the duration of a task. Nested calls run serially.
+    void Run(size_t taskCount, std::function<void(size_t, unsigned)> const& task);
+
+ private:
+    void WorkerLoop(unsigned threadIndex);
+    void Execute(std::function<void(size_t, unsigned)> const& task,
+                 size_t taskCount,
+                 unsigned threadIndex);
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_runMutex;  // serializes concurrent Run() callers
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+
+    std::function<void(size_t, unsigned)> const* m_task;
+    size_t m_taskCount;
+    std::atomic<size_t> m_nextTask;
+    size_t m_completedTasks;
+    unsigned m_activeWorkers;
+    uint64_t m_generation;
+    bool m_stopping;
+};
+
+// Splits [0, count) into chunks of at least `grain` items and calls
+// fn(begin, end, threadIndex) for each chunk on the global pool.
+template <typename Fn>
+void ParallelFor(size_t count, size_t grain, Fn&& fn)
+{
+    if (count == 0)
+        return;
+
+    grain             = std::max<size_t>(grain, 1);
+    size_t chunkCount = (count + grain - 1) / grain;
+    if (chunkCount == 1)
+    {
+        fn(size_t(0), count, ThreadPool::CurrentThreadIndex());
+        return;
+    }
+
+    ThreadPool::Global().Run(chunkCount, [&](size_t chunk, unsigned thread) {
+        size_t begin = chunk * grain;
+        size_t end   = std::min(begin + grain, count);
+        fn(begin, end, thread);
+    });
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "renderer.h"
+
+namespace SpatialRender
+{
+
+class Mesh;
+
+// CPU geometry ready to hand to a Mesh without copying
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Parametric surfaces centred on the origin with +Y as their axis. Each call
+// sizes the buffers once and writes them in place: surfaces of revolution use
+// per-column sincos tables and an SSE2 row kernel, and tessellations large
+// enough to pay for it are split by rows across the global ThreadPool.
+// Triangles wind counter-clockwise seen from outside. Texture coordinates span
+// [0, 1] over the surface parameters, with the seam column duplicated.
+void GenerateSphere(MeshData& data, float radius, int segments, int rings);
+// rings is per hemisphere; height is the length of the cylindrical section
+void GenerateCapsule(MeshData& data, float radius, float height, int segments, int rings);
+// Closed with flat caps
+void GenerateCylinder(MeshData& data, float radius, float height, int segments, int stacks);
+// The ring lies in the XZ plane; sides tessellate the tube
+void GenerateTorus(MeshData& data, float majorRadius, float minorRadius, int segments, int sides);
+// Flat in the XZ plane, facing +Y
+void GenerateGrid(MeshData& data, float width, float depth, int columns, int rows);
+// Each icosahedron face is split 2^subdivisions times per edge and projected
+// onto the sphere. Faces are generated independently, so edge vertices are
+// duplicated between them; texture coordinates are equirectangular.
+void GenerateIcosphere(MeshData& data, float radius, int subdivisions);
+
+// Moves the data into a new mesh
+std::unique_ptr<Mesh> CreateMesh(MeshData&& data);
+
+std::unique_ptr<Mesh> CreateCapsuleMesh(float radius = 0.25f,
+                                        float height = 0.5f,
+                                        int segments = 32);
+std::unique_ptr<Mesh> CreateCylinderMesh(float radius = 0.5f,
+                                         float height = 1.0f,
+                                         int segments = 32);
+std::unique_ptr<Mesh> CreateTorusMesh(float majorRadius = 0.35f,
+                                      float minorRadius = 0.15f,
+                                      int segments      = 48);
+std::unique_ptr<Mesh> CreateGridMesh(float width = 1.0f, float depth = 1.0f, int divisions = 16);
+std::unique_ptr<Mesh> CreateIcosphereMesh(float radius = 0.5f, int subdivisions = 3);
+
+}  // namespace SpatialRender
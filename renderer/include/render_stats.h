@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace SpatialRender
+{
+
+// Work the renderer submitted between BeginFrame() and EndFrame(), summed over
+// every RenderScene() call in the frame
+struct RenderStats
+{
+    uint64_t drawCalls               = 0;
+    uint64_t triangles               = 0;  // summed over instances
+    uint64_t vertices                = 0;  // summed over instances
+    uint64_t programSwitches         = 0;
+    uint64_t vertexArrayBinds        = 0;
+    uint64_t uniformUploads          = 0;
+    uint64_t bufferBytesUploaded     = 0;
+    uint64_t objectsSubmitted        = 0;  // objects in the shading pass
+    uint64_t objectsCulled           = 0;  // frustum or occlusion culled
+    uint64_t scenesReplayed          = 0;  // RenderScene() calls served by retained mode
+    uint64_t lightsDropped           = 0;  // cluster entries over the per-cluster limit
+    uint64_t frameAllocatorHighWater = 0;  // bytes of per-frame scratch memory
+};
+
+}  // namespace SpatialRender
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "frame_allocator.h"
+#include "frame_graph.h"
+#include "gl_state.h"
+#include "image_compare.h"
+#include "render_stats.h"
+
 namespace SpatialRender
 {
 
@@ -14,6 +22,19 @@ class Shader;
 class Mesh;
 class Camera;
 class Scene;
+struct SceneObject;
+class OcclusionCuller;
+struct OcclusionStats;
+class ClusteredLighting;
+struct LightingStats;
+class FrameSync;
+class GpuTimer;
+class ResolutionController;
+class Texture;
+class TextureStreamer;
+class MaterialLibrary;
+class InstanceBuffer;
+class CommandBuffer;
 
 // Forward declarations
 struct Vertex
@@ -38,19 +59,234 @@ class Renderer
 
     void RenderScene(Scene& scene, Camera& camera);
 
+    // Renders up to kMaxViews cameras in one submission, side by side across
+    // the framebuffer in camera order. Each draw is instanced once per view and
+    // the vertex shader picks the view from gl_InstanceID, so culling, sorting
+    // and uniform updates happen once. Camera aspect ratios should match their
+    // slot (width / count by height). Reversed-Z cameras are rejected: the
+    // GL 3.3 pipeline keeps the default [-1, 1] clip depth range.
+    void RenderSceneMultiView(Scene& scene, std::vector<Camera> const& cameras);
+
+    static constexpr int kMaxViews = 4;
+
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
 
+    // Issued vs. elided state calls since the last BeginFrame()
+    GLStateStats const& GetStateStats() const;
+
+    // Counters of the last completed frame, updated by EndFrame()
+    RenderStats const& GetRenderStats() const { return m_renderStats; }
+
+    // Scratch memory reset by BeginFrame(); allocations stay valid until then
+    FrameAllocator& GetFrameAllocator() { return *m_frameAllocator; }
+
+    // CPU occlusion culling of objects hidden behind those marked as occluders
+    void SetOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+    bool IsOcclusionCullingEnabled() const { return m_occlusionCulling; }
+    OcclusionStats const& GetOcclusionStats() const;
+
+    // Opaque draws are ordered front-to-back within each shader bucket
+    void SetDepthSorting(bool enabled) { m_depthSorting = enabled; }
+    bool IsDepthSortingEnabled() const { return m_depthSorting; }
+
+    // Lays down depth with a position-only pass, then shades with GL_EQUAL.
+    // Requires shaders to compute gl_Position as u_viewProj * model * position,
+    // with model from u_model or, in batched draws, from u_instanceData.
+    void SetDepthPrepass(bool enabled) { m_depthPrepass = enabled; }
+    bool IsDepthPrepassEnabled() const { return m_depthPrepass; }
+
+    // Keeps the draw stream RenderScene() records and replays it while the
+    // scene's objects, the cameras, the materials and the settings above are
+    // unchanged, so culling, sorting, batching and uniform lookups are skipped.
+    // Only view, lighting and instance bindings are set anew each frame. One
+    // recording is kept: alternating scenes or cameras re-record every call.
+    // Meshes, shaders and textures re-uploaded or reloaded in place are
+    // noticed through their revisions and re-recorded too.
+    void SetRetainedMode(bool enabled);
+    bool IsRetainedModeEnabled() const { return m_retainedMode; }
+    void InvalidateRecording();
+
+    // The CPU may queue at most this many frames (1-4) ahead of the GPU.
+    // BeginFrame() blocks until the frame slot it reuses has been retired.
+    void SetFramesInFlight(int count);
+    int GetFramesInFlight() const;
+    int GetFrameSlot() const { return m_frameSlot; }
+
+    // CPU time the last BeginFrame() spent blocked on the GPU
+    double GetFrameWaitMs() const;
+
+    // Renders into an internal target whose size follows the measured GPU frame
+    // time, then upscales it to the output with a linear blit in EndFrame()
+    void SetDynamicResolution(bool enabled, float targetFrameMs = 16.6f);
+    bool IsDynamicResolutionEnabled() const { return m_dynamicResolution; }
+    ResolutionController& GetResolutionController() { return *m_resolutionController; }
+
+    // Scale and size used for the current frame
+    float GetRenderScale() const { return m_renderScale; }
+    int GetRenderWidth() const { return m_renderWidth; }
+    int GetRenderHeight() const { return m_renderHeight; }
+
+    // GPU time from BeginFrame() to EndFrame() of the frame that last used the
+    // current slot; 0 until the first measurement arrives
+    double GetGpuFrameMs() const { return m_gpuFrameMs; }
+
+    // Point and spot lights binned into a froxel grid each frame
+    LightingStats const& GetLightingStats() const;
+
+    // Streams the mip levels of added textures in BeginFrame()
+    TextureStreamer& GetTextureStreamer() { return *m_textureStreamer; }
+    // Texture unit of SceneObject::texture, sampled as u_albedo
+    static constexpr GLuint kAlbedoUnit = 0;
+
+    // Objects with a SceneObject::material are drawn in instanced batches, one
+    // per program, texture array and mesh; see MaterialLibrary
+    MaterialLibrary& GetMaterials() { return *m_materials; }
+
+    // Pass graph for the frame, emptied by BeginFrame(). Its transient targets
+    // come from a pool that EndFrame() trims of textures the frame left unused.
+    FrameGraph& GetFrameGraph() { return *m_frameGraph; }
+    RenderTargetPool& GetRenderTargets() { return *m_renderTargets; }
+    // Imports the framebuffer the frame is rendering to, at the render size
+    FrameGraphResource ImportOutput(FrameGraph& graph);
+
     // Framebuffer capture for testing
     void CaptureFramebuffer(std::vector<uint8_t>& pixels);
+    // Captures into the frame allocator; the pixels are valid until the next
+    // BeginFrame()
+    ImageView CaptureFramebuffer();
     bool SaveFramebufferToFile(std::string const& path);
 
  private:
+    struct DrawItem
+    {
+        uint64_t sortKey;
+        uint32_t objectIndex;
+    };
+
+    // Material objects drawn by one instanced call
+    struct DrawBatch
+    {
+        uint32_t objectIndex;  // first object; supplies the shader and mesh
+        uint32_t instanceBase;
+        uint32_t instanceCount;
+        int textureArray;
+    };
+
+    // What a retained draw stream was recorded from
+    struct Recording
+    {
+        bool valid = false;
+        uint64_t sceneRevision    = 0;
+        uint64_t materialRevision = 0;
+        size_t viewCount          = 0;
+        std::array<glm::mat4, kMaxViews> views;
+        std::array<glm::mat4, kMaxViews> viewProjs;
+        bool occlusionCulling = false;
+        bool depthSorting     = false;
+        bool depthPrepass     = false;
+
+        std::vector<glm::vec4> instances;             // replayed into each frame's slot
+        std::vector<Texture const*> pendingTextures;  // not yet resident when recorded
+
+        // Revisions of every resource whose GL names the stream holds
+        std::vector<std::pair<Mesh const*, uint64_t>> meshes;
+        std::vector<std::pair<Shader const*, uint64_t>> shaders;
+        std::vector<std::pair<Texture const*, uint64_t>> textures;
+        uint64_t objectsSubmitted = 0;
+        uint64_t objectsCulled    = 0;
+    };
+
+    void RenderViews(Scene& scene, Camera const* cameras, size_t viewCount);
+    // Records the draws of RenderViews() into m_commands
+    void RecordViews(Scene& scene,
+                     Camera const* cameras,
+                     size_t viewCount,
+                     glm::mat4 const* views,
+                     glm::mat4 const* viewProjs);
+    bool IsRecordingCurrent(Scene const& scene,
+                            glm::mat4 const* views,
+                            glm::mat4 const* viewProjs,
+                            size_t viewCount) const;
+    void SetViewUniforms(Shader& shader,
+                         glm::mat4 const* views,
+                         glm::mat4 const* viewProjs,
+                         size_t viewCount);
+    // Per-object visibility against the union of the views, in the frame allocator
+    uint8_t const* CullViews(std::vector<SceneObject> const& objects,
+                             Camera const* cameras,
+                             size_t viewCount);
+    // Returns the number of drawable objects rejected by the visibility list.
+    // With batchItems, objects that have a material go there instead.
+    size_t BuildDrawList(std::vector<SceneObject> const& objects,
+                         glm::mat4 const& view,
+                         bool depthOnlyOrder,
+                         uint8_t const* visibility,
+                         FrameVector<DrawItem>& drawList,
+                         FrameVector<DrawItem>* batchItems = nullptr);
+    void SortDrawList(FrameVector<DrawItem>& drawList);
+    // Groups batch items into batches and uploads their instance data, which
+    // must have been started with InstanceBuffer::Begin(). Records each
+    // object's instance in instanceSlots; false if the upload failed.
+    bool BuildBatches(std::vector<SceneObject> const& objects,
+                      FrameVector<DrawItem>& batchItems,
+                      FrameVector<DrawBatch>& batches,
+                      uint32_t* instanceSlots);
+    bool HasMaterial(SceneObject const& object) const;
+    void ReadFramebuffer(uint8_t* pixels);
+
+    bool CreateSceneTarget();
+    void DestroySceneTarget();
+    void UpdateRenderSize();
+
     int m_width;
     int m_height;
     bool m_initialized;
 
     GLuint m_defaultFBO;
+
+    bool m_occlusionCulling;
+    std::unique_ptr<OcclusionCuller> m_occlusionCuller;
+
+    bool m_depthSorting;
+    bool m_depthPrepass;
+    std::unique_ptr<Shader> m_depthShader;
+
+    std::unique_ptr<FrameAllocator> m_frameAllocator;
+
+    RenderStats m_renderStats;
+    uint64_t m_objectsSubmitted;
+    uint64_t m_objectsCulled;
+
+    std::unique_ptr<ClusteredLighting> m_lighting;
+    uint64_t m_lightsDropped;
+
+    std::unique_ptr<FrameSync> m_frameSync;
+    int m_frameSlot;
+
+    std::unique_ptr<TextureStreamer> m_textureStreamer;
+    std::unique_ptr<MaterialLibrary> m_materials;
+    std::unique_ptr<InstanceBuffer> m_instances;
+    std::unique_ptr<RenderTargetPool> m_renderTargets;
+    std::unique_ptr<FrameGraph> m_frameGraph;
+
+    bool m_retainedMode;
+    std::unique_ptr<CommandBuffer> m_commands;
+    Recording m_recording;
+    uint64_t m_scenesReplayed;
+
+    bool m_dynamicResolution;
+    std::unique_ptr<ResolutionController> m_resolutionController;
+    std::unique_ptr<GpuTimer> m_gpuTimer;
+    double m_gpuFrameMs;
+    float m_renderScale;
+    int m_renderWidth;
+    int m_renderHeight;
+
+    // Full-size target; frames render into its lower-left render-size region
+    GLuint m_sceneFBO;
+    GLuint m_sceneColor;
+    GLuint m_sceneDepth;
 };
 
 }  // namespace SpatialRender
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "material.h"
 #include "mesh.h"
 #include "shader.h"
+#include "texture.h"
 
 namespace SpatialRender
 {
@@ -15,10 +18,47 @@ struct SceneObject
 {
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Shader> shader;
+    std::shared_ptr<Texture> texture;  // multiplies color when resident
     glm::mat4 transform;
     glm::vec3 color;
+    MaterialId material;  // replaces color and texture unless kNoMaterial
+    bool occluder;        // rasterized into the software occlusion buffer
 
-    SceneObject() : transform(1.0f), color(1.0f, 1.0f, 1.0f) {}
+    SceneObject() :
+        transform(1.0f),
+        color(1.0f, 1.0f, 1.0f),
+        material(kNoMaterial),
+        occluder(false)
+    {}
+};
+
+enum class LightType
+{
+    Point,
+    Spot
+};
+
+struct Light
+{
+    LightType type;
+    glm::vec3 position;
+    glm::vec3 direction;  // spot lights only
+    glm::vec3 color;
+    float intensity;
+    float range;           // influence ends smoothly at this distance
+    float innerConeAngle;  // degrees, spot lights only
+    float outerConeAngle;
+
+    Light() :
+        type(LightType::Point),
+        position(0.0f),
+        direction(0.0f, -1.0f, 0.0f),
+        color(1.0f),
+        intensity(1.0f),
+        range(10.0f),
+        innerConeAngle(20.0f),
+        outerConeAngle(30.0f)
+    {}
 };
 
 class Scene
@@ -32,13 +72,39 @@ class Scene
                    glm::mat4 const& transform = glm::mat4(1.0f),
                    glm::vec3 const& color     = glm::vec3(1.0f));
 
+    void SetOccluder(size_t index, bool occluder);
+    void SetTexture(size_t index, std::shared_ptr<Texture> texture);
+    // An ID from the renderer's MaterialLibrary
+    void SetMaterial(size_t index, MaterialId material);
+
+    void AddLight(Light const& light);
+    void AddPointLight(glm::vec3 const& position,
+                       glm::vec3 const& color,
+                       float intensity,
+                       float range);
+    void AddSpotLight(glm::vec3 const& position,
+                      glm::vec3 const& direction,
+                      glm::vec3 const& color,
+                      float intensity,
+                      float range,
+                      float innerConeAngle,
+                      float outerConeAngle);
+
     void Clear();
 
     std::vector<SceneObject> const& GetObjects() const { return m_objects; }
     size_t GetObjectCount() const { return m_objects.size(); }
+    // Changes whenever objects are added, edited or cleared, and differs
+    // between scenes; lights are not included
+    uint64_t GetRevision() const { return m_revision; }
+
+    std::vector<Light> const& GetLights() const { return m_lights; }
+    size_t GetLightCount() const { return m_lights.size(); }
 
  private:
     std::vector<SceneObject> m_objects;
+    std::vector<Light> m_lights;
+    uint64_t m_revision;
 };
 
 }  // namespace SpatialRender
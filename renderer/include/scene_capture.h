@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "renderer.h"
+#include "scene.h"
+
+namespace SpatialRender
+{
+
+class Camera;
+
+struct CapturedCamera
+{
+    glm::vec3 position;
+    glm::vec3 target;
+    glm::vec3 up;
+    float fov;
+    float aspect;
+    float near;
+    float far;
+    bool orthographic;
+    bool reversedZ;
+    glm::vec4 orthographicBounds;  // left, right, bottom, top
+
+    static CapturedCamera FromCamera(Camera const& camera);
+    void ApplyTo(Camera& camera) const;
+};
+
+// A scene and the cameras that viewed it, frame by frame, in a compact binary
+// file, so a workload can be replayed away from the application that built it.
+// Vertex and index data is stored once per content hash; objects keep pointing
+// at distinct meshes and shaders, so a replay binds and switches programs as
+// often as the original did. Shaders are stored as source.
+//
+// Objects, lights, transforms, colors and occluder flags are captured;
+// textures and materials are not. The file is in host byte order.
+class SceneCapture
+{
+ public:
+    static constexpr uint32_t kVersion = 1;
+
+    SceneCapture();
+
+    // Replaces the captured objects and lights; the camera path is kept
+    void CaptureScene(Scene const& scene);
+    // Appends a frame seen by 1 to Renderer::kMaxViews cameras
+    void AddFrame(Camera const* cameras, size_t count);
+    void AddFrame(Camera const& camera) { AddFrame(&camera, 1); }
+    void SetResolution(int width, int height);
+
+    std::vector<uint8_t> Serialize() const;
+    // Fails without changing the capture if data is truncated, corrupt or not
+    // a capture. Mesh data must hash to its stored hash and index only its
+    // own vertices, whole triangles at a time.
+    bool Deserialize(uint8_t const* data, size_t size);
+    bool Save(std::string const& path) const;
+    bool Load(std::string const& path);
+
+    // Recreates the meshes and compiles the shaders, then adds the objects and
+    // lights to scene. Needs a current context.
+    bool BuildScene(Scene& scene) const;
+    // Cameras of a frame; indices past the end wrap around
+    void GetFrame(size_t frame, std::vector<Camera>& cameras) const;
+
+    size_t GetFrameCount() const { return m_frames.size(); }
+    size_t GetObjectCount() const { return m_objects.size(); }
+    size_t GetMeshCount() const { return m_meshes.size(); }
+    size_t GetMeshDataCount() const { return m_meshData.size(); }
+    size_t GetShaderCount() const { return m_shaders.size(); }
+    size_t GetLightCount() const { return m_lights.size(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+    // FNV-1a over the vertex and index bytes
+    static uint64_t HashMesh(Mesh const& mesh);
+
+ private:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    struct MeshData
+    {
+        uint64_t hash;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    struct ShaderSource
+    {
+        std::string vertex;
+        std::string fragment;
+    };
+
+    struct CapturedObject
+    {
+        uint32_t mesh;    // index into m_meshes, or kNone
+        uint32_t shader;  // index into m_shaders, or kNone
+        glm::mat4 transform;
+        glm::vec3 color;
+        bool occluder;
+    };
+
+    static uint64_t HashMeshData(std::vector<Vertex> const& vertices,
+                                 std::vector<unsigned int> const& indices);
+    static bool IsValidMeshData(MeshData const& mesh);
+
+    std::vector<MeshData> m_meshData;
+    std::vector<uint32_t> m_meshes;  // mesh data of each distinct Mesh
+    std::vector<ShaderSource> m_shaders;
+    std::vector<CapturedObject> m_objects;
+    std::vector<Light> m_lights;
+    std::vector<std::vector<CapturedCamera>> m_frames;
+    int m_width;
+    int m_height;
+};
+
+}  // namespace SpatialRender
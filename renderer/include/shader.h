@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -25,9 +27,19 @@ class Shader
     void SetUniform(std::string const& name, glm::vec3 const& value);
     void SetUniform(std::string const& name, glm::vec4 const& value);
     void SetUniform(std::string const& name, glm::mat4 const& value);
+    void SetUniform(std::string const& name, glm::mat4 const* values, int count);
+
+    // -1 if the program has no such active uniform; cached after the first lookup
+    GLint GetUniformLocation(std::string const& name);
 
     GLuint GetProgram() const { return m_program; }
     bool IsValid() const { return m_program != 0; }
+    // Changes whenever a load replaces the program
+    uint64_t GetRevision() const { return m_revision; }
+
+    // Sources of the linked program, empty until a load succeeds
+    std::string const& GetVertexSource() const { return m_vertexSource; }
+    std::string const& GetFragmentSource() const { return m_fragmentSource; }
 
  private:
     GLuint CompileShader(GLenum type, std::string const& source);
@@ -37,6 +49,10 @@ class Shader
 
     GLuint m_program;
     bool m_linked;
+    uint64_t m_revision;
+    std::unordered_map<std::string, GLint> m_uniformLocations;
+    std::string m_vertexSource;
+    std::string m_fragmentSource;
 };
 
 }  // namespace SpatialRender
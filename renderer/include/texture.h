@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace SpatialRender
+{
+
+// Formats uploaded as stored. Block-compressed data goes to the driver as is;
+// there is no CPU decoder, so a format the context lacks fails to load.
+enum class TextureFormat
+{
+    RGBA8,
+    BC1,  // RGB with 1-bit alpha, 4 bpp
+    BC2,
+    BC3,
+    BC4,   // single channel
+    BC5,   // two channels, e.g. normal maps
+    BC6H,  // unsigned half-float RGB
+    BC7,
+    ETC2_RGB8,
+    ETC2_RGBA8,
+    Count
+};
+
+struct TextureFormatInfo
+{
+    char const* name;
+    GLenum internalFormat;
+    GLenum srgbInternalFormat;  // 0 if the format has no sRGB variant
+    uint32_t blockWidth;
+    uint32_t blockHeight;
+    uint32_t blockBytes;
+};
+
+TextureFormatInfo const& GetTextureFormatInfo(TextureFormat format);
+// Needs a current context
+bool IsTextureFormatSupported(TextureFormat format);
+size_t GetTextureLevelBytes(TextureFormat format, uint32_t width, uint32_t height);
+
+struct TextureLevel
+{
+    uint32_t width;
+    uint32_t height;
+    size_t offset;  // into TextureImage::data
+    size_t bytes;
+};
+
+// A 2D mip chain as stored in a container, level 0 first
+struct TextureImage
+{
+    TextureFormat format = TextureFormat::RGBA8;
+    bool srgb            = false;
+    std::vector<TextureLevel> levels;
+    std::vector<uint8_t> data;
+
+    uint32_t GetWidth() const { return levels.empty() ? 0 : levels[0].width; }
+    uint32_t GetHeight() const { return levels.empty() ? 0 : levels[0].height; }
+    uint8_t const* GetLevelData(size_t level) const { return data.data() + levels[level].offset; }
+};
+
+// KTX2 and DDS readers for single 2D images. Supercompressed KTX2 (Basis,
+// zstd), arrays, cubemaps and volumes are rejected with a message on stderr.
+bool ParseKTX2(uint8_t const* bytes, size_t size, TextureImage& image);
+bool ParseDDS(uint8_t const* bytes, size_t size, TextureImage& image);
+// Picks the reader from the file's magic number
+bool LoadTextureFile(std::string const& path, TextureImage& image);
+
+// GL texture whose mip levels become resident from the coarsest down. Levels
+// not yet uploaded are left undefined and GL_TEXTURE_BASE_LEVEL points at the
+// finest resident one, so the texture samples a blurrier version until its
+// detail arrives, and black before its first level does. The CPU copy of the
+// image is kept so evicted levels can be streamed again.
+class Texture
+{
+ public:
+    Texture();
+    ~Texture();
+
+    Texture(Texture const&)            = delete;
+    Texture& operator=(Texture const&) = delete;
+
+    // Creates the GL object with no levels resident; needs a current context
+    bool Create(TextureImage&& image, std::string const& name = "Texture");
+    // Uploads every missing level synchronously from client memory
+    void UploadAll();
+    void Cleanup();
+
+    void Bind(GLuint unit) const;
+
+    GLuint GetHandle() const { return m_texture; }
+    // Changes when Create() or Cleanup() replaces the GL object, not as
+    // levels stream in or out
+    uint64_t GetRevision() const { return m_revision; }
+    std::string const& GetName() const { return m_name; }
+    TextureImage const& GetImage() const { return m_image; }
+    uint32_t GetWidth() const { return m_image.GetWidth(); }
+    uint32_t GetHeight() const { return m_image.GetHeight(); }
+
+    int GetLevelCount() const { return (int)m_image.levels.size(); }
+    // Finest resident level; GetLevelCount() while nothing is resident
+    int GetResidentLevel() const { return m_residentLevel; }
+    bool IsResident() const { return m_residentLevel < GetLevelCount(); }
+    bool IsFullyResident() const { return m_residentLevel == 0; }
+    size_t GetResidentBytes() const { return m_residentBytes; }
+
+ private:
+    friend class TextureStreamer;
+
+    // Defines the next finer level, level GetResidentLevel() - 1. pixels is a
+    // client pointer, or an offset when a pixel-unpack buffer is bound.
+    void UploadLevel(int level, void const* pixels);
+    // Undefines the finest resident level; the coarsest one is never dropped
+    bool DropFinestLevel();
+    void SetResidentLevel(int level);
+    void TrackMemory();
+
+    GLuint m_texture;
+    std::string m_name;
+    TextureImage m_image;
+    int m_residentLevel;
+    size_t m_residentBytes;
+    uint64_t m_revision;
+};
+
+// Images of one format, size and level count packed into the layers of a
+// GL_TEXTURE_2D_ARRAY, so objects sampling any of them share one binding.
+// Layers are uploaded whole and synchronously; they do not stream.
+class TextureArray
+{
+ public:
+    TextureArray();
+    ~TextureArray();
+
+    TextureArray(TextureArray const&)            = delete;
+    TextureArray& operator=(TextureArray const&) = delete;
+
+    // Allocates layerCapacity layers shaped like layout (format, sRGB flag,
+    // size and level count); needs a current context
+    bool Create(TextureImage const& layout,
+                int layerCapacity,
+                std::string const& name = "TextureArray");
+    void Cleanup();
+
+    bool Matches(TextureImage const& image) const;
+    // Copies image into the next free layer. Returns the layer, or -1 if the
+    // image does not match or the array is full.
+    int AddLayer(TextureImage const& image);
+
+    void Bind(GLuint unit) const;
+
+    GLuint GetHandle() const { return m_texture; }
+    int GetLayerCount() const { return m_layerCount; }
+    int GetLayerCapacity() const { return m_layerCapacity; }
+    bool IsFull() const { return m_layerCount == m_layerCapacity; }
+
+ private:
+    GLuint m_texture;
+    std::string m_name;
+    TextureImage m_layout;  // levels only, no data
+    int m_layerCount;
+    int m_layerCapacity;
+};
+
+struct TextureStreamingStats
+{
+    uint64_t levelsUploaded  = 0;
+    uint64_t bytesUploaded   = 0;
+    uint64_t levelsEvicted   = 0;
+    uint64_t deferredUploads = 0;  // postponed because every staging buffer was busy
+};
+
+// Streams texture mip levels coarsest-first under a GPU memory budget. Each
+// Update() starts uploads in order of increasing level size, so every texture
+// gets a usable low-detail level before any gets its full detail. Level data
+// is copied into pixel-unpack buffers and the texture is defined from there,
+// letting the driver transfer it without stalling the CPU; a staging buffer is
+// reused once the fence after its upload has signalled. When the budget is
+// lowered, the finest levels of the largest textures are evicted first.
+class TextureStreamer
+{
+ public:
+    explicit TextureStreamer(size_t budgetBytes         = 256 * 1024 * 1024,
+                             size_t uploadBytesPerFrame = 16 * 1024 * 1024);
+    ~TextureStreamer();
+
+    TextureStreamer(TextureStreamer const&)            = delete;
+    TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+    void Add(std::shared_ptr<Texture> texture);
+    void Remove(Texture const* texture);
+
+    void SetBudget(size_t bytes) { m_budgetBytes = bytes; }
+    size_t GetBudget() const { return m_budgetBytes; }
+    // Caps the bytes copied per Update(); a single larger level still goes
+    void SetUploadBytesPerFrame(size_t bytes) { m_uploadBytesPerFrame = bytes; }
+
+    // Call once per frame on the GL thread
+    void Update();
+    // Streams until every texture is resident or the budget is reached
+    void Flush();
+    // Waits for outstanding uploads, then releases the staging buffers and the
+    // GL objects of every texture. Must be called while the context is current.
+    void Shutdown();
+
+    size_t GetResidentBytes() const;
+    size_t GetTextureCount() const { return m_textures.size(); }
+    TextureStreamingStats const& GetStats() const { return m_stats; }
+
+ private:
+    struct StagingBuffer
+    {
+        GLuint buffer   = 0;
+        size_t capacity = 0;
+        GLsync fence    = nullptr;
+    };
+
+    static constexpr size_t kMaxStagingBuffers = 8;
+
+    // Returns a staging buffer with room for size bytes whose last upload has
+    // finished, or nullptr if all are still in flight
+    StagingBuffer* AcquireStagingBuffer(size_t size);
+    bool Upload(Texture& texture, int level);
+    void Evict(size_t residentBytes);
+    void WaitForStaging();
+    void ReleaseStagingBuffers();
+
+    std::vector<std::shared_ptr<Texture>> m_textures;
+    std::vector<StagingBuffer> m_staging;
+    std::vector<std::pair<size_t, size_t>> m_queue;  // (level bytes, texture index) min-heap
+    size_t m_budgetBytes;
+    size_t m_uploadBytesPerFrame;
+    TextureStreamingStats m_stats;
+};
+
+}  // namespace SpatialRender
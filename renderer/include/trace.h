@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SpatialRender
+{
+
+struct TraceEvent
+{
+    char const* name;  // must outlive the tracer, normally a string literal
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// Collects scoped timing zones from any thread. Each thread writes into its
+// own fixed-size single-producer ring, so recording takes no lock; Collect()
+// drains the rings on the consumer side. A full ring drops new events rather
+// than blocking the producer. Timestamps come from steady_clock in ns.
+class Tracer
+{
+ public:
+    static constexpr size_t kRingCapacity = 1 << 16;  // events per thread between collections
+
+    static Tracer& Get();
+
+    void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    static uint64_t Now();
+
+    void Record(char const* name, uint64_t beginNs, uint64_t endNs);
+
+    // Labels the calling thread in exported traces
+    void SetThreadName(std::string const& name);
+
+    // Moves recorded events out of the per-thread rings. Call regularly (e.g.
+    // once per frame) so the rings do not fill up.
+    void Collect();
+
+    // Collects, then writes Chrome trace event JSON (loadable by Perfetto and
+    // chrome://tracing). Collected events are kept until Clear().
+    bool ExportChromeTrace(std::string const& path);
+
+    void Clear();
+
+    size_t GetEventCount() const;
+    uint64_t GetDroppedCount() const;
+
+ private:
+    struct ThreadBuffer;
+    struct CollectedEvent
+    {
+        TraceEvent event;
+        uint32_t threadId;
+    };
+
+    Tracer();
+    ~Tracer();
+
+    ThreadBuffer& GetThreadBuffer();
+    void CollectLocked();
+
+    std::atomic<bool> m_enabled;
+    uint64_t m_epochNs;
+
+    mutable std::mutex m_mutex;  // guards the buffer list and collected events
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<CollectedEvent> m_events;
+};
+
+// Records the time between construction and destruction as one event
+class TraceZone
+{
+ public:
+    explicit TraceZone(char const* name) :
+        m_name(name),
+        m_beginNs(Tracer::Get().IsEnabled() ? Tracer::Now() : 0)
+    {}
+
+    ~TraceZone()
+    {
+        if (m_beginNs != 0)
+            Tracer::Get().Record(m_name, m_beginNs, Tracer::Now());
+    }
+
+    TraceZone(TraceZone const&)            = delete;
+    TraceZone& operator=(TraceZone const&) = delete;
+
+ private:
+    char const* m_name;
+    uint64_t m_beginNs;
+};
+
+}  // namespace SpatialRender
+
+// SR_TRACE_ZONE("Name") times the enclosing scope. Zones compile to nothing
+// unless SPATIALRENDER_TRACING is defined (CMake option ENABLE_TRACING).
+#define SR_TRACE_CONCAT_INNER(a, b) a##b
+#define SR_TRACE_CONCAT(a, b) SR_TRACE_CONCAT_INNER(a, b)
+
+#if defined(SPATIALRENDER_TRACING)
+#define SR_TRACE_ZONE(name) ::SpatialRender::TraceZone SR_TRACE_CONCAT(srTraceZone, __LINE__)(name)
+#else
+#define SR_TRACE_ZONE(name) ((void)0)
+#endif
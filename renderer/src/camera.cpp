@@ -1,8 +1,80 @@
 #include "camera.h"
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPATIALRENDER_CAMERA_SSE2 1
+#endif
+
 namespace SpatialRender
 {
 
+namespace
+{
+
+// Same construction as glm::lookAt
+struct ViewBasis
+{
+    glm::vec3 forward;
+    glm::vec3 side;
+    glm::vec3 up;
+};
+
+ViewBasis MakeViewBasis(glm::vec3 const& position, glm::vec3 const& target, glm::vec3 const& up)
+{
+    ViewBasis basis;
+    basis.forward = glm::normalize(target - position);
+    basis.side    = glm::normalize(glm::cross(basis.forward, up));
+    basis.up      = glm::cross(basis.side, basis.forward);
+    return basis;
+}
+
+#if defined(SPATIALRENDER_CAMERA_SSE2)
+
+struct Vec3x4
+{
+    __m128 x, y, z;
+};
+
+Vec3x4 Sub(Vec3x4 const& a, Vec3x4 const& b)
+{
+    return {_mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z)};
+}
+
+__m128 Dot(Vec3x4 const& a, Vec3x4 const& b)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)),
+                      _mm_mul_ps(a.z, b.z));
+}
+
+Vec3x4 Cross(Vec3x4 const& a, Vec3x4 const& b)
+{
+    return {_mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(b.y, a.z)),
+            _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(b.z, a.x)),
+            _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(b.x, a.y))};
+}
+
+Vec3x4 Normalize(Vec3x4 const& v)
+{
+    __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(Dot(v, v)));
+    return {_mm_mul_ps(v.x, scale), _mm_mul_ps(v.y, scale), _mm_mul_ps(v.z, scale)};
+}
+
+template <typename Field>
+__m128 Gather(Camera* const* cameras, Field field)
+{
+    return _mm_setr_ps(field(*cameras[0]),
+                       field(*cameras[1]),
+                       field(*cameras[2]),
+                       field(*cameras[3]));
+}
+
+#endif
+
+}  // namespace
+
 Camera::Camera() :
     m_position(0.0f, 0.0f, 3.0f),
     m_target(0.0f, 0.0f, 0.0f),
@@ -11,7 +83,9 @@ Camera::Camera() :
     m_aspect(16.0f / 9.0f),
     m_near(0.1f),
     m_far(100.0f),
-    m_orthographic(false)
+    m_orthographic(false),
+    m_reversedZ(false),
+    m_dirty(ViewChanged | ProjectionChanged)
 {}
 
 Camera::Camera(glm::vec3 const& position, glm::vec3 const& target, glm::vec3 const& up) :
@@ -22,22 +96,27 @@ Camera::Camera(glm::vec3 const& position, glm::vec3 const& target, glm::vec3 con
     m_aspect(16.0f / 9.0f),
     m_near(0.1f),
     m_far(100.0f),
-    m_orthographic(false)
+    m_orthographic(false),
+    m_reversedZ(false),
+    m_dirty(ViewChanged | ProjectionChanged)
 {}
 
 void Camera::SetPosition(glm::vec3 const& position)
 {
     m_position = position;
+    m_dirty |= ViewChanged;
 }
 
 void Camera::SetTarget(glm::vec3 const& target)
 {
     m_target = target;
+    m_dirty |= ViewChanged;
 }
 
 void Camera::SetUp(glm::vec3 const& up)
 {
     m_up = up;
+    m_dirty |= ViewChanged;
 }
 
 void Camera::SetPerspective(float fov, float aspect, float near, float far)
@@ -47,6 +126,7 @@ void Camera::SetPerspective(float fov, float aspect, float near, float far)
     m_near         = near;
     m_far          = far;
     m_orthographic = false;
+    m_dirty |= ProjectionChanged;
 }
 
 void Camera::SetOrthographic(float left,
@@ -63,28 +143,350 @@ void Camera::SetOrthographic(float left,
     m_near         = near;
     m_far          = far;
     m_orthographic = true;
+    m_dirty |= ProjectionChanged;
+}
+
+void Camera::SetReversedZ(bool reversedZ)
+{
+    m_reversedZ = reversedZ;
+    m_dirty |= ProjectionChanged;
+}
+
+glm::mat4 const& Camera::GetViewMatrix() const
+{
+    if (m_dirty & ViewDirty)
+    {
+        m_view = glm::lookAt(m_position, m_target, m_up);
+        m_dirty &= ~ViewDirty;
+    }
+    return m_view;
+}
+
+glm::mat4 const& Camera::GetProjectionMatrix() const
+{
+    if (m_dirty & ProjectionDirty)
+    {
+        m_projection = BuildProjection();
+        m_dirty &= ~ProjectionDirty;
+    }
+    return m_projection;
+}
+
+glm::mat4 const& Camera::GetViewProjectionMatrix() const
+{
+    if (m_dirty & ViewProjectionDirty)
+    {
+        m_viewProjection = GetProjectionMatrix() * GetViewMatrix();
+        m_dirty &= ~ViewProjectionDirty;
+    }
+    return m_viewProjection;
+}
+
+glm::mat4 const& Camera::GetInverseViewMatrix() const
+{
+    if (m_dirty & InverseDirty)
+    {
+        ViewBasis basis = MakeViewBasis(m_position, m_target, m_up);
+
+        // The view is rigid, so its inverse is the basis and the position
+        m_inverseView = glm::mat4(glm::vec4(basis.side, 0.0f),
+                                  glm::vec4(basis.up, 0.0f),
+                                  glm::vec4(-basis.forward, 0.0f),
+                                  glm::vec4(m_position, 1.0f));
+
+        m_inverseProjection     = glm::inverse(GetProjectionMatrix());
+        m_inverseViewProjection = m_inverseView * m_inverseProjection;
+        m_dirty &= ~InverseDirty;
+    }
+    return m_inverseView;
+}
+
+glm::mat4 const& Camera::GetInverseProjectionMatrix() const
+{
+    GetInverseViewMatrix();
+    return m_inverseProjection;
+}
+
+glm::mat4 const& Camera::GetInverseViewProjectionMatrix() const
+{
+    GetInverseViewMatrix();
+    return m_inverseViewProjection;
+}
+
+Frustum const& Camera::GetFrustum() const
+{
+    if (m_dirty & FrustumDirty)
+    {
+        m_frustum = Frustum::FromMatrix(GetViewProjectionMatrix());
+        FixReversedZPlanes(m_frustum);
+        m_dirty &= ~FrustumDirty;
+    }
+    return m_frustum;
+}
+
+std::array<glm::vec3, 8> const& Camera::GetFrustumCorners() const
+{
+    if (m_dirty & CornersDirty)
+    {
+        // Built from the basis rather than unprojected, so an infinite far
+        // plane still gives finite corners at GetFar()
+        ViewBasis basis    = MakeViewBasis(m_position, m_target, m_up);
+        float distances[2] = {m_near, m_far};
+        for (int plane = 0; plane < 2; ++plane)
+        {
+            float distance   = distances[plane];
+            glm::vec3 center = m_position + basis.forward * distance;
+
+            float left, right, bottom, top;
+            if (m_orthographic)
+            {
+                left   = m_orthoLeft;
+                right  = m_orthoRight;
+                bottom = m_orthoBottom;
+                top    = m_orthoTop;
+            }
+            else
+            {
+                top    = distance * std::tan(glm::radians(m_fov) * 0.5f);
+                bottom = -top;
+                right  = top * m_aspect;
+                left   = -right;
+            }
+
+            glm::vec3* corners = &m_frustumCorners[plane * 4];
+            corners[0]         = center + basis.side * left + basis.up * bottom;
+            corners[1]         = center + basis.side * right + basis.up * bottom;
+            corners[2]         = center + basis.side * right + basis.up * top;
+            corners[3]         = center + basis.side * left + basis.up * top;
+        }
+        m_dirty &= ~CornersDirty;
+    }
+    return m_frustumCorners;
 }
 
-glm::mat4 Camera::GetViewMatrix() const
+void Camera::UpdateCache() const
 {
-    return glm::lookAt(m_position, m_target, m_up);
+    GetFrustum();
+    GetFrustumCorners();
+    GetInverseViewMatrix();
 }
 
-glm::mat4 Camera::GetProjectionMatrix() const
+glm::mat4 Camera::BuildProjection() const
 {
     if (m_orthographic)
     {
         return glm::ortho(m_orthoLeft, m_orthoRight, m_orthoBottom, m_orthoTop, m_near, m_far);
     }
+    else if (m_reversedZ)
+    {
+        // Depth is near / -z: 1 at the near plane, 0 at infinity
+        float focal = 1.0f / std::tan(glm::radians(m_fov) * 0.5f);
+        glm::mat4 projection(0.0f);
+        projection[0][0] = focal / m_aspect;
+        projection[1][1] = focal;
+        projection[2][3] = -1.0f;
+        projection[3][2] = m_near;
+        return projection;
+    }
     else
     {
         return glm::perspective(glm::radians(m_fov), m_aspect, m_near, m_far);
     }
 }
 
-glm::mat4 Camera::GetViewProjectionMatrix() const
+void Camera::FixReversedZPlanes(Frustum& frustum) const
 {
-    return GetProjectionMatrix() * GetViewMatrix();
+    if (!IsReversedZ())
+        return;
+
+    // w - z >= 0 is the near plane here, and w + z >= 0 clips nothing useful.
+    // A zero normal with positive w never rejects, standing in for the far plane.
+    frustum.planes[4] = frustum.planes[5];
+    frustum.planes[5] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+size_t CameraSet::Add(Camera const& camera)
+{
+    m_cameras.push_back(camera);
+    return m_cameras.size() - 1;
+}
+
+size_t CameraSet::AddCubemapFaces(glm::vec3 const& position, float near, float far)
+{
+    static glm::vec3 const kDirections[6] = {
+        {1.0f, 0.0f, 0.0f},
+        {-1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, -1.0f},
+    };
+    static glm::vec3 const kUps[6] = {
+        {0.0f, -1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f},
+        {0.0f, 0.0f, -1.0f},
+        {0.0f, -1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f},
+    };
+
+    size_t first = m_cameras.size();
+    for (int face = 0; face < 6; ++face)
+    {
+        Camera camera(position, position + kDirections[face], kUps[face]);
+        camera.SetPerspective(90.0f, 1.0f, near, far);
+        m_cameras.push_back(camera);
+    }
+    return first;
+}
+
+void CameraSet::Update()
+{
+    uint8_t const batched = Camera::ViewDirty | Camera::ProjectionDirty |
+                            Camera::ViewProjectionDirty | Camera::FrustumDirty;
+
+    m_pending.clear();
+    for (Camera& camera : m_cameras)
+    {
+        if (camera.m_dirty & batched)
+        {
+            m_pending.push_back(&camera);
+        }
+    }
+
+#if defined(SPATIALRENDER_CAMERA_SSE2)
+    for (size_t first = 0; first < m_pending.size(); first += 4)
+    {
+        Camera* lanes[4];
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            lanes[lane] = m_pending[std::min(first + lane, m_pending.size() - 1)];
+        }
+        UpdateFour(lanes);
+    }
+#else
+    for (Camera* camera : m_pending)
+    {
+        camera->GetFrustum();
+    }
+#endif
+}
+
+#if defined(SPATIALRENDER_CAMERA_SSE2)
+
+void CameraSet::UpdateFour(Camera* const* cameras)
+{
+    // Same operation order as the scalar path, so results match glm exactly
+    Vec3x4 eye    = {Gather(cameras, [](Camera& c) { return c.m_position.x; }),
+                     Gather(cameras, [](Camera& c) { return c.m_position.y; }),
+                     Gather(cameras, [](Camera& c) { return c.m_position.z; })};
+    Vec3x4 target = {Gather(cameras, [](Camera& c) { return c.m_target.x; }),
+                     Gather(cameras, [](Camera& c) { return c.m_target.y; }),
+                     Gather(cameras, [](Camera& c) { return c.m_target.z; })};
+    Vec3x4 up     = {Gather(cameras, [](Camera& c) { return c.m_up.x; }),
+                     Gather(cameras, [](Camera& c) { return c.m_up.y; }),
+                     Gather(cameras, [](Camera& c) { return c.m_up.z; })};
+
+    Vec3x4 f = Normalize(Sub(target, eye));
+    Vec3x4 s = Normalize(Cross(f, up));
+    Vec3x4 u = Cross(s, f);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one  = _mm_set1_ps(1.0f);
+
+    __m128 view[4][4] = {
+        {s.x, u.x, _mm_sub_ps(zero, f.x), zero},
+        {s.y, u.y, _mm_sub_ps(zero, f.y), zero},
+        {s.z, u.z, _mm_sub_ps(zero, f.z), zero},
+        {_mm_sub_ps(zero, Dot(s, eye)), _mm_sub_ps(zero, Dot(u, eye)), Dot(f, eye), one},
+    };
+
+    // Projections are sparse and cheap; only the products are batched
+    __m128 projection[4][4];
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            projection[column][row] = Gather(cameras, [column, row](Camera& c) {
+                return c.GetProjectionMatrix()[column][row];
+            });
+        }
+    }
+
+    __m128 viewProj[4][4];
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            __m128 sum = _mm_mul_ps(projection[0][row], view[column][0]);
+            sum        = _mm_add_ps(sum, _mm_mul_ps(projection[1][row], view[column][1]));
+            sum        = _mm_add_ps(sum, _mm_mul_ps(projection[2][row], view[column][2]));
+            sum        = _mm_add_ps(sum, _mm_mul_ps(projection[3][row], view[column][3]));
+            viewProj[column][row] = sum;
+        }
+    }
+
+    // Gribb/Hartmann, as in Frustum::FromMatrix
+    __m128 planes[6][4];
+    for (int component = 0; component < 4; ++component)
+    {
+        __m128 const* column = viewProj[component];
+        planes[0][component] = _mm_add_ps(column[3], column[0]);
+        planes[1][component] = _mm_sub_ps(column[3], column[0]);
+        planes[2][component] = _mm_add_ps(column[3], column[1]);
+        planes[3][component] = _mm_sub_ps(column[3], column[1]);
+        planes[4][component] = _mm_add_ps(column[3], column[2]);
+        planes[5][component] = _mm_sub_ps(column[3], column[2]);
+    }
+    for (__m128* plane : planes)
+    {
+        Vec3x4 normal  = {plane[0], plane[1], plane[2]};
+        __m128 length  = _mm_sqrt_ps(Dot(normal, normal));
+        __m128 valid   = _mm_cmpgt_ps(length, zero);
+        __m128 divisor = _mm_or_ps(_mm_and_ps(valid, length), _mm_andnot_ps(valid, one));
+        for (int component = 0; component < 4; ++component)
+        {
+            plane[component] = _mm_div_ps(plane[component], divisor);
+        }
+    }
+
+    alignas(16) float values[4];
+    auto scatter = [&](__m128 lanes, auto&& store) {
+        _mm_store_ps(values, lanes);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            store(*cameras[lane], values[lane]);
+        }
+    };
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            scatter(view[column][row], [&](Camera& c, float v) { c.m_view[column][row] = v; });
+            scatter(viewProj[column][row],
+                    [&](Camera& c, float v) { c.m_viewProjection[column][row] = v; });
+        }
+    }
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        for (int component = 0; component < 4; ++component)
+        {
+            scatter(planes[plane][component],
+                    [&](Camera& c, float v) { c.m_frustum.planes[plane][component] = v; });
+        }
+    }
+
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        Camera& camera = *cameras[lane];
+        if (camera.m_dirty & Camera::FrustumDirty)
+        {
+            camera.FixReversedZPlanes(camera.m_frustum);
+        }
+        camera.m_dirty &= ~(Camera::ViewDirty | Camera::ViewProjectionDirty | Camera::FrustumDirty);
+    }
+}
+
+#endif
+
 }  // namespace SpatialRender
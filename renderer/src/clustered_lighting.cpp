@@ -0,0 +1,428 @@
+#include "clustered_lighting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "camera.h"
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "parallel.h"
+#include "shader.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+uint32_t ToTile(float ndc, uint32_t tileCount)
+{
+    float tile = std::floor((ndc * 0.5f + 0.5f) * (float)tileCount);
+    return (uint32_t)std::clamp(tile, 0.0f, (float)(tileCount - 1));
+}
+
+}  // namespace
+
+LightClusterGrid::LightClusterGrid() :
+    m_near(0.1f),
+    m_far(100.0f),
+    m_depthParams(0.0f),
+    m_sliceDropped{},
+    m_clusterData(kClusterCount * 2, 0)
+{}
+
+uint32_t LightClusterGrid::GetSlice(float viewDepth) const
+{
+    float slice = std::log(std::max(viewDepth, m_near)) * m_depthParams.x - m_depthParams.y;
+    return (uint32_t)std::clamp(std::floor(slice), 0.0f, (float)(kSlices - 1));
+}
+
+void LightClusterGrid::Build(std::vector<Light> const& lights,
+                             glm::mat4 const& view,
+                             glm::mat4 const& projection,
+                             float nearPlane,
+                             float farPlane)
+{
+    SR_TRACE_ZONE("LightClusterGrid::Build");
+
+    auto start = std::chrono::steady_clock::now();
+    m_stats    = LightingStats();
+
+    m_near        = nearPlane;
+    m_far         = std::max(farPlane, nearPlane * 1.001f);
+    float scale   = (float)kSlices / std::log(m_far / m_near);
+    m_depthParams = glm::vec2(scale, std::log(m_near) * scale);
+
+    m_stats.lights = lights.size();
+
+    m_ranges.resize(lights.size());
+    m_lightData.resize(lights.size() * kTexelsPerLight);
+
+    ParallelFor(lights.size(), 128, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Light const& light = lights[i];
+            ComputeRange(light, view, projection, m_ranges[i]);
+
+            float cosOuter = std::cos(glm::radians(light.outerConeAngle));
+            float cosInner = std::cos(glm::radians(light.innerConeAngle));
+            float coneScale = 1.0f / std::max(cosInner - cosOuter, 1e-4f);
+            float spot      = light.type == LightType::Spot ? 1.0f : 0.0f;
+
+            glm::vec4* texels = &m_lightData[i * kTexelsPerLight];
+            texels[0]         = glm::vec4(light.position, light.range);
+            texels[1]         = glm::vec4(light.color * light.intensity, spot);
+            texels[2]         = glm::vec4(light.direction, cosOuter);
+            texels[3]         = glm::vec4(coneScale, 0.0f, 0.0f, 0.0f);
+        }
+    });
+
+    for (LightRange const& range : m_ranges)
+    {
+        m_stats.visibleLights += range.visible ? 1 : 0;
+    }
+
+    ParallelFor(kSlices, 1, [this](size_t begin, size_t end, unsigned) {
+        for (size_t slice = begin; slice < end; ++slice)
+        {
+            BinSlice((uint32_t)slice);
+        }
+    });
+
+    // Concatenate the per-slice lists and rebase cluster offsets onto them
+    size_t total = 0;
+    for (uint32_t slice = 0; slice < kSlices; ++slice)
+    {
+        total += m_sliceIndices[slice].size();
+        m_stats.droppedLights += m_sliceDropped[slice];
+    }
+    m_lightIndices.resize(std::max<size_t>(total, 1));
+
+    uint32_t base = 0;
+    for (uint32_t slice = 0; slice < kSlices; ++slice)
+    {
+        std::vector<uint32_t> const& indices = m_sliceIndices[slice];
+        std::copy(indices.begin(), indices.end(), m_lightIndices.begin() + base);
+
+        uint32_t first = GetClusterIndex(0, 0, slice);
+        for (uint32_t c = first; c < first + kTilesX * kTilesY; ++c)
+        {
+            m_clusterData[c * 2] += base;
+            m_stats.occupiedClusters += m_clusterData[c * 2 + 1] != 0 ? 1 : 0;
+        }
+        base += (uint32_t)indices.size();
+    }
+
+    auto end             = std::chrono::steady_clock::now();
+    m_stats.lightIndices = total;
+    m_stats.binMs        = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void LightClusterGrid::ComputeRange(Light const& light,
+                                    glm::mat4 const& view,
+                                    glm::mat4 const& projection,
+                                    LightRange& range) const
+{
+    range.visible = false;
+
+    glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+    float radius     = light.range;
+    float depth      = -center.z;
+    if (radius <= 0.0f || depth + radius < m_near || depth - radius > m_far)
+        return;
+
+    float zNear = std::max(depth - radius, m_near);
+    float zFar  = std::min(depth + radius, m_far);
+
+    // The sphere's view-space box, clipped to the depth range, projects to a
+    // convex region containing the sphere's footprint
+    glm::vec2 ndcMin(1e30f);
+    glm::vec2 ndcMax(-1e30f);
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec4 p(center.x + ((corner & 1) ? radius : -radius),
+                    center.y + ((corner & 2) ? radius : -radius),
+                    (corner & 4) ? -zFar : -zNear,
+                    1.0f);
+        glm::vec4 clip = projection * p;
+        glm::vec2 ndc  = glm::vec2(clip.x, clip.y) / clip.w;
+        ndcMin         = glm::min(ndcMin, ndc);
+        ndcMax         = glm::max(ndcMax, ndc);
+    }
+
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+        return;
+
+    range.tileMin[0] = ToTile(ndcMin.x, kTilesX);
+    range.tileMax[0] = ToTile(ndcMax.x, kTilesX);
+    range.tileMin[1] = ToTile(ndcMin.y, kTilesY);
+    range.tileMax[1] = ToTile(ndcMax.y, kTilesY);
+    range.sliceMin   = GetSlice(zNear);
+    range.sliceMax   = GetSlice(zFar);
+    range.visible    = true;
+}
+
+void LightClusterGrid::BinSlice(uint32_t slice)
+{
+    uint32_t* clusters = &m_clusterData[GetClusterIndex(0, 0, slice) * 2];
+    for (uint32_t c = 0; c < kTilesX * kTilesY; ++c)
+    {
+        clusters[c * 2 + 1] = 0;
+    }
+
+    auto overlaps = [slice](LightRange const& range) {
+        return range.visible && slice >= range.sliceMin && slice <= range.sliceMax;
+    };
+
+    // Count, then lay the lists out back to back within the slice. Lights
+    // past a full cluster are left out of it and counted.
+    uint32_t dropped = 0;
+    for (LightRange const& range : m_ranges)
+    {
+        if (!overlaps(range))
+            continue;
+        for (uint32_t y = range.tileMin[1]; y <= range.tileMax[1]; ++y)
+        {
+            for (uint32_t x = range.tileMin[0]; x <= range.tileMax[0]; ++x)
+            {
+                uint32_t& count = clusters[(y * kTilesX + x) * 2 + 1];
+                if (count == kMaxLightsPerCluster)
+                    ++dropped;
+                else
+                    ++count;
+            }
+        }
+    }
+
+    m_sliceDropped[slice] = dropped;
+
+    uint32_t offset = 0;
+    for (uint32_t c = 0; c < kTilesX * kTilesY; ++c)
+    {
+        clusters[c * 2] = offset;
+        offset += clusters[c * 2 + 1];
+        clusters[c * 2 + 1] = 0;
+    }
+
+    std::vector<uint32_t>& indices = m_sliceIndices[slice];
+    indices.resize(offset);
+    for (size_t i = 0; i < m_ranges.size(); ++i)
+    {
+        LightRange const& range = m_ranges[i];
+        if (!overlaps(range))
+            continue;
+        for (uint32_t y = range.tileMin[1]; y <= range.tileMax[1]; ++y)
+        {
+            for (uint32_t x = range.tileMin[0]; x <= range.tileMax[0]; ++x)
+            {
+                uint32_t* cluster = &clusters[(y * kTilesX + x) * 2];
+                if (cluster[1] == kMaxLightsPerCluster)
+                    continue;
+                indices[cluster[0] + cluster[1]] = (uint32_t)i;
+                ++cluster[1];
+            }
+        }
+    }
+}
+
+ClusteredLighting::ClusteredLighting() :
+    m_grids(1),
+    m_frameSlot(0),
+    m_viewCount(1),
+    m_lightCount(0),
+    m_initialized(false)
+{}
+
+ClusteredLighting::~ClusteredLighting()
+{
+    Shutdown();
+}
+
+bool ClusteredLighting::Initialize()
+{
+    if (m_initialized)
+        return true;
+
+    for (FrameBuffers& frame : m_frames)
+    {
+        if (!CreateTextureBuffer(frame.lightData, GL_RGBA32F) ||
+            !CreateTextureBuffer(frame.clusterData, GL_RG32UI) ||
+            !CreateTextureBuffer(frame.lightIndices, GL_R32UI))
+        {
+            std::cerr << "Failed to create light cluster buffers" << std::endl;
+            Shutdown();
+            return false;
+        }
+    }
+
+    m_initialized = true;
+    return true;
+}
+
+void ClusteredLighting::Shutdown()
+{
+    for (FrameBuffers& frame : m_frames)
+    {
+        Release(frame.lightData);
+        Release(frame.clusterData);
+        Release(frame.lightIndices);
+    }
+    m_lightCount  = 0;
+    m_initialized = false;
+}
+
+size_t ClusteredLighting::GetDroppedLights() const
+{
+    size_t dropped = 0;
+    for (int view = 0; view < m_viewCount; ++view)
+    {
+        dropped += m_grids[view].GetStats().droppedLights;
+    }
+    return dropped;
+}
+
+void ClusteredLighting::Update(Scene const& scene,
+                               Camera const* cameras,
+                               size_t viewCount,
+                               int frameSlot)
+{
+    SR_TRACE_ZONE("ClusteredLighting::Update");
+
+    // Views share one depth slicing so the shader needs a single set of params
+    std::vector<Light> const& lights = scene.GetLights();
+    m_grids.resize(std::max<size_t>(viewCount, 1));
+    for (size_t view = 0; view < viewCount; ++view)
+    {
+        m_grids[view].Build(lights,
+                            cameras[view].GetViewMatrix(),
+                            cameras[view].GetProjectionMatrix(),
+                            cameras[0].GetNear(),
+                            cameras[0].GetFar());
+    }
+
+    m_frameSlot  = std::clamp(frameSlot, 0, FrameSync::kMaxFramesInFlight - 1);
+    m_viewCount  = (int)viewCount;
+    m_lightCount = m_initialized ? (int)lights.size() : 0;
+    if (m_lightCount == 0 || viewCount == 0)
+        return;
+
+    FrameBuffers& frame                     = m_frames[m_frameSlot];
+    std::vector<glm::vec4> const& lightData = m_grids[0].GetLightData();
+    Upload(frame.lightData, lightData.data(), lightData.size() * sizeof(glm::vec4));
+
+    if (viewCount == 1)
+    {
+        std::vector<uint32_t> const& clusters = m_grids[0].GetClusterData();
+        std::vector<uint32_t> const& indices  = m_grids[0].GetLightIndices();
+        Upload(frame.clusterData, clusters.data(), clusters.size() * sizeof(uint32_t));
+        Upload(frame.lightIndices, indices.data(), indices.size() * sizeof(uint32_t));
+        return;
+    }
+
+    // Grids are stored back to back, offsets rebased onto the joined index list
+    m_clusterScratch.clear();
+    m_indexScratch.clear();
+    for (size_t view = 0; view < viewCount; ++view)
+    {
+        std::vector<uint32_t> const& clusters = m_grids[view].GetClusterData();
+        std::vector<uint32_t> const& indices  = m_grids[view].GetLightIndices();
+
+        uint32_t base = (uint32_t)m_indexScratch.size();
+        for (size_t c = 0; c < clusters.size(); c += 2)
+        {
+            m_clusterScratch.push_back(clusters[c] + base);
+            m_clusterScratch.push_back(clusters[c + 1]);
+        }
+        m_indexScratch.insert(m_indexScratch.end(), indices.begin(), indices.end());
+    }
+
+    Upload(frame.clusterData, m_clusterScratch.data(), m_clusterScratch.size() * sizeof(uint32_t));
+    Upload(frame.lightIndices, m_indexScratch.data(), m_indexScratch.size() * sizeof(uint32_t));
+}
+
+void ClusteredLighting::Apply(Shader& shader, int viewportWidth, int viewportHeight)
+{
+    // Samplers default to unit 0; left there, they would clash with the albedo
+    // sampler even while unused
+    shader.SetUniform("u_lightData", (int)kLightDataUnit);
+    shader.SetUniform("u_clusterData", (int)kClusterDataUnit);
+    shader.SetUniform("u_lightIndices", (int)kLightIndexUnit);
+
+    shader.SetUniform("u_lightCount", m_lightCount);
+    if (m_lightCount == 0)
+        return;
+
+    GLStateCache& state = GLStateCache::Get();
+    FrameBuffers& frame = m_frames[m_frameSlot];
+    state.BindTexture(kLightDataUnit, GL_TEXTURE_BUFFER, frame.lightData.texture);
+    state.BindTexture(kClusterDataUnit, GL_TEXTURE_BUFFER, frame.clusterData.texture);
+    state.BindTexture(kLightIndexUnit, GL_TEXTURE_BUFFER, frame.lightIndices.texture);
+
+    float viewWidth = (float)viewportWidth / (float)std::max(m_viewCount, 1);
+    glm::vec2 depth = m_grids[0].GetDepthParams();
+    shader.SetUniform("u_clusterViewWidth", viewWidth);
+    shader.SetUniform("u_clusterScale",
+                      glm::vec4((float)LightClusterGrid::kTilesX / viewWidth,
+                                (float)LightClusterGrid::kTilesY / (float)viewportHeight,
+                                depth.x,
+                                depth.y));
+}
+
+bool ClusteredLighting::CreateTextureBuffer(TextureBuffer& tb, GLenum format)
+{
+    GLStateCache& state = GLStateCache::Get();
+
+    glGenBuffers(1, &tb.buffer);
+    glGenTextures(1, &tb.texture);
+    if (tb.buffer == 0 || tb.texture == 0)
+        return false;
+
+    // A buffer texture needs a data store even before the first upload
+    uint32_t zero[4] = {0, 0, 0, 0};
+    state.BindBuffer(GL_TEXTURE_BUFFER, tb.buffer);
+    state.BufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_DYNAMIC_DRAW);
+    tb.capacity = sizeof(zero);
+    MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                tb.buffer,
+                                MemoryCategory::TextureBuffer,
+                                "ClusteredLighting",
+                                tb.capacity);
+
+    state.BindTexture(kLightDataUnit, GL_TEXTURE_BUFFER, tb.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, tb.buffer);
+    return true;
+}
+
+void ClusteredLighting::Upload(TextureBuffer& tb, void const* data, size_t bytes)
+{
+    // The frame slot's fence has signalled, so the store is free to overwrite;
+    // it only grows, with headroom to avoid reallocating as lights are added
+    GLStateCache& state = GLStateCache::Get();
+    state.BindBuffer(GL_TEXTURE_BUFFER, tb.buffer);
+    if (bytes > tb.capacity)
+    {
+        tb.capacity = bytes + bytes / 2;
+        state.BufferData(GL_TEXTURE_BUFFER, tb.capacity, nullptr, GL_DYNAMIC_DRAW);
+        MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                    tb.buffer,
+                                    MemoryCategory::TextureBuffer,
+                                    "ClusteredLighting",
+                                    tb.capacity);
+    }
+    state.BufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+}
+
+void ClusteredLighting::Release(TextureBuffer& tb)
+{
+    MemoryTracker::Get().Release(MemoryResource::Buffer, tb.buffer);
+
+    GLStateCache& state = GLStateCache::Get();
+    state.DeleteTexture(tb.texture);
+    state.DeleteBuffer(tb.buffer);
+    tb = TextureBuffer();
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,251 @@
+#include "command_buffer.h"
+
+#include <cstring>
+
+#include "gl_state.h"
+#include "shader.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+struct UniformInt
+{
+    GLint location;
+    GLint value;
+};
+
+struct UniformVec3
+{
+    GLint location;
+    glm::vec3 value;
+};
+
+struct UniformMat4
+{
+    GLint location;
+    glm::mat4 value;
+};
+
+struct TextureBinding
+{
+    GLuint unit;
+    GLenum target;
+    GLuint texture;
+};
+
+struct ArraysDraw
+{
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    GLsizei instanceCount;
+};
+
+struct ElementsDraw
+{
+    GLenum mode;
+    GLsizei count;
+    GLenum type;
+    GLsizei instanceCount;
+};
+
+struct Masks
+{
+    GLboolean r, g, b, a;
+};
+
+template <typename T>
+T Read(uint8_t const*& cursor)
+{
+    T payload;
+    std::memcpy(&payload, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return payload;
+}
+
+}  // namespace
+
+CommandBuffer::CommandBuffer() : m_commandCount(0) {}
+
+void CommandBuffer::Clear()
+{
+    m_data.clear();
+    m_commandCount = 0;
+}
+
+template <typename T>
+void CommandBuffer::Write(Op op, T const& payload)
+{
+    size_t offset = m_data.size();
+    m_data.resize(offset + 1 + sizeof(T));
+    m_data[offset] = (uint8_t)op;
+    std::memcpy(m_data.data() + offset + 1, &payload, sizeof(T));
+    ++m_commandCount;
+}
+
+void CommandBuffer::UseProgram(Shader& shader)
+{
+    Write(Op::UseProgram, shader.GetProgram());
+}
+
+void CommandBuffer::ApplyFrameConstants(Shader& shader)
+{
+    Write(Op::ApplyFrameConstants, &shader);
+}
+
+void CommandBuffer::SetUniform(Shader& shader, std::string const& name, int value)
+{
+    GLint location = shader.GetUniformLocation(name);
+    if (location >= 0)
+    {
+        Write(Op::Uniform1i, UniformInt{location, value});
+    }
+}
+
+void CommandBuffer::SetUniform(Shader& shader, std::string const& name, glm::vec3 const& value)
+{
+    GLint location = shader.GetUniformLocation(name);
+    if (location >= 0)
+    {
+        Write(Op::Uniform3f, UniformVec3{location, value});
+    }
+}
+
+void CommandBuffer::SetUniform(Shader& shader, std::string const& name, glm::mat4 const& value)
+{
+    GLint location = shader.GetUniformLocation(name);
+    if (location >= 0)
+    {
+        Write(Op::UniformMatrix4f, UniformMat4{location, value});
+    }
+}
+
+void CommandBuffer::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    Write(Op::BindTexture, TextureBinding{unit, target, texture});
+}
+
+void CommandBuffer::BindVertexArray(GLuint vao)
+{
+    Write(Op::BindVertexArray, vao);
+}
+
+void CommandBuffer::DrawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+{
+    Write(Op::DrawArrays, ArraysDraw{mode, first, count, instanceCount});
+}
+
+void CommandBuffer::DrawElements(GLenum mode, GLsizei count, GLenum type, GLsizei instanceCount)
+{
+    Write(Op::DrawElements, ElementsDraw{mode, count, type, instanceCount});
+}
+
+void CommandBuffer::Enable(GLenum cap)
+{
+    Write(Op::Enable, cap);
+}
+
+void CommandBuffer::Disable(GLenum cap)
+{
+    Write(Op::Disable, cap);
+}
+
+void CommandBuffer::DepthFunc(GLenum func)
+{
+    Write(Op::DepthFunc, func);
+}
+
+void CommandBuffer::DepthMask(GLboolean enabled)
+{
+    Write(Op::DepthMask, enabled);
+}
+
+void CommandBuffer::ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+    Write(Op::ColorMask, Masks{r, g, b, a});
+}
+
+void CommandBuffer::Execute(FrameConstantsFunction const& applyFrameConstants) const
+{
+    GLStateCache& state   = GLStateCache::Get();
+    uint8_t const* cursor = m_data.data();
+    uint8_t const* end    = cursor + m_data.size();
+    while (cursor < end)
+    {
+        Op op = (Op)*cursor++;
+        switch (op)
+        {
+            case Op::UseProgram:
+                state.UseProgram(Read<GLuint>(cursor));
+                break;
+            case Op::ApplyFrameConstants:
+                applyFrameConstants(*Read<Shader*>(cursor));
+                break;
+            case Op::Uniform1i:
+            {
+                UniformInt uniform = Read<UniformInt>(cursor);
+                glUniform1i(uniform.location, uniform.value);
+                state.CountUniformUpload();
+                break;
+            }
+            case Op::Uniform3f:
+            {
+                UniformVec3 uniform = Read<UniformVec3>(cursor);
+                glUniform3fv(uniform.location, 1, &uniform.value[0]);
+                state.CountUniformUpload();
+                break;
+            }
+            case Op::UniformMatrix4f:
+            {
+                UniformMat4 uniform = Read<UniformMat4>(cursor);
+                glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &uniform.value[0][0]);
+                state.CountUniformUpload();
+                break;
+            }
+            case Op::BindTexture:
+            {
+                TextureBinding binding = Read<TextureBinding>(cursor);
+                state.BindTexture(binding.unit, binding.target, binding.texture);
+                break;
+            }
+            case Op::BindVertexArray:
+                state.BindVertexArray(Read<GLuint>(cursor));
+                break;
+            case Op::DrawArrays:
+            {
+                ArraysDraw draw = Read<ArraysDraw>(cursor);
+                state.DrawArrays(draw.mode, draw.first, draw.count, draw.instanceCount);
+                break;
+            }
+            case Op::DrawElements:
+            {
+                ElementsDraw draw = Read<ElementsDraw>(cursor);
+                state.DrawElements(draw.mode, draw.count, draw.type, nullptr, draw.instanceCount);
+                break;
+            }
+            case Op::Enable:
+                state.Enable(Read<GLenum>(cursor));
+                break;
+            case Op::Disable:
+                state.Disable(Read<GLenum>(cursor));
+                break;
+            case Op::DepthFunc:
+                state.DepthFunc(Read<GLenum>(cursor));
+                break;
+            case Op::DepthMask:
+                state.DepthMask(Read<GLboolean>(cursor));
+                break;
+            case Op::ColorMask:
+            {
+                Masks masks = Read<Masks>(cursor);
+                state.ColorMask(masks.r, masks.g, masks.b, masks.a);
+                break;
+            }
+        }
+    }
+}
+
+}  // namespace SpatialRender
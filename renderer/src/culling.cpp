@@ -0,0 +1,71 @@
+#include "culling.h"
+
+#include <cmath>
+
+namespace SpatialRender
+{
+
+void AABB::Expand(glm::vec3 const& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+AABB AABB::Transformed(glm::mat4 const& transform) const
+{
+    if (IsEmpty())
+        return *this;
+
+    // Arvo's method: project the extents onto each transformed axis
+    glm::vec3 center  = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+    glm::vec3 extents = GetExtents();
+    glm::vec3 newExtents(0.0f);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        newExtents += glm::abs(glm::vec3(transform[axis])) * extents[axis];
+    }
+
+    return AABB(center - newExtents, center + newExtents);
+}
+
+Frustum Frustum::FromMatrix(glm::mat4 const& viewProj)
+{
+    // Gribb/Hartmann extraction from the rows of the clip matrix
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    Frustum frustum;
+    frustum.planes = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2};
+
+    for (glm::vec4& plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+bool Frustum::Intersects(AABB const& box) const
+{
+    glm::vec3 center  = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+
+    for (glm::vec4 const& plane : planes)
+    {
+        glm::vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius   = glm::dot(glm::abs(normal), extents);
+        if (distance < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace SpatialRender
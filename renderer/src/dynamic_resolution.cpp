@@ -0,0 +1,65 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SpatialRender
+{
+
+ResolutionController::ResolutionController(ResolutionControllerConfig const& config) :
+    m_config(config)
+{
+    Reset(config.maxScale);
+}
+
+void ResolutionController::Reset(float scale)
+{
+    m_scale        = Clamp(scale);
+    m_desiredScale = m_scale;
+    m_error[0]     = 0.0f;
+    m_error[1]     = 0.0f;
+}
+
+void ResolutionController::SetConfig(ResolutionControllerConfig const& config)
+{
+    m_config       = config;
+    m_scale        = Clamp(m_scale);
+    m_desiredScale = Clamp(m_desiredScale);
+}
+
+float ResolutionController::Clamp(float scale) const
+{
+    return std::clamp(scale, m_config.minScale, m_config.maxScale);
+}
+
+float ResolutionController::Update(float gpuFrameMs)
+{
+    if (!(gpuFrameMs > 0.0f) || m_config.targetFrameMs <= 0.0f)
+        return m_scale;
+
+    // Positive error means there is headroom to raise the scale
+    float error = (m_config.targetFrameMs - gpuFrameMs) / m_config.targetFrameMs;
+    error       = std::clamp(error, -1.0f, 1.0f);
+    if (std::fabs(error) < m_config.deadband)
+    {
+        error = 0.0f;
+    }
+
+    float delta = m_config.kp * (error - m_error[0]) + m_config.ki * error +
+                  m_config.kd * (error - 2.0f * m_error[0] + m_error[1]);
+    m_error[1]     = m_error[0];
+    m_error[0]     = error;
+    m_desiredScale = Clamp(m_desiredScale + delta);
+
+    // Hysteresis: only move the render target once the change is worth it,
+    // or when the controller has settled on a limit
+    bool atLimit = m_desiredScale == m_config.minScale || m_desiredScale == m_config.maxScale;
+    if (std::fabs(m_desiredScale - m_scale) >= m_config.minStep ||
+        (atLimit && m_desiredScale != m_scale))
+    {
+        m_scale = m_desiredScale;
+    }
+    return m_scale;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,146 @@
+#include "frame_allocator.h"
+
+#include <algorithm>
+
+#include "memory_tracker.h"
+#include "parallel.h"
+
+namespace SpatialRender
+{
+
+LinearArena::LinearArena(size_t initialCapacity) :
+    m_initialCapacity(std::max<size_t>(initialCapacity, 256)),
+    m_offset(0),
+    m_used(0),
+    m_capacity(0),
+    m_systemAllocations(0)
+{}
+
+LinearArena::~LinearArena()
+{
+    MemoryTracker::Get().Release(MemoryResource::Host, (uintptr_t)this);
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    size = std::max<size_t>(size, 1);
+
+    for (;;)
+    {
+        if (!m_blocks.empty())
+        {
+            Block& block     = m_blocks.back();
+            uintptr_t base   = (uintptr_t)block.memory.get();
+            uintptr_t cursor = base + m_offset;
+            uintptr_t start  = (cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (start + size <= base + block.size)
+            {
+                m_used += start + size - cursor;
+                m_offset = start + size - base;
+                return (void*)start;
+            }
+        }
+
+        // The unused tail of the previous block stays counted as used
+        if (!m_blocks.empty())
+        {
+            m_used += m_blocks.back().size - m_offset;
+        }
+
+        size_t blockSize = std::max(m_initialCapacity, size + alignment);
+        if (!m_blocks.empty())
+        {
+            blockSize = std::max(blockSize, m_blocks.back().size * 2);
+        }
+        AddBlock(blockSize);
+    }
+}
+
+void LinearArena::Reset()
+{
+    // Replace an overflowed chain with one block that holds the whole frame
+    if (m_blocks.size() > 1)
+    {
+        size_t total = m_capacity;
+        m_blocks.clear();
+        m_capacity = 0;
+        AddBlock(total);
+    }
+
+    m_offset = 0;
+    m_used   = 0;
+}
+
+void LinearArena::AddBlock(size_t size)
+{
+    m_blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+    m_offset = 0;
+    m_capacity += size;
+    ++m_systemAllocations;
+
+    MemoryTracker::Get().Record(MemoryResource::Host,
+                                (uintptr_t)this,
+                                MemoryCategory::FrameArena,
+                                "LinearArena",
+                                m_capacity);
+}
+
+FrameAllocator::FrameAllocator(unsigned threadCount, size_t arenaCapacity) : m_peakHighWater(0)
+{
+    if (threadCount == 0)
+    {
+        threadCount = ThreadPool::Global().GetThreadCount();
+    }
+
+    m_arenas.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        m_arenas.push_back(std::make_unique<LinearArena>(arenaCapacity));
+    }
+}
+
+LinearArena& FrameAllocator::GetThreadArena()
+{
+    return *m_arenas[ThreadPool::CurrentThreadIndex()];
+}
+
+void FrameAllocator::Reset()
+{
+    m_peakHighWater = std::max(m_peakHighWater, GetHighWater());
+    for (std::unique_ptr<LinearArena>& arena : m_arenas)
+    {
+        arena->Reset();
+    }
+}
+
+size_t FrameAllocator::GetHighWater() const
+{
+    size_t total = 0;
+    for (std::unique_ptr<LinearArena> const& arena : m_arenas)
+    {
+        total += arena->GetUsedBytes();
+    }
+    return total;
+}
+
+size_t FrameAllocator::GetCapacity() const
+{
+    size_t total = 0;
+    for (std::unique_ptr<LinearArena> const& arena : m_arenas)
+    {
+        total += arena->GetCapacity();
+    }
+    return total;
+}
+
+uint64_t FrameAllocator::GetSystemAllocations() const
+{
+    uint64_t total = 0;
+    for (std::unique_ptr<LinearArena> const& arena : m_arenas)
+    {
+        total += arena->GetSystemAllocations();
+    }
+    return total;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,675 @@
+#include "frame_graph.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+struct TargetFormat
+{
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    uint32_t bytesPerPixel;
+};
+
+// Drivers store 24-bit depth in 32-bit texels
+constexpr TargetFormat kTargetFormats[] = {
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4},
+    {GL_RGBA16F, GL_RGBA, GL_FLOAT, 8},
+    {GL_RGBA32F, GL_RGBA, GL_FLOAT, 16},
+    {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1},
+    {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2},
+    {GL_R16F, GL_RED, GL_FLOAT, 2},
+    {GL_RG16F, GL_RG, GL_FLOAT, 4},
+    {GL_R32F, GL_RED, GL_FLOAT, 4},
+    {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4},
+    {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4},
+    {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4},
+};
+
+TargetFormat const* FindTargetFormat(GLenum internalFormat)
+{
+    for (TargetFormat const& format : kTargetFormats)
+    {
+        if (format.internalFormat == internalFormat)
+            return &format;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+bool IsDepthFormat(GLenum format)
+{
+    return format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F ||
+           format == GL_DEPTH24_STENCIL8;
+}
+
+size_t GetRenderTargetBytes(RenderTargetDesc const& desc)
+{
+    TargetFormat const* format = FindTargetFormat(desc.format);
+    if (!format || desc.width <= 0 || desc.height <= 0)
+        return 0;
+    return (size_t)desc.width * desc.height * format->bytesPerPixel;
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+    Shutdown();
+}
+
+GLuint RenderTargetPool::Acquire(RenderTargetDesc const& desc)
+{
+    for (PooledTexture& pooled : m_textures)
+    {
+        if (!pooled.inUse && pooled.desc == desc)
+        {
+            pooled.inUse = true;
+            pooled.used  = true;
+            return pooled.texture;
+        }
+    }
+
+    TargetFormat const* format = FindTargetFormat(desc.format);
+    size_t bytes               = GetRenderTargetBytes(desc);
+    if (bytes == 0)
+    {
+        std::cerr << "Unsupported render target " << desc.width << "x" << desc.height
+                  << " format 0x" << std::hex << desc.format << std::dec << std::endl;
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 desc.format,
+                 desc.width,
+                 desc.height,
+                 0,
+                 format->format,
+                 format->type,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    MemoryTracker::Get().Record(MemoryResource::Texture,
+                                texture,
+                                MemoryCategory::RenderTarget,
+                                "RenderTargetPool",
+                                bytes);
+    m_textures.push_back({texture, desc, true, true});
+    return texture;
+}
+
+void RenderTargetPool::Release(GLuint texture)
+{
+    for (PooledTexture& pooled : m_textures)
+    {
+        if (pooled.texture == texture)
+        {
+            pooled.inUse = false;
+            return;
+        }
+    }
+}
+
+GLuint RenderTargetPool::GetFramebuffer(GLuint const* colors, size_t colorCount, GLuint depth)
+{
+    if (colorCount > kMaxColorAttachments)
+        return 0;
+
+    std::array<GLuint, kMaxColorAttachments> key = {};
+    std::copy(colors, colors + colorCount, key.begin());
+    for (CachedFramebuffer const& cached : m_framebuffers)
+    {
+        if (cached.colors == key && cached.depth == depth)
+            return cached.framebuffer;
+    }
+
+    GLStateCache& state = GLStateCache::Get();
+    GLuint framebuffer  = 0;
+    glGenFramebuffers(1, &framebuffer);
+    state.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    GLenum drawBuffers[kMaxColorAttachments];
+    for (size_t i = 0; i < colorCount; ++i)
+    {
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + (GLenum)i;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[i], GL_TEXTURE_2D, colors[i], 0);
+    }
+    if (depth != 0)
+    {
+        auto pooled = std::find_if(m_textures.begin(), m_textures.end(), [&](auto const& entry) {
+            return entry.texture == depth;
+        });
+        GLenum attachment = pooled != m_textures.end() && pooled->desc.format == GL_DEPTH24_STENCIL8
+                                ? GL_DEPTH_STENCIL_ATTACHMENT
+                                : GL_DEPTH_ATTACHMENT;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth, 0);
+    }
+
+    if (colorCount > 0)
+    {
+        glDrawBuffers((GLsizei)colorCount, drawBuffers);
+    }
+    else
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Frame graph framebuffer is incomplete (0x" << std::hex << status << std::dec
+                  << ")" << std::endl;
+        state.DeleteFramebuffer(framebuffer);
+        return 0;
+    }
+
+    m_framebuffers.push_back({key, depth, framebuffer});
+    return framebuffer;
+}
+
+void RenderTargetPool::Trim()
+{
+    GLStateCache& state   = GLStateCache::Get();
+    MemoryTracker& memory = MemoryTracker::Get();
+
+    auto unused = [&](GLuint texture) {
+        return texture != 0 && std::any_of(m_textures.begin(), m_textures.end(), [&](auto& entry) {
+                   return entry.texture == texture && !entry.used;
+               });
+    };
+    auto stale = [&](CachedFramebuffer const& cached) {
+        return unused(cached.depth) ||
+               std::any_of(cached.colors.begin(), cached.colors.end(), unused);
+    };
+    for (CachedFramebuffer const& cached : m_framebuffers)
+    {
+        if (stale(cached))
+        {
+            state.DeleteFramebuffer(cached.framebuffer);
+        }
+    }
+    std::erase_if(m_framebuffers, stale);
+
+    for (PooledTexture const& pooled : m_textures)
+    {
+        if (!pooled.used)
+        {
+            memory.Release(MemoryResource::Texture, pooled.texture);
+            state.DeleteTexture(pooled.texture);
+        }
+    }
+    std::erase_if(m_textures, [](PooledTexture const& pooled) { return !pooled.used; });
+
+    for (PooledTexture& pooled : m_textures)
+    {
+        pooled.used = false;
+    }
+}
+
+void RenderTargetPool::Shutdown()
+{
+    for (PooledTexture& pooled : m_textures)
+    {
+        pooled.used = false;
+    }
+    Trim();
+}
+
+size_t RenderTargetPool::GetBytes() const
+{
+    size_t bytes = 0;
+    for (PooledTexture const& pooled : m_textures)
+    {
+        bytes += GetRenderTargetBytes(pooled.desc);
+    }
+    return bytes;
+}
+
+FrameGraphResource FrameGraph::PassBuilder::Create(std::string const& name,
+                                                   RenderTargetDesc const& desc)
+{
+    m_graph.m_resources.push_back({name, desc, false, 0, 0, -1, -1});
+    return (FrameGraphResource)(m_graph.m_resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::PassBuilder::Read(FrameGraphResource resource)
+{
+    if (resource >= m_graph.m_resources.size())
+        return kInvalidFrameGraphResource;
+    m_graph.m_passes[m_pass].reads.push_back(resource);
+    return resource;
+}
+
+FrameGraphResource FrameGraph::PassBuilder::Write(FrameGraphResource resource)
+{
+    if (resource >= m_graph.m_resources.size())
+        return kInvalidFrameGraphResource;
+    m_graph.m_passes[m_pass].writes.push_back(resource);
+    return resource;
+}
+
+void FrameGraph::PassBuilder::SetSideEffect()
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+GLuint FrameGraph::PassContext::GetTexture(FrameGraphResource resource) const
+{
+    return m_graph.GetTexture(resource);
+}
+
+FrameGraph::FrameGraph(RenderTargetPool& pool) : m_pool(pool), m_compiled(false) {}
+
+FrameGraphResource FrameGraph::Import(std::string const& name,
+                                      GLuint framebuffer,
+                                      int width,
+                                      int height)
+{
+    RenderTargetDesc desc;
+    desc.width  = width;
+    desc.height = height;
+    m_resources.push_back({name, desc, true, framebuffer, 0, -1, -1});
+    return (FrameGraphResource)(m_resources.size() - 1);
+}
+
+void FrameGraph::AddPass(std::string const& name,
+                         SetupFunction const& setup,
+                         ExecuteFunction execute)
+{
+    m_passes.push_back({name, std::move(execute), {}, {}, {}, {}, false, false});
+    m_compiled = false;
+    ++m_stats.passesDeclared;
+
+    PassBuilder builder(*this, m_passes.size() - 1);
+    setup(builder);
+}
+
+bool FrameGraph::Compile()
+{
+    SR_TRACE_ZONE("FrameGraph::Compile");
+
+    ReleaseTextures();
+    m_compiled = false;
+    if (!Link())
+        return false;
+    Cull();
+    Schedule();
+    Allocate();
+    m_compiled = true;
+    return true;
+}
+
+bool FrameGraph::Execute()
+{
+    SR_TRACE_ZONE("FrameGraph::Execute");
+
+    if (!m_compiled && !Compile())
+        return false;
+
+    GLStateCache& state = GLStateCache::Get();
+    bool bound          = false;
+    GLuint current      = 0;
+    for (size_t index : m_order)
+    {
+        Pass const& pass = m_passes[index];
+
+        int width  = 0;
+        int height = 0;
+        if (!pass.writes.empty())
+        {
+            Resource const& first = m_resources[pass.writes[0]];
+            GLuint framebuffer    = first.framebuffer;
+            width                 = first.desc.width;
+            height                = first.desc.height;
+            if (!first.imported)
+            {
+                GLuint colors[RenderTargetPool::kMaxColorAttachments];
+                size_t colorCount = 0;
+                GLuint depth      = 0;
+                for (FrameGraphResource write : pass.writes)
+                {
+                    Resource const& resource = m_resources[write];
+                    if (IsDepthFormat(resource.desc.format))
+                    {
+                        depth = resource.texture;
+                    }
+                    else
+                    {
+                        colors[colorCount++] = resource.texture;
+                    }
+                }
+                framebuffer = m_pool.GetFramebuffer(colors, colorCount, depth);
+                if (framebuffer == 0)
+                    return false;
+            }
+
+            if (!bound || framebuffer != current)
+            {
+                ++m_stats.targetSwitches;
+            }
+            bound   = true;
+            current = framebuffer;
+            state.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            state.Viewport(0, 0, width, height);
+        }
+
+        if (pass.execute)
+        {
+            pass.execute(PassContext(*this, width, height));
+        }
+    }
+    return true;
+}
+
+void FrameGraph::Reset()
+{
+    ReleaseTextures();
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+    m_compiled = false;
+    m_stats    = FrameGraphStats();
+}
+
+std::vector<std::string> FrameGraph::GetExecutionOrder() const
+{
+    std::vector<std::string> names;
+    for (size_t index : m_order)
+    {
+        names.push_back(m_passes[index].name);
+    }
+    return names;
+}
+
+bool FrameGraph::IsCulled(std::string const& pass) const
+{
+    for (Pass const& candidate : m_passes)
+    {
+        if (candidate.name == pass)
+            return candidate.culled;
+    }
+    return false;
+}
+
+bool FrameGraph::Link()
+{
+    // Dependencies follow declaration order, so the graph cannot have cycles
+    std::vector<size_t> const none;
+    std::vector<int64_t> lastWriter(m_resources.size(), -1);
+    std::vector<std::vector<size_t>> readersSinceWrite(m_resources.size());
+    for (size_t index = 0; index < m_passes.size(); ++index)
+    {
+        Pass& pass = m_passes[index];
+        pass.producers.clear();
+        pass.after.clear();
+        pass.culled = false;
+
+        size_t colorCount = 0;
+        size_t depthCount = 0;
+        bool imported     = false;
+        for (FrameGraphResource write : pass.writes)
+        {
+            Resource const& resource = m_resources[write];
+            imported |= resource.imported;
+            (IsDepthFormat(resource.desc.format) ? depthCount : colorCount) += 1;
+            if (std::find(pass.reads.begin(), pass.reads.end(), write) != pass.reads.end())
+            {
+                std::cerr << "Pass " << pass.name << " reads and writes " << resource.name
+                          << std::endl;
+                return false;
+            }
+            if (resource.desc.width != m_resources[pass.writes[0]].desc.width ||
+                resource.desc.height != m_resources[pass.writes[0]].desc.height)
+            {
+                std::cerr << "Pass " << pass.name << " writes targets of different sizes"
+                          << std::endl;
+                return false;
+            }
+        }
+        if (imported && pass.writes.size() > 1)
+        {
+            std::cerr << "Pass " << pass.name << " mixes an imported target with others"
+                      << std::endl;
+            return false;
+        }
+        if (colorCount > RenderTargetPool::kMaxColorAttachments || depthCount > 1)
+        {
+            std::cerr << "Pass " << pass.name << " writes too many targets" << std::endl;
+            return false;
+        }
+
+        for (FrameGraphResource read : pass.reads)
+        {
+            Resource const& resource = m_resources[read];
+            if (lastWriter[read] >= 0)
+            {
+                pass.producers.push_back((size_t)lastWriter[read]);
+            }
+            else if (!resource.imported)
+            {
+                std::cerr << "Pass " << pass.name << " reads " << resource.name
+                          << " before any pass writes it" << std::endl;
+                return false;
+            }
+        }
+
+        for (FrameGraphResource write : pass.writes)
+        {
+            // Writing on top of earlier content keeps its writer; earlier
+            // readers must see the content before this pass replaces it
+            if (lastWriter[write] >= 0)
+            {
+                pass.producers.push_back((size_t)lastWriter[write]);
+            }
+            std::vector<size_t>& readers = readersSinceWrite[write];
+            pass.after.insert(pass.after.end(), readers.begin(), readers.end());
+            readers.clear();
+
+            lastWriter[write] = (int64_t)index;
+        }
+        for (FrameGraphResource read : pass.reads)
+        {
+            readersSinceWrite[read].push_back(index);
+        }
+
+        pass.after.insert(pass.after.end(), pass.producers.begin(), pass.producers.end());
+    }
+    return true;
+}
+
+void FrameGraph::Cull()
+{
+    // Passes that write an imported target or have side effects are kept,
+    // along with everything that produced what they consume
+    std::vector<size_t> stack;
+    for (size_t index = 0; index < m_passes.size(); ++index)
+    {
+        Pass& pass = m_passes[index];
+        pass.culled =
+            !pass.sideEffect && std::none_of(pass.writes.begin(), pass.writes.end(), [&](auto w) {
+                return m_resources[w].imported;
+            });
+        if (!pass.culled)
+        {
+            stack.push_back(index);
+        }
+    }
+
+    while (!stack.empty())
+    {
+        Pass const& pass = m_passes[stack.back()];
+        stack.pop_back();
+        for (size_t producer : pass.producers)
+        {
+            if (m_passes[producer].culled)
+            {
+                m_passes[producer].culled = false;
+                stack.push_back(producer);
+            }
+        }
+    }
+
+    m_stats.passesCulled = 0;
+    for (Pass const& pass : m_passes)
+    {
+        m_stats.passesCulled += pass.culled ? 1 : 0;
+    }
+}
+
+void FrameGraph::Schedule()
+{
+    m_order.clear();
+
+    std::vector<uint32_t> pending(m_passes.size(), 0);
+    std::vector<std::vector<size_t>> dependents(m_passes.size());
+    for (size_t index = 0; index < m_passes.size(); ++index)
+    {
+        if (m_passes[index].culled)
+            continue;
+        for (size_t before : m_passes[index].after)
+        {
+            if (!m_passes[before].culled)
+            {
+                ++pending[index];
+                dependents[before].push_back(index);
+            }
+        }
+    }
+
+    std::vector<size_t> ready;
+    for (size_t index = 0; index < m_passes.size(); ++index)
+    {
+        if (!m_passes[index].culled && pending[index] == 0)
+        {
+            ready.push_back(index);
+        }
+    }
+
+    while (!ready.empty())
+    {
+        // Stay on the previous pass's framebuffer if anything can, then go in
+        // declaration order
+        auto next = std::min_element(ready.begin(), ready.end());
+        if (!m_order.empty())
+        {
+            Pass const& previous = m_passes[m_order.back()];
+            for (auto it = ready.begin(); it != ready.end(); ++it)
+            {
+                bool same = SameTarget(previous, m_passes[*it]);
+                if (same && (!SameTarget(previous, m_passes[*next]) || *it < *next))
+                {
+                    next = it;
+                }
+            }
+        }
+
+        size_t index = *next;
+        ready.erase(next);
+        m_order.push_back(index);
+        for (size_t dependent : dependents[index])
+        {
+            if (--pending[dependent] == 0)
+            {
+                ready.push_back(dependent);
+            }
+        }
+    }
+}
+
+void FrameGraph::Allocate()
+{
+    for (Resource& resource : m_resources)
+    {
+        resource.firstUse = -1;
+        resource.lastUse  = -1;
+    }
+    for (size_t position = 0; position < m_order.size(); ++position)
+    {
+        Pass const& pass = m_passes[m_order[position]];
+        for (auto const* uses : {&pass.reads, &pass.writes})
+        {
+            for (FrameGraphResource use : *uses)
+            {
+                Resource& resource = m_resources[use];
+                if (resource.firstUse < 0)
+                {
+                    resource.firstUse = (int)position;
+                }
+                resource.lastUse = (int)position;
+            }
+        }
+    }
+
+    m_stats.transientTargets = 0;
+    m_stats.textures         = 0;
+    m_stats.transientBytes   = 0;
+    m_stats.unaliasedBytes   = 0;
+    std::vector<GLuint> textures;
+    for (size_t position = 0; position < m_order.size(); ++position)
+    {
+        // Acquire everything the pass needs before handing anything on, so no
+        // two of its targets share a texture
+        for (Resource& resource : m_resources)
+        {
+            if (resource.imported || resource.firstUse != (int)position)
+                continue;
+
+            size_t bytes     = GetRenderTargetBytes(resource.desc);
+            resource.texture = m_pool.Acquire(resource.desc);
+            ++m_stats.transientTargets;
+            m_stats.unaliasedBytes += bytes;
+            if (std::find(textures.begin(), textures.end(), resource.texture) == textures.end())
+            {
+                textures.push_back(resource.texture);
+                m_stats.transientBytes += bytes;
+            }
+        }
+        for (Resource const& resource : m_resources)
+        {
+            if (!resource.imported && resource.lastUse == (int)position)
+            {
+                m_pool.Release(resource.texture);
+            }
+        }
+    }
+    m_stats.textures = (uint32_t)textures.size();
+}
+
+bool FrameGraph::SameTarget(Pass const& a, Pass const& b) const
+{
+    if (a.writes.empty() || a.writes.size() != b.writes.size())
+        return false;
+    return std::is_permutation(a.writes.begin(), a.writes.end(), b.writes.begin());
+}
+
+void FrameGraph::ReleaseTextures()
+{
+    // Compile() hands every texture back to the pool once its last pass is
+    // scheduled, so the assignments are only meaningful until the next one
+    for (Resource& resource : m_resources)
+    {
+        resource.texture = 0;
+    }
+}
+
+}  // namespace SpatialRender
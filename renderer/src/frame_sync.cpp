@@ -0,0 +1,76 @@
+#include "frame_sync.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+FrameSync::FrameSync(int framesInFlight) :
+    m_fences{},
+    m_framesInFlight(std::clamp(framesInFlight, 1, kMaxFramesInFlight)),
+    m_slot(0),
+    m_frameIndex(0),
+    m_lastWaitMs(0.0)
+{}
+
+void FrameSync::SetFramesInFlight(int count)
+{
+    count = std::clamp(count, 1, kMaxFramesInFlight);
+    if (count == m_framesInFlight)
+        return;
+
+    WaitIdle();
+    m_framesInFlight = count;
+}
+
+int FrameSync::BeginFrame()
+{
+    m_slot = (int)(m_frameIndex % (uint64_t)m_framesInFlight);
+
+    SR_TRACE_ZONE("FrameSync::Wait");
+    auto start = std::chrono::steady_clock::now();
+    Wait(m_slot);
+    auto end     = std::chrono::steady_clock::now();
+    m_lastWaitMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return m_slot;
+}
+
+void FrameSync::EndFrame()
+{
+    m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_frameIndex;
+}
+
+void FrameSync::WaitIdle()
+{
+    for (int slot = 0; slot < kMaxFramesInFlight; ++slot)
+    {
+        Wait(slot);
+    }
+}
+
+void FrameSync::Wait(int slot)
+{
+    GLsync fence = m_fences[slot];
+    if (!fence)
+        return;
+
+    // The first wait flushes so the fence is guaranteed to reach the GPU
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;)
+    {
+        GLenum result = glClientWaitSync(fence, flags, 1000000000ull);
+        if (result != GL_TIMEOUT_EXPIRED)
+            break;
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    m_fences[slot] = nullptr;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,422 @@
+#include "gl_state.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace SpatialRender
+{
+
+GLStateCache& GLStateCache::Get()
+{
+    static GLStateCache cache;
+    return cache;
+}
+
+GLStateCache::GLStateCache()
+{
+    Invalidate();
+}
+
+void GLStateCache::Invalidate()
+{
+    m_program     = kUnknown;
+    m_vertexArray = kUnknown;
+    m_buffers.fill(kUnknown);
+    m_drawFramebuffer   = kUnknown;
+    m_readFramebuffer   = kUnknown;
+    m_activeTextureUnit = kUnknown;
+    for (auto& unit : m_textures)
+    {
+        unit.fill(kUnknown);
+    }
+
+    m_caps = {{{GL_DEPTH_TEST, -1},
+               {GL_CULL_FACE, -1},
+               {GL_BLEND, -1},
+               {GL_SCISSOR_TEST, -1},
+               {GL_POLYGON_OFFSET_FILL, -1},
+               {GL_CLIP_DISTANCE0, -1},
+               {GL_CLIP_DISTANCE1, -1},
+               {GL_FRAMEBUFFER_SRGB, -1}}};
+
+    m_depthFunc = kUnknown;
+    m_depthMask = -1;
+    m_colorMask.fill(-1);
+    m_cullFace = kUnknown;
+    m_viewport.fill(-1);
+    m_clearColor.fill(std::numeric_limits<GLfloat>::quiet_NaN());
+}
+
+void GLStateCache::ResetStats()
+{
+    m_stats = GLStateStats();
+}
+
+template <typename T>
+bool GLStateCache::Update(T& cached, T const& value)
+{
+    if (cached == value)
+    {
+        ++m_stats.elidedCalls;
+        return false;
+    }
+
+    cached = value;
+    ++m_stats.issuedCalls;
+    return true;
+}
+
+int GLStateCache::GetBufferSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:
+            return kArrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return kElementArrayBuffer;
+        case GL_UNIFORM_BUFFER:
+            return kUniformBuffer;
+        case GL_TEXTURE_BUFFER:
+            return kTextureBuffer;
+        case GL_PIXEL_PACK_BUFFER:
+            return kPixelPackBuffer;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return kPixelUnpackBuffer;
+        case GL_COPY_READ_BUFFER:
+            return kCopyReadBuffer;
+        case GL_COPY_WRITE_BUFFER:
+            return kCopyWriteBuffer;
+        default:
+            return -1;
+    }
+}
+
+int GLStateCache::GetTextureSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:
+            return kTarget2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return kTarget2DArray;
+        case GL_TEXTURE_BUFFER:
+            return kTargetBuffer;
+        default:
+            return -1;
+    }
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+    if (Update(m_program, program))
+    {
+        ++m_stats.programSwitches;
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    if (Update(m_vertexArray, vao))
+    {
+        ++m_stats.vertexArrayBinds;
+        glBindVertexArray(vao);
+        // The element array binding is part of the VAO
+        m_buffers[kElementArrayBuffer] = kUnknown;
+    }
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+    int slot = GetBufferSlot(target);
+    if (slot < 0)
+    {
+        ++m_stats.issuedCalls;
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (Update(m_buffers[slot], buffer))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+    if (draw && read)
+    {
+        if (m_drawFramebuffer == framebuffer && m_readFramebuffer == framebuffer)
+        {
+            ++m_stats.elidedCalls;
+            return;
+        }
+        m_drawFramebuffer = framebuffer;
+        m_readFramebuffer = framebuffer;
+        ++m_stats.issuedCalls;
+        glBindFramebuffer(target, framebuffer);
+    }
+    else if (Update(draw ? m_drawFramebuffer : m_readFramebuffer, framebuffer))
+    {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    int slot = GetTextureSlot(target);
+    if (slot >= 0 && unit < kTrackedTextureUnits && m_textures[unit][slot] == texture)
+    {
+        ++m_stats.elidedCalls;
+        return;
+    }
+
+    if (Update(m_activeTextureUnit, unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    ++m_stats.issuedCalls;
+    glBindTexture(target, texture);
+    if (slot >= 0 && unit < kTrackedTextureUnits)
+    {
+        m_textures[unit][slot] = texture;
+    }
+}
+
+static void ApplyEnabled(GLenum cap, bool enabled)
+{
+    if (enabled)
+    {
+        glEnable(cap);
+    }
+    else
+    {
+        glDisable(cap);
+    }
+}
+
+void GLStateCache::SetEnabled(GLenum cap, bool enabled)
+{
+    for (CapState& state : m_caps)
+    {
+        if (state.cap != cap)
+            continue;
+
+        int8_t value = enabled ? 1 : 0;
+        if (Update(state.enabled, value))
+        {
+            ApplyEnabled(cap, enabled);
+        }
+        return;
+    }
+
+    // Untracked capability: always forward
+    ++m_stats.issuedCalls;
+    ApplyEnabled(cap, enabled);
+}
+
+void GLStateCache::Enable(GLenum cap)
+{
+    SetEnabled(cap, true);
+}
+
+void GLStateCache::Disable(GLenum cap)
+{
+    SetEnabled(cap, false);
+}
+
+void GLStateCache::DepthFunc(GLenum func)
+{
+    if (Update(m_depthFunc, func))
+    {
+        glDepthFunc(func);
+    }
+}
+
+void GLStateCache::DepthMask(GLboolean enabled)
+{
+    if (Update(m_depthMask, (GLint)enabled))
+    {
+        glDepthMask(enabled);
+    }
+}
+
+void GLStateCache::ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+    if (Update(m_colorMask, std::array<GLint, 4>{r, g, b, a}))
+    {
+        glColorMask(r, g, b, a);
+    }
+}
+
+void GLStateCache::CullFace(GLenum mode)
+{
+    if (Update(m_cullFace, mode))
+    {
+        glCullFace(mode);
+    }
+}
+
+void GLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (Update(m_viewport, std::array<GLint, 4>{x, y, width, height}))
+    {
+        glViewport(x, y, width, height);
+    }
+}
+
+void GLStateCache::ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    if (Update(m_clearColor, std::array<GLfloat, 4>{r, g, b, a}))
+    {
+        glClearColor(r, g, b, a);
+    }
+}
+
+void GLStateCache::CountDraw(GLenum mode, GLsizei count, GLsizei instanceCount)
+{
+    uint64_t instances = (uint64_t)std::max(instanceCount, 1);
+    uint64_t triangles = 0;
+    if (mode == GL_TRIANGLES)
+    {
+        triangles = count / 3;
+    }
+    else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count >= 3)
+    {
+        triangles = count - 2;
+    }
+
+    ++m_stats.drawCalls;
+    m_stats.vertices += (uint64_t)count * instances;
+    m_stats.triangles += triangles * instances;
+}
+
+void GLStateCache::DrawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+{
+    CountDraw(mode, count, instanceCount);
+    if (instanceCount > 1)
+    {
+        glDrawArraysInstanced(mode, first, count, instanceCount);
+    }
+    else
+    {
+        glDrawArrays(mode, first, count);
+    }
+}
+
+void GLStateCache::DrawElements(GLenum mode,
+                                GLsizei count,
+                                GLenum type,
+                                void const* indices,
+                                GLsizei instanceCount)
+{
+    CountDraw(mode, count, instanceCount);
+    if (instanceCount > 1)
+    {
+        glDrawElementsInstanced(mode, count, type, indices, instanceCount);
+    }
+    else
+    {
+        glDrawElements(mode, count, type, indices);
+    }
+}
+
+void GLStateCache::BufferData(GLenum target, GLsizeiptr size, void const* data, GLenum usage)
+{
+    // Allocating an uninitialised store transfers nothing
+    if (data != nullptr)
+    {
+        m_stats.bufferBytes += (uint64_t)size;
+    }
+    glBufferData(target, size, data, usage);
+}
+
+void GLStateCache::BufferSubData(GLenum target,
+                                 GLintptr offset,
+                                 GLsizeiptr size,
+                                 void const* data)
+{
+    m_stats.bufferBytes += (uint64_t)size;
+    glBufferSubData(target, offset, size, data);
+}
+
+void GLStateCache::DeleteProgram(GLuint program)
+{
+    if (program == 0)
+        return;
+
+    glDeleteProgram(program);
+    if (m_program == program)
+    {
+        // A bound program stays current until unbound, so force the next bind
+        m_program = kUnknown;
+    }
+}
+
+void GLStateCache::DeleteVertexArray(GLuint vao)
+{
+    if (vao == 0)
+        return;
+
+    glDeleteVertexArrays(1, &vao);
+    if (m_vertexArray == vao)
+    {
+        m_vertexArray                  = 0;
+        m_buffers[kElementArrayBuffer] = kUnknown;
+    }
+}
+
+void GLStateCache::DeleteBuffer(GLuint buffer)
+{
+    if (buffer == 0)
+        return;
+
+    glDeleteBuffers(1, &buffer);
+    for (GLuint& bound : m_buffers)
+    {
+        if (bound == buffer)
+        {
+            bound = 0;
+        }
+    }
+}
+
+void GLStateCache::DeleteFramebuffer(GLuint framebuffer)
+{
+    if (framebuffer == 0)
+        return;
+
+    glDeleteFramebuffers(1, &framebuffer);
+    if (m_drawFramebuffer == framebuffer)
+    {
+        m_drawFramebuffer = 0;
+    }
+    if (m_readFramebuffer == framebuffer)
+    {
+        m_readFramebuffer = 0;
+    }
+}
+
+void GLStateCache::DeleteTexture(GLuint texture)
+{
+    if (texture == 0)
+        return;
+
+    glDeleteTextures(1, &texture);
+    for (auto& unit : m_textures)
+    {
+        for (GLuint& bound : unit)
+        {
+            if (bound == texture)
+            {
+                bound = 0;
+            }
+        }
+    }
+}
+
+}  // namespace SpatialRender
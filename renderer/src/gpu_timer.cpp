@@ -0,0 +1,94 @@
+#include "gpu_timer.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+// Some drivers report a raw timestamp for the first query of a context
+constexpr double kMaxPlausibleMs = 1000.0;
+
+}  // namespace
+
+GpuTimer::GpuTimer() :
+    m_queries{},
+    m_issued{},
+    m_activeSlot(-1),
+    m_latestMs(0.0),
+    m_hasResult(false),
+    m_initialized(false)
+{}
+
+GpuTimer::~GpuTimer()
+{
+    Shutdown();
+}
+
+bool GpuTimer::Initialize()
+{
+    if (m_initialized)
+        return true;
+
+    glGenQueries(kSlotCount, m_queries.data());
+    m_issued.fill(false);
+    m_activeSlot  = -1;
+    m_hasResult   = false;
+    m_initialized = m_queries[0] != 0;
+    return m_initialized;
+}
+
+void GpuTimer::Shutdown()
+{
+    if (!m_initialized)
+        return;
+
+    End();
+    glDeleteQueries(kSlotCount, m_queries.data());
+    m_queries.fill(0);
+    m_initialized = false;
+}
+
+void GpuTimer::Begin(int slot)
+{
+    if (!m_initialized || m_activeSlot >= 0 || slot < 0 || slot >= kSlotCount)
+        return;
+
+    if (m_issued[slot])
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_queries[slot], GL_QUERY_RESULT, &nanoseconds);
+
+        double duration = (double)nanoseconds / 1.0e6;
+        if (duration <= kMaxPlausibleMs)
+        {
+            m_latestMs  = duration;
+            m_hasResult = true;
+        }
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[slot]);
+    m_issued[slot] = true;
+    m_activeSlot   = slot;
+}
+
+void GpuTimer::End()
+{
+    if (m_activeSlot < 0)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_activeSlot = -1;
+}
+
+bool GpuTimer::Poll(double& milliseconds)
+{
+    if (!m_hasResult)
+        return false;
+
+    milliseconds = m_latestMs;
+    m_hasResult  = false;
+    return true;
+}
+
+}  // namespace SpatialRender
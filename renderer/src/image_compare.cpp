@@ -0,0 +1,325 @@
+#include "image_compare.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPATIALRENDER_IMAGE_SSE2 1
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+struct DiffTotals
+{
+    uint64_t mismatched   = 0;
+    uint64_t squaredError = 0;
+    int maxDelta          = 0;
+};
+
+// Per-channel absolute differences over RGBA pixels. Channels are little-endian
+// within each 32-bit pixel, so alpha is the top byte.
+DiffTotals DiffPixels(uint8_t const* a,
+                      uint8_t const* b,
+                      size_t pixelCount,
+                      int tolerance,
+                      bool compareAlpha)
+{
+    DiffTotals totals;
+    int channels = compareAlpha ? 4 : 3;
+    size_t i     = 0;
+
+#if defined(SPATIALRENDER_IMAGE_SSE2)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const mask = _mm_set1_epi32(compareAlpha ? -1 : 0x00FFFFFF);
+    __m128i const tol  = _mm_set1_epi8((char)(uint8_t)std::clamp(tolerance, 0, 255));
+    __m128i maxDelta   = zero;
+    __m128i squared    = zero;
+
+    // Each 32-bit lane gains at most 2 * 2 * 255^2 per step; flush long before it wraps
+    auto flushSquared = [&]() {
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128((__m128i*)lanes, squared);
+        totals.squaredError += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        squared = zero;
+    };
+
+    int steps = 0;
+    for (; i + 4 <= pixelCount; i += 4)
+    {
+        __m128i va    = _mm_loadu_si128((__m128i const*)(a + i * 4));
+        __m128i vb    = _mm_loadu_si128((__m128i const*)(b + i * 4));
+        __m128i delta = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        delta         = _mm_and_si128(delta, mask);
+        maxDelta      = _mm_max_epu8(maxDelta, delta);
+
+        // A pixel matches when no channel exceeds the tolerance
+        __m128i excess  = _mm_subs_epu8(delta, tol);
+        __m128i matches = _mm_cmpeq_epi32(excess, zero);
+        int matchBits   = _mm_movemask_ps(_mm_castsi128_ps(matches));
+        totals.mismatched += 4 - std::popcount((unsigned)matchBits);
+
+        __m128i lo = _mm_unpacklo_epi8(delta, zero);
+        __m128i hi = _mm_unpackhi_epi8(delta, zero);
+        squared    = _mm_add_epi32(squared,
+                                _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        if (++steps == 4096)
+        {
+            flushSquared();
+            steps = 0;
+        }
+    }
+    flushSquared();
+
+    alignas(16) uint8_t maxLanes[16];
+    _mm_store_si128((__m128i*)maxLanes, maxDelta);
+    totals.maxDelta = *std::max_element(maxLanes, maxLanes + 16);
+#endif
+
+    for (; i < pixelCount; ++i)
+    {
+        bool mismatch = false;
+        for (int c = 0; c < channels; ++c)
+        {
+            int delta = std::abs((int)a[i * 4 + c] - (int)b[i * 4 + c]);
+            mismatch |= delta > tolerance;
+            totals.maxDelta = std::max(totals.maxDelta, delta);
+            totals.squaredError += (uint64_t)(delta * delta);
+        }
+        totals.mismatched += mismatch ? 1 : 0;
+    }
+    return totals;
+}
+
+void ComputeLuma(ImageView const& image, std::vector<uint8_t>& luma)
+{
+    size_t count = (size_t)image.width * image.height;
+    luma.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t const* p = image.pixels + i * 4;
+        luma[i]          = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+    }
+}
+
+struct WindowSums
+{
+    int64_t x  = 0;
+    int64_t y  = 0;
+    int64_t xx = 0;
+    int64_t yy = 0;
+    int64_t xy = 0;
+};
+
+WindowSums SumWindow(uint8_t const* x,
+                     uint8_t const* y,
+                     int stride,
+                     int left,
+                     int top,
+                     int width,
+                     int height)
+{
+    WindowSums sums;
+#if defined(SPATIALRENDER_IMAGE_SSE2)
+    if (width == 8)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const ones = _mm_set1_epi16(1);
+        __m128i sx = zero, sy = zero, sxx = zero, syy = zero, sxy = zero;
+        for (int row = top; row < top + height; ++row)
+        {
+            size_t offset = (size_t)row * stride + left;
+            __m128i vx    = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)(x + offset)), zero);
+            __m128i vy    = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)(y + offset)), zero);
+            sx            = _mm_add_epi32(sx, _mm_madd_epi16(vx, ones));
+            sy            = _mm_add_epi32(sy, _mm_madd_epi16(vy, ones));
+            sxx           = _mm_add_epi32(sxx, _mm_madd_epi16(vx, vx));
+            syy           = _mm_add_epi32(syy, _mm_madd_epi16(vy, vy));
+            sxy           = _mm_add_epi32(sxy, _mm_madd_epi16(vx, vy));
+        }
+
+        auto horizontalSum = [](__m128i v) {
+            alignas(16) int32_t lanes[4];
+            _mm_store_si128((__m128i*)lanes, v);
+            return (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        };
+        sums.x  = horizontalSum(sx);
+        sums.y  = horizontalSum(sy);
+        sums.xx = horizontalSum(sxx);
+        sums.yy = horizontalSum(syy);
+        sums.xy = horizontalSum(sxy);
+        return sums;
+    }
+#endif
+
+    for (int row = top; row < top + height; ++row)
+    {
+        for (int col = left; col < left + width; ++col)
+        {
+            int64_t vx = x[(size_t)row * stride + col];
+            int64_t vy = y[(size_t)row * stride + col];
+            sums.x += vx;
+            sums.y += vy;
+            sums.xx += vx * vx;
+            sums.yy += vy * vy;
+            sums.xy += vx * vy;
+        }
+    }
+    return sums;
+}
+
+double WindowSsim(WindowSums const& sums, int count)
+{
+    constexpr double kC1 = (0.01 * 255.0) * (0.01 * 255.0);
+    constexpr double kC2 = (0.03 * 255.0) * (0.03 * 255.0);
+
+    double n          = count;
+    double meanX      = sums.x / n;
+    double meanY      = sums.y / n;
+    double varianceX  = sums.xx / n - meanX * meanX;
+    double varianceY  = sums.yy / n - meanY * meanY;
+    double covariance = sums.xy / n - meanX * meanY;
+
+    return ((2.0 * meanX * meanY + kC1) * (2.0 * covariance + kC2)) /
+           ((meanX * meanX + meanY * meanY + kC1) * (varianceX + varianceY + kC2));
+}
+
+// Mean SSIM over 8x8 luma windows at a stride of 4; images smaller than one
+// window are treated as a single window
+double ComputeSsim(ImageView const& actual, ImageView const& expected)
+{
+    constexpr int kWindow = 8;
+    constexpr int kStride = 4;
+
+    std::vector<uint8_t> x, y;
+    ComputeLuma(actual, x);
+    ComputeLuma(expected, y);
+
+    int width  = actual.width;
+    int height = actual.height;
+    if (width < kWindow || height < kWindow)
+    {
+        return WindowSsim(SumWindow(x.data(), y.data(), width, 0, 0, width, height),
+                          width * height);
+    }
+
+    double total = 0.0;
+    int windows  = 0;
+    for (int top = 0; top + kWindow <= height; top += kStride)
+    {
+        for (int left = 0; left + kWindow <= width; left += kStride)
+        {
+            WindowSums sums = SumWindow(x.data(), y.data(), width, left, top, kWindow, kWindow);
+            total += WindowSsim(sums, kWindow * kWindow);
+            ++windows;
+        }
+    }
+    return total / windows;
+}
+
+}  // namespace
+
+ImageCompareResult CompareImages(ImageView const& actual,
+                                 ImageView const& expected,
+                                 ImageCompareOptions const& options)
+{
+    ImageCompareResult result;
+    result.sizeMatches = actual.width == expected.width && actual.height == expected.height;
+    if (!result.sizeMatches || !actual.pixels || !expected.pixels || actual.width <= 0 ||
+        actual.height <= 0)
+    {
+        result.sizeMatches = false;
+        return result;
+    }
+
+    size_t pixelCount = (size_t)actual.width * actual.height;
+    DiffTotals totals = DiffPixels(actual.pixels,
+                                   expected.pixels,
+                                   pixelCount,
+                                   options.channelTolerance,
+                                   options.compareAlpha);
+
+    int channels           = options.compareAlpha ? 4 : 3;
+    result.mismatched      = totals.mismatched;
+    result.mismatchPercent = 100.0 * totals.mismatched / pixelCount;
+    result.maxChannelDelta = totals.maxDelta;
+    result.mse             = (double)totals.squaredError / (pixelCount * channels);
+    result.psnr            = result.mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / result.mse)
+                                              : std::numeric_limits<double>::infinity();
+    result.ssim            = totals.squaredError > 0 ? ComputeSsim(actual, expected) : 1.0;
+    result.passed =
+        result.mismatchPercent <= options.maxMismatchPercent && result.ssim >= options.minSsim;
+    return result;
+}
+
+void BuildDiffImage(ImageView const& actual,
+                    ImageView const& expected,
+                    int channelTolerance,
+                    std::vector<uint8_t>& diff)
+{
+    size_t pixelCount = (size_t)expected.width * expected.height;
+    diff.resize(pixelCount * 4);
+    bool sameSize = actual.width == expected.width && actual.height == expected.height;
+
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        uint8_t const* e = expected.pixels + i * 4;
+        uint8_t* out     = diff.data() + i * 4;
+
+        int delta = 0;
+        if (sameSize)
+        {
+            uint8_t const* a = actual.pixels + i * 4;
+            for (int c = 0; c < 3; ++c)
+            {
+                delta = std::max(delta, std::abs((int)a[c] - (int)e[c]));
+            }
+        }
+
+        if (!sameSize || delta > channelTolerance)
+        {
+            // Brighter red for larger differences
+            out[0] = (uint8_t)std::min(255, 128 + delta);
+            out[1] = 0;
+            out[2] = 0;
+        }
+        else
+        {
+            uint8_t dimmed = (uint8_t)((77 * e[0] + 150 * e[1] + 29 * e[2]) >> 10);
+            out[0]         = dimmed;
+            out[1]         = dimmed;
+            out[2]         = dimmed;
+        }
+        out[3] = 255;
+    }
+}
+
+bool LoadImageRGBA(std::string const& path, std::vector<uint8_t>& pixels, int& width, int& height)
+{
+    int components = 0;
+    stbi_uc* data  = stbi_load(path.c_str(), &width, &height, &components, 4);
+    if (!data)
+        return false;
+
+    pixels.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+bool SaveImageRGBA(std::string const& path, ImageView const& image)
+{
+    return stbi_write_png(
+               path.c_str(), image.width, image.height, 4, image.pixels, image.width * 4) != 0;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,20 @@
+#include "image_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace SpatialRender
+{
+
+void FlipRowsVertically(uint8_t* pixels, int width, int height, int channels)
+{
+    size_t rowBytes = (size_t)width * channels;
+    for (int y = 0; y < height / 2; ++y)
+    {
+        uint8_t* top    = pixels + (size_t)y * rowBytes;
+        uint8_t* bottom = pixels + (size_t)(height - 1 - y) * rowBytes;
+        std::swap_ranges(top, top + rowBytes, bottom);
+    }
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,302 @@
+#include "material.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "shader.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+bool CreateBufferTexture(GLuint& buffer,
+                         GLuint& texture,
+                         size_t& capacity,
+                         GLuint unit,
+                         char const* owner)
+{
+    glGenBuffers(1, &buffer);
+    glGenTextures(1, &texture);
+    if (buffer == 0 || texture == 0)
+        return false;
+
+    // A buffer texture needs a data store even before the first upload
+    float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    GLStateCache& state = GLStateCache::Get();
+    state.BindBuffer(GL_TEXTURE_BUFFER, buffer);
+    state.BufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_DYNAMIC_DRAW);
+    capacity = sizeof(zero);
+    MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                buffer,
+                                MemoryCategory::TextureBuffer,
+                                owner,
+                                capacity);
+
+    state.BindTexture(unit, GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    return true;
+}
+
+// Grows the store with headroom, then overwrites its start
+void UploadBufferTexture(GLuint buffer,
+                         size_t& capacity,
+                         void const* data,
+                         size_t bytes,
+                         char const* owner)
+{
+    GLStateCache& state = GLStateCache::Get();
+    state.BindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (bytes > capacity)
+    {
+        capacity = bytes + bytes / 2;
+        state.BufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+        MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                    buffer,
+                                    MemoryCategory::TextureBuffer,
+                                    owner,
+                                    capacity);
+    }
+    state.BufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+}
+
+void ReleaseBufferTexture(GLuint& buffer, GLuint& texture)
+{
+    MemoryTracker::Get().Release(MemoryResource::Buffer, buffer);
+
+    GLStateCache& state = GLStateCache::Get();
+    state.DeleteTexture(texture);
+    state.DeleteBuffer(buffer);
+    buffer  = 0;
+    texture = 0;
+}
+
+}  // namespace
+
+MaterialLibrary::MaterialLibrary() :
+    m_tableBuffer(0),
+    m_tableTexture(0),
+    m_tableCapacity(0),
+    m_dirty(true),
+    m_revision(0)
+{}
+
+MaterialLibrary::~MaterialLibrary()
+{
+    Shutdown();
+}
+
+int32_t MaterialLibrary::AddTexture(TextureImage const& image)
+{
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+    {
+        if (!m_arrays[i]->IsFull() && m_arrays[i]->Matches(image))
+        {
+            return MakeTextureHandle((int)i, m_arrays[i]->AddLayer(image));
+        }
+    }
+
+    auto array = std::make_unique<TextureArray>();
+    if (!array->Create(image, kLayersPerArray, "Materials" + std::to_string(m_arrays.size())))
+        return -1;
+
+    int layer = array->AddLayer(image);
+    m_arrays.push_back(std::move(array));
+    return MakeTextureHandle((int)m_arrays.size() - 1, layer);
+}
+
+MaterialId MaterialLibrary::AddMaterial(Material const& material)
+{
+    m_materials.push_back(material);
+    m_dirty = true;
+    ++m_revision;
+    return (MaterialId)(m_materials.size() - 1);
+}
+
+void MaterialLibrary::SetMaterial(MaterialId id, Material const& material)
+{
+    m_materials[id] = material;
+    m_dirty         = true;
+    ++m_revision;
+}
+
+int MaterialLibrary::GetTextureArrayIndex(MaterialId id) const
+{
+    return GetArrayIndex(m_materials[id].texture);
+}
+
+glm::vec4 MaterialLibrary::PackMaterial(Material const& material)
+{
+    return glm::vec4(material.color, (float)GetLayer(material.texture));
+}
+
+void MaterialLibrary::Update()
+{
+    if (!m_dirty || m_materials.empty())
+        return;
+
+    SR_TRACE_ZONE("MaterialLibrary::Update");
+
+    if (m_tableBuffer == 0 && !CreateBufferTexture(m_tableBuffer,
+                                                   m_tableTexture,
+                                                   m_tableCapacity,
+                                                   kMaterialTableUnit,
+                                                   "MaterialLibrary"))
+    {
+        std::cerr << "Failed to create the material table" << std::endl;
+        ReleaseBufferTexture(m_tableBuffer, m_tableTexture);
+        return;
+    }
+
+    m_tableScratch.clear();
+    for (Material const& material : m_materials)
+    {
+        m_tableScratch.push_back(PackMaterial(material));
+    }
+    UploadBufferTexture(m_tableBuffer,
+                        m_tableCapacity,
+                        m_tableScratch.data(),
+                        m_tableScratch.size() * sizeof(glm::vec4),
+                        "MaterialLibrary");
+    m_dirty = false;
+}
+
+void MaterialLibrary::Apply(Shader& shader)
+{
+    GLStateCache::Get().BindTexture(kMaterialTableUnit, GL_TEXTURE_BUFFER, m_tableTexture);
+    shader.SetUniform("u_materials", (int)kMaterialTableUnit);
+    shader.SetUniform("u_materialTextures", (int)kTextureArrayUnit);
+}
+
+void MaterialLibrary::BindTextureArray(int index)
+{
+    if (index >= 0 && index < (int)m_arrays.size())
+    {
+        m_arrays[index]->Bind(kTextureArrayUnit);
+    }
+}
+
+void MaterialLibrary::Shutdown()
+{
+    m_materials.clear();
+    m_arrays.clear();
+    if (m_tableBuffer != 0)
+    {
+        ReleaseBufferTexture(m_tableBuffer, m_tableTexture);
+    }
+    m_tableCapacity = 0;
+    m_dirty         = true;
+    ++m_revision;
+}
+
+InstanceBuffer::InstanceBuffer() : m_frameSlot(0), m_maxTexels(0), m_initialized(false) {}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    Shutdown();
+}
+
+bool InstanceBuffer::Initialize()
+{
+    if (m_initialized)
+        return true;
+
+    for (SlotBuffer& slot : m_slots)
+    {
+        if (!CreateBufferTexture(slot.buffer, slot.texture, slot.capacity, kUnit, "InstanceBuffer"))
+        {
+            std::cerr << "Failed to create instance buffers" << std::endl;
+            Shutdown();
+            return false;
+        }
+    }
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    m_maxTexels   = (size_t)maxTexels;
+    m_initialized = true;
+    return true;
+}
+
+void InstanceBuffer::Shutdown()
+{
+    for (SlotBuffer& slot : m_slots)
+    {
+        if (slot.buffer != 0 || slot.texture != 0)
+        {
+            ReleaseBufferTexture(slot.buffer, slot.texture);
+        }
+        slot.capacity = 0;
+    }
+    m_data.clear();
+    m_initialized = false;
+}
+
+void InstanceBuffer::Begin(int frameSlot)
+{
+    m_frameSlot = frameSlot;
+    m_data.clear();
+}
+
+uint32_t InstanceBuffer::Add(glm::mat4 const& model, MaterialId material)
+{
+    size_t index = GetCount();
+    m_data.resize(m_data.size() + kTexelsPerInstance);
+    PackInstance(model, material, &m_data[index * kTexelsPerInstance]);
+    return (uint32_t)index;
+}
+
+void InstanceBuffer::Restore(std::vector<glm::vec4> const& texels)
+{
+    m_data = texels;
+}
+
+bool InstanceBuffer::Upload()
+{
+    if (!m_initialized)
+        return false;
+    if (m_data.size() > m_maxTexels)
+    {
+        std::cerr << "Batched instances exceed GL_MAX_TEXTURE_BUFFER_SIZE (" << GetCount()
+                  << " instances)" << std::endl;
+        m_data.clear();
+        return false;
+    }
+    if (m_data.empty())
+        return true;
+
+    // The frame slot's fence has signalled, so its store is free to overwrite
+    SlotBuffer& slot = m_slots[m_frameSlot];
+    UploadBufferTexture(slot.buffer,
+                        slot.capacity,
+                        m_data.data(),
+                        m_data.size() * sizeof(glm::vec4),
+                        "InstanceBuffer");
+    return true;
+}
+
+void InstanceBuffer::Apply(Shader& shader)
+{
+    GLStateCache::Get().BindTexture(kUnit, GL_TEXTURE_BUFFER, m_slots[m_frameSlot].texture);
+    shader.SetUniform("u_instanceData", (int)kUnit);
+}
+
+void InstanceBuffer::PackInstance(glm::mat4 const& model, MaterialId material, glm::vec4* texels)
+{
+    // glm is column-major; rows keep the fetch to three texels
+    for (int row = 0; row < 3; ++row)
+    {
+        texels[row] = glm::vec4(model[0][row], model[1][row], model[2][row], model[3][row]);
+    }
+
+    float bits;
+    std::memcpy(&bits, &material, sizeof(bits));
+    texels[3] = glm::vec4(bits, 0.0f, 0.0f, 0.0f);
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,216 @@
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include <GL/glew.h>
+
+namespace SpatialRender
+{
+
+char const* GetMemoryCategoryName(MemoryCategory category)
+{
+    switch (category)
+    {
+        case MemoryCategory::VertexBuffer:
+            return "vertex_buffer";
+        case MemoryCategory::IndexBuffer:
+            return "index_buffer";
+        case MemoryCategory::TextureBuffer:
+            return "texture_buffer";
+        case MemoryCategory::Texture:
+            return "texture";
+        case MemoryCategory::Renderbuffer:
+            return "renderbuffer";
+        case MemoryCategory::ShaderProgram:
+            return "shader_program";
+        case MemoryCategory::MeshData:
+            return "mesh_data";
+        case MemoryCategory::FrameArena:
+            return "frame_arena";
+        case MemoryCategory::StagingBuffer:
+            return "staging_buffer";
+        case MemoryCategory::TextureData:
+            return "texture_data";
+        case MemoryCategory::RenderTarget:
+            return "render_target";
+        default:
+            return "unknown";
+    }
+}
+
+bool IsGpuMemoryCategory(MemoryCategory category)
+{
+    return category != MemoryCategory::MeshData && category != MemoryCategory::FrameArena &&
+           category != MemoryCategory::TextureData;
+}
+
+MemoryTracker& MemoryTracker::Get()
+{
+    static MemoryTracker tracker;
+    return tracker;
+}
+
+static void AddUsage(MemoryUsage& usage, size_t bytes)
+{
+    usage.liveBytes += bytes;
+    usage.peakBytes = std::max(usage.peakBytes, usage.liveBytes);
+    ++usage.allocations;
+}
+
+static void RemoveUsage(MemoryUsage& usage, size_t bytes)
+{
+    usage.liveBytes -= std::min(usage.liveBytes, bytes);
+    usage.allocations -= usage.allocations > 0 ? 1 : 0;
+}
+
+void MemoryTracker::Add(MemoryCategory category, size_t bytes)
+{
+    AddUsage(m_categories[(size_t)category], bytes);
+    AddUsage(IsGpuMemoryCategory(category) ? m_gpu : m_cpu, bytes);
+}
+
+void MemoryTracker::Remove(MemoryCategory category, size_t bytes)
+{
+    RemoveUsage(m_categories[(size_t)category], bytes);
+    RemoveUsage(IsGpuMemoryCategory(category) ? m_gpu : m_cpu, bytes);
+}
+
+void MemoryTracker::Record(MemoryResource resource,
+                           uint64_t id,
+                           MemoryCategory category,
+                           std::string const& owner,
+                           size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto [it, inserted] = m_allocations.try_emplace({resource, id});
+    if (!inserted)
+    {
+        Remove(it->second.category, it->second.bytes);
+    }
+    it->second = {resource, id, category, owner, bytes};
+    Add(category, bytes);
+}
+
+void MemoryTracker::Release(MemoryResource resource, uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_allocations.find({resource, id});
+    if (it == m_allocations.end())
+        return;
+
+    Remove(it->second.category, it->second.bytes);
+    m_allocations.erase(it);
+}
+
+MemoryUsage MemoryTracker::GetUsage(MemoryCategory category) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_categories[(size_t)category];
+}
+
+MemoryUsage MemoryTracker::GetGpuUsage() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_gpu;
+}
+
+MemoryUsage MemoryTracker::GetCpuUsage() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cpu;
+}
+
+std::vector<MemoryAllocation> MemoryTracker::GetAllocations() const
+{
+    std::vector<MemoryAllocation> allocations;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        allocations.reserve(m_allocations.size());
+        for (auto const& entry : m_allocations)
+        {
+            allocations.push_back(entry.second);
+        }
+    }
+
+    std::stable_sort(allocations.begin(),
+                     allocations.end(),
+                     [](MemoryAllocation const& a, MemoryAllocation const& b) {
+                         return a.bytes > b.bytes;
+                     });
+    return allocations;
+}
+
+void MemoryTracker::Dump(std::ostream& out) const
+{
+    MemoryUsage gpu = GetGpuUsage();
+    MemoryUsage cpu = GetCpuUsage();
+    out << "GPU: " << gpu.liveBytes << " bytes live, " << gpu.peakBytes << " peak, "
+        << gpu.allocations << " allocations" << std::endl;
+    out << "CPU: " << cpu.liveBytes << " bytes live, " << cpu.peakBytes << " peak, "
+        << cpu.allocations << " allocations" << std::endl;
+
+    for (size_t i = 0; i < (size_t)MemoryCategory::Count; ++i)
+    {
+        MemoryUsage usage = GetUsage((MemoryCategory)i);
+        if (usage.peakBytes == 0)
+            continue;
+
+        out << "  " << std::left << std::setw(16) << GetMemoryCategoryName((MemoryCategory)i)
+            << std::right << std::setw(12) << usage.liveBytes << " live " << std::setw(12)
+            << usage.peakBytes << " peak" << std::endl;
+    }
+
+    for (MemoryAllocation const& allocation : GetAllocations())
+    {
+        out << "  " << std::left << std::setw(16) << GetMemoryCategoryName(allocation.category)
+            << std::setw(28) << allocation.owner << std::right << std::setw(12)
+            << allocation.bytes << std::endl;
+    }
+}
+
+void MemoryTracker::ResetPeaks()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (MemoryUsage& usage : m_categories)
+    {
+        usage.peakBytes = usage.liveBytes;
+    }
+    m_gpu.peakBytes = m_gpu.liveBytes;
+    m_cpu.peakBytes = m_cpu.liveBytes;
+}
+
+void MemoryTracker::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocations.clear();
+    m_categories.fill(MemoryUsage());
+    m_gpu = MemoryUsage();
+    m_cpu = MemoryUsage();
+}
+
+DeviceMemoryInfo QueryDeviceMemory()
+{
+    DeviceMemoryInfo info;
+    GLint values[4] = {0, 0, 0, 0};
+    if (GLEW_NVX_gpu_memory_info)
+    {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, values);
+        info.totalKb = values[0];
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, values);
+        info.freeKb    = values[0];
+        info.available = true;
+    }
+    else if (GLEW_ATI_meminfo)
+    {
+        // Total free memory in the texture pool, which shares the VBO pool
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, values);
+        info.freeKb    = values[0];
+        info.available = true;
+    }
+    return info;
+}
+
+}  // namespace SpatialRender
@@ -3,28 +3,70 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <utility>
+
+#include "command_buffer.h"
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "trace.h"
 
 namespace SpatialRender
 {
 
-Mesh::Mesh() : m_VAO(0), m_VBO(0), m_EBO(0), m_uploaded(false)
+Mesh::Mesh() :
+    m_VAO(0),
+    m_VBO(0),
+    m_EBO(0),
+    m_depthVAO(0),
+    m_positionVBO(0),
+    m_uploaded(false),
+    m_revision(0)
 {}
 
 Mesh::~Mesh()
 {
     Cleanup();
+    MemoryTracker::Get().Release(MemoryResource::Host, (uintptr_t)this);
 }
 
 void Mesh::SetVertices(std::vector<Vertex> const& vertices)
 {
-    m_vertices = vertices;
+    SetVertices(std::vector<Vertex>(vertices));
+}
+
+void Mesh::SetVertices(std::vector<Vertex>&& vertices)
+{
+    m_vertices = std::move(vertices);
     m_uploaded = false;
+    ++m_revision;
+
+    m_bounds = AABB();
+    for (Vertex const& vertex : m_vertices)
+    {
+        m_bounds.Expand(vertex.position);
+    }
+    TrackHostMemory();
 }
 
 void Mesh::SetIndices(std::vector<unsigned int> const& indices)
 {
-    m_indices  = indices;
+    SetIndices(std::vector<unsigned int>(indices));
+}
+
+void Mesh::SetIndices(std::vector<unsigned int>&& indices)
+{
+    m_indices  = std::move(indices);
     m_uploaded = false;
+    ++m_revision;
+    TrackHostMemory();
+}
+
+void Mesh::TrackHostMemory()
+{
+    size_t bytes =
+        m_vertices.capacity() * sizeof(Vertex) + m_indices.capacity() * sizeof(unsigned int);
+    MemoryTracker::Get().Record(
+        MemoryResource::Host, (uintptr_t)this, MemoryCategory::MeshData, "Mesh", bytes);
 }
 
 void Mesh::Upload()
@@ -32,16 +74,30 @@ void Mesh::Upload()
     if (m_uploaded)
         return;
 
+    SR_TRACE_ZONE("Mesh::Upload");
+
+    // Objects from an earlier upload would otherwise leak; the position stream
+    // is rebuilt from the new vertices on the next depth-only draw
+    Cleanup();
+
+    GLStateCache& state   = GLStateCache::Get();
+    MemoryTracker& memory = MemoryTracker::Get();
+
     glGenVertexArrays(1, &m_VAO);
     glGenBuffers(1, &m_VBO);
 
-    glBindVertexArray(m_VAO);
+    state.BindVertexArray(m_VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 m_vertices.size() * sizeof(Vertex),
-                 m_vertices.data(),
-                 GL_STATIC_DRAW);
+    state.BindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    state.BufferData(GL_ARRAY_BUFFER,
+                     m_vertices.size() * sizeof(Vertex),
+                     m_vertices.data(),
+                     GL_STATIC_DRAW);
+    memory.Record(MemoryResource::Buffer,
+                  m_VBO,
+                  MemoryCategory::VertexBuffer,
+                  "Mesh",
+                  m_vertices.size() * sizeof(Vertex));
 
     // Position
     glEnableVertexAttribArray(0);
@@ -73,61 +129,170 @@ void Mesh::Upload()
     if (!m_indices.empty())
     {
         glGenBuffers(1, &m_EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     m_indices.size() * sizeof(unsigned int),
-                     m_indices.data(),
-                     GL_STATIC_DRAW);
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+        state.BufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         m_indices.size() * sizeof(unsigned int),
+                         m_indices.data(),
+                         GL_STATIC_DRAW);
+        memory.Record(MemoryResource::Buffer,
+                      m_EBO,
+                      MemoryCategory::IndexBuffer,
+                      "Mesh",
+                      m_indices.size() * sizeof(unsigned int));
     }
 
-    glBindVertexArray(0);
+    // The VAO stays bound; the state cache elides the rebind in Render()
     m_uploaded = true;
+    ++m_revision;
 }
 
-void Mesh::Render()
+void Mesh::Render(int instanceCount)
 {
+    SR_TRACE_ZONE("Mesh::Render");
+
     if (!m_uploaded)
     {
         Upload();
     }
 
-    glBindVertexArray(m_VAO);
+    GLStateCache::Get().BindVertexArray(m_VAO);
+    Draw(instanceCount);
+}
 
+void Mesh::RenderDepthOnly(int instanceCount)
+{
+    SR_TRACE_ZONE("Mesh::RenderDepthOnly");
+
+    if (!m_uploaded)
+    {
+        Upload();
+    }
+    if (m_depthVAO == 0)
+    {
+        UploadPositionStream();
+    }
+
+    GLStateCache::Get().BindVertexArray(m_depthVAO);
+    Draw(instanceCount);
+}
+
+void Mesh::Draw(int instanceCount)
+{
+    GLStateCache& state = GLStateCache::Get();
     if (!m_indices.empty())
     {
-        glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+        state.DrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0, instanceCount);
     }
     else
     {
-        glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
+        state.DrawArrays(GL_TRIANGLES, 0, m_vertices.size(), instanceCount);
+    }
+}
+
+void Mesh::Record(CommandBuffer& commands, int instanceCount)
+{
+    if (!m_uploaded)
+    {
+        Upload();
     }
 
-    glBindVertexArray(0);
+    commands.BindVertexArray(m_VAO);
+    RecordDraw(commands, instanceCount);
 }
 
-void Mesh::Cleanup()
+void Mesh::RecordDepthOnly(CommandBuffer& commands, int instanceCount)
+{
+    if (!m_uploaded)
+    {
+        Upload();
+    }
+    if (m_depthVAO == 0)
+    {
+        UploadPositionStream();
+    }
+
+    commands.BindVertexArray(m_depthVAO);
+    RecordDraw(commands, instanceCount);
+}
+
+void Mesh::RecordDraw(CommandBuffer& commands, int instanceCount)
 {
-    if (m_VAO != 0)
+    if (!m_indices.empty())
+    {
+        commands.DrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, instanceCount);
+    }
+    else
     {
-        glDeleteVertexArrays(1, &m_VAO);
-        m_VAO = 0;
+        commands.DrawArrays(GL_TRIANGLES, 0, m_vertices.size(), instanceCount);
     }
-    if (m_VBO != 0)
+}
+
+void Mesh::UploadPositionStream()
+{
+    std::vector<glm::vec3> positions(m_vertices.size());
+    for (size_t i = 0; i < m_vertices.size(); ++i)
     {
-        glDeleteBuffers(1, &m_VBO);
-        m_VBO = 0;
+        positions[i] = m_vertices[i].position;
     }
+
+    GLStateCache& state = GLStateCache::Get();
+
+    glGenVertexArrays(1, &m_depthVAO);
+    glGenBuffers(1, &m_positionVBO);
+
+    state.BindVertexArray(m_depthVAO);
+    state.BindBuffer(GL_ARRAY_BUFFER, m_positionVBO);
+    state.BufferData(GL_ARRAY_BUFFER,
+                     positions.size() * sizeof(glm::vec3),
+                     positions.data(),
+                     GL_STATIC_DRAW);
+    MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                m_positionVBO,
+                                MemoryCategory::VertexBuffer,
+                                "Mesh position stream",
+                                positions.size() * sizeof(glm::vec3));
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
     if (m_EBO != 0)
     {
-        glDeleteBuffers(1, &m_EBO);
-        m_EBO = 0;
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
     }
+}
+
+void Mesh::ReleasePositionStream()
+{
+    MemoryTracker::Get().Release(MemoryResource::Buffer, m_positionVBO);
+
+    GLStateCache& state = GLStateCache::Get();
+    state.DeleteVertexArray(m_depthVAO);
+    state.DeleteBuffer(m_positionVBO);
+    m_depthVAO    = 0;
+    m_positionVBO = 0;
+}
+
+void Mesh::Cleanup()
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Release(MemoryResource::Buffer, m_VBO);
+    memory.Release(MemoryResource::Buffer, m_EBO);
+
+    GLStateCache& state = GLStateCache::Get();
+    state.DeleteVertexArray(m_VAO);
+    state.DeleteBuffer(m_VBO);
+    state.DeleteBuffer(m_EBO);
+    ReleasePositionStream();
+    m_VAO      = 0;
+    m_VBO      = 0;
+    m_EBO      = 0;
     m_uploaded = false;
+    ++m_revision;
 }
 
-Mesh* CreateCubeMesh()
+std::unique_ptr<Mesh> CreateCubeMesh()
 {
-    Mesh* mesh = new Mesh();
+    auto mesh = std::make_unique<Mesh>();
 
     std::vector<Vertex> vertices = {
         // Front face
@@ -156,55 +321,9 @@ Mesh* CreateCubeMesh()
     return mesh;
 }
 
-Mesh* CreateSphereMesh(int segments)
-{
-    Mesh* mesh = new Mesh();
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-
-    for (int y = 0; y <= segments; ++y)
-    {
-        for (int x = 0; x <= segments; ++x)
-        {
-            float xSegment = (float)x / (float)segments;
-            float ySegment = (float)y / (float)segments;
-            float xPos     = std::cos(xSegment * 2.0f * M_PI) * std::sin(ySegment * M_PI);
-            float yPos     = std::cos(ySegment * M_PI);
-            float zPos     = std::sin(xSegment * 2.0f * M_PI) * std::sin(ySegment * M_PI);
-
-            Vertex v;
-            v.position = glm::vec3(xPos, yPos, zPos) * 0.5f;
-            v.normal   = glm::normalize(glm::vec3(xPos, yPos, zPos));
-            v.texCoord = glm::vec2(xSegment, ySegment);
-            vertices.push_back(v);
-        }
-    }
-
-    for (int y = 0; y < segments; ++y)
-    {
-        for (int x = 0; x < segments; ++x)
-        {
-            int first  = y * (segments + 1) + x;
-            int second = first + segments + 1;
-
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
-    }
-
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
-    return mesh;
-}
-
-Mesh* CreatePlaneMesh(float width, float height)
+std::unique_ptr<Mesh> CreatePlaneMesh(float width, float height)
 {
-    Mesh* mesh = new Mesh();
+    auto mesh = std::make_unique<Mesh>();
 
     float w = width * 0.5f;
     float h = height * 0.5f;
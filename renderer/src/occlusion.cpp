@@ -0,0 +1,355 @@
+#include "occlusion.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPATIALRENDER_OCCLUSION_SSE2 1
+#endif
+
+#include "mesh.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+// Clip-space w below which a vertex is treated as touching the eye plane
+constexpr float kMinClipW = 1e-5f;
+
+double ElapsedMs(std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}  // namespace
+
+OcclusionCuller::OcclusionCuller(int width, int height) :
+    m_width(std::max(kTileWidth, width - width % kTileWidth)),
+    m_height(std::max(kTileHeight, height - height % kTileHeight)),
+    m_tilesX(m_width / kTileWidth),
+    m_tilesY(m_height / kTileHeight),
+    m_depth(m_width * m_height, 1.0f),
+    m_tileMaxDepth(m_tilesX * m_tilesY, 1.0f)
+{}
+
+void OcclusionCuller::Cull(std::vector<SceneObject> const& objects, glm::mat4 const& viewProj)
+{
+    SR_TRACE_ZONE("OcclusionCuller::Cull");
+
+    auto rasterStart = std::chrono::steady_clock::now();
+    m_stats          = OcclusionStats();
+
+    SetupOccluders(objects, viewProj);
+
+    // A few bands per thread keeps workers busy when occluders cluster on screen
+    size_t bandCount = std::max(1u, ThreadPool::Global().GetThreadCount() * 4);
+    size_t bandRows  = std::max<size_t>(1, m_tilesY / bandCount);
+    ParallelFor(m_tilesY, bandRows, [this](size_t begin, size_t end, unsigned) {
+        RasterizeBand((int)begin, (int)end);
+    });
+
+    auto testStart = std::chrono::steady_clock::now();
+    Frustum frustum = Frustum::FromMatrix(viewProj);
+
+    m_visibility.assign(objects.size(), 1);
+    std::atomic<size_t> tested(0);
+    std::atomic<size_t> frustumCulled(0);
+    std::atomic<size_t> occluded(0);
+
+    ParallelFor(objects.size(), 256, [&](size_t begin, size_t end, unsigned) {
+        size_t localTested = 0, localFrustum = 0, localOccluded = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            SceneObject const& obj = objects[i];
+            if (!obj.mesh)
+                continue;
+
+            ++localTested;
+            AABB bounds       = obj.mesh->GetBounds().Transformed(obj.transform);
+            TestResult result = TestBounds(bounds, viewProj, frustum);
+            if (result == TestResult::FrustumCulled)
+            {
+                m_visibility[i] = 0;
+                ++localFrustum;
+            }
+            else if (result == TestResult::Occluded)
+            {
+                m_visibility[i] = 0;
+                ++localOccluded;
+            }
+        }
+        tested += localTested;
+        frustumCulled += localFrustum;
+        occluded += localOccluded;
+    });
+
+    auto testEnd            = std::chrono::steady_clock::now();
+    m_stats.objectsTested   = tested;
+    m_stats.frustumCulled   = frustumCulled;
+    m_stats.occlusionCulled = occluded;
+    m_stats.rasterizeMs     = ElapsedMs(rasterStart, testStart);
+    m_stats.testMs          = ElapsedMs(testStart, testEnd);
+}
+
+void OcclusionCuller::SetupOccluders(std::vector<SceneObject> const& objects,
+                                     glm::mat4 const& viewProj)
+{
+    m_triangles.clear();
+
+    for (SceneObject const& obj : objects)
+    {
+        if (!obj.occluder || !obj.mesh)
+            continue;
+
+        ++m_stats.occluders;
+        glm::mat4 mvp = viewProj * obj.transform;
+
+        std::vector<Vertex> const& vertices      = obj.mesh->GetVertices();
+        std::vector<unsigned int> const& indices = obj.mesh->GetIndices();
+
+        m_clipScratch.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            m_clipScratch[i] = mvp * glm::vec4(vertices[i].position, 1.0f);
+        }
+
+        size_t triangleCount = indices.empty() ? vertices.size() / 3 : indices.size() / 3;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            glm::vec4 c[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                size_t index = indices.empty() ? t * 3 + k : indices[t * 3 + k];
+                c[k]         = m_clipScratch[index];
+            }
+
+            // Occluders only need to be conservative, so triangles crossing the
+            // near plane are dropped instead of clipped
+            bool nearClipped = false;
+            for (int k = 0; k < 3; ++k)
+            {
+                nearClipped |= c[k].w <= kMinClipW || c[k].z < -c[k].w;
+            }
+            if (nearClipped)
+                continue;
+
+            // Trivially outside one side of the frustum
+            if ((c[0].x > c[0].w && c[1].x > c[1].w && c[2].x > c[2].w) ||
+                (c[0].x < -c[0].w && c[1].x < -c[1].w && c[2].x < -c[2].w) ||
+                (c[0].y > c[0].w && c[1].y > c[1].w && c[2].y > c[2].w) ||
+                (c[0].y < -c[0].w && c[1].y < -c[1].w && c[2].y < -c[2].w))
+            {
+                continue;
+            }
+
+            ScreenTriangle tri;
+            for (int k = 0; k < 3; ++k)
+            {
+                glm::vec3 ndc = glm::vec3(c[k]) / c[k].w;
+                tri.v[k] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_width,
+                                     (ndc.y * 0.5f + 0.5f) * m_height,
+                                     glm::clamp(ndc.z * 0.5f + 0.5f, 0.0f, 1.0f));
+            }
+            tri.minY = std::min({tri.v[0].y, tri.v[1].y, tri.v[2].y});
+            tri.maxY = std::max({tri.v[0].y, tri.v[1].y, tri.v[2].y});
+            m_triangles.push_back(tri);
+        }
+    }
+
+    m_stats.occluderTriangles = m_triangles.size();
+}
+
+void OcclusionCuller::RasterizeBand(int tileRowBegin, int tileRowEnd)
+{
+    int rowBegin = tileRowBegin * kTileHeight;
+    int rowEnd   = tileRowEnd * kTileHeight;
+
+    std::fill(m_depth.begin() + rowBegin * m_width, m_depth.begin() + rowEnd * m_width, 1.0f);
+
+    for (ScreenTriangle const& tri : m_triangles)
+    {
+        if (tri.maxY < (float)rowBegin || tri.minY > (float)rowEnd)
+            continue;
+        RasterizeTriangle(tri, rowBegin, rowEnd);
+    }
+
+    // Reduce each tile to its farthest depth
+    for (int ty = tileRowBegin; ty < tileRowEnd; ++ty)
+    {
+        for (int tx = 0; tx < m_tilesX; ++tx)
+        {
+            float maxDepth = 0.0f;
+            for (int y = 0; y < kTileHeight; ++y)
+            {
+                float const* row = &m_depth[(ty * kTileHeight + y) * m_width + tx * kTileWidth];
+                for (int x = 0; x < kTileWidth; ++x)
+                {
+                    maxDepth = std::max(maxDepth, row[x]);
+                }
+            }
+            m_tileMaxDepth[ty * m_tilesX + tx] = maxDepth;
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(ScreenTriangle const& tri, int rowBegin, int rowEnd)
+{
+    glm::vec3 v0 = tri.v[0];
+    glm::vec3 v1 = tri.v[1];
+    glm::vec3 v2 = tri.v[2];
+
+    // Both windings are rasterized so single-sided walls occlude from behind too
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::abs(area) < 1e-8f)
+        return;
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    int minX = std::max(0, (int)std::floor(std::min({v0.x, v1.x, v2.x})));
+    int maxX = std::min(m_width - 1, (int)std::ceil(std::max({v0.x, v1.x, v2.x})));
+    int minY = std::max(rowBegin, (int)std::floor(tri.minY));
+    int maxY = std::min(rowEnd - 1, (int)std::ceil(tri.maxY));
+    if (minX > maxX || minY > maxY)
+        return;
+
+    // Edge functions e(p) = a * p.x + b * p.y + c, positive inside
+    glm::vec3 const* edges[3][2] = {{&v1, &v2}, {&v2, &v0}, {&v0, &v1}};
+    float a[3], b[3], c[3];
+    for (int e = 0; e < 3; ++e)
+    {
+        glm::vec3 const& p = *edges[e][0];
+        glm::vec3 const& q = *edges[e][1];
+        a[e]               = p.y - q.y;
+        b[e]               = q.x - p.x;
+        c[e]               = -(a[e] * p.x + b[e] * p.y);
+    }
+
+    // Depth is affine in screen space after the perspective divide
+    float invArea = 1.0f / area;
+    float za      = (a[0] * v0.z + a[1] * v1.z + a[2] * v2.z) * invArea;
+    float zb      = (b[0] * v0.z + b[1] * v1.z + b[2] * v2.z) * invArea;
+    float zc      = (c[0] * v0.z + c[1] * v1.z + c[2] * v2.z) * invArea;
+
+    // Width is a multiple of the tile width, so 4-wide groups never run off a row
+    int startX = minX & ~3;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py   = (float)y + 0.5f;
+        float* row = &m_depth[y * m_width];
+        float e0y  = b[0] * py + c[0];
+        float e1y  = b[1] * py + c[1];
+        float e2y  = b[2] * py + c[2];
+        float zy   = zb * py + zc;
+
+#if defined(SPATIALRENDER_OCCLUSION_SSE2)
+        __m128 const zero  = _mm_setzero_ps();
+        __m128 const lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        for (int x = startX; x <= maxX; x += 4)
+        {
+            __m128 px     = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 e0     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), _mm_set1_ps(e0y));
+            __m128 e1     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), _mm_set1_ps(e1y));
+            __m128 e2     = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), _mm_set1_ps(e2y));
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                       _mm_cmpge_ps(e2, zero));
+            __m128 z      = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zy));
+            __m128 old    = _mm_loadu_ps(row + x);
+            __m128 nearer = _mm_min_ps(old, z);
+            _mm_storeu_ps(row + x,
+                          _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+        }
+#else
+        for (int x = startX; x <= maxX; ++x)
+        {
+            float px = (float)x + 0.5f;
+            bool inside =
+                (a[0] * px + e0y >= 0.0f) & (a[1] * px + e1y >= 0.0f) & (a[2] * px + e2y >= 0.0f);
+            float z = za * px + zy;
+            row[x]  = inside ? std::min(row[x], z) : row[x];
+        }
+#endif
+    }
+}
+
+OcclusionCuller::TestResult OcclusionCuller::TestBounds(AABB const& worldBounds,
+                                                        glm::mat4 const& viewProj,
+                                                        Frustum const& frustum) const
+{
+    if (worldBounds.IsEmpty())
+        return TestResult::Visible;
+    if (!frustum.Intersects(worldBounds))
+        return TestResult::FrustumCulled;
+
+    // Screen-space rectangle and nearest depth of the box
+    float minX = m_width, maxX = 0.0f;
+    float minY = m_height, maxY = 0.0f;
+    float minZ = 1.0f;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 p((corner & 1) ? worldBounds.max.x : worldBounds.min.x,
+                    (corner & 2) ? worldBounds.max.y : worldBounds.min.y,
+                    (corner & 4) ? worldBounds.max.z : worldBounds.min.z);
+        glm::vec4 clip = viewProj * glm::vec4(p, 1.0f);
+        if (clip.w <= kMinClipW || clip.z < -clip.w)
+        {
+            // Box reaches the near plane; it covers the view, keep it
+            return TestResult::Visible;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        float x       = (ndc.x * 0.5f + 0.5f) * m_width;
+        float y       = (ndc.y * 0.5f + 0.5f) * m_height;
+        minX          = std::min(minX, x);
+        maxX          = std::max(maxX, x);
+        minY          = std::min(minY, y);
+        maxY          = std::max(maxY, y);
+        minZ          = std::min(minZ, ndc.z * 0.5f + 0.5f);
+    }
+
+    int x0 = std::max(0, (int)std::floor(minX));
+    int x1 = std::min(m_width - 1, (int)std::floor(maxX));
+    int y0 = std::max(0, (int)std::floor(minY));
+    int y1 = std::min(m_height - 1, (int)std::floor(maxY));
+    if (x0 > x1 || y0 > y1)
+        return TestResult::FrustumCulled;
+
+    for (int ty = y0 / kTileHeight; ty <= y1 / kTileHeight; ++ty)
+    {
+        for (int tx = x0 / kTileWidth; tx <= x1 / kTileWidth; ++tx)
+        {
+            // Every occluder pixel in this tile is nearer than the box
+            if (m_tileMaxDepth[ty * m_tilesX + tx] < minZ)
+                continue;
+
+            int px0 = std::max(x0, tx * kTileWidth);
+            int px1 = std::min(x1, tx * kTileWidth + kTileWidth - 1);
+            int py0 = std::max(y0, ty * kTileHeight);
+            int py1 = std::min(y1, ty * kTileHeight + kTileHeight - 1);
+            for (int y = py0; y <= py1; ++y)
+            {
+                float const* row = &m_depth[y * m_width];
+                for (int x = px0; x <= px1; ++x)
+                {
+                    if (row[x] >= minZ)
+                        return TestResult::Visible;
+                }
+            }
+        }
+    }
+
+    return TestResult::Occluded;
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,168 @@
+#include "parallel.h"
+
+#include <string>
+
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+thread_local unsigned t_threadIndex = 0;
+thread_local bool t_insideRun       = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(int workerCount) :
+    m_task(nullptr),
+    m_taskCount(0),
+    m_nextTask(0),
+    m_completedTasks(0),
+    m_activeWorkers(0),
+    m_generation(0),
+    m_stopping(false)
+{
+    if (workerCount < 0)
+    {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        workerCount              = hardwareThreads > 1 ? (int)hardwareThreads - 1 : 0;
+    }
+
+    m_workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, (unsigned)i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+unsigned ThreadPool::CurrentThreadIndex()
+{
+    return t_threadIndex;
+}
+
+void ThreadPool::Run(size_t taskCount, std::function<void(size_t, unsigned)> const& task)
+{
+    if (taskCount == 0)
+        return;
+
+    // Nested or trivially small work runs inline on the calling thread
+    if (t_insideRun || m_workers.empty() || taskCount == 1)
+    {
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            task(i, t_threadIndex);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task           = &task;
+        m_taskCount      = taskCount;
+        m_completedTasks = 0;
+        m_nextTask.store(0);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    t_insideRun = true;
+    Execute(task, taskCount, t_threadIndex);
+    t_insideRun = false;
+
+    // Wait for stragglers so no worker still references `task` after return
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock,
+                    [this] { return m_completedTasks == m_taskCount && m_activeWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::Execute(std::function<void(size_t, unsigned)> const& task,
+                         size_t taskCount,
+                         unsigned threadIndex)
+{
+    SR_TRACE_ZONE("ThreadPool::Execute");
+
+    size_t completed = 0;
+    for (;;)
+    {
+        size_t index = m_nextTask.fetch_add(1);
+        if (index >= taskCount)
+            break;
+
+        task(index, threadIndex);
+        ++completed;
+    }
+
+    if (completed > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completedTasks += completed;
+        if (m_completedTasks == m_taskCount)
+        {
+            m_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(unsigned threadIndex)
+{
+    t_threadIndex = threadIndex;
+    t_insideRun   = true;
+#if defined(SPATIALRENDER_TRACING)
+    Tracer::Get().SetThreadName("Worker " + std::to_string(threadIndex));
+#endif
+
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        std::function<void(size_t, unsigned)> const* task = nullptr;
+        size_t taskCount                                   = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping)
+                return;
+
+            seenGeneration = m_generation;
+            task           = m_task;
+            taskCount      = m_taskCount;
+            ++m_activeWorkers;
+        }
+
+        if (task)
+        {
+            Execute(*task, taskCount, threadIndex);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_activeWorkers == 0)
+        {
+            m_finished.notify_all();
+        }
+    }
+}
+
+}  // namespace SpatialRender
@@ -0,0 +1,549 @@
+#include "procedural.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPATIALRENDER_PROCEDURAL_SSE2 1
+#endif
+
+#include "mesh.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+// Rows are handed to the pool in chunks of roughly this many vertices, so
+// small meshes are generated inline on the calling thread
+constexpr size_t kVerticesPerTask = 8192;
+
+size_t RowGrain(size_t rowLength)
+{
+    return std::max<size_t>(1, kVerticesPerTask / std::max<size_t>(rowLength, 1));
+}
+
+// One ring of a surface of revolution: where the profile curve sits in the
+// (radial, y) half-plane and its outward normal there
+struct ProfileRow
+{
+    double radius;
+    double y;
+    double normalRadial;
+    double normalY;
+    float v;
+};
+
+// Cosine and sine of every column angle, in double precision and from a float
+// fraction exactly as the original sphere factory computed them per vertex
+void BuildColumnTable(int segments, std::vector<double>& cosines, std::vector<double>& sines)
+{
+    cosines.resize(segments + 1);
+    sines.resize(segments + 1);
+    for (int i = 0; i <= segments; ++i)
+    {
+        float u     = (float)i / (float)segments;
+        double turn = u * 2.0f * std::numbers::pi;
+        cosines[i]  = std::cos(turn);
+        sines[i]    = std::sin(turn);
+    }
+}
+
+void WriteRevolvedRow(Vertex* out,
+                      ProfileRow const& row,
+                      double const* cosines,
+                      double const* sines,
+                      int segments)
+{
+    int count     = segments + 1;
+    float y       = (float)row.y;
+    float normalY = (float)row.normalY;
+    int i         = 0;
+
+#if defined(SPATIALRENDER_PROCEDURAL_SSE2)
+    __m128d const radius = _mm_set1_pd(row.radius);
+    __m128d const radial = _mm_set1_pd(row.normalRadial);
+    __m128 const one     = _mm_set1_ps(1.0f);
+    __m128 const ny      = _mm_set1_ps(normalY);
+
+    // Products stay in double before rounding, like the scalar path
+    auto scale = [](__m128d factor, double const* values) {
+        __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(factor, _mm_loadu_pd(values)));
+        __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(factor, _mm_loadu_pd(values + 2)));
+        return _mm_movelh_ps(lo, hi);
+    };
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 nx = scale(radial, cosines + i);
+        __m128 nz = scale(radial, sines + i);
+
+        // Same operations as the scalar path and glm::normalize, in the same order
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+                                     _mm_mul_ps(nz, nz));
+        __m128 inverse  = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+        alignas(16) float lanes[5][4];
+        _mm_store_ps(lanes[0], scale(radius, cosines + i));
+        _mm_store_ps(lanes[1], scale(radius, sines + i));
+        _mm_store_ps(lanes[2], _mm_mul_ps(nx, inverse));
+        _mm_store_ps(lanes[3], _mm_mul_ps(ny, inverse));
+        _mm_store_ps(lanes[4], _mm_mul_ps(nz, inverse));
+
+        for (int k = 0; k < 4; ++k)
+        {
+            Vertex& vertex  = out[i + k];
+            vertex.position = glm::vec3(lanes[0][k], y, lanes[1][k]);
+            vertex.normal   = glm::vec3(lanes[2][k], lanes[3][k], lanes[4][k]);
+            vertex.texCoord = glm::vec2((float)(i + k) / (float)segments, row.v);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float nx      = (float)(row.normalRadial * cosines[i]);
+        float nz      = (float)(row.normalRadial * sines[i]);
+        float inverse = 1.0f / std::sqrt(nx * nx + normalY * normalY + nz * nz);
+
+        Vertex& vertex = out[i];
+        vertex.position =
+            glm::vec3((float)(row.radius * cosines[i]), y, (float)(row.radius * sines[i]));
+        vertex.normal   = glm::vec3(nx * inverse, normalY * inverse, nz * inverse);
+        vertex.texCoord = glm::vec2((float)i / (float)segments, row.v);
+    }
+}
+
+// Two triangles per quad between row r and row r + 1. The default order is
+// (a, b, a + 1), (b, b + 1, a + 1) with b on the next row; reversed flips every
+// triangle.
+void WriteQuadRow(unsigned int* out,
+                  unsigned int first,
+                  unsigned int rowLength,
+                  int columns,
+                  bool reversed)
+{
+    for (int x = 0; x < columns; ++x)
+    {
+        unsigned int a = first + x;
+        unsigned int b = a + rowLength;
+        if (reversed)
+        {
+            out[0] = a;
+            out[1] = a + 1;
+            out[2] = b;
+            out[3] = b;
+            out[4] = a + 1;
+            out[5] = b + 1;
+        }
+        else
+        {
+            out[0] = a;
+            out[1] = b;
+            out[2] = a + 1;
+            out[3] = b;
+            out[4] = b + 1;
+            out[5] = a + 1;
+        }
+        out += 6;
+    }
+}
+
+// Fills (columns + 1) x (rows + 1) vertices through writeRow(row, out) and the
+// quads between them, in parallel row chunks
+template <typename WriteRow>
+void WriteQuadGrid(Vertex* vertices,
+                   unsigned int* indices,
+                   int columns,
+                   int rows,
+                   bool reversed,
+                   WriteRow const& writeRow)
+{
+    size_t rowLength = (size_t)columns + 1;
+    size_t grain     = RowGrain(rowLength);
+
+    ParallelFor((size_t)rows + 1, grain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t row = begin; row < end; ++row)
+        {
+            writeRow(row, vertices + row * rowLength);
+        }
+    });
+
+    ParallelFor((size_t)rows, grain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t row = begin; row < end; ++row)
+        {
+            WriteQuadRow(indices + row * columns * 6,
+                         (unsigned int)(row * rowLength),
+                         (unsigned int)rowLength,
+                         columns,
+                         reversed);
+        }
+    });
+}
+
+size_t QuadGridVertexCount(int columns, int rows)
+{
+    return ((size_t)columns + 1) * ((size_t)rows + 1);
+}
+
+size_t QuadGridIndexCount(int columns, int rows)
+{
+    return (size_t)columns * rows * 6;
+}
+
+// Revolves the profile around +Y. Extra vertices and indices are left at the
+// end of the buffers for the caller.
+void GenerateRevolved(MeshData& data,
+                      std::vector<ProfileRow> const& profile,
+                      int segments,
+                      bool reversed,
+                      size_t extraVertices = 0,
+                      size_t extraIndices  = 0)
+{
+    std::vector<double> cosines, sines;
+    BuildColumnTable(segments, cosines, sines);
+
+    int rows = (int)profile.size() - 1;
+    data.vertices.resize(QuadGridVertexCount(segments, rows) + extraVertices);
+    data.indices.resize(QuadGridIndexCount(segments, rows) + extraIndices);
+
+    WriteQuadGrid(data.vertices.data(),
+                  data.indices.data(),
+                  segments,
+                  rows,
+                  reversed,
+                  [&](size_t row, Vertex* out) {
+                      WriteRevolvedRow(out, profile[row], cosines.data(), sines.data(), segments);
+                  });
+}
+
+// reversed selects the counter-clockwise order; the original factory used the
+// other one
+void GenerateSphereRows(MeshData& data, float radius, int segments, int rings, bool reversed)
+{
+    std::vector<ProfileRow> profile(rings + 1);
+    for (int j = 0; j <= rings; ++j)
+    {
+        float v      = (float)j / (float)rings;
+        double polar = v * std::numbers::pi;
+        double s     = std::sin(polar);
+        double c     = std::cos(polar);
+        profile[j]   = {radius * s, radius * c, s, c, v};
+    }
+    GenerateRevolved(data, profile, segments, reversed);
+}
+
+// Corners of an icosahedron and its faces, counter-clockwise seen from outside
+constexpr double kGolden = 1.6180339887498948482;
+
+constexpr double kIcosahedronCorners[12][3] = {{-1, kGolden, 0},
+                                               {1, kGolden, 0},
+                                               {-1, -kGolden, 0},
+                                               {1, -kGolden, 0},
+                                               {0, -1, kGolden},
+                                               {0, 1, kGolden},
+                                               {0, -1, -kGolden},
+                                               {0, 1, -kGolden},
+                                               {kGolden, 0, -1},
+                                               {kGolden, 0, 1},
+                                               {-kGolden, 0, -1},
+                                               {-kGolden, 0, 1}};
+
+constexpr int kIcosahedronFaces[20][3] = {{0, 11, 5},  {0, 5, 1},  {0, 1, 7},   {0, 7, 10},
+                                          {0, 10, 11}, {1, 5, 9},  {5, 11, 4},  {11, 10, 2},
+                                          {10, 7, 6},  {7, 1, 8},  {3, 9, 4},   {3, 4, 2},
+                                          {3, 2, 6},   {3, 6, 8},  {3, 8, 9},   {4, 9, 5},
+                                          {2, 4, 11},  {6, 2, 10}, {8, 6, 7},   {9, 8, 1}};
+
+}  // namespace
+
+void GenerateSphere(MeshData& data, float radius, int segments, int rings)
+{
+    SR_TRACE_ZONE("GenerateSphere");
+    GenerateSphereRows(data, radius, std::max(segments, 3), std::max(rings, 2), true);
+}
+
+void GenerateCapsule(MeshData& data, float radius, float height, int segments, int rings)
+{
+    SR_TRACE_ZONE("GenerateCapsule");
+
+    segments = std::max(segments, 3);
+    rings    = std::max(rings, 1);
+
+    // Two hemispheres; the quads between their equators form the cylinder
+    double halfHeight = 0.5 * height;
+    double top        = halfHeight + radius;
+    double length     = height + 2.0 * radius;
+
+    std::vector<ProfileRow> profile;
+    profile.reserve(2 * (rings + 1));
+    for (int cap = 0; cap < 2; ++cap)
+    {
+        double center = cap == 0 ? halfHeight : -halfHeight;
+        for (int j = 0; j <= rings; ++j)
+        {
+            double polar = (cap + (double)j / rings) * 0.5 * std::numbers::pi;
+            double s     = std::sin(polar);
+            double c     = std::cos(polar);
+            double y     = center + radius * c;
+            profile.push_back({radius * s, y, s, c, (float)((top - y) / length)});
+        }
+    }
+    GenerateRevolved(data, profile, segments, true);
+}
+
+void GenerateCylinder(MeshData& data, float radius, float height, int segments, int stacks)
+{
+    SR_TRACE_ZONE("GenerateCylinder");
+
+    segments = std::max(segments, 3);
+    stacks   = std::max(stacks, 1);
+
+    std::vector<ProfileRow> profile(stacks + 1);
+    for (int j = 0; j <= stacks; ++j)
+    {
+        float v    = (float)j / (float)stacks;
+        profile[j] = {radius, height * (0.5 - v), 1.0, 0.0, v};
+    }
+
+    // Each cap is a center vertex and its own ring, fanned
+    size_t ringLength  = (size_t)segments + 1;
+    size_t sideCount   = QuadGridVertexCount(segments, stacks);
+    size_t sideIndices = QuadGridIndexCount(segments, stacks);
+    GenerateRevolved(data, profile, segments, true, 2 * (ringLength + 1), 2 * segments * 3);
+
+    std::vector<double> cosines, sines;
+    BuildColumnTable(segments, cosines, sines);
+
+    Vertex* vertices      = data.vertices.data() + sideCount;
+    unsigned int* indices = data.indices.data() + sideIndices;
+    for (int cap = 0; cap < 2; ++cap)
+    {
+        float sign          = cap == 0 ? 1.0f : -1.0f;
+        glm::vec3 normal    = glm::vec3(0.0f, sign, 0.0f);
+        unsigned int center = (unsigned int)(vertices - data.vertices.data());
+
+        *vertices++ = {glm::vec3(0.0f, sign * 0.5f * height, 0.0f), normal, glm::vec2(0.5f)};
+        for (size_t i = 0; i < ringLength; ++i)
+        {
+            *vertices++ = {glm::vec3((float)(radius * cosines[i]),
+                                     sign * 0.5f * height,
+                                     (float)(radius * sines[i])),
+                           normal,
+                           glm::vec2((float)(0.5 + 0.5 * cosines[i]),
+                                     (float)(0.5 + 0.5 * sines[i]))};
+        }
+
+        // The column angle turns clockwise seen from +Y
+        for (int i = 0; i < segments; ++i)
+        {
+            unsigned int a = center + 1 + i;
+            *indices++     = center;
+            *indices++     = cap == 0 ? a + 1 : a;
+            *indices++     = cap == 0 ? a : a + 1;
+        }
+    }
+}
+
+void GenerateTorus(MeshData& data, float majorRadius, float minorRadius, int segments, int sides)
+{
+    SR_TRACE_ZONE("GenerateTorus");
+
+    segments = std::max(segments, 3);
+    sides    = std::max(sides, 3);
+
+    // Starts at the top of the tube and turns outward first, like the sphere
+    std::vector<ProfileRow> profile(sides + 1);
+    for (int j = 0; j <= sides; ++j)
+    {
+        float v      = (float)j / (float)sides;
+        double angle = (0.25 - v) * 2.0 * std::numbers::pi;
+        double s     = std::sin(angle);
+        double c     = std::cos(angle);
+        profile[j]   = {majorRadius + minorRadius * c, minorRadius * s, c, s, v};
+    }
+    GenerateRevolved(data, profile, segments, true);
+}
+
+void GenerateGrid(MeshData& data, float width, float depth, int columns, int rows)
+{
+    SR_TRACE_ZONE("GenerateGrid");
+
+    columns = std::max(columns, 1);
+    rows    = std::max(rows, 1);
+
+    data.vertices.resize(QuadGridVertexCount(columns, rows));
+    data.indices.resize(QuadGridIndexCount(columns, rows));
+
+    WriteQuadGrid(data.vertices.data(),
+                  data.indices.data(),
+                  columns,
+                  rows,
+                  false,
+                  [&](size_t row, Vertex* out) {
+                      float v = (float)row / (float)rows;
+                      float z = (v - 0.5f) * depth;
+                      for (int i = 0; i <= columns; ++i)
+                      {
+                          float u = (float)i / (float)columns;
+                          out[i]  = {glm::vec3((u - 0.5f) * width, 0.0f, z),
+                                     glm::vec3(0.0f, 1.0f, 0.0f),
+                                     glm::vec2(u, v)};
+                      }
+                  });
+}
+
+void GenerateIcosphere(MeshData& data, float radius, int subdivisions)
+{
+    SR_TRACE_ZONE("GenerateIcosphere");
+
+    int n                = 1 << std::clamp(subdivisions, 0, 10);
+    size_t faceVertices  = ((size_t)n + 1) * ((size_t)n + 2) / 2;
+    size_t faceTriangles = (size_t)n * n;
+    data.vertices.resize(20 * faceVertices);
+    data.indices.resize(20 * faceTriangles * 3);
+
+    // Vertices of a face by row j (toward the third corner) then column i
+    auto rowStart = [n](int j) { return (size_t)j * (n + 1) - (size_t)j * (j - 1) / 2; };
+
+    ParallelFor(20, RowGrain(faceVertices), [&](size_t begin, size_t end, unsigned) {
+        for (size_t face = begin; face < end; ++face)
+        {
+            glm::dvec3 corners[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                double const* corner = kIcosahedronCorners[kIcosahedronFaces[face][k]];
+                corners[k]           = glm::dvec3(corner[0], corner[1], corner[2]);
+            }
+            glm::dvec3 stepI = (corners[1] - corners[0]) / (double)n;
+            glm::dvec3 stepJ = (corners[2] - corners[0]) / (double)n;
+
+            Vertex* out = data.vertices.data() + face * faceVertices;
+            for (int j = 0; j <= n; ++j)
+            {
+                for (int i = 0; i <= n - j; ++i)
+                {
+                    glm::dvec3 point    = corners[0] + stepI * (double)i + stepJ * (double)j;
+                    glm::vec3 direction = glm::vec3(glm::normalize(point));
+                    float u = 0.5f + std::atan2(direction.z, direction.x) /
+                                         (2.0f * std::numbers::pi_v<float>);
+                    float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) /
+                              std::numbers::pi_v<float>;
+                    *out++  = {direction * radius, direction, glm::vec2(u, v)};
+                }
+            }
+
+            // A face across the -X seam would interpolate u from ~1 back to ~0.
+            // Keep every u within half a turn of the face centre's instead, so
+            // the face stays contiguous and the sampler wraps. Vertices on the
+            // poles have no longitude and take the face's mean.
+            glm::dvec3 centre = corners[0] + corners[1] + corners[2];
+            float centreU     = 0.5f + (float)(std::atan2(centre.z, centre.x) /
+                                                (2.0 * std::numbers::pi));
+            Vertex* first     = data.vertices.data() + face * faceVertices;
+            auto isPole       = [](Vertex const& vertex) {
+                return std::abs(vertex.normal.x) < 1e-6f && std::abs(vertex.normal.z) < 1e-6f;
+            };
+            float sumU   = 0.0f;
+            size_t count = 0;
+            for (Vertex* vertex = first; vertex != out; ++vertex)
+            {
+                if (isPole(*vertex))
+                    continue;
+                float& u = vertex->texCoord.x;
+                if (u - centreU > 0.5f)
+                    u -= 1.0f;
+                else if (u - centreU < -0.5f)
+                    u += 1.0f;
+                sumU += u;
+                ++count;
+            }
+            for (Vertex* vertex = first; vertex != out; ++vertex)
+            {
+                if (isPole(*vertex))
+                    vertex->texCoord.x = sumU / (float)count;
+            }
+
+            unsigned int base     = (unsigned int)(face * faceVertices);
+            unsigned int* indices = data.indices.data() + face * faceTriangles * 3;
+            for (int j = 0; j < n; ++j)
+            {
+                unsigned int row  = base + (unsigned int)rowStart(j);
+                unsigned int next = base + (unsigned int)rowStart(j + 1);
+                for (int i = 0; i < n - j; ++i)
+                {
+                    *indices++ = row + i;
+                    *indices++ = row + i + 1;
+                    *indices++ = next + i;
+                    if (i + 1 < n - j)
+                    {
+                        *indices++ = row + i + 1;
+                        *indices++ = next + i + 1;
+                        *indices++ = next + i;
+                    }
+                }
+            }
+        }
+    });
+}
+
+std::unique_ptr<Mesh> CreateMesh(MeshData&& data)
+{
+    auto mesh = std::make_unique<Mesh>();
+    mesh->SetVertices(std::move(data.vertices));
+    mesh->SetIndices(std::move(data.indices));
+    return mesh;
+}
+
+std::unique_ptr<Mesh> CreateSphereMesh(int segments)
+{
+    // Same vertices and triangle order as the original per-vertex loop, so
+    // existing captures still match; that order winds clockwise seen from
+    // outside, unlike GenerateSphere
+    MeshData data;
+    segments = std::max(segments, 3);
+    GenerateSphereRows(data, 0.5f, segments, segments, false);
+    return CreateMesh(std::move(data));
+}
+
+std::unique_ptr<Mesh> CreateCapsuleMesh(float radius, float height, int segments)
+{
+    MeshData data;
+    GenerateCapsule(data, radius, height, segments, segments / 4);
+    return CreateMesh(std::move(data));
+}
+
+std::unique_ptr<Mesh> CreateCylinderMesh(float radius, float height, int segments)
+{
+    MeshData data;
+    GenerateCylinder(data, radius, height, segments, 1);
+    return CreateMesh(std::move(data));
+}
+
+std::unique_ptr<Mesh> CreateTorusMesh(float majorRadius, float minorRadius, int segments)
+{
+    MeshData data;
+    GenerateTorus(data, majorRadius, minorRadius, segments, segments / 2);
+    return CreateMesh(std::move(data));
+}
+
+std::unique_ptr<Mesh> CreateGridMesh(float width, float depth, int divisions)
+{
+    MeshData data;
+    GenerateGrid(data, width, depth, divisions, divisions);
+    return CreateMesh(std::move(data));
+}
+
+std::unique_ptr<Mesh> CreateIcosphereMesh(float radius, int subdivisions)
+{
+    MeshData data;
+    GenerateIcosphere(data, radius, subdivisions);
+    return CreateMesh(std::move(data));
+}
+
+}  // namespace SpatialRender
@@ -1,21 +1,161 @@
 #include "renderer.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
 #include "camera.h"
+#include "clustered_lighting.h"
+#include "command_buffer.h"
+#include "culling.h"
+#include "dynamic_resolution.h"
+#include "frame_sync.h"
+#include "gl_state.h"
+#include "gpu_timer.h"
+#include "image_utils.h"
+#include "material.h"
+#include "memory_tracker.h"
+#include "mesh.h"
+#include "occlusion.h"
+#include "parallel.h"
 #include "scene.h"
+#include "shader.h"
+#include "texture.h"
+#include "trace.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
 namespace SpatialRender
 {
 
+namespace
+{
+
+// Must transform exactly like basic.vert so the GL_EQUAL pass matches
+char const* const kDepthOnlyVertexSource = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+
+const int kMaxViews = 4;
+
+uniform mat4 u_model;
+uniform mat4 u_viewProj;
+uniform int u_viewCount;
+uniform mat4 u_viewProjs[kMaxViews];
+uniform int u_instanced;
+uniform int u_instanceBase;
+uniform samplerBuffer u_instanceData;
+
+out float gl_ClipDistance[2];
+
+invariant gl_Position;
+
+void main() {
+    mat4 model = u_model;
+    if (u_instanced != 0) {
+        int base = (u_instanceBase + gl_InstanceID / max(u_viewCount, 1)) * 4;
+        model = transpose(mat4(texelFetch(u_instanceData, base),
+                               texelFetch(u_instanceData, base + 1),
+                               texelFetch(u_instanceData, base + 2),
+                               vec4(0.0, 0.0, 0.0, 1.0)));
+    }
+
+    if (u_viewCount > 0) {
+        int view = gl_InstanceID % u_viewCount;
+        vec4 clip = u_viewProjs[view] * model * vec4(a_position, 1.0);
+        gl_ClipDistance[0] = clip.w + clip.x;
+        gl_ClipDistance[1] = clip.w - clip.x;
+        clip.x = (clip.x + clip.w * float(2 * view + 1 - u_viewCount)) / float(u_viewCount);
+        gl_Position = clip;
+    } else {
+        gl_Position = u_viewProj * model * vec4(a_position, 1.0);
+        gl_ClipDistance[0] = 1.0;
+        gl_ClipDistance[1] = 1.0;
+    }
+}
+)";
+
+char const* const kDepthOnlyFragmentSource = R"(#version 330 core
+void main() {
+}
+)";
+
+// Non-negative IEEE floats order the same as their bit patterns
+uint32_t DepthSortBits(float depth)
+{
+    depth = std::max(depth, 0.0f);
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+// Call after recording the resource's draw or bind, which may upload it
+template <typename Resource>
+void TrackRevision(std::vector<std::pair<Resource const*, uint64_t>>& resources,
+                   Resource const& resource)
+{
+    if (resources.empty() || resources.back().first != &resource)
+    {
+        resources.emplace_back(&resource, resource.GetRevision());
+    }
+}
+
+template <typename Resource>
+void DeduplicateRevisions(std::vector<std::pair<Resource const*, uint64_t>>& resources)
+{
+    std::sort(resources.begin(), resources.end());
+    resources.erase(std::unique(resources.begin(), resources.end()), resources.end());
+}
+
+template <typename Resource>
+bool RevisionsMatch(std::vector<std::pair<Resource const*, uint64_t>> const& resources)
+{
+    for (auto const& [resource, revision] : resources)
+    {
+        if (resource->GetRevision() != revision)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
 Renderer::Renderer(int width, int height) :
     m_width(width),
     m_height(height),
     m_initialized(false),
-    m_defaultFBO(0)
+    m_defaultFBO(0),
+    m_occlusionCulling(false),
+    m_occlusionCuller(std::make_unique<OcclusionCuller>()),
+    m_depthSorting(true),
+    m_depthPrepass(false),
+    m_frameAllocator(std::make_unique<FrameAllocator>()),
+    m_objectsSubmitted(0),
+    m_objectsCulled(0),
+    m_lighting(std::make_unique<ClusteredLighting>()),
+    m_lightsDropped(0),
+    m_frameSync(std::make_unique<FrameSync>()),
+    m_frameSlot(0),
+    m_textureStreamer(std::make_unique<TextureStreamer>()),
+    m_materials(std::make_unique<MaterialLibrary>()),
+    m_instances(std::make_unique<InstanceBuffer>()),
+    m_renderTargets(std::make_unique<RenderTargetPool>()),
+    m_frameGraph(std::make_unique<FrameGraph>(*m_renderTargets)),
+    m_retainedMode(false),
+    m_commands(std::make_unique<CommandBuffer>()),
+    m_scenesReplayed(0),
+    m_dynamicResolution(false),
+    m_resolutionController(std::make_unique<ResolutionController>()),
+    m_gpuTimer(std::make_unique<GpuTimer>()),
+    m_gpuFrameMs(0.0),
+    m_renderScale(1.0f),
+    m_renderWidth(width),
+    m_renderHeight(height),
+    m_sceneFBO(0),
+    m_sceneColor(0),
+    m_sceneDepth(0)
 {}
 
 Renderer::~Renderer()
@@ -39,85 +179,825 @@ bool Renderer::Initialize()
         return false;
     }
 
+    // A new context starts from unknown state
+    GLStateCache& state = GLStateCache::Get();
+    state.Invalidate();
+
     // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    state.Enable(GL_DEPTH_TEST);
+    state.DepthFunc(GL_LESS);
 
     // Enable backface culling
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    state.Enable(GL_CULL_FACE);
+    state.CullFace(GL_BACK);
 
     // Get default framebuffer
     glGetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&m_defaultFBO);
 
+    m_depthShader = std::make_unique<Shader>();
+    if (!m_depthShader->LoadFromSource(kDepthOnlyVertexSource, kDepthOnlyFragmentSource))
+    {
+        std::cerr << "Failed to compile depth pre-pass shader" << std::endl;
+        return false;
+    }
+
+    if (!m_lighting->Initialize())
+    {
+        return false;
+    }
+
+    if (!m_instances->Initialize())
+    {
+        return false;
+    }
+
+    // Timing is optional; without it dynamic resolution holds its scale
+    if (!m_gpuTimer->Initialize())
+    {
+        std::cerr << "GPU timer queries unavailable" << std::endl;
+    }
+
     m_initialized = true;
     return true;
 }
 
 void Renderer::Shutdown()
 {
+    if (m_initialized)
+    {
+        m_frameSync->WaitIdle();
+    }
+    m_depthShader.reset();
+    InvalidateRecording();
+    m_textureStreamer->Shutdown();
+    m_materials->Shutdown();
+    m_instances->Shutdown();
+    m_frameGraph->Reset();
+    m_renderTargets->Shutdown();
+    m_lighting->Shutdown();
+    m_gpuTimer->Shutdown();
+    DestroySceneTarget();
     m_initialized = false;
 }
 
+void Renderer::SetFramesInFlight(int count)
+{
+    m_frameSync->SetFramesInFlight(count);
+}
+
+int Renderer::GetFramesInFlight() const
+{
+    return m_frameSync->GetFramesInFlight();
+}
+
+double Renderer::GetFrameWaitMs() const
+{
+    return m_frameSync->GetLastWaitMs();
+}
+
+void Renderer::SetDynamicResolution(bool enabled, float targetFrameMs)
+{
+    ResolutionControllerConfig config = m_resolutionController->GetConfig();
+    config.targetFrameMs              = targetFrameMs;
+    m_resolutionController->SetConfig(config);
+
+    if (enabled && !m_dynamicResolution)
+    {
+        m_resolutionController->Reset(config.maxScale);
+    }
+    else if (!enabled && m_dynamicResolution)
+    {
+        // BeginFrame() recreates the target if the feature comes back
+        DestroySceneTarget();
+    }
+    m_dynamicResolution = enabled;
+    UpdateRenderSize();
+}
+
+void Renderer::UpdateRenderSize()
+{
+    m_renderScale  = m_dynamicResolution ? m_resolutionController->GetScale() : 1.0f;
+    m_renderWidth  = std::max(1, (int)std::lround(m_width * m_renderScale));
+    m_renderHeight = std::max(1, (int)std::lround(m_height * m_renderScale));
+}
+
+bool Renderer::CreateSceneTarget()
+{
+    GLStateCache& state = GLStateCache::Get();
+
+    glGenRenderbuffers(1, &m_sceneColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sceneColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenRenderbuffers(1, &m_sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+
+    // Drivers store 24-bit depth in 32-bit texels
+    MemoryTracker& memory = MemoryTracker::Get();
+    size_t bytes          = (size_t)m_width * m_height * 4;
+    memory.Record(MemoryResource::Renderbuffer,
+                  m_sceneColor,
+                  MemoryCategory::Renderbuffer,
+                  "Renderer scene color",
+                  bytes);
+    memory.Record(MemoryResource::Renderbuffer,
+                  m_sceneDepth,
+                  MemoryCategory::Renderbuffer,
+                  "Renderer scene depth",
+                  bytes);
+
+    glGenFramebuffers(1, &m_sceneFBO);
+    state.BindFramebuffer(GL_FRAMEBUFFER, m_sceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_sceneColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_sceneDepth);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    state.BindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Scaled render target is incomplete" << std::endl;
+        DestroySceneTarget();
+        return false;
+    }
+    return true;
+}
+
+void Renderer::DestroySceneTarget()
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Release(MemoryResource::Renderbuffer, m_sceneColor);
+    memory.Release(MemoryResource::Renderbuffer, m_sceneDepth);
+
+    GLStateCache::Get().DeleteFramebuffer(m_sceneFBO);
+    if (m_sceneColor != 0)
+    {
+        glDeleteRenderbuffers(1, &m_sceneColor);
+    }
+    if (m_sceneDepth != 0)
+    {
+        glDeleteRenderbuffers(1, &m_sceneDepth);
+    }
+    m_sceneFBO   = 0;
+    m_sceneColor = 0;
+    m_sceneDepth = 0;
+}
+
 void Renderer::BeginFrame()
 {
-    glViewport(0, 0, m_width, m_height);
+    SR_TRACE_ZONE("Renderer::BeginFrame");
+
+    GLStateCache& state = GLStateCache::Get();
+    state.ResetStats();
+    m_objectsSubmitted = 0;
+    m_objectsCulled    = 0;
+    m_scenesReplayed   = 0;
+    m_lightsDropped    = 0;
+    m_frameAllocator->Reset();
+
+    // Once the slot's previous frame has retired its resources and GPU time
+    // are free to reuse
+    m_frameSlot = m_frameSync->BeginFrame();
+    m_gpuTimer->Begin(m_frameSlot);
+    m_textureStreamer->Update();
+    m_frameGraph->Reset();
+
+    double gpuMs = 0.0;
+    if (m_gpuTimer->Poll(gpuMs))
+    {
+        m_gpuFrameMs = gpuMs;
+        if (m_dynamicResolution)
+        {
+            m_resolutionController->Update((float)gpuMs);
+        }
+    }
+
+    if (m_dynamicResolution && (m_sceneFBO != 0 || CreateSceneTarget()))
+    {
+        state.BindFramebuffer(GL_FRAMEBUFFER, m_sceneFBO);
+    }
+    else
+    {
+        m_dynamicResolution = false;
+    }
+
+    UpdateRenderSize();
+    state.Viewport(0, 0, m_renderWidth, m_renderHeight);
 }
 
 void Renderer::EndFrame()
 {
-    // Frame end logic (if needed)
+    SR_TRACE_ZONE("Renderer::EndFrame");
+
+    GLStateCache& state = GLStateCache::Get();
+    if (m_dynamicResolution)
+    {
+        state.BindFramebuffer(GL_READ_FRAMEBUFFER, m_sceneFBO);
+        state.BindFramebuffer(GL_DRAW_FRAMEBUFFER, m_defaultFBO);
+        glBlitFramebuffer(0,
+                          0,
+                          m_renderWidth,
+                          m_renderHeight,
+                          0,
+                          0,
+                          m_width,
+                          m_height,
+                          GL_COLOR_BUFFER_BIT,
+                          GL_LINEAR);
+        state.BindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+    }
+    else
+    {
+        // Frame graph passes may have left one of their targets bound
+        state.BindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+    }
+    m_renderTargets->Trim();
+
+    m_gpuTimer->End();
+    m_frameSync->EndFrame();
+
+    GLStateStats const& counters = state.GetStats();
+
+    m_renderStats.drawCalls           = counters.drawCalls;
+    m_renderStats.triangles           = counters.triangles;
+    m_renderStats.vertices            = counters.vertices;
+    m_renderStats.programSwitches     = counters.programSwitches;
+    m_renderStats.vertexArrayBinds    = counters.vertexArrayBinds;
+    m_renderStats.uniformUploads      = counters.uniformUploads;
+    m_renderStats.bufferBytesUploaded = counters.bufferBytes;
+    m_renderStats.objectsSubmitted    = m_objectsSubmitted;
+    m_renderStats.objectsCulled       = m_objectsCulled;
+    m_renderStats.scenesReplayed      = m_scenesReplayed;
+    m_renderStats.lightsDropped       = m_lightsDropped;
+
+    m_renderStats.frameAllocatorHighWater = m_frameAllocator->GetHighWater();
+}
+
+FrameGraphResource Renderer::ImportOutput(FrameGraph& graph)
+{
+    GLuint framebuffer = m_dynamicResolution ? m_sceneFBO : m_defaultFBO;
+    return graph.Import("output", framebuffer, m_renderWidth, m_renderHeight);
 }
 
 void Renderer::Clear(glm::vec4 const& color)
 {
-    glClearColor(color.r, color.g, color.b, color.a);
+    // glClear honours the write masks
+    GLStateCache& state = GLStateCache::Get();
+    state.ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    state.DepthMask(GL_TRUE);
+    state.ClearColor(color.r, color.g, color.b, color.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void Renderer::RenderScene(Scene& scene, Camera& camera)
 {
-    glm::mat4 viewProj = camera.GetViewProjectionMatrix();
+    RenderViews(scene, &camera, 1);
+}
+
+void Renderer::RenderSceneMultiView(Scene& scene, std::vector<Camera> const& cameras)
+{
+    if (cameras.empty() || cameras.size() > (size_t)kMaxViews)
+    {
+        std::cerr << "Multi-view rendering supports 1 to " << kMaxViews << " views" << std::endl;
+        return;
+    }
+
+    RenderViews(scene, cameras.data(), cameras.size());
+}
+
+void Renderer::SetRetainedMode(bool enabled)
+{
+    m_retainedMode = enabled;
+    InvalidateRecording();
+}
+
+void Renderer::InvalidateRecording()
+{
+    m_recording.valid = false;
+    m_recording.instances.clear();
+    m_recording.pendingTextures.clear();
+    m_recording.meshes.clear();
+    m_recording.shaders.clear();
+    m_recording.textures.clear();
+}
+
+void Renderer::RenderViews(Scene& scene, Camera const* cameras, size_t viewCount)
+{
+    SR_TRACE_ZONE("Renderer::RenderScene");
+
+    for (size_t i = 0; i < viewCount; ++i)
+    {
+        if (cameras[i].IsReversedZ())
+        {
+            std::cerr << "Reversed-Z cameras need a [0, 1] clip depth range" << std::endl;
+            return;
+        }
+    }
+
+    std::array<glm::mat4, kMaxViews> views;
+    std::array<glm::mat4, kMaxViews> viewProjs;
+    for (size_t i = 0; i < viewCount; ++i)
+    {
+        views[i]     = cameras[i].GetViewMatrix();
+        viewProjs[i] = cameras[i].GetViewProjectionMatrix();
+    }
+
+    m_lighting->Update(scene, cameras, viewCount, m_frameSlot);
+    m_lightsDropped += m_lighting->GetDroppedLights();
 
-    for (auto const& obj : scene.GetObjects())
+    if (m_retainedMode && IsRecordingCurrent(scene, views.data(), viewProjs.data(), viewCount))
     {
+        // The instance data goes to this frame's slot like a freshly built list
+        if (!m_recording.instances.empty())
+        {
+            m_instances->Begin(m_frameSlot);
+            m_instances->Restore(m_recording.instances);
+            m_instances->Upload();
+        }
+        m_objectsSubmitted += m_recording.objectsSubmitted;
+        m_objectsCulled += m_recording.objectsCulled;
+        ++m_scenesReplayed;
+    }
+    else
+    {
+        RecordViews(scene, cameras, viewCount, views.data(), viewProjs.data());
+        m_objectsSubmitted += m_recording.objectsSubmitted;
+        m_objectsCulled += m_recording.objectsCulled;
+
+        m_recording.valid = m_retainedMode;
+        if (m_retainedMode)
+        {
+            m_recording.sceneRevision    = scene.GetRevision();
+            m_recording.materialRevision = m_materials->GetRevision();
+            m_recording.viewCount        = viewCount;
+            m_recording.views            = views;
+            m_recording.viewProjs        = viewProjs;
+            m_recording.occlusionCulling = m_occlusionCulling;
+            m_recording.depthSorting     = m_depthSorting;
+            m_recording.depthPrepass     = m_depthPrepass;
+            m_recording.instances        = m_instances->GetTexels();
+        }
+    }
+
+    // Everything that differs between frames, set where each program starts
+    m_commands->Execute([&](Shader& shader) {
+        SetViewUniforms(shader, views.data(), viewProjs.data(), viewCount);
+        m_instances->Apply(shader);
+        if (&shader != m_depthShader.get())
+        {
+            m_lighting->Apply(shader, m_renderWidth, m_renderHeight);
+            m_materials->Apply(shader);
+        }
+    });
+}
+
+bool Renderer::IsRecordingCurrent(Scene const& scene,
+                                  glm::mat4 const* views,
+                                  glm::mat4 const* viewProjs,
+                                  size_t viewCount) const
+{
+    Recording const& recording = m_recording;
+    if (!recording.valid || recording.sceneRevision != scene.GetRevision() ||
+        recording.materialRevision != m_materials->GetRevision() ||
+        recording.viewCount != viewCount || recording.occlusionCulling != m_occlusionCulling ||
+        recording.depthSorting != m_depthSorting || recording.depthPrepass != m_depthPrepass)
+        return false;
+
+    for (size_t i = 0; i < viewCount; ++i)
+    {
+        if (recording.views[i] != views[i] || recording.viewProjs[i] != viewProjs[i])
+            return false;
+    }
+
+    // An unchanged scene still holds every resource these point at
+    if (!RevisionsMatch(recording.meshes) || !RevisionsMatch(recording.shaders) ||
+        !RevisionsMatch(recording.textures))
+        return false;
+
+    // Textures only ever become resident; one that did must now be sampled
+    for (Texture const* texture : recording.pendingTextures)
+    {
+        if (texture->IsResident())
+            return false;
+    }
+    return true;
+}
+
+void Renderer::RecordViews(Scene& scene,
+                           Camera const* cameras,
+                           size_t viewCount,
+                           glm::mat4 const* views,
+                           glm::mat4 const* viewProjs)
+{
+    SR_TRACE_ZONE("Renderer::RecordViews");
+
+    CommandBuffer& commands = *m_commands;
+    commands.Clear();
+    m_recording.pendingTextures.clear();
+    m_recording.meshes.clear();
+    m_recording.shaders.clear();
+    m_recording.textures.clear();
+
+    bool multiView = viewCount > 1;
+
+    std::vector<SceneObject> const& objects = scene.GetObjects();
+    uint8_t const* visibility               = nullptr;
+    if (multiView)
+    {
+        // Occlusion from one eye does not hold for the others; cull against
+        // the union of the view frustums instead
+        visibility = CullViews(objects, cameras, viewCount);
+    }
+    else if (m_occlusionCulling)
+    {
+        m_occlusionCuller->Cull(objects, viewProjs[0]);
+        visibility = m_occlusionCuller->GetVisibility().data();
+    }
+
+    bool prepass      = m_depthPrepass && m_depthShader && m_depthShader->IsValid();
+    int instanceCount = (int)viewCount;
+
+    FrameVector<DrawItem> drawList(m_frameAllocator->MakeAllocator<DrawItem>());
+    FrameVector<DrawItem> batchItems(m_frameAllocator->MakeAllocator<DrawItem>());
+    FrameVector<DrawBatch> batches(m_frameAllocator->MakeAllocator<DrawBatch>());
+    drawList.reserve(objects.size());
+    if (m_materials->GetMaterialCount() > 0)
+    {
+        batchItems.reserve(objects.size());
+    }
+
+    // Batches are built first: the pre-pass reads their instance data
+    m_recording.objectsCulled =
+        BuildDrawList(objects, views[0], false, visibility, drawList, &batchItems);
+    m_recording.objectsSubmitted = drawList.size() + batchItems.size();
+    uint32_t* instanceSlots      = nullptr;
+    bool batched                 = true;
+    m_instances->Begin(m_frameSlot);  // stays empty without batches
+    if (!batchItems.empty())
+    {
+        m_materials->Update();
+        instanceSlots = m_frameAllocator->GetThreadArena().AllocateArray<uint32_t>(objects.size());
+        batched       = BuildBatches(objects, batchItems, batches, instanceSlots);
+    }
+
+    if (multiView)
+    {
+        commands.Enable(GL_CLIP_DISTANCE0);
+        commands.Enable(GL_CLIP_DISTANCE1);
+    }
+
+    if (prepass)
+    {
+        // Depth only, strictly front-to-back regardless of shader
+        FrameVector<DrawItem> depthList(m_frameAllocator->MakeAllocator<DrawItem>());
+        depthList.reserve(objects.size());
+        BuildDrawList(objects, views[0], true, visibility, depthList);
+        SortDrawList(depthList);
+
+        commands.ColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        commands.DepthMask(GL_TRUE);
+        commands.DepthFunc(GL_LESS);
+
+        Shader& depthShader = *m_depthShader;
+        commands.UseProgram(depthShader);
+        TrackRevision(m_recording.shaders, depthShader);
+        commands.ApplyFrameConstants(depthShader);
+        commands.SetUniform(depthShader, "u_instanced", 0);
+
+        // Material objects take their model matrix from the instance data, so
+        // their depth comes out of the same computation as in the batch
+        bool instanced = false;
+        for (DrawItem const& item : depthList)
+        {
+            SceneObject const& obj = objects[item.objectIndex];
+            bool material          = HasMaterial(obj);
+            if (material && !batched)
+                continue;
+            if (material != instanced)
+            {
+                instanced = material;
+                commands.SetUniform(depthShader, "u_instanced", instanced ? 1 : 0);
+            }
+
+            if (material)
+            {
+                commands.SetUniform(
+                    depthShader, "u_instanceBase", (int)instanceSlots[item.objectIndex]);
+            }
+            else
+            {
+                commands.SetUniform(depthShader, "u_model", obj.transform);
+            }
+            obj.mesh->RecordDepthOnly(commands, instanceCount);
+            TrackRevision(m_recording.meshes, *obj.mesh);
+        }
+
+        // Shade only the surviving fragments; order by state, not depth
+        commands.ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        commands.DepthMask(GL_FALSE);
+        commands.DepthFunc(GL_EQUAL);
+    }
+
+    if (m_depthSorting || prepass)
+    {
+        SortDrawList(drawList);
+    }
+
+    // Uniforms persist per program, so per-frame ones are set once per shader
+    GLuint frameProgram = 0;
+    auto useProgram     = [&](Shader& shader) {
+        commands.UseProgram(shader);
+        TrackRevision(m_recording.shaders, shader);
+        if (shader.GetProgram() != frameProgram)
+        {
+            frameProgram = shader.GetProgram();
+            commands.ApplyFrameConstants(shader);
+            commands.SetUniform(shader, "u_albedo", (int)kAlbedoUnit);
+            commands.SetUniform(shader, "u_instanced", 0);
+        }
+    };
+
+    for (DrawItem const& item : drawList)
+    {
+        SceneObject const& obj = objects[item.objectIndex];
+        Shader& shader         = *obj.shader;
+
+        useProgram(shader);
+        commands.SetUniform(shader, "u_model", obj.transform);
+        commands.SetUniform(shader, "u_color", obj.color);
+
+        bool textured = obj.texture && obj.texture->IsResident();
+        if (textured)
+        {
+            commands.BindTexture(kAlbedoUnit, GL_TEXTURE_2D, obj.texture->GetHandle());
+            TrackRevision(m_recording.textures, *obj.texture);
+        }
+        else if (obj.texture)
+        {
+            m_recording.pendingTextures.push_back(obj.texture.get());
+        }
+        commands.SetUniform(shader, "u_useAlbedo", textured ? 1 : 0);
+
+        obj.mesh->Record(commands, instanceCount);
+        TrackRevision(m_recording.meshes, *obj.mesh);
+    }
+
+    // One draw per batch, however many objects and materials it holds
+    for (DrawBatch const& batch : batches)
+    {
+        SceneObject const& obj = objects[batch.objectIndex];
+        Shader& shader         = *obj.shader;
+
+        useProgram(shader);
+        if (batch.textureArray >= 0)
+        {
+            GLuint array = m_materials->GetTextureArray(batch.textureArray).GetHandle();
+            commands.BindTexture(MaterialLibrary::kTextureArrayUnit, GL_TEXTURE_2D_ARRAY, array);
+        }
+        commands.SetUniform(shader, "u_instanced", 1);
+        commands.SetUniform(shader, "u_instanceBase", (int)batch.instanceBase);
+
+        obj.mesh->Record(commands, (int)batch.instanceCount * instanceCount);
+        TrackRevision(m_recording.meshes, *obj.mesh);
+    }
+
+    if (prepass)
+    {
+        commands.DepthMask(GL_TRUE);
+        commands.DepthFunc(GL_LESS);
+    }
+
+    if (multiView)
+    {
+        commands.Disable(GL_CLIP_DISTANCE0);
+        commands.Disable(GL_CLIP_DISTANCE1);
+    }
+
+    DeduplicateRevisions(m_recording.meshes);
+    DeduplicateRevisions(m_recording.shaders);
+    DeduplicateRevisions(m_recording.textures);
+}
+
+void Renderer::SetViewUniforms(Shader& shader,
+                               glm::mat4 const* views,
+                               glm::mat4 const* viewProjs,
+                               size_t viewCount)
+{
+    if (viewCount > 1)
+    {
+        shader.SetUniform("u_viewCount", (int)viewCount);
+        shader.SetUniform("u_views", views, (int)viewCount);
+        shader.SetUniform("u_viewProjs", viewProjs, (int)viewCount);
+    }
+    else
+    {
+        shader.SetUniform("u_viewCount", 0);
+        shader.SetUniform("u_view", views[0]);
+        shader.SetUniform("u_viewProj", viewProjs[0]);
+    }
+}
+
+uint8_t const* Renderer::CullViews(std::vector<SceneObject> const& objects,
+                                   Camera const* cameras,
+                                   size_t viewCount)
+{
+    SR_TRACE_ZONE("Renderer::CullViews");
+
+    std::array<Frustum, kMaxViews> frustums;
+    for (size_t i = 0; i < viewCount; ++i)
+    {
+        frustums[i] = cameras[i].GetFrustum();
+    }
+
+    uint8_t* visibility = m_frameAllocator->GetThreadArena().AllocateArray<uint8_t>(objects.size());
+    std::fill(visibility, visibility + objects.size(), uint8_t(0));
+    ParallelFor(objects.size(), 256, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            SceneObject const& obj = objects[i];
+            if (!obj.mesh)
+                continue;
+
+            AABB bounds = obj.mesh->GetBounds().Transformed(obj.transform);
+            for (size_t view = 0; view < viewCount; ++view)
+            {
+                if (frustums[view].Intersects(bounds))
+                {
+                    visibility[i] = 1;
+                    break;
+                }
+            }
+        }
+    });
+    return visibility;
+}
+
+size_t Renderer::BuildDrawList(std::vector<SceneObject> const& objects,
+                               glm::mat4 const& view,
+                               bool depthOnlyOrder,
+                               uint8_t const* visibility,
+                               FrameVector<DrawItem>& drawList,
+                               FrameVector<DrawItem>* batchItems)
+{
+    SR_TRACE_ZONE("Renderer::BuildDrawList");
+
+    // Capacity for every object was reserved up front, so this never allocates
+    drawList.clear();
+    if (batchItems)
+    {
+        batchItems->clear();
+    }
+
+    size_t culled = 0;
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        SceneObject const& obj = objects[i];
         if (!obj.mesh || !obj.shader)
             continue;
+        if (visibility && !visibility[i])
+        {
+            ++culled;
+            continue;
+        }
 
-        obj.shader->Use();
-        obj.shader->SetUniform("u_model", obj.transform);
-        obj.shader->SetUniform("u_viewProj", viewProj);
-        obj.shader->SetUniform("u_color", obj.color);
+        if (batchItems && HasMaterial(obj))
+        {
+            // Key: program, then texture array; BuildBatches orders the rest
+            uint32_t array = (uint32_t)(m_materials->GetTextureArrayIndex(obj.material) + 1);
+            batchItems->push_back({(uint64_t)obj.shader->GetProgram() << 32 | array, (uint32_t)i});
+            continue;
+        }
 
-        obj.mesh->Render();
+        // Key: state bucket in the high half, view depth or VAO in the low half
+        uint32_t bucket = depthOnlyOrder ? 0 : obj.shader->GetProgram();
+        uint32_t order  = 0;
+        if (depthOnlyOrder || !m_depthPrepass)
+        {
+            glm::vec4 center = obj.transform * glm::vec4(obj.mesh->GetBounds().GetCenter(), 1.0f);
+            order            = DepthSortBits(-(view * center).z);
+        }
+        else
+        {
+            // Depth is already resolved; group draws that share a vertex array
+            order = obj.mesh->GetVertexArray();
+        }
 
-        obj.shader->Unuse();
+        drawList.push_back({((uint64_t)bucket << 32) | order, (uint32_t)i});
     }
+    return culled;
 }
 
-void Renderer::CaptureFramebuffer(std::vector<uint8_t>& pixels)
+void Renderer::SortDrawList(FrameVector<DrawItem>& drawList)
 {
-    pixels.resize(m_width * m_height * 4);
-    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    SR_TRACE_ZONE("Renderer::SortDrawList");
 
-    // Flip vertically (OpenGL reads from bottom-left)
-    for (int y = 0; y < m_height / 2; ++y)
+    // Ties keep insertion order so results are deterministic
+    std::sort(drawList.begin(), drawList.end(), [](DrawItem const& a, DrawItem const& b) {
+        if (a.sortKey != b.sortKey)
+            return a.sortKey < b.sortKey;
+        return a.objectIndex < b.objectIndex;
+    });
+}
+
+bool Renderer::BuildBatches(std::vector<SceneObject> const& objects,
+                            FrameVector<DrawItem>& batchItems,
+                            FrameVector<DrawBatch>& batches,
+                            uint32_t* instanceSlots)
+{
+    SR_TRACE_ZONE("Renderer::BuildBatches");
+
+    // A batch draws one mesh, so the VAO must exist before it can sort by it
+    for (DrawItem const& item : batchItems)
     {
-        int top    = y;
-        int bottom = m_height - 1 - y;
-        for (int x = 0; x < m_width * 4; ++x)
+        Mesh& mesh = *objects[item.objectIndex].mesh;
+        if (mesh.GetVertexArray() == 0)
         {
-            std::swap(pixels[top * m_width * 4 + x], pixels[bottom * m_width * 4 + x]);
+            mesh.Upload();
         }
     }
+
+    std::sort(batchItems.begin(), batchItems.end(), [&](DrawItem const& a, DrawItem const& b) {
+        if (a.sortKey != b.sortKey)
+            return a.sortKey < b.sortKey;
+        GLuint vaoA = objects[a.objectIndex].mesh->GetVertexArray();
+        GLuint vaoB = objects[b.objectIndex].mesh->GetVertexArray();
+        if (vaoA != vaoB)
+            return vaoA < vaoB;
+        return a.objectIndex < b.objectIndex;
+    });
+
+    batches.clear();
+    for (size_t i = 0; i < batchItems.size(); ++i)
+    {
+        SceneObject const& obj = objects[batchItems[i].objectIndex];
+        if (i == 0 || batchItems[i].sortKey != batchItems[i - 1].sortKey ||
+            obj.mesh.get() != objects[batchItems[i - 1].objectIndex].mesh.get())
+        {
+            uint32_t base = (uint32_t)m_instances->GetCount();
+            int array     = (int)(uint32_t)batchItems[i].sortKey - 1;
+            batches.push_back({batchItems[i].objectIndex, base, 0, array});
+        }
+
+        instanceSlots[batchItems[i].objectIndex] = m_instances->Add(obj.transform, obj.material);
+        ++batches.back().instanceCount;
+    }
+
+    if (!m_instances->Upload())
+    {
+        batches.clear();
+        return false;
+    }
+    return true;
 }
 
-bool Renderer::SaveFramebufferToFile(std::string const& path)
+bool Renderer::HasMaterial(SceneObject const& object) const
+{
+    return object.material < m_materials->GetMaterialCount();
+}
+
+GLStateStats const& Renderer::GetStateStats() const
 {
-    std::vector<uint8_t> pixels;
-    CaptureFramebuffer(pixels);
+    return GLStateCache::Get().GetStats();
+}
+
+OcclusionStats const& Renderer::GetOcclusionStats() const
+{
+    return m_occlusionCuller->GetStats();
+}
 
-    return stbi_write_png(path.c_str(), m_width, m_height, 4, pixels.data(), m_width * 4) != 0;
+LightingStats const& Renderer::GetLightingStats() const
+{
+    return m_lighting->GetStats();
+}
+
+void Renderer::CaptureFramebuffer(std::vector<uint8_t>& pixels)
+{
+    pixels.resize(m_width * m_height * 4);
+    ReadFramebuffer(pixels.data());
+}
+
+ImageView Renderer::CaptureFramebuffer()
+{
+    uint8_t* pixels =
+        m_frameAllocator->GetThreadArena().AllocateArray<uint8_t>((size_t)m_width * m_height * 4);
+    ReadFramebuffer(pixels);
+    return {pixels, m_width, m_height};
+}
+
+void Renderer::ReadFramebuffer(uint8_t* pixels)
+{
+    SR_TRACE_ZONE("Renderer::CaptureFramebuffer");
+
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // OpenGL reads from bottom-left
+    FlipRowsVertically(pixels, m_width, m_height, 4);
+}
+
+bool Renderer::SaveFramebufferToFile(std::string const& path)
+{
+    ImageView image = CaptureFramebuffer();
+    return stbi_write_png(path.c_str(), m_width, m_height, 4, image.pixels, m_width * 4) != 0;
 }
 
 }  // namespace SpatialRender
@@ -1,10 +1,23 @@
 #include "scene.h"
 
+#include <atomic>
+#include <utility>
+
 namespace SpatialRender
 {
 
-Scene::Scene()
-{}
+namespace
+{
+
+uint64_t NextRevision()
+{
+    static std::atomic<uint64_t> s_revision{0};
+    return ++s_revision;
+}
+
+}  // namespace
+
+Scene::Scene() : m_revision(NextRevision()) {}
 
 Scene::~Scene()
 {
@@ -22,11 +35,80 @@ void Scene::AddObject(std::shared_ptr<Mesh> mesh,
     obj.transform = transform;
     obj.color     = color;
     m_objects.push_back(obj);
+    m_revision = NextRevision();
+}
+
+void Scene::SetOccluder(size_t index, bool occluder)
+{
+    if (index < m_objects.size())
+    {
+        m_objects[index].occluder = occluder;
+        m_revision = NextRevision();
+    }
+}
+
+void Scene::SetTexture(size_t index, std::shared_ptr<Texture> texture)
+{
+    if (index < m_objects.size())
+    {
+        m_objects[index].texture = std::move(texture);
+        m_revision = NextRevision();
+    }
+}
+
+void Scene::SetMaterial(size_t index, MaterialId material)
+{
+    if (index < m_objects.size())
+    {
+        m_objects[index].material = material;
+        m_revision = NextRevision();
+    }
+}
+
+void Scene::AddLight(Light const& light)
+{
+    m_lights.push_back(light);
+}
+
+void Scene::AddPointLight(glm::vec3 const& position,
+                          glm::vec3 const& color,
+                          float intensity,
+                          float range)
+{
+    Light light;
+    light.type      = LightType::Point;
+    light.position  = position;
+    light.color     = color;
+    light.intensity = intensity;
+    light.range     = range;
+    m_lights.push_back(light);
+}
+
+void Scene::AddSpotLight(glm::vec3 const& position,
+                         glm::vec3 const& direction,
+                         glm::vec3 const& color,
+                         float intensity,
+                         float range,
+                         float innerConeAngle,
+                         float outerConeAngle)
+{
+    Light light;
+    light.type           = LightType::Spot;
+    light.position       = position;
+    light.direction      = glm::normalize(direction);
+    light.color          = color;
+    light.intensity      = intensity;
+    light.range          = range;
+    light.innerConeAngle = innerConeAngle;
+    light.outerConeAngle = outerConeAngle;
+    m_lights.push_back(light);
 }
 
 void Scene::Clear()
 {
     m_objects.clear();
+    m_lights.clear();
+    m_revision = NextRevision();
 }
 
 }  // namespace SpatialRender
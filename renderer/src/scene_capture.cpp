@@ -0,0 +1,528 @@
+#include "scene_capture.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "camera.h"
+#include "mesh.h"
+#include "shader.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+constexpr char kMagic[4] = {'S', 'R', 'C', 'P'};
+
+class Writer
+{
+ public:
+    template <typename T>
+    void Put(T const& value)
+    {
+        PutBytes(&value, sizeof(T));
+    }
+
+    void PutBytes(void const* data, size_t size)
+    {
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+
+    void PutString(std::string const& text)
+    {
+        Put((uint32_t)text.size());
+        PutBytes(text.data(), text.size());
+    }
+
+    template <typename T>
+    void PutArray(std::vector<T> const& values)
+    {
+        Put((uint32_t)values.size());
+        PutBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    std::vector<uint8_t>& GetData() { return m_data; }
+
+ private:
+    std::vector<uint8_t> m_data;
+};
+
+// Every read is bounds-checked; after the first failure all reads fail
+class Reader
+{
+ public:
+    Reader(uint8_t const* data, size_t size) : m_data(data), m_size(size), m_offset(0) {}
+
+    template <typename T>
+    bool Get(T& value)
+    {
+        return GetBytes(&value, sizeof(T));
+    }
+
+    bool GetBytes(void* data, size_t size)
+    {
+        if (size > m_size - m_offset)
+        {
+            m_offset = m_size;
+            return false;
+        }
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    // Counts are checked against the bytes left so a corrupt file cannot
+    // trigger a huge allocation
+    bool GetCount(uint32_t& count, size_t elementBytes)
+    {
+        return Get(count) && (uint64_t)count * elementBytes <= m_size - m_offset;
+    }
+
+    bool GetString(std::string& text)
+    {
+        uint32_t size = 0;
+        if (!GetCount(size, 1))
+            return false;
+        text.resize(size);
+        return GetBytes(text.data(), size);
+    }
+
+    template <typename T>
+    bool GetArray(std::vector<T>& values)
+    {
+        uint32_t count = 0;
+        if (!GetCount(count, sizeof(T)))
+            return false;
+        values.resize(count);
+        return GetBytes(values.data(), count * sizeof(T));
+    }
+
+    bool AtEnd() const { return m_offset == m_size; }
+
+ private:
+    uint8_t const* m_data;
+    size_t m_size;
+    size_t m_offset;
+};
+
+void PutCamera(Writer& writer, CapturedCamera const& camera)
+{
+    writer.Put(camera.position);
+    writer.Put(camera.target);
+    writer.Put(camera.up);
+    writer.Put(camera.fov);
+    writer.Put(camera.aspect);
+    writer.Put(camera.near);
+    writer.Put(camera.far);
+    writer.Put((uint8_t)camera.orthographic);
+    writer.Put((uint8_t)camera.reversedZ);
+    writer.Put(camera.orthographicBounds);
+}
+
+bool GetCamera(Reader& reader, CapturedCamera& camera)
+{
+    uint8_t orthographic = 0;
+    uint8_t reversedZ    = 0;
+    bool ok = reader.Get(camera.position) && reader.Get(camera.target) && reader.Get(camera.up) &&
+              reader.Get(camera.fov) && reader.Get(camera.aspect) && reader.Get(camera.near) &&
+              reader.Get(camera.far) && reader.Get(orthographic) && reader.Get(reversedZ) &&
+              reader.Get(camera.orthographicBounds);
+    camera.orthographic = orthographic != 0;
+    camera.reversedZ    = reversedZ != 0;
+    return ok;
+}
+
+}  // namespace
+
+CapturedCamera CapturedCamera::FromCamera(Camera const& camera)
+{
+    CapturedCamera captured;
+    captured.position           = camera.GetPosition();
+    captured.target             = camera.GetTarget();
+    captured.up                 = camera.GetUp();
+    captured.fov                = camera.GetFov();
+    captured.aspect             = camera.GetAspect();
+    captured.near               = camera.GetNear();
+    captured.far                = camera.GetFar();
+    captured.orthographic       = camera.IsOrthographic();
+    captured.reversedZ          = camera.IsReversedZ();
+    captured.orthographicBounds = camera.GetOrthographicBounds();
+    return captured;
+}
+
+void CapturedCamera::ApplyTo(Camera& camera) const
+{
+    camera.SetPosition(position);
+    camera.SetTarget(target);
+    camera.SetUp(up);
+    if (orthographic)
+    {
+        glm::vec4 const& bounds = orthographicBounds;
+        camera.SetOrthographic(bounds.x, bounds.y, bounds.z, bounds.w, near, far);
+    }
+    else
+    {
+        camera.SetPerspective(fov, aspect, near, far);
+    }
+    camera.SetReversedZ(reversedZ);
+}
+
+SceneCapture::SceneCapture() : m_width(0), m_height(0) {}
+
+uint64_t SceneCapture::HashMesh(Mesh const& mesh)
+{
+    return HashMeshData(mesh.GetVertices(), mesh.GetIndices());
+}
+
+uint64_t SceneCapture::HashMeshData(std::vector<Vertex> const& vertices,
+                                    std::vector<unsigned int> const& indices)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix      = [&](void const* data, size_t size) {
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    // The counts keep a vertex/index split from colliding with another
+    uint64_t counts[2] = {vertices.size(), indices.size()};
+    mix(counts, sizeof(counts));
+    mix(vertices.data(), vertices.size() * sizeof(Vertex));
+    mix(indices.data(), indices.size() * sizeof(unsigned int));
+    return hash;
+}
+
+bool SceneCapture::IsValidMeshData(MeshData const& mesh)
+{
+    // Indices past the vertices would be read by the occlusion rasterizer and
+    // handed to the driver
+    if (mesh.indices.size() % 3 != 0)
+        return false;
+    for (unsigned int index : mesh.indices)
+    {
+        if (index >= mesh.vertices.size())
+            return false;
+    }
+    return HashMeshData(mesh.vertices, mesh.indices) == mesh.hash;
+}
+
+void SceneCapture::CaptureScene(Scene const& scene)
+{
+    SR_TRACE_ZONE("SceneCapture::CaptureScene");
+
+    m_meshData.clear();
+    m_meshes.clear();
+    m_shaders.clear();
+    m_objects.clear();
+
+    std::unordered_map<uint64_t, uint32_t> dataByHash;
+    std::unordered_map<Mesh const*, uint32_t> meshIndices;
+    std::unordered_map<Shader const*, uint32_t> shaderIndices;
+    for (SceneObject const& obj : scene.GetObjects())
+    {
+        CapturedObject captured{kNone, kNone, obj.transform, obj.color, obj.occluder};
+
+        if (obj.mesh)
+        {
+            auto [mesh, added] = meshIndices.try_emplace(obj.mesh.get(), (uint32_t)m_meshes.size());
+            if (added)
+            {
+                uint64_t hash        = HashMesh(*obj.mesh);
+                auto [data, newData] = dataByHash.try_emplace(hash, (uint32_t)m_meshData.size());
+                if (newData)
+                {
+                    m_meshData.push_back({hash, obj.mesh->GetVertices(), obj.mesh->GetIndices()});
+                }
+                m_meshes.push_back(data->second);
+            }
+            captured.mesh = mesh->second;
+        }
+
+        if (obj.shader)
+        {
+            auto [shader, added] =
+                shaderIndices.try_emplace(obj.shader.get(), (uint32_t)m_shaders.size());
+            if (added)
+            {
+                m_shaders.push_back(
+                    {obj.shader->GetVertexSource(), obj.shader->GetFragmentSource()});
+            }
+            captured.shader = shader->second;
+        }
+
+        m_objects.push_back(captured);
+    }
+
+    m_lights = scene.GetLights();
+}
+
+void SceneCapture::AddFrame(Camera const* cameras, size_t count)
+{
+    if (count == 0 || count > (size_t)Renderer::kMaxViews)
+    {
+        std::cerr << "A captured frame needs 1 to " << Renderer::kMaxViews << " cameras"
+                  << std::endl;
+        return;
+    }
+
+    std::vector<CapturedCamera>& frame = m_frames.emplace_back();
+    for (size_t i = 0; i < count; ++i)
+    {
+        frame.push_back(CapturedCamera::FromCamera(cameras[i]));
+    }
+}
+
+void SceneCapture::SetResolution(int width, int height)
+{
+    m_width  = width;
+    m_height = height;
+}
+
+std::vector<uint8_t> SceneCapture::Serialize() const
+{
+    Writer writer;
+    writer.PutBytes(kMagic, sizeof(kMagic));
+    writer.Put(kVersion);
+    writer.Put((int32_t)m_width);
+    writer.Put((int32_t)m_height);
+
+    writer.Put((uint32_t)m_meshData.size());
+    for (MeshData const& data : m_meshData)
+    {
+        writer.Put(data.hash);
+        writer.PutArray(data.vertices);
+        writer.PutArray(data.indices);
+    }
+    writer.PutArray(m_meshes);
+
+    writer.Put((uint32_t)m_shaders.size());
+    for (ShaderSource const& shader : m_shaders)
+    {
+        writer.PutString(shader.vertex);
+        writer.PutString(shader.fragment);
+    }
+
+    writer.Put((uint32_t)m_objects.size());
+    for (CapturedObject const& obj : m_objects)
+    {
+        writer.Put(obj.mesh);
+        writer.Put(obj.shader);
+        writer.Put(obj.transform);
+        writer.Put(obj.color);
+        writer.Put((uint8_t)obj.occluder);
+    }
+
+    writer.Put((uint32_t)m_lights.size());
+    for (Light const& light : m_lights)
+    {
+        writer.Put((uint32_t)light.type);
+        writer.Put(light.position);
+        writer.Put(light.direction);
+        writer.Put(light.color);
+        writer.Put(light.intensity);
+        writer.Put(light.range);
+        writer.Put(light.innerConeAngle);
+        writer.Put(light.outerConeAngle);
+    }
+
+    writer.Put((uint32_t)m_frames.size());
+    for (std::vector<CapturedCamera> const& frame : m_frames)
+    {
+        writer.Put((uint32_t)frame.size());
+        for (CapturedCamera const& camera : frame)
+        {
+            PutCamera(writer, camera);
+        }
+    }
+    return std::move(writer.GetData());
+}
+
+bool SceneCapture::Deserialize(uint8_t const* data, size_t size)
+{
+    SR_TRACE_ZONE("SceneCapture::Deserialize");
+
+    Reader reader(data, size);
+    SceneCapture capture;
+
+    char magic[4]    = {};
+    uint32_t version = 0;
+    int32_t width    = 0;
+    int32_t height   = 0;
+    if (!reader.GetBytes(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    {
+        std::cerr << "Not a scene capture" << std::endl;
+        return false;
+    }
+    if (!reader.Get(version) || version != kVersion)
+    {
+        std::cerr << "Unsupported scene capture version " << version << std::endl;
+        return false;
+    }
+    bool ok          = reader.Get(width) && reader.Get(height);
+    capture.m_width  = width;
+    capture.m_height = height;
+
+    uint32_t count = 0;
+    ok             = ok && reader.GetCount(count, sizeof(uint64_t));
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        MeshData& mesh = capture.m_meshData.emplace_back();
+        ok = reader.Get(mesh.hash) && reader.GetArray(mesh.vertices) &&
+             reader.GetArray(mesh.indices) && IsValidMeshData(mesh);
+    }
+    ok = ok && reader.GetArray(capture.m_meshes);
+    for (uint32_t mesh : capture.m_meshes)
+    {
+        ok = ok && mesh < capture.m_meshData.size();
+    }
+
+    ok = ok && reader.GetCount(count, 2 * sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        ShaderSource& shader = capture.m_shaders.emplace_back();
+        ok                   = reader.GetString(shader.vertex) && reader.GetString(shader.fragment);
+    }
+
+    ok = ok && reader.GetCount(count, 2 * sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        CapturedObject& obj = capture.m_objects.emplace_back();
+        uint8_t occluder    = 0;
+        ok = reader.Get(obj.mesh) && reader.Get(obj.shader) && reader.Get(obj.transform) &&
+             reader.Get(obj.color) && reader.Get(occluder) &&
+             (obj.mesh == kNone || obj.mesh < capture.m_meshes.size()) &&
+             (obj.shader == kNone || obj.shader < capture.m_shaders.size());
+        obj.occluder = occluder != 0;
+    }
+
+    ok = ok && reader.GetCount(count, sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        Light& light  = capture.m_lights.emplace_back();
+        uint32_t type = 0;
+        ok = reader.Get(type) && reader.Get(light.position) && reader.Get(light.direction) &&
+             reader.Get(light.color) && reader.Get(light.intensity) && reader.Get(light.range) &&
+             reader.Get(light.innerConeAngle) && reader.Get(light.outerConeAngle) &&
+             type <= (uint32_t)LightType::Spot;
+        light.type = (LightType)type;
+    }
+
+    ok = ok && reader.GetCount(count, sizeof(uint32_t));
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        uint32_t views = 0;
+        ok = reader.Get(views) && views >= 1 && views <= (uint32_t)Renderer::kMaxViews;
+        std::vector<CapturedCamera>& frame = capture.m_frames.emplace_back(ok ? views : 0);
+        for (CapturedCamera& camera : frame)
+        {
+            ok = ok && GetCamera(reader, camera);
+        }
+    }
+
+    if (!ok || !reader.AtEnd())
+    {
+        std::cerr << "Scene capture is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    *this = std::move(capture);
+    return true;
+}
+
+bool SceneCapture::Save(std::string const& path) const
+{
+    std::vector<uint8_t> data = Serialize();
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<char const*>(data.data()), data.size());
+    return file.good();
+}
+
+bool SceneCapture::Load(std::string const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open scene capture: " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    return Deserialize(data.data(), data.size());
+}
+
+bool SceneCapture::BuildScene(Scene& scene) const
+{
+    SR_TRACE_ZONE("SceneCapture::BuildScene");
+
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    for (uint32_t index : m_meshes)
+    {
+        MeshData const& data = m_meshData[index];
+        auto mesh            = std::make_shared<Mesh>();
+        mesh->SetVertices(data.vertices);
+        mesh->SetIndices(data.indices);
+        meshes.push_back(std::move(mesh));
+    }
+
+    std::vector<std::shared_ptr<Shader>> shaders;
+    for (ShaderSource const& source : m_shaders)
+    {
+        auto shader = std::make_shared<Shader>();
+        if (!shader->LoadFromSource(source.vertex, source.fragment))
+        {
+            std::cerr << "Failed to compile captured shader " << shaders.size() << std::endl;
+            return false;
+        }
+        shaders.push_back(std::move(shader));
+    }
+
+    for (CapturedObject const& obj : m_objects)
+    {
+        scene.AddObject(obj.mesh == kNone ? nullptr : meshes[obj.mesh],
+                        obj.shader == kNone ? nullptr : shaders[obj.shader],
+                        obj.transform,
+                        obj.color);
+        if (obj.occluder)
+        {
+            scene.SetOccluder(scene.GetObjectCount() - 1, true);
+        }
+    }
+    for (Light const& light : m_lights)
+    {
+        scene.AddLight(light);
+    }
+    return true;
+}
+
+void SceneCapture::GetFrame(size_t frame, std::vector<Camera>& cameras) const
+{
+    if (m_frames.empty())
+    {
+        cameras.clear();
+        return;
+    }
+
+    std::vector<CapturedCamera> const& views = m_frames[frame % m_frames.size()];
+    cameras.resize(views.size());
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        views[i].ApplyTo(cameras[i]);
+    }
+}
+
+}  // namespace SpatialRender
@@ -4,18 +4,20 @@
 #include <iostream>
 #include <sstream>
 
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "trace.h"
+
 namespace SpatialRender
 {
 
-Shader::Shader() : m_program(0), m_linked(false)
+Shader::Shader() : m_program(0), m_linked(false), m_revision(0)
 {}
 
 Shader::~Shader()
 {
-    if (m_program != 0)
-    {
-        glDeleteProgram(m_program);
-    }
+    MemoryTracker::Get().Release(MemoryResource::Program, m_program);
+    GLStateCache::Get().DeleteProgram(m_program);
 }
 
 std::string Shader::ReadFile(std::string const& path)
@@ -34,6 +36,8 @@ std::string Shader::ReadFile(std::string const& path)
 
 GLuint Shader::CompileShader(GLenum type, std::string const& source)
 {
+    SR_TRACE_ZONE("Shader::CompileShader");
+
     GLuint shader   = glCreateShader(type);
     char const* src = source.c_str();
     glShaderSource(shader, 1, &src, nullptr);
@@ -54,7 +58,15 @@ GLuint Shader::CompileShader(GLenum type, std::string const& source)
 
 bool Shader::LinkProgram(GLuint vertex, GLuint fragment)
 {
+    SR_TRACE_ZONE("Shader::LinkProgram");
+
+    // A reload replaces the program, linked or not
+    MemoryTracker::Get().Release(MemoryResource::Program, m_program);
+    GLStateCache::Get().DeleteProgram(m_program);
+    ++m_revision;
+
     m_program = glCreateProgram();
+    m_uniformLocations.clear();
     glAttachShader(m_program, vertex);
     glAttachShader(m_program, fragment);
     glLinkProgram(m_program);
@@ -73,6 +85,16 @@ bool Shader::LinkProgram(GLuint vertex, GLuint fragment)
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    // The binary length is the closest measure of what the driver keeps
+    if (GLEW_ARB_get_program_binary)
+    {
+        GLint length = 0;
+        glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+        MemoryTracker::Get().Record(
+            MemoryResource::Program, m_program, MemoryCategory::ShaderProgram, "Shader", length);
+    }
+
     m_linked = true;
     return true;
 }
@@ -115,64 +137,94 @@ bool Shader::LoadFromSource(std::string const& vertexSource, std::string const&
         return false;
     }
 
-    return LinkProgram(vertex, fragment);
+    if (!LinkProgram(vertex, fragment))
+        return false;
+
+    m_vertexSource   = vertexSource;
+    m_fragmentSource = fragmentSource;
+    return true;
 }
 
 void Shader::Use()
 {
     if (m_program != 0)
     {
-        glUseProgram(m_program);
+        GLStateCache::Get().UseProgram(m_program);
     }
 }
 
 void Shader::Unuse()
 {
-    glUseProgram(0);
+    GLStateCache::Get().UseProgram(0);
+}
+
+GLint Shader::GetUniformLocation(std::string const& name)
+{
+    auto it = m_uniformLocations.find(name);
+    if (it == m_uniformLocations.end())
+    {
+        it = m_uniformLocations.emplace(name, glGetUniformLocation(m_program, name.c_str())).first;
+    }
+    return it->second;
 }
 
 void Shader::SetUniform(std::string const& name, float value)
 {
-    GLint location = glGetUniformLocation(m_program, name.c_str());
+    GLint location = GetUniformLocation(name);
     if (location >= 0)
     {
         glUniform1f(location, value);
+        GLStateCache::Get().CountUniformUpload();
     }
 }
 
 void Shader::SetUniform(std::string const& name, int value)
 {
-    GLint location = glGetUniformLocation(m_program, name.c_str());
+    GLint location = GetUniformLocation(name);
     if (location >= 0)
     {
         glUniform1i(location, value);
+        GLStateCache::Get().CountUniformUpload();
     }
 }
 
 void Shader::SetUniform(std::string const& name, glm::vec3 const& value)
 {
-    GLint location = glGetUniformLocation(m_program, name.c_str());
+    GLint location = GetUniformLocation(name);
     if (location >= 0)
     {
         glUniform3fv(location, 1, &value[0]);
+        GLStateCache::Get().CountUniformUpload();
     }
 }
 
 void Shader::SetUniform(std::string const& name, glm::vec4 const& value)
 {
-    GLint location = glGetUniformLocation(m_program, name.c_str());
+    GLint location = GetUniformLocation(name);
     if (location >= 0)
     {
         glUniform4fv(location, 1, &value[0]);
+        GLStateCache::Get().CountUniformUpload();
     }
 }
 
 void Shader::SetUniform(std::string const& name, glm::mat4 const& value)
 {
-    GLint location = glGetUniformLocation(m_program, name.c_str());
+    GLint location = GetUniformLocation(name);
     if (location >= 0)
     {
         glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+        GLStateCache::Get().CountUniformUpload();
+    }
+}
+
+void Shader::SetUniform(std::string const& name, glm::mat4 const* values, int count)
+{
+    GLint location = GetUniformLocation(name);
+    if (location >= 0 && count > 0)
+    {
+        glUniformMatrix4fv(location, count, GL_FALSE, &values[0][0][0]);
+        GLStateCache::Get().CountUniformUpload();
     }
 }
 
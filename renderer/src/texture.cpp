@@ -0,0 +1,983 @@
+#include "texture.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+
+#include "gl_state.h"
+#include "memory_tracker.h"
+#include "trace.h"
+
+namespace SpatialRender
+{
+
+namespace
+{
+
+std::array<TextureFormatInfo, (size_t)TextureFormat::Count> const kFormats = {{
+    {"RGBA8", GL_RGBA8, GL_SRGB8_ALPHA8, 1, 1, 4},
+    {"BC1", GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 4, 4, 8},
+    {"BC2", GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 4, 4, 16},
+    {"BC3", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 4, 4, 16},
+    {"BC4", GL_COMPRESSED_RED_RGTC1, 0, 4, 4, 8},
+    {"BC5", GL_COMPRESSED_RG_RGTC2, 0, 4, 4, 16},
+    {"BC6H", GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 4, 4, 16},
+    {"BC7", GL_COMPRESSED_RGBA_BPTC_UNORM, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 4, 4, 16},
+    {"ETC2_RGB8", GL_COMPRESSED_RGB8_ETC2, GL_COMPRESSED_SRGB8_ETC2, 4, 4, 8},
+    {"ETC2_RGBA8", GL_COMPRESSED_RGBA8_ETC2_EAC, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 4, 4, 16},
+}};
+
+// Staging buffers are never smaller than this, so small levels share sizes
+constexpr size_t kMinStagingBytes = 1024 * 1024;
+
+template <typename T>
+T ReadLE(uint8_t const* bytes)
+{
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// Lays out up to levelCount levels of the chain below width x height, tightly
+// packed in level order
+bool BuildLevels(TextureImage& image, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+    if (width == 0 || height == 0)
+    {
+        std::cerr << "Texture has no pixels" << std::endl;
+        return false;
+    }
+
+    image.levels.clear();
+    size_t offset = 0;
+    for (uint32_t level = 0; level < std::max(levelCount, 1u); ++level)
+    {
+        TextureLevel info;
+        info.width  = std::max(width >> level, 1u);
+        info.height = std::max(height >> level, 1u);
+        info.offset = offset;
+        info.bytes  = GetTextureLevelBytes(image.format, info.width, info.height);
+        image.levels.push_back(info);
+        offset += info.bytes;
+
+        if (info.width == 1 && info.height == 1)
+            break;
+    }
+    return true;
+}
+
+GLenum GetInternalFormat(TextureImage const& image)
+{
+    TextureFormatInfo const& info = GetTextureFormatInfo(image.format);
+    return image.srgb ? info.srgbInternalFormat : info.internalFormat;
+}
+
+bool SetSrgb(TextureImage& image, bool srgb)
+{
+    if (srgb && GetTextureFormatInfo(image.format).srgbInternalFormat == 0)
+    {
+        std::cerr << GetTextureFormatInfo(image.format).name << " has no sRGB variant" << std::endl;
+        return false;
+    }
+    image.srgb = srgb;
+    return true;
+}
+
+bool FromVkFormat(uint32_t vkFormat, TextureImage& image)
+{
+    struct Mapping
+    {
+        uint32_t vkFormat;
+        TextureFormat format;
+        bool srgb;
+    };
+    static Mapping const kMappings[] = {
+        {37, TextureFormat::RGBA8, false},       {43, TextureFormat::RGBA8, true},
+        {133, TextureFormat::BC1, false},        {134, TextureFormat::BC1, true},
+        {135, TextureFormat::BC2, false},        {136, TextureFormat::BC2, true},
+        {137, TextureFormat::BC3, false},        {138, TextureFormat::BC3, true},
+        {139, TextureFormat::BC4, false},        {141, TextureFormat::BC5, false},
+        {143, TextureFormat::BC6H, false},       {145, TextureFormat::BC7, false},
+        {146, TextureFormat::BC7, true},         {147, TextureFormat::ETC2_RGB8, false},
+        {148, TextureFormat::ETC2_RGB8, true},   {151, TextureFormat::ETC2_RGBA8, false},
+        {152, TextureFormat::ETC2_RGBA8, true},
+    };
+
+    for (Mapping const& mapping : kMappings)
+    {
+        if (mapping.vkFormat == vkFormat)
+        {
+            image.format = mapping.format;
+            image.srgb   = mapping.srgb;
+            return true;
+        }
+    }
+    std::cerr << "Unsupported KTX2 vkFormat " << vkFormat << std::endl;
+    return false;
+}
+
+bool FromDxgiFormat(uint32_t dxgiFormat, TextureImage& image)
+{
+    struct Mapping
+    {
+        uint32_t dxgiFormat;
+        TextureFormat format;
+        bool srgb;
+    };
+    static Mapping const kMappings[] = {
+        {28, TextureFormat::RGBA8, false}, {29, TextureFormat::RGBA8, true},
+        {71, TextureFormat::BC1, false},   {72, TextureFormat::BC1, true},
+        {74, TextureFormat::BC2, false},   {75, TextureFormat::BC2, true},
+        {77, TextureFormat::BC3, false},   {78, TextureFormat::BC3, true},
+        {80, TextureFormat::BC4, false},   {83, TextureFormat::BC5, false},
+        {95, TextureFormat::BC6H, false},  {98, TextureFormat::BC7, false},
+        {99, TextureFormat::BC7, true},
+    };
+
+    for (Mapping const& mapping : kMappings)
+    {
+        if (mapping.dxgiFormat == dxgiFormat)
+        {
+            image.format = mapping.format;
+            image.srgb   = mapping.srgb;
+            return true;
+        }
+    }
+    std::cerr << "Unsupported DDS DXGI format " << dxgiFormat << std::endl;
+    return false;
+}
+
+uint32_t FourCC(char const (&code)[5])
+{
+    return (uint32_t)(uint8_t)code[0] | ((uint32_t)(uint8_t)code[1] << 8) |
+           ((uint32_t)(uint8_t)code[2] << 16) | ((uint32_t)(uint8_t)code[3] << 24);
+}
+
+}  // namespace
+
+TextureFormatInfo const& GetTextureFormatInfo(TextureFormat format)
+{
+    return kFormats[std::min((size_t)format, kFormats.size() - 1)];
+}
+
+bool IsTextureFormatSupported(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::RGBA8:
+        case TextureFormat::BC4:
+        case TextureFormat::BC5:
+            // RGTC is core since GL 3.0
+            return true;
+        case TextureFormat::BC1:
+        case TextureFormat::BC2:
+        case TextureFormat::BC3:
+            return GLEW_EXT_texture_compression_s3tc;
+        case TextureFormat::BC6H:
+        case TextureFormat::BC7:
+            return GLEW_ARB_texture_compression_bptc;
+        case TextureFormat::ETC2_RGB8:
+        case TextureFormat::ETC2_RGBA8:
+            return GLEW_ARB_ES3_compatibility;
+        default:
+            return false;
+    }
+}
+
+size_t GetTextureLevelBytes(TextureFormat format, uint32_t width, uint32_t height)
+{
+    TextureFormatInfo const& info = GetTextureFormatInfo(format);
+
+    size_t blocksX = (std::max(width, 1u) + info.blockWidth - 1) / info.blockWidth;
+    size_t blocksY = (std::max(height, 1u) + info.blockHeight - 1) / info.blockHeight;
+    return blocksX * blocksY * info.blockBytes;
+}
+
+bool ParseKTX2(uint8_t const* bytes, size_t size, TextureImage& image)
+{
+    static uint8_t const kIdentifier[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    size_t const kHeaderBytes = 80;
+    size_t const kLevelBytes  = 24;
+
+    if (size < kHeaderBytes || std::memcmp(bytes, kIdentifier, sizeof(kIdentifier)) != 0)
+    {
+        std::cerr << "Not a KTX2 file" << std::endl;
+        return false;
+    }
+
+    uint32_t vkFormat         = ReadLE<uint32_t>(bytes + 12);
+    uint32_t width            = ReadLE<uint32_t>(bytes + 20);
+    uint32_t height           = ReadLE<uint32_t>(bytes + 24);
+    uint32_t depth            = ReadLE<uint32_t>(bytes + 28);
+    uint32_t layerCount       = ReadLE<uint32_t>(bytes + 32);
+    uint32_t faceCount        = ReadLE<uint32_t>(bytes + 36);
+    uint32_t levelCount       = std::max(ReadLE<uint32_t>(bytes + 40), 1u);
+    uint32_t supercompression = ReadLE<uint32_t>(bytes + 44);
+
+    if (supercompression != 0)
+    {
+        std::cerr << "Supercompressed KTX2 files are not supported" << std::endl;
+        return false;
+    }
+    if (depth > 1 || layerCount > 1 || faceCount != 1)
+    {
+        std::cerr << "Only single 2D KTX2 images are supported" << std::endl;
+        return false;
+    }
+    if (size < kHeaderBytes + levelCount * kLevelBytes || !FromVkFormat(vkFormat, image) ||
+        !BuildLevels(image, width, height, levelCount))
+    {
+        return false;
+    }
+
+    // Every level must lie inside the file before anything is allocated: the
+    // header alone can claim gigabytes of pixels
+    size_t total = 0;
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        uint8_t const* entry = bytes + kHeaderBytes + level * kLevelBytes;
+        uint64_t offset      = ReadLE<uint64_t>(entry);
+        uint64_t length      = ReadLE<uint64_t>(entry + 8);
+        if (length != image.levels[level].bytes || offset > size || size - offset < length)
+        {
+            std::cerr << "KTX2 level " << level << " is truncated or has the wrong size"
+                      << std::endl;
+            return false;
+        }
+        total += length;
+    }
+    if (total > size)
+    {
+        std::cerr << "KTX2 levels claim more data than the file holds" << std::endl;
+        return false;
+    }
+
+    // The level index starts at level 0 while the data is usually stored
+    // coarsest first; copy each level to its place in our level-0-first layout
+    image.data.resize(total);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        TextureLevel const& info = image.levels[level];
+        uint64_t offset          = ReadLE<uint64_t>(bytes + kHeaderBytes + level * kLevelBytes);
+        std::memcpy(image.data.data() + info.offset, bytes + offset, info.bytes);
+    }
+    return true;
+}
+
+bool ParseDDS(uint8_t const* bytes, size_t size, TextureImage& image)
+{
+    uint32_t const kFlagMipMapCount = 0x20000;
+    uint32_t const kPixelFourCC     = 0x4;
+    uint32_t const kPixelRGB        = 0x40;
+    uint32_t const kCaps2Cubemap    = 0x200;
+    uint32_t const kCaps2Volume     = 0x200000;
+    size_t const kHeaderBytes       = 4 + 124;
+    size_t const kDX10Bytes         = 20;
+
+    if (size < kHeaderBytes || ReadLE<uint32_t>(bytes) != FourCC("DDS ") ||
+        ReadLE<uint32_t>(bytes + 4) != 124)
+    {
+        std::cerr << "Not a DDS file" << std::endl;
+        return false;
+    }
+
+    uint32_t flags      = ReadLE<uint32_t>(bytes + 8);
+    uint32_t height     = ReadLE<uint32_t>(bytes + 12);
+    uint32_t width      = ReadLE<uint32_t>(bytes + 16);
+    uint32_t levelCount = (flags & kFlagMipMapCount) ? ReadLE<uint32_t>(bytes + 28) : 1;
+    uint32_t pixelFlags = ReadLE<uint32_t>(bytes + 80);
+    uint32_t fourCC     = ReadLE<uint32_t>(bytes + 84);
+    uint32_t bitCount   = ReadLE<uint32_t>(bytes + 88);
+    uint32_t caps2      = ReadLE<uint32_t>(bytes + 112);
+    size_t dataOffset   = kHeaderBytes;
+
+    if (caps2 & (kCaps2Cubemap | kCaps2Volume))
+    {
+        std::cerr << "Only 2D DDS images are supported" << std::endl;
+        return false;
+    }
+
+    if ((pixelFlags & kPixelFourCC) && fourCC == FourCC("DX10"))
+    {
+        if (size < kHeaderBytes + kDX10Bytes)
+        {
+            std::cerr << "DDS DX10 header is truncated" << std::endl;
+            return false;
+        }
+        uint8_t const* dx10 = bytes + kHeaderBytes;
+        uint32_t dimension  = ReadLE<uint32_t>(dx10 + 4);
+        uint32_t miscFlags  = ReadLE<uint32_t>(dx10 + 8);
+        uint32_t arraySize  = ReadLE<uint32_t>(dx10 + 12);
+        if (dimension != 3 || (miscFlags & 0x4) || arraySize > 1)
+        {
+            std::cerr << "Only single 2D DDS images are supported" << std::endl;
+            return false;
+        }
+        if (!FromDxgiFormat(ReadLE<uint32_t>(dx10), image))
+            return false;
+        dataOffset += kDX10Bytes;
+    }
+    else if (pixelFlags & kPixelFourCC)
+    {
+        image.srgb = false;
+        if (fourCC == FourCC("DXT1"))
+            image.format = TextureFormat::BC1;
+        else if (fourCC == FourCC("DXT2") || fourCC == FourCC("DXT3"))
+            image.format = TextureFormat::BC2;
+        else if (fourCC == FourCC("DXT4") || fourCC == FourCC("DXT5"))
+            image.format = TextureFormat::BC3;
+        else if (fourCC == FourCC("ATI1") || fourCC == FourCC("BC4U"))
+            image.format = TextureFormat::BC4;
+        else if (fourCC == FourCC("ATI2") || fourCC == FourCC("BC5U"))
+            image.format = TextureFormat::BC5;
+        else
+        {
+            std::cerr << "Unsupported DDS FourCC" << std::endl;
+            return false;
+        }
+    }
+    else if ((pixelFlags & kPixelRGB) && bitCount == 32 &&
+             ReadLE<uint32_t>(bytes + 92) == 0x000000FF &&
+             ReadLE<uint32_t>(bytes + 96) == 0x0000FF00 &&
+             ReadLE<uint32_t>(bytes + 100) == 0x00FF0000)
+    {
+        image.format = TextureFormat::RGBA8;
+        image.srgb   = false;
+    }
+    else
+    {
+        std::cerr << "Unsupported DDS pixel format" << std::endl;
+        return false;
+    }
+
+    if (!BuildLevels(image, width, height, levelCount))
+        return false;
+
+    size_t total = image.levels.back().offset + image.levels.back().bytes;
+    if (size - dataOffset < total)
+    {
+        std::cerr << "DDS data is truncated" << std::endl;
+        return false;
+    }
+    image.data.assign(bytes + dataOffset, bytes + dataOffset + total);
+    return true;
+}
+
+bool LoadTextureFile(std::string const& path, TextureImage& image)
+{
+    SR_TRACE_ZONE("LoadTextureFile");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open texture " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    bool loaded = false;
+    if (bytes.size() >= 4 && ReadLE<uint32_t>(bytes.data()) == FourCC("DDS "))
+    {
+        loaded = ParseDDS(bytes.data(), bytes.size(), image);
+    }
+    else
+    {
+        loaded = ParseKTX2(bytes.data(), bytes.size(), image);
+    }
+
+    if (!loaded)
+    {
+        std::cerr << "Failed to load texture " << path << std::endl;
+    }
+    return loaded;
+}
+
+Texture::Texture() : m_texture(0), m_residentLevel(0), m_residentBytes(0), m_revision(0) {}
+
+Texture::~Texture()
+{
+    Cleanup();
+}
+
+bool Texture::Create(TextureImage&& image, std::string const& name)
+{
+    Cleanup();
+
+    if (image.levels.empty())
+    {
+        std::cerr << "Texture " << name << " has no levels" << std::endl;
+        return false;
+    }
+    if (!IsTextureFormatSupported(image.format))
+    {
+        std::cerr << "Texture " << name << ": " << GetTextureFormatInfo(image.format).name
+                  << " is not supported by this context" << std::endl;
+        return false;
+    }
+    if (!SetSrgb(image, image.srgb))
+        return false;
+
+    m_name          = name;
+    m_image         = std::move(image);
+    m_residentLevel = GetLevelCount();
+    m_residentBytes = 0;
+
+    glGenTextures(1, &m_texture);
+    ++m_revision;
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D,
+                    GL_TEXTURE_MIN_FILTER,
+                    GetLevelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GetLevelCount() - 1);
+    // A base level past the last one leaves the texture incomplete until the
+    // first upload
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_residentLevel);
+
+    TrackMemory();
+    return true;
+}
+
+void Texture::UploadAll()
+{
+    while (m_texture != 0 && m_residentLevel > 0)
+    {
+        UploadLevel(m_residentLevel - 1, m_image.GetLevelData(m_residentLevel - 1));
+    }
+}
+
+void Texture::Cleanup()
+{
+    if (m_texture != 0)
+    {
+        GLStateCache::Get().DeleteTexture(m_texture);
+        MemoryTracker& memory = MemoryTracker::Get();
+        memory.Release(MemoryResource::Texture, m_texture);
+        memory.Release(MemoryResource::Host, (uintptr_t)this);
+        m_texture = 0;
+        ++m_revision;
+    }
+    m_residentLevel = GetLevelCount();
+    m_residentBytes = 0;
+}
+
+void Texture::Bind(GLuint unit) const
+{
+    GLStateCache::Get().BindTexture(unit, GL_TEXTURE_2D, m_texture);
+}
+
+void Texture::UploadLevel(int level, void const* pixels)
+{
+    TextureLevel const& info = m_image.levels[level];
+    GLenum internalFormat    = GetInternalFormat(m_image);
+
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    if (m_image.format == TextureFormat::RGBA8)
+    {
+        glTexImage2D(GL_TEXTURE_2D,
+                     level,
+                     internalFormat,
+                     info.width,
+                     info.height,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     pixels);
+    }
+    else
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D,
+                               level,
+                               internalFormat,
+                               info.width,
+                               info.height,
+                               0,
+                               (GLsizei)info.bytes,
+                               pixels);
+    }
+    SetResidentLevel(level);
+}
+
+bool Texture::DropFinestLevel()
+{
+    if (m_texture == 0 || m_residentLevel >= GetLevelCount() - 1)
+        return false;
+
+    // Respecifying a level as 0x0 releases its storage
+    GLenum internalFormat = GetInternalFormat(m_image);
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    if (m_image.format == TextureFormat::RGBA8)
+    {
+        glTexImage2D(GL_TEXTURE_2D,
+                     m_residentLevel,
+                     internalFormat,
+                     0,
+                     0,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    }
+    else
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, m_residentLevel, internalFormat, 0, 0, 0, 0, nullptr);
+    }
+    SetResidentLevel(m_residentLevel + 1);
+    return true;
+}
+
+void Texture::SetResidentLevel(int level)
+{
+    m_residentLevel = level;
+    m_residentBytes = 0;
+    for (int i = level; i < GetLevelCount(); ++i)
+    {
+        m_residentBytes += m_image.levels[i].bytes;
+    }
+
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    TrackMemory();
+}
+
+void Texture::TrackMemory()
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Record(MemoryResource::Texture,
+                  m_texture,
+                  MemoryCategory::Texture,
+                  m_name,
+                  m_residentBytes);
+    memory.Record(MemoryResource::Host,
+                  (uintptr_t)this,
+                  MemoryCategory::TextureData,
+                  m_name,
+                  m_image.data.size());
+}
+
+TextureArray::TextureArray() : m_texture(0), m_layerCount(0), m_layerCapacity(0) {}
+
+TextureArray::~TextureArray()
+{
+    Cleanup();
+}
+
+bool TextureArray::Create(TextureImage const& layout, int layerCapacity, std::string const& name)
+{
+    Cleanup();
+
+    if (layout.levels.empty() || layerCapacity <= 0)
+    {
+        std::cerr << "Texture array " << name << " has no levels or layers" << std::endl;
+        return false;
+    }
+    if (!IsTextureFormatSupported(layout.format))
+    {
+        std::cerr << "Texture array " << name << ": " << GetTextureFormatInfo(layout.format).name
+                  << " is not supported by this context" << std::endl;
+        return false;
+    }
+
+    m_name          = name;
+    m_layout.format = layout.format;
+    m_layout.srgb   = layout.srgb;
+    m_layout.levels = layout.levels;
+    m_layerCount    = 0;
+    m_layerCapacity = layerCapacity;
+
+    GLenum internalFormat = GetInternalFormat(m_layout);
+    if (internalFormat == 0)
+    {
+        std::cerr << "Texture array " << name << ": " << GetTextureFormatInfo(layout.format).name
+                  << " has no sRGB variant" << std::endl;
+        return false;
+    }
+
+    glGenTextures(1, &m_texture);
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY,
+                    GL_TEXTURE_MIN_FILTER,
+                    m_layout.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)m_layout.levels.size() - 1);
+
+    size_t bytes = 0;
+    for (size_t level = 0; level < m_layout.levels.size(); ++level)
+    {
+        TextureLevel const& info = m_layout.levels[level];
+        if (m_layout.format == TextureFormat::RGBA8)
+        {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                         (GLint)level,
+                         internalFormat,
+                         info.width,
+                         info.height,
+                         layerCapacity,
+                         0,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         nullptr);
+        }
+        else
+        {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY,
+                                   (GLint)level,
+                                   internalFormat,
+                                   info.width,
+                                   info.height,
+                                   layerCapacity,
+                                   0,
+                                   (GLsizei)(info.bytes * layerCapacity),
+                                   nullptr);
+        }
+        bytes += info.bytes * layerCapacity;
+    }
+
+    MemoryTracker::Get().Record(MemoryResource::Texture,
+                                m_texture,
+                                MemoryCategory::Texture,
+                                m_name,
+                                bytes);
+    return true;
+}
+
+void TextureArray::Cleanup()
+{
+    if (m_texture != 0)
+    {
+        GLStateCache::Get().DeleteTexture(m_texture);
+        MemoryTracker::Get().Release(MemoryResource::Texture, m_texture);
+        m_texture = 0;
+    }
+    m_layerCount    = 0;
+    m_layerCapacity = 0;
+}
+
+bool TextureArray::Matches(TextureImage const& image) const
+{
+    if (image.format != m_layout.format || image.srgb != m_layout.srgb ||
+        image.levels.size() != m_layout.levels.size())
+    {
+        return false;
+    }
+    return image.GetWidth() == m_layout.GetWidth() && image.GetHeight() == m_layout.GetHeight();
+}
+
+int TextureArray::AddLayer(TextureImage const& image)
+{
+    if (m_texture == 0 || IsFull() || !Matches(image))
+        return -1;
+
+    int layer             = m_layerCount++;
+    GLenum internalFormat = GetInternalFormat(m_layout);
+
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        TextureLevel const& info = image.levels[level];
+        if (image.format == TextureFormat::RGBA8)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                            (GLint)level,
+                            0,
+                            0,
+                            layer,
+                            info.width,
+                            info.height,
+                            1,
+                            GL_RGBA,
+                            GL_UNSIGNED_BYTE,
+                            image.GetLevelData(level));
+        }
+        else
+        {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                      (GLint)level,
+                                      0,
+                                      0,
+                                      layer,
+                                      info.width,
+                                      info.height,
+                                      1,
+                                      internalFormat,
+                                      (GLsizei)info.bytes,
+                                      image.GetLevelData(level));
+        }
+    }
+    return layer;
+}
+
+void TextureArray::Bind(GLuint unit) const
+{
+    GLStateCache::Get().BindTexture(unit, GL_TEXTURE_2D_ARRAY, m_texture);
+}
+
+TextureStreamer::TextureStreamer(size_t budgetBytes, size_t uploadBytesPerFrame) :
+    m_budgetBytes(budgetBytes),
+    m_uploadBytesPerFrame(uploadBytesPerFrame)
+{
+    // Acquire hands out pointers into this vector
+    m_staging.reserve(kMaxStagingBuffers);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    ReleaseStagingBuffers();
+}
+
+void TextureStreamer::Add(std::shared_ptr<Texture> texture)
+{
+    if (texture && std::find(m_textures.begin(), m_textures.end(), texture) == m_textures.end())
+    {
+        m_textures.push_back(std::move(texture));
+    }
+}
+
+void TextureStreamer::Remove(Texture const* texture)
+{
+    m_textures.erase(std::remove_if(m_textures.begin(),
+                                    m_textures.end(),
+                                    [texture](std::shared_ptr<Texture> const& entry) {
+                                        return entry.get() == texture;
+                                    }),
+                     m_textures.end());
+}
+
+void TextureStreamer::Update()
+{
+    SR_TRACE_ZONE("TextureStreamer::Update");
+
+    size_t resident = GetResidentBytes();
+    if (resident > m_budgetBytes)
+    {
+        Evict(resident);
+        return;
+    }
+
+    // Coarsest first: the smallest missing level of any texture goes next.
+    // Levels only get larger from there, so the first one that does not fit
+    // ends the frame.
+    auto later = std::greater<std::pair<size_t, size_t>>();
+    m_queue.clear();
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        Texture const& texture = *m_textures[i];
+        if (texture.GetHandle() != 0 && !texture.IsFullyResident())
+        {
+            size_t bytes = texture.m_image.levels[texture.GetResidentLevel() - 1].bytes;
+            m_queue.emplace_back(bytes, i);
+        }
+    }
+    std::make_heap(m_queue.begin(), m_queue.end(), later);
+
+    size_t uploaded = 0;
+    while (!m_queue.empty())
+    {
+        auto [bytes, index] = m_queue.front();
+        if (resident + bytes > m_budgetBytes ||
+            (uploaded > 0 && uploaded + bytes > m_uploadBytesPerFrame))
+        {
+            break;
+        }
+
+        Texture& texture = *m_textures[index];
+        if (!Upload(texture, texture.GetResidentLevel() - 1))
+        {
+            ++m_stats.deferredUploads;
+            break;
+        }
+        resident += bytes;
+        uploaded += bytes;
+
+        std::pop_heap(m_queue.begin(), m_queue.end(), later);
+        m_queue.pop_back();
+        if (!texture.IsFullyResident())
+        {
+            m_queue.emplace_back(texture.m_image.levels[texture.GetResidentLevel() - 1].bytes,
+                                 index);
+            std::push_heap(m_queue.begin(), m_queue.end(), later);
+        }
+    }
+}
+
+void TextureStreamer::Flush()
+{
+    SR_TRACE_ZONE("TextureStreamer::Flush");
+
+    size_t uploadBytesPerFrame = m_uploadBytesPerFrame;
+    m_uploadBytesPerFrame      = SIZE_MAX;
+    for (;;)
+    {
+        uint64_t deferred = m_stats.deferredUploads;
+        Update();
+        if (m_stats.deferredUploads == deferred)
+            break;
+        WaitForStaging();
+    }
+    m_uploadBytesPerFrame = uploadBytesPerFrame;
+}
+
+void TextureStreamer::Shutdown()
+{
+    ReleaseStagingBuffers();
+    for (std::shared_ptr<Texture> const& texture : m_textures)
+    {
+        texture->Cleanup();
+    }
+    m_textures.clear();
+}
+
+size_t TextureStreamer::GetResidentBytes() const
+{
+    size_t total = 0;
+    for (std::shared_ptr<Texture> const& texture : m_textures)
+    {
+        total += texture->GetResidentBytes();
+    }
+    return total;
+}
+
+TextureStreamer::StagingBuffer* TextureStreamer::AcquireStagingBuffer(size_t size)
+{
+    StagingBuffer* best = nullptr;
+    for (StagingBuffer& staging : m_staging)
+    {
+        if (staging.fence)
+        {
+            GLenum status = glClientWaitSync(staging.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+            glDeleteSync(staging.fence);
+            staging.fence = nullptr;
+        }
+
+        // Prefer the smallest idle buffer that fits, else the largest idle one
+        bool fits     = staging.capacity >= size;
+        bool bestFits = best && best->capacity >= size;
+        if (!best || (fits && (!bestFits || staging.capacity < best->capacity)) ||
+            (!fits && !bestFits && staging.capacity > best->capacity))
+        {
+            best = &staging;
+        }
+    }
+
+    if ((!best || best->capacity < size) && m_staging.size() < kMaxStagingBuffers)
+    {
+        m_staging.emplace_back();
+        best = &m_staging.back();
+        glGenBuffers(1, &best->buffer);
+    }
+    if (!best)
+        return nullptr;
+
+    if (best->capacity < size)
+    {
+        best->capacity      = std::max(size, kMinStagingBytes);
+        GLStateCache& state = GLStateCache::Get();
+        state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, best->buffer);
+        state.BufferData(GL_PIXEL_UNPACK_BUFFER, best->capacity, nullptr, GL_STREAM_DRAW);
+        state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        MemoryTracker::Get().Record(MemoryResource::Buffer,
+                                    best->buffer,
+                                    MemoryCategory::StagingBuffer,
+                                    "TextureStreamer",
+                                    best->capacity);
+    }
+    return best;
+}
+
+bool TextureStreamer::Upload(Texture& texture, int level)
+{
+    size_t bytes           = texture.m_image.levels[level].bytes;
+    StagingBuffer* staging = AcquireStagingBuffer(bytes);
+    if (!staging)
+        return false;
+
+    GLStateCache& state = GLStateCache::Get();
+    state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->buffer);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                    0,
+                                    bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped)
+    {
+        std::memcpy(mapped, texture.m_image.GetLevelData(level), bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        texture.UploadLevel(level, nullptr);
+        state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    else
+    {
+        // Still correct, only synchronous
+        state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        texture.UploadLevel(level, texture.m_image.GetLevelData(level));
+    }
+
+    ++m_stats.levelsUploaded;
+    m_stats.bytesUploaded += bytes;
+    return true;
+}
+
+void TextureStreamer::Evict(size_t residentBytes)
+{
+    while (residentBytes > m_budgetBytes)
+    {
+        // The largest finest level frees the most for the least visible loss
+        Texture* victim    = nullptr;
+        size_t victimBytes = 0;
+        for (std::shared_ptr<Texture> const& texture : m_textures)
+        {
+            int level = texture->GetResidentLevel();
+            if (level >= texture->GetLevelCount() - 1)
+                continue;
+            size_t bytes = texture->m_image.levels[level].bytes;
+            if (bytes > victimBytes)
+            {
+                victim      = texture.get();
+                victimBytes = bytes;
+            }
+        }
+
+        if (!victim || !victim->DropFinestLevel())
+            break;
+        residentBytes -= victimBytes;
+        ++m_stats.levelsEvicted;
+    }
+}
+
+void TextureStreamer::WaitForStaging()
+{
+    for (StagingBuffer& staging : m_staging)
+    {
+        if (staging.fence)
+        {
+            glClientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(staging.fence);
+            staging.fence = nullptr;
+        }
+    }
+}
+
+void TextureStreamer::ReleaseStagingBuffers()
+{
+    WaitForStaging();
+    for (StagingBuffer& staging : m_staging)
+    {
+        GLStateCache::Get().DeleteBuffer(staging.buffer);
+        MemoryTracker::Get().Release(MemoryResource::Buffer, staging.buffer);
+    }
+    m_staging.clear();
+}
+
+}  // namespace SpatialRender
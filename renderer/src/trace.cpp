@@ -0,0 +1,193 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace SpatialRender
+{
+
+struct Tracer::ThreadBuffer
+{
+    uint32_t threadId;
+    std::string name;
+
+    // Producer owns head, consumer owns tail. The consumer only reads slots
+    // published through head, so the lazily allocated ring is safe to read.
+    std::vector<TraceEvent> ring;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+Tracer& Tracer::Get()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() : m_enabled(false), m_epochNs(Now())
+{}
+
+Tracer::~Tracer()
+{}
+
+uint64_t Tracer::Now()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+Tracer::ThreadBuffer& Tracer::GetThreadBuffer()
+{
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    if (!t_buffer)
+    {
+        // Buffers live as long as the tracer, so exited threads keep their events
+        auto buffer = std::make_unique<ThreadBuffer>();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer->threadId = (uint32_t)m_buffers.size() + 1;
+        t_buffer         = buffer.get();
+        m_buffers.push_back(std::move(buffer));
+    }
+    return *t_buffer;
+}
+
+void Tracer::Record(char const* name, uint64_t beginNs, uint64_t endNs)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    if (buffer.ring.empty())
+    {
+        // Allocated on the first event, so naming a thread costs no ring
+        buffer.ring.resize(kRingCapacity);
+    }
+
+    size_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= kRingCapacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.ring[head % kRingCapacity] = {name, beginNs, endNs};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(std::string const& name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer.name = name;
+}
+
+void Tracer::CollectLocked()
+{
+    for (auto const& buffer : m_buffers)
+    {
+        size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        size_t head = buffer->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+            m_events.push_back({buffer->ring[tail % kRingCapacity], buffer->threadId});
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+}
+
+void Tracer::Collect()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CollectLocked();
+}
+
+static void WriteJsonString(FILE* file, char const* text)
+{
+    std::fputc('"', file);
+    for (char const* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            std::fputc('\\', file);
+        if ((unsigned char)*c >= 0x20)
+            std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+bool Tracer::ExportChromeTrace(std::string const& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CollectLocked();
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events with microsecond timestamps relative to startup
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (auto const& buffer : m_buffers)
+    {
+        std::string name =
+            buffer->name.empty() ? "thread " + std::to_string(buffer->threadId) : buffer->name;
+        std::fprintf(file,
+                     "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                     "\"args\":{\"name\":",
+                     first ? "" : ",\n",
+                     buffer->threadId);
+        WriteJsonString(file, name.c_str());
+        std::fprintf(file, "}}");
+        first = false;
+    }
+    for (CollectedEvent const& e : m_events)
+    {
+        uint64_t begin = e.event.beginNs > m_epochNs ? e.event.beginNs - m_epochNs : 0;
+        std::fprintf(file, "%s{\"ph\":\"X\",\"name\":", first ? "" : ",\n");
+        WriteJsonString(file, e.event.name);
+        std::fprintf(file,
+                     ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     e.threadId,
+                     (double)begin / 1000.0,
+                     (double)(e.event.endNs - e.event.beginNs) / 1000.0);
+        first = false;
+    }
+    std::fprintf(file, "\n]}\n");
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+void Tracer::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CollectLocked();
+    m_events.clear();
+    for (auto const& buffer : m_buffers)
+    {
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t Tracer::GetEventCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events.size();
+}
+
+uint64_t Tracer::GetDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t dropped = 0;
+    for (auto const& buffer : m_buffers)
+    {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+}  // namespace SpatialRender
@@ -2,15 +2,89 @@
 
 in vec3 v_normal;
 in vec2 v_texCoord;
+in vec3 v_worldPos;
+in float v_viewDepth;
+flat in int v_viewIndex;
+flat in int v_material;
 
 uniform vec3 u_color;
+uniform sampler2D u_albedo;
+uniform int u_useAlbedo;
+
+// Material table, one texel per material: color, then texture array layer or -1
+uniform samplerBuffer u_materials;
+uniform sampler2DArray u_materialTextures;
+
+// Clustered point and spot lights, see LightClusterGrid for the layout
+const uint kClusterTilesX = 16u;
+const uint kClusterTilesY = 9u;
+const uint kClusterSlices = 24u;
+
+uniform int u_lightCount;
+uniform samplerBuffer u_lightData;     // 4 texels per light
+uniform usamplerBuffer u_clusterData;  // (offset, count) per cluster
+uniform usamplerBuffer u_lightIndices;
+uniform vec4 u_clusterScale;           // tiles per pixel (xy), log-depth to slice (zw)
+uniform float u_clusterViewWidth;      // pixels per view slot; grids are stored per view
 
 out vec4 FragColor;
 
+vec3 ShadeClusterLights(vec3 normal) {
+    vec2 viewCoord = gl_FragCoord.xy - vec2(float(v_viewIndex) * u_clusterViewWidth, 0.0);
+    uvec2 tile = min(uvec2(viewCoord * u_clusterScale.xy),
+                     uvec2(kClusterTilesX - 1u, kClusterTilesY - 1u));
+    float sliceF = log(max(v_viewDepth, 1e-4)) * u_clusterScale.z - u_clusterScale.w;
+    uint slice = min(uint(max(sliceF, 0.0)), kClusterSlices - 1u);
+    uint cluster = ((uint(v_viewIndex) * kClusterSlices + slice) * kClusterTilesY + tile.y)
+                   * kClusterTilesX + tile.x;
+
+    uvec2 range = texelFetch(u_clusterData, int(cluster)).xy;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int base = int(texelFetch(u_lightIndices, int(range.x + i)).r) * 4;
+        vec4 positionRange = texelFetch(u_lightData, base);
+        vec4 colorType = texelFetch(u_lightData, base + 1);
+
+        vec3 toLight = positionRange.xyz - v_worldPos;
+        float dist2 = dot(toLight, toLight);
+        vec3 L = toLight * inversesqrt(max(dist2, 1e-8));
+
+        // Inverse square falloff windowed to reach zero at the light's range
+        float window = clamp(1.0 - dist2 / (positionRange.w * positionRange.w), 0.0, 1.0);
+        float attenuation = window * window / (dist2 + 1.0);
+
+        if (colorType.w > 0.5) {
+            vec4 spotDir = texelFetch(u_lightData, base + 2);
+            float coneScale = texelFetch(u_lightData, base + 3).x;
+            attenuation *= clamp((dot(-L, spotDir.xyz) - spotDir.w) * coneScale, 0.0, 1.0);
+        }
+
+        result += colorType.rgb * (max(dot(normal, L), 0.0) * attenuation);
+    }
+    return result;
+}
+
 void main() {
     // Simple directional lighting
+    vec3 normal = normalize(v_normal);
     vec3 lightDir = normalize(vec3(1.0, 1.0, 1.0));
-    float diff = max(dot(normalize(v_normal), lightDir), 0.3);
-    
-    FragColor = vec4(u_color * diff, 1.0);
+    float diff = max(dot(normal, lightDir), 0.3);
+
+    vec3 lighting = vec3(diff);
+    if (u_lightCount > 0) {
+        lighting += ShadeClusterLights(normal);
+    }
+
+    vec3 albedo = u_color;
+    if (v_material >= 0) {
+        vec4 material = texelFetch(u_materials, v_material);
+        albedo = material.rgb;
+        if (material.w >= 0.0) {
+            albedo *= texture(u_materialTextures, vec3(v_texCoord, material.w)).rgb;
+        }
+    } else if (u_useAlbedo != 0) {
+        albedo *= texture(u_albedo, v_texCoord).rgb;
+    }
+
+    FragColor = vec4(albedo * lighting, 1.0);
 }
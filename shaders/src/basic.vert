@@ -4,14 +4,71 @@ layout (location = 0) in vec3 a_position;
 layout (location = 1) in vec3 a_normal;
 layout (location = 2) in vec2 a_texCoord;
 
+// Must match Renderer::kMaxViews
+const int kMaxViews = 4;
+
 uniform mat4 u_model;
+uniform mat4 u_view;
 uniform mat4 u_viewProj;
 
+// Instanced multi-view: instance i draws view i into the i-th horizontal
+// slot of the framebuffer. u_viewCount == 0 selects the single-view uniforms.
+uniform int u_viewCount;
+uniform mat4 u_views[kMaxViews];
+uniform mat4 u_viewProjs[kMaxViews];
+
+// Batched material draws: u_instanced != 0 takes the model matrix and material
+// from u_instanceData instead of u_model. Each object is instanced once per
+// view, so object = u_instanceBase + gl_InstanceID / views. See InstanceBuffer.
+uniform int u_instanced;
+uniform int u_instanceBase;
+uniform samplerBuffer u_instanceData;  // 4 texels per instance
+
 out vec3 v_normal;
 out vec2 v_texCoord;
+out vec3 v_worldPos;
+out float v_viewDepth;
+flat out int v_viewIndex;
+flat out int v_material;  // -1 outside batched draws
+
+out float gl_ClipDistance[2];
+
+// Keeps depth bit-identical to the renderer's depth pre-pass
+invariant gl_Position;
 
 void main() {
-    gl_Position = u_viewProj * u_model * vec4(a_position, 1.0);
-    v_normal = mat3(transpose(inverse(u_model))) * a_normal;
+    mat4 model = u_model;
+    v_material = -1;
+    if (u_instanced != 0) {
+        int base = (u_instanceBase + gl_InstanceID / max(u_viewCount, 1)) * 4;
+        model = transpose(mat4(texelFetch(u_instanceData, base),
+                               texelFetch(u_instanceData, base + 1),
+                               texelFetch(u_instanceData, base + 2),
+                               vec4(0.0, 0.0, 0.0, 1.0)));
+        v_material = floatBitsToInt(texelFetch(u_instanceData, base + 3).x);
+    }
+
+    vec4 worldPos = model * vec4(a_position, 1.0);
+    if (u_viewCount > 0) {
+        int view = gl_InstanceID % u_viewCount;
+        vec4 clip = u_viewProjs[view] * model * vec4(a_position, 1.0);
+
+        // Clip against the view's own side planes, then squeeze it into its slot
+        gl_ClipDistance[0] = clip.w + clip.x;
+        gl_ClipDistance[1] = clip.w - clip.x;
+        clip.x = (clip.x + clip.w * float(2 * view + 1 - u_viewCount)) / float(u_viewCount);
+
+        gl_Position = clip;
+        v_viewDepth = -(u_views[view] * worldPos).z;
+        v_viewIndex = view;
+    } else {
+        gl_Position = u_viewProj * model * vec4(a_position, 1.0);
+        gl_ClipDistance[0] = 1.0;
+        gl_ClipDistance[1] = 1.0;
+        v_viewDepth = -(u_view * worldPos).z;
+        v_viewIndex = 0;
+    }
+    v_normal = mat3(transpose(inverse(model))) * a_normal;
     v_texCoord = a_texCoord;
+    v_worldPos = worldPos.xyz;
 }
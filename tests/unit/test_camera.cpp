@@ -37,3 +37,147 @@ TEST(CameraTest, OrthographicProjection)
     glm::mat4 proj = camera.GetProjectionMatrix();
     EXPECT_NE(proj[0][0], 0.0f);
 }
+
+namespace
+{
+
+void ExpectMatrixNear(glm::mat4 const& actual, glm::mat4 const& expected, float tolerance)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            EXPECT_NEAR(actual[column][row], expected[column][row], tolerance)
+                << "[" << column << "][" << row << "]";
+        }
+    }
+}
+
+}  // namespace
+
+TEST(CameraTest, CachedMatricesFollowSetters)
+{
+    Camera camera;
+    camera.SetPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 const* cached = &camera.GetViewProjectionMatrix();
+    EXPECT_EQ(&camera.GetViewProjectionMatrix(), cached);
+
+    camera.SetPosition(glm::vec3(4.0f, 1.0f, -2.0f));
+    camera.SetTarget(glm::vec3(0.0f, 0.5f, 0.0f));
+    glm::mat4 view       = glm::lookAt(glm::vec3(4.0f, 1.0f, -2.0f),
+                                 glm::vec3(0.0f, 0.5f, 0.0f),
+                                 glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    ExpectMatrixNear(camera.GetViewMatrix(), view, 0.0f);
+    ExpectMatrixNear(camera.GetViewProjectionMatrix(), projection * view, 1e-6f);
+
+    camera.SetOrthographic(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 50.0f);
+    glm::mat4 ortho = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 50.0f);
+    ExpectMatrixNear(camera.GetViewProjectionMatrix(), ortho * view, 1e-6f);
+}
+
+TEST(CameraTest, InversesAndFrustumMatchTheMatrices)
+{
+    Camera camera(glm::vec3(3.0f, 2.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    camera.SetPerspective(50.0f, 4.0f / 3.0f, 0.5f, 40.0f);
+
+    ExpectMatrixNear(camera.GetInverseViewMatrix() * camera.GetViewMatrix(),
+                     glm::mat4(1.0f),
+                     1e-5f);
+    ExpectMatrixNear(camera.GetInverseViewProjectionMatrix() * camera.GetViewProjectionMatrix(),
+                     glm::mat4(1.0f),
+                     1e-4f);
+
+    // Corners sit on the clip volume: unprojecting NDC corners lands on them
+    std::array<glm::vec3, 8> const& corners = camera.GetFrustumCorners();
+    glm::vec2 const ndc[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec4 point = camera.GetInverseViewProjectionMatrix() *
+                          glm::vec4(ndc[i % 4], i < 4 ? -1.0f : 1.0f, 1.0f);
+        glm::vec3 world = glm::vec3(point) / point.w;
+        EXPECT_NEAR(glm::length(world - corners[i]), 0.0f, 1e-3f * glm::length(corners[i]));
+
+        for (glm::vec4 const& plane : camera.GetFrustum().planes)
+        {
+            EXPECT_GE(glm::dot(glm::vec3(plane), corners[i]) + plane.w, -1e-3f);
+        }
+    }
+}
+
+TEST(CameraTest, ReversedZHasNoFarPlane)
+{
+    Camera camera(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    camera.SetPerspective(60.0f, 1.0f, 0.25f, 10.0f);
+    camera.SetReversedZ(true);
+    ASSERT_TRUE(camera.IsReversedZ());
+
+    auto depth = [&](float distance) {
+        glm::vec4 clip = camera.GetViewProjectionMatrix() * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+        return clip.z / clip.w;
+    };
+    EXPECT_FLOAT_EQ(depth(0.25f), 1.0f);
+    EXPECT_LT(depth(1e6f), 1e-6f);
+    EXPECT_GT(depth(1e6f), 0.0f);
+
+    // Far away is still visible; closer than near or behind the eye is not
+    Frustum const& frustum = camera.GetFrustum();
+    AABB distant(glm::vec3(-1.0f, -1.0f, -1e6f), glm::vec3(1.0f, 1.0f, -9e5f));
+    AABB tooNear(glm::vec3(-0.1f, -0.1f, -0.2f), glm::vec3(0.1f, 0.1f, -0.1f));
+    AABB behind(glm::vec3(-1.0f, -1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 2.0f));
+    EXPECT_TRUE(frustum.Intersects(distant));
+    EXPECT_FALSE(frustum.Intersects(tooNear));
+    EXPECT_FALSE(frustum.Intersects(behind));
+
+    // Reversed-Z only applies to perspective projections
+    camera.SetOrthographic(-1.0f, 1.0f, -1.0f, 1.0f, 0.1f, 10.0f);
+    EXPECT_FALSE(camera.IsReversedZ());
+}
+
+TEST(CameraTest, CameraSetMatchesIndividualCameras)
+{
+    CameraSet set;
+    set.AddCubemapFaces(glm::vec3(1.0f, 2.0f, 3.0f), 0.1f, 20.0f);
+
+    // Seven cameras leave a partial batch of three
+    Camera reversed(glm::vec3(-4.0f, 1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    reversed.SetReversedZ(true);
+    set.Add(reversed);
+    ASSERT_EQ(set.GetCount(), 7u);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        set.Update();
+        for (size_t i = 0; i < set.GetCount(); ++i)
+        {
+            // A copy taken before any query computes everything on its own
+            Camera const& batched = set.GetCamera(i);
+            Camera scalar(batched.GetPosition(), batched.GetTarget(), batched.GetUp());
+            scalar.SetPerspective(batched.GetFov(),
+                                  batched.GetAspect(),
+                                  batched.GetNear(),
+                                  batched.GetFar());
+            scalar.SetReversedZ(batched.IsReversedZ());
+
+            ExpectMatrixNear(batched.GetViewMatrix(), scalar.GetViewMatrix(), 1e-6f);
+            ExpectMatrixNear(batched.GetViewProjectionMatrix(),
+                             scalar.GetViewProjectionMatrix(),
+                             1e-5f);
+            for (int plane = 0; plane < 6; ++plane)
+            {
+                glm::vec4 a = batched.GetFrustum().planes[plane];
+                glm::vec4 b = scalar.GetFrustum().planes[plane];
+                EXPECT_NEAR(glm::length(a - b), 0.0f, 1e-5f)
+                    << "camera " << i << " plane " << plane;
+            }
+        }
+
+        // Only the moved camera is re-evaluated on the second pass
+        set.GetCamera(2).SetPosition(glm::vec3(0.0f, -3.0f, 0.5f));
+    }
+
+    // +X face looks down +X with -Y up, as cubemap sampling expects
+    glm::mat4 const& view = set.GetCamera(0).GetViewMatrix();
+    EXPECT_NEAR(view[0][2], -1.0f, 1e-6f);
+    EXPECT_NEAR(view[1][1], -1.0f, 1e-6f);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "comparison.h"
+
+using namespace SpatialRender;
+
+// Frame times around meanUs with a few percent of noise, as a summary holds them
+static BenchmarkResult MakeRun(std::string const& scenario, double meanUs, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> noise(meanUs, meanUs * 0.02);
+
+    BenchmarkResult result{};
+    result.scenario = scenario;
+    for (int i = 0; i < 500; ++i)
+    {
+        result.frame_times.push_back(noise(rng));
+        result.render_times.push_back(result.frame_times.back() * 0.5);
+    }
+    result.statistics = AnalyzeFrames(result.frame_times, result.render_times);
+    return result;
+}
+
+TEST(ComparisonTest, ShiftPastThresholdIsRegression)
+{
+    std::vector<BenchmarkResult> baseline = {MakeRun("cubes", 10000.0, 1)};
+    std::vector<BenchmarkResult> current  = {MakeRun("cubes", 11000.0, 2)};
+
+    ComparisonReport report = CompareResults(baseline, current);
+    ASSERT_EQ(report.scenarios.size(), 1u);
+    EXPECT_TRUE(report.scenarios[0].significant);
+    EXPECT_TRUE(report.scenarios[0].regression);
+    EXPECT_EQ(report.regressions, 1u);
+    EXPECT_EQ(ComparisonExitCode(report), 1);
+
+    // The same runs the other way round are an improvement
+    report = CompareResults(current, baseline);
+    EXPECT_TRUE(report.scenarios[0].improvement);
+    EXPECT_EQ(ComparisonExitCode(report), 0);
+}
+
+TEST(ComparisonTest, NoiseIsNotRegression)
+{
+    std::vector<BenchmarkResult> baseline = {MakeRun("cubes", 10000.0, 1)};
+    std::vector<BenchmarkResult> current  = {MakeRun("cubes", 10000.0, 2)};
+
+    ComparisonReport report = CompareResults(baseline, current);
+    ASSERT_EQ(report.scenarios.size(), 1u);
+    EXPECT_FALSE(report.scenarios[0].regression);
+    EXPECT_EQ(ComparisonExitCode(report), 0);
+
+    // A significant shift below the threshold is not a regression either
+    current = {MakeRun("cubes", 10200.0, 2)};
+    report  = CompareResults(baseline, current);
+    EXPECT_TRUE(report.scenarios[0].significant);
+    EXPECT_FALSE(report.scenarios[0].regression);
+    EXPECT_EQ(ComparisonExitCode(report), 0);
+}
+
+TEST(ComparisonTest, SummaryWithoutSamplesGivesNoVerdict)
+{
+    BenchmarkResult baseline{};
+    baseline.scenario          = "cubes";
+    baseline.avg_frame_time_us = 10000.0;
+    BenchmarkResult current    = baseline;
+    current.avg_frame_time_us  = 20000.0;
+
+    ComparisonReport report = CompareResults({baseline}, {current});
+    ASSERT_EQ(report.scenarios.size(), 1u);
+    ScenarioComparison const& scenario = report.scenarios[0];
+    ASSERT_EQ(scenario.metrics.size(), 1u);
+    EXPECT_DOUBLE_EQ(scenario.metrics[0].delta_percent, 100.0);
+    EXPECT_FALSE(scenario.significant);
+    EXPECT_FALSE(scenario.regression);
+    EXPECT_EQ(ComparisonExitCode(report), 0);
+}
+
+TEST(ComparisonTest, MissingScenarioFailsComparison)
+{
+    std::vector<BenchmarkResult> baseline = {MakeRun("cubes", 10000.0, 1),
+                                             MakeRun("spheres", 10000.0, 3)};
+    std::vector<BenchmarkResult> current  = {MakeRun("cubes", 10000.0, 2)};
+
+    ComparisonReport report = CompareResults(baseline, current);
+    EXPECT_EQ(report.regressions, 0u);
+    ASSERT_EQ(report.missing.size(), 1u);
+    EXPECT_EQ(report.missing[0], "spheres");
+    EXPECT_EQ(ComparisonExitCode(report), 1);
+}
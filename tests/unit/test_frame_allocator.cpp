@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "frame_allocator.h"
+#include "memory_tracker.h"
+#include "parallel.h"
+
+using namespace SpatialRender;
+
+TEST(FrameAllocatorTest, AllocationsAreAlignedAndDistinct)
+{
+    LinearArena arena(1024);
+    auto* a = static_cast<uint8_t*>(arena.Allocate(3, 1));
+    auto* b = static_cast<uint8_t*>(arena.Allocate(16, 64));
+    auto* c = arena.AllocateArray<double>(4);
+
+    EXPECT_EQ((uintptr_t)b % 64, 0u);
+    EXPECT_EQ((uintptr_t)c % alignof(double), 0u);
+    EXPECT_GE(b, a + 3);
+    EXPECT_GE((uint8_t*)c, b + 16);
+    EXPECT_GE(arena.GetUsedBytes(), 3u + 16u + 4u * sizeof(double));
+    EXPECT_EQ(arena.GetSystemAllocations(), 1u);
+}
+
+TEST(FrameAllocatorTest, OverflowIsMergedIntoOneBlockOnReset)
+{
+    LinearArena arena(256);
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        arena.Reset();
+        for (int i = 0; i < 64; ++i)
+        {
+            arena.Allocate(100);
+        }
+    }
+
+    // The first frame grew a chain of blocks; the merged block then holds a
+    // whole frame, so later frames reuse it
+    uint64_t warm = arena.GetSystemAllocations();
+    arena.Reset();
+    for (int i = 0; i < 64; ++i)
+    {
+        arena.Allocate(100);
+    }
+    EXPECT_EQ(arena.GetSystemAllocations(), warm);
+    EXPECT_GE(arena.GetCapacity(), arena.GetUsedBytes());
+
+    arena.Reset();
+    EXPECT_EQ(arena.GetUsedBytes(), 0u);
+}
+
+TEST(FrameAllocatorTest, FrameVectorUsesTheArena)
+{
+    LinearArena arena(4096);
+    FrameVector<int> values{ArenaAllocator<int>(arena)};
+    values.reserve(100);
+    for (int i = 0; i < 100; ++i)
+    {
+        values.push_back(i * i);
+    }
+
+    EXPECT_EQ(values[99], 99 * 99);
+    EXPECT_GE(arena.GetUsedBytes(), 100u * sizeof(int));
+    EXPECT_EQ(arena.GetSystemAllocations(), 1u);
+}
+
+TEST(FrameAllocatorTest, WorkerThreadsUseTheirOwnArenas)
+{
+    FrameAllocator frame(ThreadPool::Global().GetThreadCount(), 1024);
+    std::atomic<int> written{0};
+
+    ParallelFor(4096, 64, [&](size_t begin, size_t end, unsigned thread) {
+        LinearArena& arena = frame.GetThreadArena();
+        EXPECT_EQ(&arena, &frame.GetArena(thread));
+
+        uint32_t* scratch = arena.AllocateArray<uint32_t>(end - begin);
+        for (size_t i = begin; i < end; ++i)
+        {
+            scratch[i - begin] = (uint32_t)i;
+        }
+        written += (int)(end - begin);
+    });
+
+    EXPECT_EQ(written.load(), 4096);
+    EXPECT_GE(frame.GetHighWater(), 4096u * sizeof(uint32_t));
+
+    size_t highWater = frame.GetHighWater();
+    frame.Reset();
+    EXPECT_EQ(frame.GetHighWater(), 0u);
+    EXPECT_EQ(frame.GetPeakHighWater(), highWater);
+    EXPECT_GE(MemoryTracker::Get().GetUsage(MemoryCategory::FrameArena).liveBytes,
+              frame.GetCapacity());
+}
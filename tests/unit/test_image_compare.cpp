@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "image_compare.h"
+
+using namespace SpatialRender;
+
+static std::vector<uint8_t> MakeGradient(int width, int height)
+{
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t* p = &pixels[((size_t)y * width + x) * 4];
+            p[0]       = (uint8_t)(x * 255 / std::max(width - 1, 1));
+            p[1]       = (uint8_t)(y * 255 / std::max(height - 1, 1));
+            p[2]       = (uint8_t)((x + y) & 0xFF);
+            p[3]       = 255;
+        }
+    }
+    return pixels;
+}
+
+TEST(ImageCompareTest, IdenticalImagesMatchExactly)
+{
+    std::vector<uint8_t> image = MakeGradient(37, 23);
+    ImageCompareResult result =
+        CompareImages({image.data(), 37, 23}, {image.data(), 37, 23});
+
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.mismatched, 0u);
+    EXPECT_EQ(result.maxChannelDelta, 0);
+    EXPECT_TRUE(std::isinf(result.psnr));
+    EXPECT_DOUBLE_EQ(result.ssim, 1.0);
+}
+
+TEST(ImageCompareTest, CountsPixelsBeyondTheTolerance)
+{
+    std::vector<uint8_t> expected = MakeGradient(64, 32);
+    std::vector<uint8_t> actual   = expected;
+
+    // Within tolerance, beyond it in one channel, and only in alpha
+    actual[0 * 4 + 1] = (uint8_t)(actual[0 * 4 + 1] + 2);
+    actual[5 * 4 + 2] = (uint8_t)(actual[5 * 4 + 2] ^ 0x40);
+    actual[9 * 4 + 3] = 0;
+    // The last pixel exercises the scalar tail when the count is not a multiple of 4
+    actual[(64 * 32 - 1) * 4] = (uint8_t)(actual[(64 * 32 - 1) * 4] ^ 0x80);
+
+    ImageCompareOptions options;
+    options.channelTolerance = 2;
+    ImageCompareResult result =
+        CompareImages({actual.data(), 64, 32}, {expected.data(), 64, 32}, options);
+    EXPECT_EQ(result.mismatched, 2u);
+    EXPECT_EQ(result.maxChannelDelta, 0x80);
+    EXPECT_NEAR(result.mse, (4.0 + 64.0 * 64.0 + 128.0 * 128.0) / (64 * 32 * 3), 1e-9);
+
+    options.compareAlpha = true;
+    result = CompareImages({actual.data(), 64, 32}, {expected.data(), 64, 32}, options);
+    EXPECT_EQ(result.mismatched, 3u);
+    EXPECT_EQ(result.maxChannelDelta, 255);
+}
+
+TEST(ImageCompareTest, MatchesScalarReferenceOnNoise)
+{
+    // Odd sizes so both the SIMD body and the scalar tail see work
+    int const width = 101, height = 53;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> value(0, 255);
+    std::uniform_int_distribution<int> noise(-6, 6);
+
+    std::vector<uint8_t> expected((size_t)width * height * 4);
+    std::vector<uint8_t> actual(expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        expected[i] = (uint8_t)value(rng);
+        actual[i]   = (uint8_t)std::clamp(expected[i] + noise(rng), 0, 255);
+    }
+
+    uint64_t mismatched = 0;
+    double squared      = 0.0;
+    for (size_t p = 0; p < (size_t)width * height; ++p)
+    {
+        bool mismatch = false;
+        for (int c = 0; c < 3; ++c)
+        {
+            int delta = std::abs(actual[p * 4 + c] - expected[p * 4 + c]);
+            mismatch |= delta > 3;
+            squared += delta * delta;
+        }
+        mismatched += mismatch ? 1 : 0;
+    }
+
+    ImageCompareOptions options;
+    options.channelTolerance = 3;
+    ImageCompareResult result =
+        CompareImages({actual.data(), width, height}, {expected.data(), width, height}, options);
+    EXPECT_EQ(result.mismatched, mismatched);
+    EXPECT_NEAR(result.mse, squared / (width * height * 3), 1e-9);
+    EXPECT_NEAR(result.psnr, 10.0 * std::log10(255.0 * 255.0 / result.mse), 1e-9);
+    EXPECT_GT(result.ssim, 0.9);
+    EXPECT_LT(result.ssim, 1.0);
+}
+
+TEST(ImageCompareTest, StructuralChangesLowerSsim)
+{
+    std::vector<uint8_t> expected = MakeGradient(64, 64);
+
+    // Same mean brightness, but the horizontal gradient is mirrored
+    std::vector<uint8_t> mirrored = expected;
+    for (int y = 0; y < 64; ++y)
+    {
+        for (int x = 0; x < 64; ++x)
+        {
+            mirrored[(y * 64 + x) * 4] = expected[(y * 64 + 63 - x) * 4];
+        }
+    }
+
+    ImageCompareResult result =
+        CompareImages({mirrored.data(), 64, 64}, {expected.data(), 64, 64});
+    EXPECT_FALSE(result.passed);
+    EXPECT_LT(result.ssim, 0.98);
+}
+
+TEST(ImageCompareTest, SizeMismatchFails)
+{
+    std::vector<uint8_t> a = MakeGradient(16, 16);
+    std::vector<uint8_t> b = MakeGradient(16, 8);
+
+    ImageCompareResult result = CompareImages({a.data(), 16, 16}, {b.data(), 16, 8});
+    EXPECT_FALSE(result.sizeMatches);
+    EXPECT_FALSE(result.passed);
+}
+
+TEST(ImageCompareTest, DiffImageMarksMismatchedPixels)
+{
+    std::vector<uint8_t> expected = MakeGradient(8, 8);
+    std::vector<uint8_t> actual   = expected;
+    actual[(3 * 8 + 4) * 4 + 1] ^= 0xFF;
+
+    std::vector<uint8_t> diff;
+    BuildDiffImage({actual.data(), 8, 8}, {expected.data(), 8, 8}, 2, diff);
+    ASSERT_EQ(diff.size(), expected.size());
+
+    uint8_t const* marked = &diff[(3 * 8 + 4) * 4];
+    EXPECT_GE(marked[0], 128);
+    EXPECT_EQ(marked[1], 0);
+    EXPECT_EQ(marked[2], 0);
+
+    uint8_t const* unchanged = &diff[0];
+    EXPECT_EQ(unchanged[0], unchanged[1]);
+    EXPECT_EQ(unchanged[1], unchanged[2]);
+}
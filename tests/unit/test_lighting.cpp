@@ -0,0 +1,167 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "camera.h"
+#include "clustered_lighting.h"
+#include "scene.h"
+
+using namespace SpatialRender;
+
+namespace
+{
+
+Camera TestCamera()
+{
+    Camera camera;
+    camera.SetPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 10.0f));
+    camera.SetTarget(glm::vec3(0.0f, 0.0f, 0.0f));
+    return camera;
+}
+
+void BuildGrid(LightClusterGrid& grid, Scene const& scene, Camera& camera)
+{
+    grid.Build(scene.GetLights(),
+               camera.GetViewMatrix(),
+               camera.GetProjectionMatrix(),
+               camera.GetNear(),
+               camera.GetFar());
+}
+
+bool ClusterHasLight(LightClusterGrid const& grid, uint32_t cluster, uint32_t light)
+{
+    uint32_t const* lights = grid.GetClusterLights(cluster);
+    uint32_t count         = grid.GetClusterLightCount(cluster);
+    return std::find(lights, lights + count, light) != lights + count;
+}
+
+}  // namespace
+
+TEST(LightingTest, SceneStoresLights)
+{
+    Scene scene;
+    scene.AddPointLight(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(1.0f, 0.5f, 0.0f), 2.0f, 5.0f);
+    scene.AddSpotLight(glm::vec3(0.0f, 4.0f, 0.0f),
+                       glm::vec3(0.0f, -2.0f, 0.0f),
+                       glm::vec3(1.0f),
+                       1.0f,
+                       8.0f,
+                       15.0f,
+                       25.0f);
+
+    ASSERT_EQ(scene.GetLightCount(), 2u);
+    EXPECT_EQ(scene.GetLights()[0].type, LightType::Point);
+    EXPECT_EQ(scene.GetLights()[1].type, LightType::Spot);
+    EXPECT_FLOAT_EQ(scene.GetLights()[1].direction.y, -1.0f);
+
+    scene.Clear();
+    EXPECT_EQ(scene.GetLightCount(), 0u);
+}
+
+TEST(LightingTest, LightIsBinnedOnlyNearItsPosition)
+{
+    Scene scene;
+    scene.AddPointLight(glm::vec3(0.0f), glm::vec3(1.0f), 1.0f, 1.0f);
+
+    Camera camera = TestCamera();
+    LightClusterGrid grid;
+    BuildGrid(grid, scene, camera);
+
+    // The light sits at the centre of the screen, 10 units in front of the camera
+    uint32_t slice  = grid.GetSlice(10.0f);
+    uint32_t centre = LightClusterGrid::GetClusterIndex(LightClusterGrid::kTilesX / 2,
+                                                        LightClusterGrid::kTilesY / 2,
+                                                        slice);
+    EXPECT_TRUE(ClusterHasLight(grid, centre, 0));
+
+    uint32_t corner = LightClusterGrid::GetClusterIndex(0, 0, slice);
+    EXPECT_EQ(grid.GetClusterLightCount(corner), 0u);
+
+    uint32_t nearSlice = LightClusterGrid::GetClusterIndex(LightClusterGrid::kTilesX / 2,
+                                                           LightClusterGrid::kTilesY / 2,
+                                                           grid.GetSlice(1.0f));
+    EXPECT_EQ(grid.GetClusterLightCount(nearSlice), 0u);
+
+    EXPECT_EQ(grid.GetStats().visibleLights, 1u);
+    EXPECT_GT(grid.GetStats().occupiedClusters, 0u);
+}
+
+TEST(LightingTest, LightsOutsideTheFrustumAreSkipped)
+{
+    Scene scene;
+    scene.AddPointLight(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(1.0f), 1.0f, 2.0f);
+    scene.AddPointLight(glm::vec3(100.0f, 0.0f, 0.0f), glm::vec3(1.0f), 1.0f, 2.0f);
+
+    Camera camera = TestCamera();
+    LightClusterGrid grid;
+    BuildGrid(grid, scene, camera);
+
+    EXPECT_EQ(grid.GetStats().visibleLights, 0u);
+    EXPECT_EQ(grid.GetStats().lightIndices, 0u);
+    EXPECT_EQ(grid.GetStats().occupiedClusters, 0u);
+}
+
+TEST(LightingTest, ClusterListsAreContiguous)
+{
+    Scene scene;
+    for (int i = 0; i < 50; ++i)
+    {
+        float x = (float)(i % 10) - 4.5f;
+        float y = (float)(i / 10) - 2.0f;
+        scene.AddPointLight(glm::vec3(x, y, (float)(i % 7) - 3.0f), glm::vec3(1.0f), 1.0f, 1.5f);
+    }
+
+    Camera camera = TestCamera();
+    LightClusterGrid grid;
+    BuildGrid(grid, scene, camera);
+
+    std::vector<uint32_t> const& clusters = grid.GetClusterData();
+    uint32_t expectedOffset               = 0;
+    size_t total                          = 0;
+    for (uint32_t c = 0; c < LightClusterGrid::kClusterCount; ++c)
+    {
+        EXPECT_EQ(clusters[c * 2], expectedOffset);
+        expectedOffset += clusters[c * 2 + 1];
+        total += clusters[c * 2 + 1];
+
+        uint32_t const* lights = grid.GetClusterLights(c);
+        for (uint32_t i = 1; i < clusters[c * 2 + 1]; ++i)
+        {
+            EXPECT_LT(lights[i - 1], lights[i]);
+        }
+    }
+    EXPECT_EQ(total, grid.GetStats().lightIndices);
+    EXPECT_EQ(grid.GetLightData().size(), 50u * LightClusterGrid::kTexelsPerLight);
+}
+
+TEST(LightingTest, OverfullClustersCountDroppedLights)
+{
+    // Identical lights all land in the same clusters
+    uint32_t const extra = 5;
+    Scene scene;
+    for (uint32_t i = 0; i < LightClusterGrid::kMaxLightsPerCluster + extra; ++i)
+    {
+        scene.AddPointLight(glm::vec3(0.0f), glm::vec3(1.0f), 1.0f, 0.05f);
+    }
+
+    Camera camera = TestCamera();
+    LightClusterGrid grid;
+    BuildGrid(grid, scene, camera);
+
+    // The lights may straddle a tile or slice boundary; each cluster they touch is full
+    size_t occupied = grid.GetStats().occupiedClusters;
+    ASSERT_GT(occupied, 0u);
+    for (uint32_t c = 0; c < LightClusterGrid::kClusterCount; ++c)
+    {
+        uint32_t count = grid.GetClusterLightCount(c);
+        EXPECT_TRUE(count == 0 || count == LightClusterGrid::kMaxLightsPerCluster);
+    }
+    EXPECT_EQ(grid.GetStats().droppedLights, extra * occupied);
+    EXPECT_EQ(grid.GetStats().lightIndices, LightClusterGrid::kMaxLightsPerCluster * occupied);
+
+    scene.Clear();
+    scene.AddPointLight(glm::vec3(0.0f), glm::vec3(1.0f), 1.0f, 0.05f);
+    BuildGrid(grid, scene, camera);
+    EXPECT_EQ(grid.GetStats().droppedLights, 0u);
+}
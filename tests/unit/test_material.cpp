@@ -0,0 +1,65 @@
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "material.h"
+
+using namespace SpatialRender;
+
+TEST(MaterialTest, LibraryHandsOutSequentialIds)
+{
+    MaterialLibrary library;
+    int32_t texture = MaterialLibrary::MakeTextureHandle(2, 5);
+    MaterialId red  = library.AddMaterial({glm::vec3(1.0f, 0.0f, 0.0f), -1});
+    MaterialId tile = library.AddMaterial({glm::vec3(1.0f), texture});
+    EXPECT_EQ(red, 0u);
+    EXPECT_EQ(tile, 1u);
+    EXPECT_EQ(library.GetMaterialCount(), 2u);
+
+    EXPECT_EQ(library.GetTextureArrayIndex(red), -1);
+    EXPECT_EQ(library.GetTextureArrayIndex(tile), 2);
+
+    library.SetMaterial(red, {glm::vec3(0.5f), -1});
+    EXPECT_EQ(library.GetMaterial(red).color, glm::vec3(0.5f));
+}
+
+TEST(MaterialTest, TableTexelHoldsColorAndLayer)
+{
+    int32_t texture = MaterialLibrary::MakeTextureHandle(3, 17);
+    EXPECT_EQ(MaterialLibrary::GetArrayIndex(texture), 3);
+    EXPECT_EQ(MaterialLibrary::GetLayer(texture), 17);
+
+    glm::vec4 texel = MaterialLibrary::PackMaterial({glm::vec3(0.25f, 0.5f, 0.75f), texture});
+    EXPECT_EQ(texel, glm::vec4(0.25f, 0.5f, 0.75f, 17.0f));
+
+    // Untextured materials tell the shader not to sample
+    texel = MaterialLibrary::PackMaterial({glm::vec3(1.0f), -1});
+    EXPECT_EQ(texel.w, -1.0f);
+}
+
+TEST(MaterialTest, InstanceTexelsHoldModelRowsAndMaterialBits)
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    model           = glm::scale(model, glm::vec3(2.0f, 4.0f, 8.0f));
+
+    glm::vec4 texels[InstanceBuffer::kTexelsPerInstance];
+    InstanceBuffer::PackInstance(model, 123456789u, texels);
+
+    EXPECT_EQ(texels[0], glm::vec4(2.0f, 0.0f, 0.0f, 1.0f));
+    EXPECT_EQ(texels[1], glm::vec4(0.0f, 4.0f, 0.0f, 2.0f));
+    EXPECT_EQ(texels[2], glm::vec4(0.0f, 0.0f, 8.0f, 3.0f));
+
+    // The shader reads the ID back with floatBitsToInt
+    uint32_t material;
+    std::memcpy(&material, &texels[3].x, sizeof(material));
+    EXPECT_EQ(material, 123456789u);
+
+    // Rows times a position give the same point as the matrix
+    glm::vec4 position(0.5f, -1.0f, 2.0f, 1.0f);
+    glm::vec4 expected = model * position;
+    for (int row = 0; row < 3; ++row)
+    {
+        EXPECT_FLOAT_EQ(glm::dot(texels[row], position), expected[row]);
+    }
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+
+#include "memory_tracker.h"
+#include "mesh.h"
+
+using namespace SpatialRender;
+
+class MemoryTrackerTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override { MemoryTracker::Get().Clear(); }
+    void TearDown() override { MemoryTracker::Get().Clear(); }
+};
+
+TEST_F(MemoryTrackerTest, TracksLiveTotalsAndPeaks)
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Record(MemoryResource::Buffer, 1, MemoryCategory::VertexBuffer, "A", 1000);
+    memory.Record(MemoryResource::Buffer, 2, MemoryCategory::IndexBuffer, "A", 500);
+    memory.Record(MemoryResource::Host, 1, MemoryCategory::MeshData, "A", 200);
+
+    EXPECT_EQ(memory.GetGpuUsage().liveBytes, 1500u);
+    EXPECT_EQ(memory.GetGpuUsage().allocations, 2u);
+    EXPECT_EQ(memory.GetCpuUsage().liveBytes, 200u);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::IndexBuffer).liveBytes, 500u);
+
+    memory.Release(MemoryResource::Buffer, 1);
+    EXPECT_EQ(memory.GetGpuUsage().liveBytes, 500u);
+    EXPECT_EQ(memory.GetGpuUsage().peakBytes, 1500u);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::VertexBuffer).peakBytes, 1000u);
+
+    memory.ResetPeaks();
+    EXPECT_EQ(memory.GetGpuUsage().peakBytes, 500u);
+
+    // Unknown ids are ignored
+    memory.Release(MemoryResource::Buffer, 42);
+    EXPECT_EQ(memory.GetGpuUsage().liveBytes, 500u);
+}
+
+TEST_F(MemoryTrackerTest, RecordingAnExistingResourceReplacesIt)
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Record(MemoryResource::Buffer, 7, MemoryCategory::TextureBuffer, "Lights", 64);
+    memory.Record(MemoryResource::Buffer, 7, MemoryCategory::TextureBuffer, "Lights", 4096);
+
+    MemoryUsage usage = memory.GetUsage(MemoryCategory::TextureBuffer);
+    EXPECT_EQ(usage.liveBytes, 4096u);
+    EXPECT_EQ(usage.allocations, 1u);
+
+    // Ids are per resource kind, so the same name in another namespace is separate
+    memory.Record(MemoryResource::Texture, 7, MemoryCategory::Texture, "Albedo", 256);
+    EXPECT_EQ(memory.GetGpuUsage().liveBytes, 4096u + 256u);
+}
+
+TEST_F(MemoryTrackerTest, AllocationsAreListedLargestFirst)
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    memory.Record(MemoryResource::Buffer, 1, MemoryCategory::VertexBuffer, "Small", 10);
+    memory.Record(MemoryResource::Renderbuffer, 1, MemoryCategory::Renderbuffer, "Big", 1000);
+    memory.Record(MemoryResource::Program, 3, MemoryCategory::ShaderProgram, "Mid", 100);
+
+    std::vector<MemoryAllocation> allocations = memory.GetAllocations();
+    ASSERT_EQ(allocations.size(), 3u);
+    EXPECT_EQ(allocations[0].owner, "Big");
+    EXPECT_EQ(allocations[1].owner, "Mid");
+    EXPECT_EQ(allocations[2].owner, "Small");
+
+    std::ostringstream dump;
+    memory.Dump(dump);
+    EXPECT_NE(dump.str().find("renderbuffer"), std::string::npos);
+    EXPECT_NE(dump.str().find("Big"), std::string::npos);
+}
+
+TEST_F(MemoryTrackerTest, MeshDataIsTrackedUntilDestruction)
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    {
+        std::unique_ptr<Mesh> mesh(CreateCubeMesh());
+        size_t expected = mesh->GetVertexCount() * sizeof(Vertex) +
+                          mesh->GetIndexCount() * sizeof(unsigned int);
+        EXPECT_EQ(memory.GetUsage(MemoryCategory::MeshData).liveBytes, expected);
+    }
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::MeshData).liveBytes, 0u);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::MeshData).allocations, 0u);
+}
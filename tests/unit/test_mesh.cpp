@@ -24,18 +24,15 @@ TEST(MeshTest, MeshVertices)
 
 TEST(MeshTest, FactoryFunctions)
 {
-    Mesh* cube = CreateCubeMesh();
+    std::unique_ptr<Mesh> cube = CreateCubeMesh();
     EXPECT_NE(cube, nullptr);
     EXPECT_GT(cube->GetVertexCount(), 0);
-    delete cube;
 
-    Mesh* sphere = CreateSphereMesh(16);
+    std::unique_ptr<Mesh> sphere = CreateSphereMesh(16);
     EXPECT_NE(sphere, nullptr);
     EXPECT_GT(sphere->GetVertexCount(), 0);
-    delete sphere;
 
-    Mesh* plane = CreatePlaneMesh();
+    std::unique_ptr<Mesh> plane = CreatePlaneMesh();
     EXPECT_NE(plane, nullptr);
     EXPECT_GT(plane->GetVertexCount(), 0);
-    delete plane;
 }
@@ -0,0 +1,101 @@
+#include <memory>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+
+#include "camera.h"
+#include "culling.h"
+#include "mesh.h"
+#include "occlusion.h"
+#include "scene.h"
+
+using namespace SpatialRender;
+
+namespace
+{
+
+glm::mat4 BoxTransform(glm::vec3 const& position, glm::vec3 const& size)
+{
+    return glm::scale(glm::translate(glm::mat4(1.0f), position), size);
+}
+
+glm::mat4 TestViewProj()
+{
+    Camera camera;
+    camera.SetPerspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 10.0f));
+    camera.SetTarget(glm::vec3(0.0f, 0.0f, 0.0f));
+    return camera.GetViewProjectionMatrix();
+}
+
+}  // namespace
+
+TEST(CullingTest, TransformedBounds)
+{
+    AABB box(glm::vec3(-1.0f), glm::vec3(1.0f));
+    AABB moved = box.Transformed(BoxTransform(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(2.0f)));
+    EXPECT_FLOAT_EQ(moved.min.x, 3.0f);
+    EXPECT_FLOAT_EQ(moved.max.x, 7.0f);
+    EXPECT_FLOAT_EQ(moved.max.y, 2.0f);
+}
+
+TEST(CullingTest, FrustumRejectsBoxBehindCamera)
+{
+    Frustum frustum = Frustum::FromMatrix(TestViewProj());
+    EXPECT_TRUE(frustum.Intersects(AABB(glm::vec3(-1.0f), glm::vec3(1.0f))));
+    EXPECT_FALSE(
+        frustum.Intersects(AABB(glm::vec3(-1.0f, -1.0f, 20.0f), glm::vec3(1.0f, 1.0f, 22.0f))));
+    EXPECT_FALSE(
+        frustum.Intersects(AABB(glm::vec3(50.0f, -1.0f, -1.0f), glm::vec3(52.0f, 1.0f, 1.0f))));
+}
+
+TEST(OcclusionTest, WallHidesObjectsBehindIt)
+{
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+
+    Scene scene;
+    // Wall facing the camera, then boxes behind, in front of and beside it
+    scene.AddObject(cube, nullptr, BoxTransform(glm::vec3(0.0f), glm::vec3(8.0f, 8.0f, 0.2f)));
+    scene.SetOccluder(0, true);
+    scene.AddObject(cube, nullptr, BoxTransform(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(1.0f)));
+    scene.AddObject(cube, nullptr, BoxTransform(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(1.0f)));
+    scene.AddObject(cube, nullptr, BoxTransform(glm::vec3(9.0f, 0.0f, -5.0f), glm::vec3(1.0f)));
+    scene.AddObject(cube, nullptr, BoxTransform(glm::vec3(0.0f, 0.0f, 30.0f), glm::vec3(1.0f)));
+
+    OcclusionCuller culler;
+    culler.Cull(scene.GetObjects(), TestViewProj());
+
+    EXPECT_TRUE(culler.IsVisible(0));   // the occluder itself
+    EXPECT_FALSE(culler.IsVisible(1));  // hidden behind the wall
+    EXPECT_TRUE(culler.IsVisible(2));   // in front of the wall
+    EXPECT_TRUE(culler.IsVisible(3));   // beside the wall
+    EXPECT_FALSE(culler.IsVisible(4));  // behind the camera
+
+    OcclusionStats const& stats = culler.GetStats();
+    EXPECT_EQ(stats.occluders, 1u);
+    EXPECT_EQ(stats.occluderTriangles, 12u);
+    EXPECT_EQ(stats.objectsTested, 5u);
+    EXPECT_EQ(stats.occlusionCulled, 1u);
+    EXPECT_EQ(stats.frustumCulled, 1u);
+}
+
+TEST(OcclusionTest, NoOccludersKeepsEverythingInView)
+{
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+
+    Scene scene;
+    for (int i = 0; i < 10; ++i)
+    {
+        glm::mat4 transform = BoxTransform(glm::vec3(0.0f, 0.0f, -i * 2.0f), glm::vec3(1.0f));
+        scene.AddObject(cube, nullptr, transform);
+    }
+
+    OcclusionCuller culler;
+    culler.Cull(scene.GetObjects(), TestViewProj());
+
+    for (size_t i = 0; i < scene.GetObjectCount(); ++i)
+    {
+        EXPECT_TRUE(culler.IsVisible(i));
+    }
+    EXPECT_FLOAT_EQ(culler.GetDepth(culler.GetWidth() / 2, culler.GetHeight() / 2), 1.0f);
+}
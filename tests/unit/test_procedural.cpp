@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "mesh.h"
+#include "procedural.h"
+
+using namespace SpatialRender;
+
+namespace
+{
+
+// Every triangle faces the same way as the normals of its corners, skipping
+// the slivers that collapse at poles
+void ExpectOutwardWinding(MeshData const& data, char const* name)
+{
+    size_t inward = 0;
+    for (size_t t = 0; t + 2 < data.indices.size(); t += 3)
+    {
+        Vertex const& a = data.vertices[data.indices[t]];
+        Vertex const& b = data.vertices[data.indices[t + 1]];
+        Vertex const& c = data.vertices[data.indices[t + 2]];
+
+        glm::vec3 face = glm::cross(b.position - a.position, c.position - a.position);
+        if (glm::length(face) < 1e-9f)
+            continue;
+        if (glm::dot(face, a.normal + b.normal + c.normal) <= 0.0f)
+            ++inward;
+    }
+    EXPECT_EQ(inward, 0u) << name;
+}
+
+void ExpectValidIndices(MeshData const& data, char const* name)
+{
+    ASSERT_EQ(data.indices.size() % 3, 0u) << name;
+    for (unsigned int index : data.indices)
+    {
+        ASSERT_LT(index, data.vertices.size()) << name;
+    }
+}
+
+}  // namespace
+
+TEST(ProceduralTest, SphereFactoryMatchesOriginalLoop)
+{
+    // 17 segments leaves a scalar tail after the four-wide kernel
+    int const segments = 17;
+    std::unique_ptr<Mesh> mesh = CreateSphereMesh(segments);
+
+    std::vector<Vertex> expected;
+    for (int y = 0; y <= segments; ++y)
+    {
+        for (int x = 0; x <= segments; ++x)
+        {
+            float xSegment = (float)x / (float)segments;
+            float ySegment = (float)y / (float)segments;
+            float xPos = std::cos(xSegment * 2.0f * std::numbers::pi) *
+                         std::sin(ySegment * std::numbers::pi);
+            float yPos = std::cos(ySegment * std::numbers::pi);
+            float zPos = std::sin(xSegment * 2.0f * std::numbers::pi) *
+                         std::sin(ySegment * std::numbers::pi);
+
+            Vertex v;
+            v.position = glm::vec3(xPos, yPos, zPos) * 0.5f;
+            v.normal   = glm::normalize(glm::vec3(xPos, yPos, zPos));
+            v.texCoord = glm::vec2(xSegment, ySegment);
+            expected.push_back(v);
+        }
+    }
+
+    ASSERT_EQ(mesh->GetVertexCount(), expected.size());
+    EXPECT_EQ(std::memcmp(mesh->GetVertices().data(),
+                          expected.data(),
+                          expected.size() * sizeof(Vertex)),
+              0);
+
+    std::vector<unsigned int> const& indices = mesh->GetIndices();
+    ASSERT_EQ(indices.size(), (size_t)segments * segments * 6);
+    EXPECT_EQ(indices[0], 0u);
+    EXPECT_EQ(indices[1], (unsigned int)segments + 1);
+    EXPECT_EQ(indices[2], 1u);
+}
+
+TEST(ProceduralTest, SurfacesWindOutward)
+{
+    MeshData data;
+
+    GenerateSphere(data, 1.0f, 23, 11);
+    ExpectValidIndices(data, "sphere");
+    ExpectOutwardWinding(data, "sphere");
+
+    GenerateCapsule(data, 0.5f, 1.0f, 16, 5);
+    ExpectValidIndices(data, "capsule");
+    ExpectOutwardWinding(data, "capsule");
+
+    GenerateCylinder(data, 0.5f, 2.0f, 16, 3);
+    ExpectValidIndices(data, "cylinder");
+    ExpectOutwardWinding(data, "cylinder");
+
+    GenerateTorus(data, 1.0f, 0.25f, 24, 12);
+    ExpectValidIndices(data, "torus");
+    ExpectOutwardWinding(data, "torus");
+
+    GenerateGrid(data, 2.0f, 3.0f, 5, 7);
+    ExpectValidIndices(data, "grid");
+    ExpectOutwardWinding(data, "grid");
+
+    GenerateIcosphere(data, 1.0f, 2);
+    ExpectValidIndices(data, "icosphere");
+    ExpectOutwardWinding(data, "icosphere");
+}
+
+TEST(ProceduralTest, SurfacesHaveTheRequestedShape)
+{
+    MeshData data;
+
+    GenerateIcosphere(data, 2.0f, 3);
+    EXPECT_EQ(data.vertices.size(), 20u * 9u * 10u / 2u);
+    EXPECT_EQ(data.indices.size(), 20u * 64u * 3u);
+    for (Vertex const& v : data.vertices)
+    {
+        ASSERT_NEAR(glm::length(v.position), 2.0f, 1e-5f);
+        ASSERT_NEAR(glm::length(v.normal), 1.0f, 1e-5f);
+    }
+
+    // Every torus vertex sits on the tube around the ring
+    GenerateTorus(data, 1.0f, 0.25f, 32, 16);
+    for (Vertex const& v : data.vertices)
+    {
+        glm::vec2 radial(v.position.x, v.position.z);
+        glm::vec2 ring = glm::length(radial) > 0.0f ? glm::normalize(radial) : glm::vec2(1, 0);
+        glm::vec3 onRing(ring.x, 0.0f, ring.y);
+        ASSERT_NEAR(glm::length(v.position - onRing), 0.25f, 1e-5f);
+    }
+
+    // Capsule: a cylinder of the given height between two hemispheres
+    GenerateCapsule(data, 0.5f, 1.0f, 16, 4);
+    float minY = 0.0f, maxY = 0.0f;
+    for (Vertex const& v : data.vertices)
+    {
+        minY = std::min(minY, v.position.y);
+        maxY = std::max(maxY, v.position.y);
+        ASSERT_LE(glm::length(glm::vec2(v.position.x, v.position.z)), 0.5f + 1e-5f);
+    }
+    EXPECT_NEAR(minY, -1.0f, 1e-5f);
+    EXPECT_NEAR(maxY, 1.0f, 1e-5f);
+}
+
+TEST(ProceduralTest, LargeTessellationsAreGeneratedInParallelRows)
+{
+    // Well past the per-task vertex count, so rows are split across the pool
+    int const segments = 1024, rings = 512;
+    MeshData data;
+    GenerateSphere(data, 1.0f, segments, rings);
+
+    ASSERT_EQ(data.vertices.size(), (size_t)(segments + 1) * (rings + 1));
+    ASSERT_EQ(data.indices.size(), (size_t)segments * rings * 6);
+
+    for (int j = 0; j <= rings; j += 37)
+    {
+        for (int i = 0; i <= segments; i += 41)
+        {
+            double polar   = (double)j / rings * std::numbers::pi;
+            double azimuth = (double)i / segments * 2.0 * std::numbers::pi;
+            glm::vec3 expected((float)(std::sin(polar) * std::cos(azimuth)),
+                               (float)std::cos(polar),
+                               (float)(std::sin(polar) * std::sin(azimuth)));
+
+            Vertex const& v = data.vertices[(size_t)j * (segments + 1) + i];
+            ASSERT_NEAR(glm::length(v.position - expected), 0.0f, 1e-5f);
+        }
+    }
+    ExpectValidIndices(data, "large sphere");
+}
+
+TEST(ProceduralTest, IcosphereFacesDoNotWrapAcrossTheSeam)
+{
+    MeshData data;
+    for (int subdivisions = 0; subdivisions <= 3; ++subdivisions)
+    {
+        GenerateIcosphere(data, 1.0f, subdivisions);
+        for (size_t t = 0; t + 2 < data.indices.size(); t += 3)
+        {
+            float u[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                u[k] = data.vertices[data.indices[t + k]].texCoord.x;
+            }
+            float range = std::max({u[0], u[1], u[2]}) - std::min({u[0], u[1], u[2]});
+            ASSERT_LE(range, 0.5f) << "subdivisions " << subdivisions << ", triangle " << t / 3;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "dynamic_resolution.h"
+
+using namespace SpatialRender;
+
+TEST(ResolutionControllerTest, StartsAtMaximumScale)
+{
+    ResolutionController controller;
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(ResolutionControllerTest, OverBudgetFramesLowerScaleToMinimum)
+{
+    ResolutionControllerConfig config;
+    config.targetFrameMs = 10.0f;
+    config.minScale      = 0.5f;
+    ResolutionController controller(config);
+
+    float previous = controller.GetScale();
+    for (int i = 0; i < 100; ++i)
+    {
+        float scale = controller.Update(20.0f);
+        EXPECT_LE(scale, previous);
+        previous = scale;
+    }
+    EXPECT_FLOAT_EQ(controller.GetScale(), 0.5f);
+}
+
+TEST(ResolutionControllerTest, HeadroomRaisesScaleBackToMaximum)
+{
+    ResolutionControllerConfig config;
+    config.targetFrameMs = 10.0f;
+    ResolutionController controller(config);
+    controller.Reset(0.5f);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        controller.Update(4.0f);
+    }
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(ResolutionControllerTest, HoldsScaleWithinDeadband)
+{
+    ResolutionControllerConfig config;
+    config.targetFrameMs = 10.0f;
+    config.deadband      = 0.05f;
+    ResolutionController controller(config);
+    controller.Reset(0.75f);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        controller.Update(i % 2 ? 10.4f : 9.6f);
+    }
+    EXPECT_FLOAT_EQ(controller.GetScale(), 0.75f);
+}
+
+TEST(ResolutionControllerTest, SmallCorrectionsAreHeldBack)
+{
+    ResolutionControllerConfig config;
+    config.targetFrameMs = 10.0f;
+    config.minStep       = 0.05f;
+    ResolutionController controller(config);
+    controller.Reset(0.75f);
+
+    // A single slightly slow frame moves the desired scale less than minStep
+    EXPECT_FLOAT_EQ(controller.Update(10.8f), 0.75f);
+}
+
+TEST(ResolutionControllerTest, IgnoresMissingMeasurements)
+{
+    ResolutionController controller;
+    controller.Reset(0.8f);
+    EXPECT_FLOAT_EQ(controller.Update(0.0f), 0.8f);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "scenario.h"
+
+using namespace SpatialRender;
+
+// Writes text to a scenario file and loads it back
+static bool LoadFromText(std::string const& text, std::vector<BenchmarkScenario>& scenarios)
+{
+    std::string path = ::testing::TempDir() + "scenario_test.json";
+    {
+        std::ofstream file(path);
+        file << text;
+    }
+    bool loaded = LoadScenarios(path, scenarios);
+    std::remove(path.c_str());
+    return loaded;
+}
+
+TEST(ScenarioTest, SweepsExpandToCartesianProduct)
+{
+    std::vector<BenchmarkScenario> scenarios;
+    ASSERT_TRUE(LoadFromText(R"({
+        "defaults": {"resolution": "1280x720", "frames": 50},
+        "scenarios": [
+            {"name": "grid", "objects": [10, 100], "mesh": ["cube", "sphere"], "lights": 4},
+            {"name": "single", "camera": "orbit", "frames": 20}
+        ]
+    })",
+                             scenarios));
+
+    // Swept keys come in key order, the last varying fastest
+    ASSERT_EQ(scenarios.size(), 5u);
+    EXPECT_EQ(scenarios[0].name, "grid/mesh=cube/objects=10");
+    EXPECT_EQ(scenarios[1].name, "grid/mesh=cube/objects=100");
+    EXPECT_EQ(scenarios[2].name, "grid/mesh=sphere/objects=10");
+    EXPECT_EQ(scenarios[3].name, "grid/mesh=sphere/objects=100");
+    EXPECT_EQ(scenarios[3].object_count, 100);
+    EXPECT_EQ(scenarios[3].mesh, "sphere");
+    EXPECT_EQ(scenarios[3].light_count, 4);
+    EXPECT_EQ(scenarios[3].resolution, glm::ivec2(1280, 720));
+    EXPECT_EQ(scenarios[3].frame_count, 50);
+
+    EXPECT_EQ(scenarios[4].name, "single");
+    EXPECT_EQ(scenarios[4].camera_motion, CameraMotion::Orbit);
+    EXPECT_EQ(scenarios[4].frame_count, 20);
+}
+
+TEST(ScenarioTest, RejectsInvalidFiles)
+{
+    std::vector<BenchmarkScenario> scenarios;
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"name": "a"})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"defaults": {}})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"objects": 10}]})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"name": "a", "unknown": 1}]})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"name": "a", "objects": "many"}]})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"name": "a", "camera": "spin"}]})", scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"scenarios": [{"name": "a", "resolution": "0x0"}]})", scenarios));
+    EXPECT_FALSE(
+        LoadFromText(R"({"scenarios": [{"name": "a", "resolution": ["64x64", "-1x64"]}]})",
+                     scenarios));
+    EXPECT_FALSE(LoadFromText(R"({"defaults": {"lights": "x"}, "scenarios": []})", scenarios));
+    EXPECT_FALSE(LoadScenarios(::testing::TempDir() + "no_such_scenarios.json", scenarios));
+}
+
+TEST(ScenarioTest, ResolutionMustBePositive)
+{
+    glm::ivec2 resolution(1, 1);
+    EXPECT_TRUE(ParseResolution("640x480", resolution));
+    EXPECT_EQ(resolution, glm::ivec2(640, 480));
+
+    for (char const* text : {"0x0", "640x0", "-640x480", "640", "x480", ""})
+    {
+        EXPECT_FALSE(ParseResolution(text, resolution)) << text;
+    }
+    EXPECT_EQ(resolution, glm::ivec2(640, 480));
+}
+
+TEST(ScenarioTest, FilterMatchesCommaSeparatedGlobs)
+{
+    EXPECT_TRUE(MatchesFilter("cubes/objects=10", ""));
+    EXPECT_TRUE(MatchesFilter("cubes/objects=10", "cubes/*"));
+    EXPECT_TRUE(MatchesFilter("cubes/objects=10", "*=10"));
+    EXPECT_TRUE(MatchesFilter("cubes/objects=10", "cubes/objects=1?"));
+    EXPECT_FALSE(MatchesFilter("cubes/objects=100", "cubes/objects=1?"));
+    EXPECT_FALSE(MatchesFilter("cubes/objects=10", "cubes"));
+    EXPECT_TRUE(MatchesFilter("spheres", "cubes*,spheres"));
+    EXPECT_FALSE(MatchesFilter("lights", "cubes*,spheres"));
+
+    std::vector<BenchmarkScenario> scenarios = DefaultScenarios();
+    std::vector<BenchmarkScenario> selected  = FilterScenarios(scenarios, "*=1,*=500");
+    ASSERT_EQ(selected.size(), 2u);
+    EXPECT_EQ(selected[0].object_count, 1);
+    EXPECT_EQ(selected[1].object_count, 500);
+}
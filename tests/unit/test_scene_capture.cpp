@@ -0,0 +1,165 @@
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera.h"
+#include "mesh.h"
+#include "scene_capture.h"
+#include "shader.h"
+
+using namespace SpatialRender;
+
+namespace
+{
+
+// Two objects share one cube, a third has its own copy of the same cube
+void BuildTestScene(Scene& scene)
+{
+    std::shared_ptr<Mesh> cube     = CreateCubeMesh();
+    std::shared_ptr<Mesh> copy     = CreateCubeMesh();
+    std::shared_ptr<Mesh> sphere   = CreateSphereMesh(8);
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+
+    scene.AddObject(cube, shader, glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    scene.AddObject(cube, shader, glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)));
+    scene.AddObject(copy, shader, glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    scene.AddObject(sphere, shader, glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)));
+    scene.SetOccluder(0, true);
+    scene.AddPointLight(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(1.0f), 2.0f, 10.0f);
+}
+
+}  // namespace
+
+TEST(SceneCaptureTest, DeduplicatesMeshDataByContent)
+{
+    Scene scene;
+    BuildTestScene(scene);
+
+    SceneCapture capture;
+    capture.CaptureScene(scene);
+    EXPECT_EQ(capture.GetObjectCount(), 4u);
+    EXPECT_EQ(capture.GetMeshCount(), 3u);
+    EXPECT_EQ(capture.GetMeshDataCount(), 2u);
+    EXPECT_EQ(capture.GetShaderCount(), 1u);
+    EXPECT_EQ(capture.GetLightCount(), 1u);
+
+    std::unique_ptr<Mesh> cube   = CreateCubeMesh();
+    std::unique_ptr<Mesh> sphere = CreateSphereMesh(8);
+    EXPECT_EQ(SceneCapture::HashMesh(*cube), SceneCapture::HashMesh(*CreateCubeMesh()));
+    EXPECT_NE(SceneCapture::HashMesh(*cube), SceneCapture::HashMesh(*sphere));
+}
+
+TEST(SceneCaptureTest, RoundTripsSceneAndCameraPath)
+{
+    Scene scene;
+    BuildTestScene(scene);
+
+    SceneCapture capture;
+    capture.CaptureScene(scene);
+    capture.SetResolution(640, 360);
+
+    Camera left(glm::vec3(-1.0f, 2.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Camera right(glm::vec3(1.0f, 2.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    right.SetPerspective(60.0f, 1.5f, 0.2f, 50.0f);
+    right.SetReversedZ(true);
+    Camera top;
+    top.SetOrthographic(-4.0f, 4.0f, -3.0f, 3.0f, 0.5f, 20.0f);
+
+    Camera views[2] = {left, right};
+    capture.AddFrame(views, 2);
+    capture.AddFrame(top);
+    capture.AddFrame(views, 0);  // rejected
+    EXPECT_EQ(capture.GetFrameCount(), 2u);
+
+    std::vector<uint8_t> data = capture.Serialize();
+    SceneCapture loaded;
+    ASSERT_TRUE(loaded.Deserialize(data.data(), data.size()));
+    EXPECT_EQ(loaded.GetWidth(), 640);
+    EXPECT_EQ(loaded.GetHeight(), 360);
+    EXPECT_EQ(loaded.GetObjectCount(), 4u);
+    EXPECT_EQ(loaded.GetMeshCount(), 3u);
+    EXPECT_EQ(loaded.GetMeshDataCount(), 2u);
+    EXPECT_EQ(loaded.GetLightCount(), 1u);
+    EXPECT_EQ(loaded.GetFrameCount(), 2u);
+    EXPECT_EQ(loaded.Serialize(), data);
+
+    std::vector<Camera> cameras;
+    loaded.GetFrame(0, cameras);
+    ASSERT_EQ(cameras.size(), 2u);
+    EXPECT_EQ(cameras[0].GetViewProjectionMatrix(), left.GetViewProjectionMatrix());
+    EXPECT_EQ(cameras[1].GetViewProjectionMatrix(), right.GetViewProjectionMatrix());
+    EXPECT_TRUE(cameras[1].IsReversedZ());
+
+    // Frames past the end wrap around
+    loaded.GetFrame(3, cameras);
+    ASSERT_EQ(cameras.size(), 1u);
+    EXPECT_TRUE(cameras[0].IsOrthographic());
+    EXPECT_EQ(cameras[0].GetProjectionMatrix(), top.GetProjectionMatrix());
+}
+
+TEST(SceneCaptureTest, RejectsTruncatedAndForeignData)
+{
+    Scene scene;
+    BuildTestScene(scene);
+
+    SceneCapture capture;
+    capture.CaptureScene(scene);
+    capture.AddFrame(Camera());
+    std::vector<uint8_t> data = capture.Serialize();
+
+    SceneCapture loaded;
+    EXPECT_FALSE(loaded.Deserialize(data.data(), data.size() - 1));
+    EXPECT_FALSE(loaded.Deserialize(data.data(), 6));
+    EXPECT_EQ(loaded.GetObjectCount(), 0u);
+
+    std::vector<uint8_t> foreign = data;
+    foreign[0]                   = 'X';
+    EXPECT_FALSE(loaded.Deserialize(foreign.data(), foreign.size()));
+
+    std::vector<uint8_t> padded = data;
+    padded.push_back(0);
+    EXPECT_FALSE(loaded.Deserialize(padded.data(), padded.size()));
+
+    EXPECT_TRUE(loaded.Deserialize(data.data(), data.size()));
+    EXPECT_EQ(loaded.GetObjectCount(), 4u);
+}
+
+TEST(SceneCaptureTest, RejectsMeshDataThatIndexesPastItsVertices)
+{
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+    std::unique_ptr<Mesh> cube     = CreateCubeMesh();
+
+    // Out-of-range and partial-triangle meshes hash consistently, so only the
+    // index checks can reject them
+    auto capture = [&](std::vector<unsigned int> const& indices) {
+        auto mesh = std::make_shared<Mesh>();
+        mesh->SetVertices(cube->GetVertices());
+        mesh->SetIndices(indices);
+
+        Scene scene;
+        scene.AddObject(mesh, shader, glm::mat4(1.0f));
+        scene.SetOccluder(0, true);
+        SceneCapture capture;
+        capture.CaptureScene(scene);
+        return capture.Serialize();
+    };
+
+    unsigned int vertexCount = (unsigned int)cube->GetVertexCount();
+    SceneCapture loaded;
+    std::vector<uint8_t> data = capture({0, 1, 2, 2, 3, vertexCount - 1});
+    EXPECT_TRUE(loaded.Deserialize(data.data(), data.size()));
+
+    data = capture({0, 1, 2, 2, 3, vertexCount});
+    EXPECT_FALSE(loaded.Deserialize(data.data(), data.size()));
+    data = capture({0, 1, 2, 2});
+    EXPECT_FALSE(loaded.Deserialize(data.data(), data.size()));
+    EXPECT_EQ(loaded.GetMeshDataCount(), 1u);
+
+    // Damage to the vertex data shows up as a hash mismatch. The first vertex
+    // follows magic, version, size, mesh data count, hash and vertex count.
+    data = capture({0, 1, 2});
+    data[32] ^= 0x40;
+    EXPECT_FALSE(loaded.Deserialize(data.data(), data.size()));
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "soak_monitor.h"
+
+using namespace SpatialRender;
+
+// Four phases of a 100-frame ramp, each 1 ms slower than the last, with a
+// snapshot after each phase, 15 minutes apart
+TEST(SoakMonitorTest, SnapshotsTrackWindowAndDrift)
+{
+    SoakConfig config;
+    config.window_frames = 100;
+    SoakMonitor monitor(config);
+    monitor.Start();
+
+    std::vector<double> frames;
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        double base = 10000.0 + 1000.0 * phase;
+        for (int i = 0; i < 100; ++i)
+        {
+            frames.push_back(base + i);
+            monitor.RecordFrame(base + i, (base + i) * 0.5);
+        }
+        monitor.TakeSnapshot(900.0 * (phase + 1));
+    }
+
+    double mean = 0.0;
+    for (double frame : frames)
+    {
+        mean += frame;
+    }
+    mean /= frames.size();
+    double variance = 0.0;
+    for (double frame : frames)
+    {
+        variance += (frame - mean) * (frame - mean);
+    }
+    variance /= frames.size() - 1;
+
+    RunningStats const& stats = monitor.GetFrameStats();
+    EXPECT_EQ(stats.GetCount(), 400u);
+    EXPECT_NEAR(stats.GetMean(), mean, 1e-9);
+    EXPECT_NEAR(stats.GetVariance(), variance, variance * 1e-12);
+    EXPECT_DOUBLE_EQ(stats.GetMin(), 10000.0);
+    EXPECT_DOUBLE_EQ(stats.GetMax(), 13099.0);
+    EXPECT_NEAR(monitor.GetRenderStats().GetMean(), mean * 0.5, 1e-9);
+    EXPECT_EQ(monitor.GetHistogram().GetTotalCount(), 400u);
+
+    // Each window holds exactly one phase
+    std::vector<SoakSnapshot> const& snapshots = monitor.GetSnapshots();
+    ASSERT_EQ(snapshots.size(), 4u);
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        SoakSnapshot const& snapshot = snapshots[phase];
+        double base                  = 10000.0 + 1000.0 * phase;
+        EXPECT_EQ(snapshot.frame_count, 100u * (phase + 1));
+        EXPECT_DOUBLE_EQ(snapshot.window_frame_time.p50, base + 49.5);
+        EXPECT_NEAR(snapshot.window_frame_time.p99, base + 98.01, 1e-9);
+        EXPECT_DOUBLE_EQ(snapshot.window_frame_time.max, base + 99.0);
+        EXPECT_DOUBLE_EQ(snapshot.window_mean_us, base + 49.5);
+        EXPECT_NEAR(snapshot.drift_percent, (base + 49.5) / 10049.5 * 100.0 - 100.0, 1e-9);
+    }
+
+    // The window p50 grows 1 ms every 15 minutes
+    EXPECT_NEAR(monitor.GetFrameTimeDriftPerHour(), 4000.0, 1e-6);
+}
+
+TEST(SoakMonitorTest, StartForgetsEarlierRun)
+{
+    SoakMonitor monitor;
+    monitor.RecordFrame(1000.0, 500.0);
+    monitor.TakeSnapshot(60.0);
+
+    monitor.Start();
+    EXPECT_EQ(monitor.GetFrameStats().GetCount(), 0u);
+    EXPECT_EQ(monitor.GetHistogram().GetTotalCount(), 0u);
+    EXPECT_TRUE(monitor.GetSnapshots().empty());
+    EXPECT_EQ(monitor.GetFrameTimeDriftPerHour(), 0.0);
+}
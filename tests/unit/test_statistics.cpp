@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "statistics.h"
+
+using namespace SpatialRender;
+
+static std::vector<double> Ramp(int count)
+{
+    std::vector<double> values;
+    for (int i = 1; i <= count; ++i)
+    {
+        values.push_back((double)i);
+    }
+    return values;
+}
+
+TEST(StatisticsTest, PercentilesInterpolateBetweenSamples)
+{
+    std::vector<double> values = Ramp(101);
+    std::reverse(values.begin(), values.end());
+
+    PercentileSummary p = ComputePercentiles(values);
+    EXPECT_DOUBLE_EQ(p.p50, 51.0);
+    EXPECT_DOUBLE_EQ(p.p90, 91.0);
+    EXPECT_DOUBLE_EQ(p.p99, 100.0);
+    EXPECT_NEAR(p.p999, 100.9, 1e-9);
+    EXPECT_DOUBLE_EQ(p.max, 101.0);
+}
+
+TEST(StatisticsTest, EmptyInputGivesZeros)
+{
+    PercentileSummary p = ComputePercentiles({});
+    EXPECT_EQ(p.max, 0.0);
+    EXPECT_EQ(OnePercentLowFps({}), 0.0);
+    EXPECT_EQ(DetectWarmup({}), 0u);
+    EXPECT_TRUE(DetectOutliers({}).empty());
+}
+
+TEST(StatisticsTest, OnePercentLowAveragesSlowestFrames)
+{
+    std::vector<double> frames(198, 10000.0);
+    frames.push_back(40000.0);
+    frames.push_back(60000.0);
+
+    // Slowest two frames average 50 ms
+    EXPECT_DOUBLE_EQ(OnePercentLowFps(frames), 20.0);
+}
+
+TEST(StatisticsTest, HistogramBucketsHaveBoundedRelativeError)
+{
+    LogHistogram histogram;
+    for (double value : {1.0, 100.0, 1000.0, 16667.0, 33333.0, 1000000.0})
+    {
+        histogram.Clear();
+        histogram.Record(value);
+        double upper = histogram.ValueAtPercentile(100.0);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper, value * (1.0 + 1.0 / 32.0) + 1e-9);
+    }
+}
+
+TEST(StatisticsTest, HistogramCountsEverySample)
+{
+    LogHistogram histogram;
+    for (double value : Ramp(1000))
+    {
+        histogram.Record(value);
+    }
+    EXPECT_EQ(histogram.GetTotalCount(), 1000u);
+
+    uint64_t total = 0;
+    double previous = 0.0;
+    for (auto const& bucket : histogram.GetNonEmptyBuckets())
+    {
+        EXPECT_GE(bucket.lower, previous);
+        EXPECT_LT(bucket.lower, bucket.upper);
+        previous = bucket.upper;
+        total += bucket.count;
+    }
+    EXPECT_EQ(total, 1000u);
+    EXPECT_NEAR(histogram.ValueAtPercentile(50.0), 500.0, 500.0 / 32.0 + 1.0);
+}
+
+TEST(StatisticsTest, BootstrapIntervalContainsMeanAndIsDeterministic)
+{
+    std::vector<double> values;
+    for (int i = 0; i < 500; ++i)
+    {
+        values.push_back(1000.0 + (i * 37 % 101));
+    }
+    double mean = 0.0;
+    for (double v : values)
+    {
+        mean += v;
+    }
+    mean /= values.size();
+
+    ConfidenceInterval ci = BootstrapMeanCI(values, 0.95, 500, 7);
+    EXPECT_LT(ci.low, mean);
+    EXPECT_GT(ci.high, mean);
+    EXPECT_LT(ci.high - ci.low, 10.0);
+
+    ConfidenceInterval again = BootstrapMeanCI(values, 0.95, 500, 7);
+    EXPECT_EQ(ci.low, again.low);
+    EXPECT_EQ(ci.high, again.high);
+}
+
+TEST(StatisticsTest, OutliersOutsideTukeyFences)
+{
+    std::vector<double> values(100, 10.0);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] += (double)(i % 5);
+    }
+    values[42] = 500.0;
+
+    std::vector<size_t> outliers = DetectOutliers(values);
+    ASSERT_EQ(outliers.size(), 1u);
+    EXPECT_EQ(outliers[0], 42u);
+}
+
+TEST(StatisticsTest, WarmupDetectsSlowStart)
+{
+    std::vector<double> frames;
+    for (int i = 0; i < 50; ++i)
+    {
+        frames.push_back(50000.0 - i * 800.0);
+    }
+    for (int i = 0; i < 450; ++i)
+    {
+        frames.push_back(10000.0 + (i % 7) * 10.0);
+    }
+
+    size_t warmup = DetectWarmup(frames);
+    EXPECT_GE(warmup, 40u);
+    EXPECT_LE(warmup, 60u);
+
+    // Steady input needs no truncation
+    EXPECT_LE(DetectWarmup(std::vector<double>(500, 10000.0)), 5u);
+}
+
+TEST(StatisticsTest, AnalyzeFramesKeepsSlowStart)
+{
+    std::vector<double> frames(20, 100000.0);
+    std::vector<double> steady(480, 10000.0);
+    frames.insert(frames.end(), steady.begin(), steady.end());
+
+    // The slow start is reported, but every frame stays in the tail statistics
+    FrameStatistics stats = AnalyzeFrames(frames, frames);
+    EXPECT_EQ(stats.warmup_frames, 20u);
+    EXPECT_EQ(stats.sample_count, 500u);
+    EXPECT_DOUBLE_EQ(stats.frame_time.max, 100000.0);
+    EXPECT_DOUBLE_EQ(stats.render_time.p50, 10000.0);
+    EXPECT_DOUBLE_EQ(stats.one_percent_low_fps, 10.0);
+    EXPECT_EQ(stats.outlier_frames.size(), 20u);
+    ASSERT_EQ(stats.histogram.size(), 2u);
+    EXPECT_EQ(stats.histogram[0].count, 480u);
+    EXPECT_EQ(stats.histogram[1].count, 20u);
+}
+
+TEST(StatisticsTest, LateStallReachesTailStatistics)
+{
+    // 16 ms frames with 0.3 ms of noise and one 200 ms stall well into the run
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> noise(16000.0, 300.0);
+    std::vector<double> frames(1000);
+    for (double& frame : frames)
+    {
+        frame = noise(rng);
+    }
+    frames[400] = 200000.0;
+
+    FrameStatistics stats = AnalyzeFrames(frames, frames);
+    EXPECT_LE(stats.warmup_frames, 100u);
+    EXPECT_EQ(stats.sample_count, 1000u);
+    EXPECT_DOUBLE_EQ(stats.frame_time.max, 200000.0);
+
+    std::vector<double> sorted(frames);
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_GT(stats.frame_time.p999, sorted[998]);
+    EXPECT_LT(stats.one_percent_low_fps, 1.0e6 / sorted[990]);
+    EXPECT_EQ(stats.histogram.back().count, 1u);
+    EXPECT_GT(stats.histogram.back().upper, 200000.0);
+}
+
+TEST(StatisticsTest, RunningStatsMatchesTwoPassVariance)
+{
+    std::vector<double> values;
+    for (int i = 0; i < 1000; ++i)
+    {
+        values.push_back(1.0e6 + (i * 7919 % 1000) * 0.5);
+    }
+
+    RunningStats running;
+    double mean = 0.0;
+    for (double v : values)
+    {
+        running.Add(v);
+        mean += v;
+    }
+    mean /= values.size();
+
+    double variance = 0.0;
+    for (double v : values)
+    {
+        variance += (v - mean) * (v - mean);
+    }
+    variance /= values.size() - 1;
+
+    EXPECT_EQ(running.GetCount(), 1000u);
+    EXPECT_NEAR(running.GetMean(), mean, 1e-6);
+    EXPECT_NEAR(running.GetVariance(), variance, variance * 1e-9);
+    EXPECT_DOUBLE_EQ(running.GetMin(), 1.0e6);
+    EXPECT_DOUBLE_EQ(running.GetMax(), 1.0e6 + 499.5);
+}
+
+TEST(StatisticsTest, WindowedPercentilesForgetOldSamples)
+{
+    WindowedPercentiles window(100);
+    for (int i = 0; i < 1000; ++i)
+    {
+        window.Add(1000.0);
+    }
+    for (int i = 1; i <= 100; ++i)
+    {
+        window.Add((double)i);
+    }
+
+    EXPECT_EQ(window.GetSize(), 100u);
+    PercentileSummary p = window.Compute();
+    EXPECT_DOUBLE_EQ(p.max, 100.0);
+    EXPECT_DOUBLE_EQ(p.p50, 50.5);
+
+    window.Clear();
+    window.Add(7.0);
+    EXPECT_DOUBLE_EQ(window.Compute().p99, 7.0);
+}
+
+TEST(StatisticsTest, MannWhitneyFindsShiftedDistribution)
+{
+    std::vector<double> baseline;
+    std::vector<double> slower;
+    for (int i = 0; i < 200; ++i)
+    {
+        double noise = (double)((i * 7919) % 211) - 105.0;
+        baseline.push_back(10000.0 + noise * 5.0);
+        slower.push_back(10600.0 + noise * 5.0);
+    }
+
+    MannWhitneyResult result = MannWhitneyU(baseline, slower);
+    EXPECT_LT(result.p_value, 1e-6);
+    EXPECT_GT(result.z, 0.0);
+    EXPECT_GT(result.probability, 0.8);
+
+    ConfidenceInterval delta = BootstrapMeanDeltaCI(baseline, slower);
+    EXPECT_LT(delta.low, 6.0);
+    EXPECT_GT(delta.high, 6.0);
+    EXPECT_GT(delta.low, 4.0);
+}
+
+TEST(StatisticsTest, MannWhitneyAcceptsSameDistribution)
+{
+    std::vector<double> first;
+    std::vector<double> second;
+    for (int i = 0; i < 200; ++i)
+    {
+        first.push_back((double)((i * 7919) % 211));
+        second.push_back((double)((i * 104729) % 211));
+    }
+
+    MannWhitneyResult result = MannWhitneyU(first, second);
+    EXPECT_GT(result.p_value, 0.2);
+    EXPECT_NEAR(result.probability, 0.5, 0.1);
+
+    // All ties: no evidence of a shift
+    std::vector<double> ones(50, 1.0);
+    MannWhitneyResult tied = MannWhitneyU(ones, ones);
+    EXPECT_DOUBLE_EQ(tied.p_value, 1.0);
+    EXPECT_DOUBLE_EQ(tied.probability, 0.5);
+}
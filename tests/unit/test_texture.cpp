@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "texture.h"
+
+using namespace SpatialRender;
+
+namespace
+{
+
+template <typename T>
+void Put(std::vector<uint8_t>& bytes, size_t offset, T value)
+{
+    if (bytes.size() < offset + sizeof(T))
+    {
+        bytes.resize(offset + sizeof(T));
+    }
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+// Level i is filled with the byte i + 1 so the tests can tell levels apart
+std::vector<uint8_t> MakeKTX2(uint32_t vkFormat,
+                              uint32_t width,
+                              uint32_t height,
+                              std::vector<size_t> const& levelBytes)
+{
+    static uint8_t const kIdentifier[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    std::vector<uint8_t> bytes(80 + 24 * levelBytes.size(), 0);
+    std::memcpy(bytes.data(), kIdentifier, sizeof(kIdentifier));
+    Put<uint32_t>(bytes, 12, vkFormat);
+    Put<uint32_t>(bytes, 20, width);
+    Put<uint32_t>(bytes, 24, height);
+    Put<uint32_t>(bytes, 36, 1);  // faces
+    Put<uint32_t>(bytes, 40, (uint32_t)levelBytes.size());
+
+    // Stored coarsest first, like the files KTX tools write
+    for (size_t level = levelBytes.size(); level-- > 0;)
+    {
+        size_t offset = bytes.size();
+        bytes.resize(offset + levelBytes[level], (uint8_t)(level + 1));
+        Put<uint64_t>(bytes, 80 + 24 * level, offset);
+        Put<uint64_t>(bytes, 80 + 24 * level + 8, levelBytes[level]);
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> MakeDDS(char const* fourCC, uint32_t width, uint32_t height, uint32_t levels)
+{
+    std::vector<uint8_t> bytes(128, 0);
+    std::memcpy(bytes.data(), "DDS ", 4);
+    Put<uint32_t>(bytes, 4, 124);
+    Put<uint32_t>(bytes, 8, 0x1007 | 0x20000);  // caps, size, pixel format, mip count
+    Put<uint32_t>(bytes, 12, height);
+    Put<uint32_t>(bytes, 16, width);
+    Put<uint32_t>(bytes, 28, levels);
+    Put<uint32_t>(bytes, 76, 32);
+    Put<uint32_t>(bytes, 80, 0x4);  // FourCC
+    std::memcpy(bytes.data() + 84, fourCC, 4);
+    return bytes;
+}
+
+}  // namespace
+
+TEST(TextureTest, LevelSizesFollowTheBlockFormat)
+{
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::BC1, 256, 256), 64u * 64u * 8u);
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::BC7, 256, 256), 64u * 64u * 16u);
+    // Partial blocks round up, and small levels still take a whole block
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::BC7, 5, 3), 2u * 1u * 16u);
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::ETC2_RGB8, 1, 1), 8u);
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::RGBA8, 3, 3), 36u);
+
+    // Block compression is 4-8x smaller than the RGBA8 it replaces
+    EXPECT_EQ(GetTextureLevelBytes(TextureFormat::RGBA8, 256, 256) /
+                  GetTextureLevelBytes(TextureFormat::BC1, 256, 256),
+              8u);
+}
+
+TEST(TextureTest, ParsesKTX2MipChainIntoLevelOrder)
+{
+    // BC7 sRGB, 8x8 with a full chain: 4 blocks, then one block per level
+    std::vector<uint8_t> file = MakeKTX2(146, 8, 8, {64, 16, 16, 16});
+
+    TextureImage image;
+    ASSERT_TRUE(ParseKTX2(file.data(), file.size(), image));
+    EXPECT_EQ(image.format, TextureFormat::BC7);
+    EXPECT_TRUE(image.srgb);
+    ASSERT_EQ(image.levels.size(), 4u);
+    EXPECT_EQ(image.GetWidth(), 8u);
+    EXPECT_EQ(image.levels[3].width, 1u);
+    ASSERT_EQ(image.data.size(), 64u + 16u * 3u);
+
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        uint8_t const* data = image.GetLevelData(level);
+        for (size_t i = 0; i < image.levels[level].bytes; ++i)
+        {
+            ASSERT_EQ(data[i], level + 1) << "level " << level;
+        }
+    }
+}
+
+TEST(TextureTest, ParsesDDSLegacyAndDX10Headers)
+{
+    // DXT1 16x8: 4x2 blocks, then 2x1, then 1x1
+    std::vector<uint8_t> file = MakeDDS("DXT1", 16, 8, 3);
+    file.resize(file.size() + 64 + 16 + 8, 0x5A);
+
+    TextureImage image;
+    ASSERT_TRUE(ParseDDS(file.data(), file.size(), image));
+    EXPECT_EQ(image.format, TextureFormat::BC1);
+    ASSERT_EQ(image.levels.size(), 3u);
+    EXPECT_EQ(image.levels[1].offset, 64u);
+    EXPECT_EQ(image.levels[2].bytes, 8u);
+    EXPECT_EQ(image.data.size(), 88u);
+
+    // DX10 extension header carrying a DXGI format
+    file = MakeDDS("DX10", 4, 4, 1);
+    Put<uint32_t>(file, 128, 99);  // BC7_UNORM_SRGB
+    Put<uint32_t>(file, 132, 3);   // TEXTURE2D
+    Put<uint32_t>(file, 140, 1);   // array size
+    file.resize(148 + 16, 0);
+    ASSERT_TRUE(ParseDDS(file.data(), file.size(), image));
+    EXPECT_EQ(image.format, TextureFormat::BC7);
+    EXPECT_TRUE(image.srgb);
+    EXPECT_EQ(image.levels.size(), 1u);
+}
+
+TEST(TextureTest, RejectsKTX2HeadersTheFileCannotBackUp)
+{
+    // 65536 x 65536 RGBA8 claimed by a file of a few dozen bytes: rejected
+    // before the ~17 GB level chain is allocated
+    std::vector<uint8_t> file = MakeKTX2(37, 65536, 65536, {16});
+    TextureImage image;
+    EXPECT_FALSE(ParseKTX2(file.data(), file.size(), image));
+    EXPECT_EQ(image.data.capacity(), 0u);
+
+    // The level index itself runs past the end of the file
+    file = MakeKTX2(146, 8, 8, {64, 16, 16, 16});
+    file.resize(80 + 24 * 2);
+    EXPECT_FALSE(ParseKTX2(file.data(), file.size(), image));
+}
+
+TEST(TextureTest, RejectsWhatItCannotUploadDirectly)
+{
+    TextureImage image;
+
+    // Basis or zstd supercompression would need a CPU transcoder
+    std::vector<uint8_t> file = MakeKTX2(145, 4, 4, {16});
+    Put<uint32_t>(file, 44, 2);
+    EXPECT_FALSE(ParseKTX2(file.data(), file.size(), image));
+
+    // Level data shorter than the format requires
+    file = MakeKTX2(145, 8, 8, {64, 16, 16, 8});
+    EXPECT_FALSE(ParseKTX2(file.data(), file.size(), image));
+
+    file = MakeDDS("DXT5", 8, 8, 1);
+    file.resize(file.size() + 63);
+    EXPECT_FALSE(ParseDDS(file.data(), file.size(), image));
+
+    file = MakeDDS("DXT5", 8, 8, 1);
+    file.resize(file.size() + 64);
+    Put<uint32_t>(file, 112, 0x200);  // cubemap
+    EXPECT_FALSE(ParseDDS(file.data(), file.size(), image));
+
+    EXPECT_FALSE(ParseKTX2(file.data(), file.size(), image));
+}
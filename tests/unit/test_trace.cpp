@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "parallel.h"
+#include "trace.h"
+
+using namespace SpatialRender;
+
+class TraceTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override { Tracer::Get().Clear(); }
+    void TearDown() override
+    {
+        Tracer::Get().SetEnabled(false);
+        Tracer::Get().Clear();
+    }
+};
+
+TEST_F(TraceTest, DisabledZonesRecordNothing)
+{
+    Tracer::Get().SetEnabled(false);
+    {
+        TraceZone zone("Disabled");
+    }
+    Tracer::Get().Collect();
+    EXPECT_EQ(Tracer::Get().GetEventCount(), 0u);
+}
+
+TEST_F(TraceTest, EnabledZonesRecordNestedEvents)
+{
+    Tracer::Get().SetEnabled(true);
+    {
+        TraceZone outer("Outer");
+        TraceZone inner("Inner");
+    }
+    Tracer::Get().Collect();
+    EXPECT_EQ(Tracer::Get().GetEventCount(), 2u);
+}
+
+TEST_F(TraceTest, WorkerThreadsRecordIntoTheirOwnRings)
+{
+    Tracer::Get().SetEnabled(true);
+    ParallelFor(64, 1, [](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            TraceZone zone("Task");
+        }
+    });
+    Tracer::Get().Collect();
+
+    // One per task, plus ThreadPool::Execute zones when compiled in
+    EXPECT_GE(Tracer::Get().GetEventCount(), 64u);
+    EXPECT_EQ(Tracer::Get().GetDroppedCount(), 0u);
+}
+
+TEST_F(TraceTest, FullRingDropsInsteadOfBlocking)
+{
+    Tracer::Get().SetEnabled(true);
+    for (size_t i = 0; i < Tracer::kRingCapacity + 10; ++i)
+    {
+        Tracer::Get().Record("Flood", 1, 2);
+    }
+    EXPECT_EQ(Tracer::Get().GetDroppedCount(), 10u);
+
+    Tracer::Get().Collect();
+    EXPECT_EQ(Tracer::Get().GetEventCount(), Tracer::kRingCapacity);
+}
+
+TEST_F(TraceTest, ExportsChromeTraceEvents)
+{
+    Tracer::Get().SetEnabled(true);
+    Tracer::Get().SetThreadName("Test \"main\"");
+    {
+        TraceZone zone("Exported");
+    }
+
+    std::string path = ::testing::TempDir() + "trace_test.json";
+    ASSERT_TRUE(Tracer::Get().ExportChromeTrace(path));
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+    std::remove(path.c_str());
+
+    EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\",\"name\":\"Exported\""), std::string::npos);
+    EXPECT_NE(json.find("Test \\\"main\\\""), std::string::npos);
+}
+
+#if defined(SPATIALRENDER_TRACING)
+TEST_F(TraceTest, MacroRecordsWhenCompiledIn)
+{
+    Tracer::Get().SetEnabled(true);
+    {
+        SR_TRACE_ZONE("Macro");
+    }
+    Tracer::Get().Collect();
+    EXPECT_EQ(Tracer::Get().GetEventCount(), 1u);
+}
+#endif
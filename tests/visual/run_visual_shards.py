@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Sharded visual test runner for SpatialRender
+
+Spreads the visual test cases across several worker processes, each with its own
+GL context, using Google Test's sharding variables. The per-shard JUnit reports
+are merged into one so CI sees a single result.
+"""
+
+import os
+import sys
+import argparse
+import subprocess
+import time
+import xml.etree.ElementTree as ET
+from pathlib import Path
+from typing import List, Optional
+
+
+class Shard:
+    def __init__(self, index: int, total: int, work_dir: Path):
+        self.index = index
+        self.total = total
+        self.xml_path = work_dir / f"shard_{index}.xml"
+        self.log_path = work_dir / f"shard_{index}.log"
+        self.process: Optional[subprocess.Popen] = None
+        self.return_code: Optional[int] = None
+        self.start = 0.0
+        self.duration = 0.0
+
+
+def count_tests(binary: Path, gtest_filter: Optional[str]) -> int:
+    """Count the test cases the binary would run"""
+    command = [str(binary), "--gtest_list_tests"]
+    if gtest_filter:
+        command.append(f"--gtest_filter={gtest_filter}")
+
+    output = subprocess.run(command, capture_output=True, text=True, check=True).stdout
+    # Suites are flush left, their test cases are indented
+    return sum(1 for line in output.splitlines() if line.startswith("  "))
+
+
+def launch_shard(
+    shard: Shard, binary: Path, gtest_filter: Optional[str], llvmpipe_threads: int
+) -> None:
+    env = os.environ.copy()
+    env["GTEST_TOTAL_SHARDS"] = str(shard.total)
+    env["GTEST_SHARD_INDEX"] = str(shard.index)
+    # llvmpipe sizes its rasterizer pool to the machine; split the cores between
+    # shards instead of oversubscribing them
+    env.setdefault("LP_NUM_THREADS", str(llvmpipe_threads))
+
+    command = [str(binary), f"--gtest_output=xml:{shard.xml_path}"]
+    if gtest_filter:
+        command.append(f"--gtest_filter={gtest_filter}")
+
+    shard.xml_path.unlink(missing_ok=True)
+    log = open(shard.log_path, "w")
+    shard.process = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT, env=env)
+    log.close()
+
+
+def merge_reports(shards: List[Shard], report_path: Path) -> ET.Element:
+    """Merge the shard reports into one <testsuites> document"""
+    merged = ET.Element("testsuites", name="AllTests")
+    suites = {}
+    totals = {"tests": 0, "failures": 0, "errors": 0, "disabled": 0, "skipped": 0}
+    total_time = 0.0
+
+    for shard in shards:
+        if not shard.xml_path.exists():
+            continue
+
+        root = ET.parse(shard.xml_path).getroot()
+        for suite in root.findall("testsuite"):
+            name = suite.get("name")
+            target = suites.get(name)
+            if target is None:
+                target = ET.SubElement(merged, "testsuite", name=name)
+                for key in totals:
+                    target.set(key, "0")
+                target.set("time", "0")
+                suites[name] = target
+
+            for key in totals:
+                count = int(suite.get(key, "0"))
+                target.set(key, str(int(target.get(key)) + count))
+                totals[key] += count
+
+            suite_time = float(suite.get("time", "0"))
+            target.set("time", f"{float(target.get('time')) + suite_time:.3f}")
+            total_time += suite_time
+            target.extend(suite.findall("testcase"))
+
+    for key, count in totals.items():
+        merged.set(key, str(count))
+    merged.set("time", f"{total_time:.3f}")
+
+    report_path.parent.mkdir(parents=True, exist_ok=True)
+    ET.ElementTree(merged).write(report_path, encoding="utf-8", xml_declaration=True)
+    return merged
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the visual tests in parallel shards")
+    parser.add_argument(
+        "--binary",
+        default="tests/visual/spatialrender_visual_tests",
+        help="Path to the visual test executable",
+    )
+    parser.add_argument(
+        "--jobs", type=int, default=os.cpu_count() or 1, help="Number of worker processes"
+    )
+    parser.add_argument("--filter", help="Google Test filter passed to every shard")
+    parser.add_argument(
+        "--report",
+        default="tests/visual/visual_test_report.xml",
+        help="Merged JUnit report to write",
+    )
+
+    args = parser.parse_args()
+
+    binary = Path(args.binary).resolve()
+    if not binary.exists():
+        print(f"Error: Test binary not found: {binary}")
+        sys.exit(1)
+
+    test_count = count_tests(binary, args.filter)
+    if test_count == 0:
+        print("No visual tests matched")
+        sys.exit(1)
+
+    jobs = max(1, min(args.jobs, test_count))
+    llvmpipe_threads = max(1, (os.cpu_count() or 1) // jobs)
+    work_dir = Path(args.report).resolve().parent / "shards"
+    work_dir.mkdir(parents=True, exist_ok=True)
+
+    print(f"Running {test_count} visual tests in {jobs} shards")
+    start = time.perf_counter()
+    shards = [Shard(i, jobs, work_dir) for i in range(jobs)]
+    for shard in shards:
+        shard.start = time.perf_counter()
+        launch_shard(shard, binary, args.filter, llvmpipe_threads)
+
+    for shard in shards:
+        shard.return_code = shard.process.wait()
+        shard.duration = time.perf_counter() - shard.start
+
+    merged = merge_reports(shards, Path(args.report))
+    elapsed = time.perf_counter() - start
+
+    all_passed = True
+    for shard in shards:
+        status = "PASS" if shard.return_code == 0 else "FAIL"
+        print(f"{status}: shard {shard.index} ({shard.duration:.2f}s)")
+        if shard.return_code != 0 or not shard.xml_path.exists():
+            all_passed = False
+            # A crashed shard leaves no report; its log is the only record
+            print(shard.log_path.read_text())
+
+    for case in merged.iter("testcase"):
+        if case.find("failure") is not None:
+            print(f"FAIL: {case.get('classname')}.{case.get('name')}")
+
+    print(f"\nReport generated: {args.report}")
+    print(
+        f"Total: {merged.get('tests')}, Failed: {merged.get('failures')}, "
+        f"Wall time: {elapsed:.2f}s"
+    )
+
+    sys.exit(0 if all_passed else 1)
+
+
+if __name__ == "__main__":
+    main()
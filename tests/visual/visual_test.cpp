@@ -1,27 +1,47 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <utility>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <gtest/gtest.h>
 
 #include "camera.h"
+#include "clustered_lighting.h"
+#include "frame_graph.h"
+#include "gl_state.h"
+#include "image_compare.h"
+#include "material.h"
+#include "memory_tracker.h"
 #include "mesh.h"
 #include "renderer.h"
 #include "scene.h"
+#include "scene_capture.h"
 #include "shader.h"
+#include "texture.h"
 
 using namespace SpatialRender;
 namespace fs = std::filesystem;
 
+#ifndef SPATIALRENDER_GOLDEN_DIR
+#define SPATIALRENDER_GOLDEN_DIR "tests/visual/golden"
+#endif
+
+// One hidden window and context serve the whole suite; creating them per test
+// dominated the run time. Each test gets a fresh Renderer on a context reset to
+// default state. run_visual_shards.py spreads tests across processes.
 class VisualRegressionTest : public ::testing::Test
 {
  protected:
-    void SetUp() override
+    static void SetUpTestSuite()
     {
         if (!glfwInit())
         {
-            GTEST_SKIP() << "GLFW initialization failed";
+            s_skipReason = "GLFW initialization failed";
+            return;
         }
 
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -29,20 +49,46 @@ class VisualRegressionTest : public ::testing::Test
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
         glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);  // Headless
 
-        window = glfwCreateWindow(800, 600, "Test", nullptr, nullptr);
-        if (!window)
+        s_window = glfwCreateWindow(800, 600, "Test", nullptr, nullptr);
+        if (!s_window)
         {
-            GTEST_SKIP() << "Window creation failed";
+            s_skipReason = "Window creation failed";
+            return;
         }
 
-        glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(s_window);
 
         glewExperimental = GL_TRUE;
         if (glewInit() != GLEW_OK)
         {
-            GTEST_SKIP() << "GLEW initialization failed";
+            s_skipReason = "GLEW initialization failed";
+            glfwDestroyWindow(s_window);
+            s_window = nullptr;
+            return;
         }
 
+        // The window's framebuffer is not necessarily object 0
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &s_defaultFramebuffer);
+    }
+
+    static void TearDownTestSuite()
+    {
+        if (s_window)
+        {
+            glfwDestroyWindow(s_window);
+            s_window = nullptr;
+        }
+        glfwTerminate();
+    }
+
+    void SetUp() override
+    {
+        if (!s_window)
+        {
+            GTEST_SKIP() << s_skipReason;
+        }
+
+        ResetContextState();
         renderer = std::make_unique<Renderer>(800, 600);
         renderer->Initialize();
 
@@ -53,14 +99,98 @@ class VisualRegressionTest : public ::testing::Test
 
     void TearDown() override
     {
-        if (window)
+        // GL objects must be released while the shared context is current
+        renderer.reset();
+    }
+
+    // Returns the state a previous test may have changed to the GL defaults,
+    // so results do not depend on test order
+    static void ResetContextState()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)s_defaultFramebuffer);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glUseProgram(0);
+        for (GLenum cap : {GL_DEPTH_TEST,
+                           GL_CULL_FACE,
+                           GL_BLEND,
+                           GL_SCISSOR_TEST,
+                           GL_POLYGON_OFFSET_FILL,
+                           GL_CLIP_DISTANCE0,
+                           GL_CLIP_DISTANCE1,
+                           GL_FRAMEBUFFER_SRGB})
         {
-            glfwDestroyWindow(window);
+            glDisable(cap);
         }
-        glfwTerminate();
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glCullFace(GL_BACK);
+        glViewport(0, 0, 800, 600);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        while (glGetError() != GL_NO_ERROR)
+        {
+        }
+
+        GLStateCache::Get().Invalidate();
+    }
+
+    // Compares the framebuffer against <golden dir>/<name>.png in process. Only
+    // a failure writes files: the capture to tests/visual/output and a diff to
+    // tests/visual/diffs. A missing golden fails the test and leaves the capture
+    // for review; SPATIALRENDER_UPDATE_GOLDENS=1 writes it as the new golden.
+    void ExpectMatchesGolden(std::string const& name,
+                             ImageCompareOptions const& options = ImageCompareOptions())
+    {
+        ImageView actual = renderer->CaptureFramebuffer();
+
+        char const* goldenDir = std::getenv("SPATIALRENDER_GOLDEN_DIR");
+        char const* update    = std::getenv("SPATIALRENDER_UPDATE_GOLDENS");
+        fs::path golden       = fs::path(goldenDir ? goldenDir : SPATIALRENDER_GOLDEN_DIR);
+        golden /= name + ".png";
+        std::string output = "tests/visual/output/" + name + ".png";
+
+        if (update && std::strcmp(update, "1") == 0)
+        {
+            fs::create_directories(golden.parent_path());
+            EXPECT_TRUE(SaveImageRGBA(golden.string(), actual));
+            return;
+        }
+
+        std::vector<uint8_t> goldenPixels;
+        int goldenWidth = 0, goldenHeight = 0;
+        if (!LoadImageRGBA(golden.string(), goldenPixels, goldenWidth, goldenHeight))
+        {
+            SaveImageRGBA(output, actual);
+            ADD_FAILURE() << name << ": no golden at " << golden.string() << "; capture written to "
+                          << output << ", record it with SPATIALRENDER_UPDATE_GOLDENS=1";
+            return;
+        }
+
+        ImageView expected{goldenPixels.data(), goldenWidth, goldenHeight};
+        ImageCompareResult result = CompareImages(actual, expected, options);
+        if (!result.passed)
+        {
+            std::vector<uint8_t> diff;
+            BuildDiffImage(actual, expected, options.channelTolerance, diff);
+            fs::create_directories("tests/visual/diffs");
+            SaveImageRGBA(output, actual);
+            SaveImageRGBA("tests/visual/diffs/" + name + "_diff.png",
+                          {diff.data(), goldenWidth, goldenHeight});
+        }
+
+        EXPECT_TRUE(result.sizeMatches)
+            << name << ": " << actual.width << "x" << actual.height << " against a "
+            << goldenWidth << "x" << goldenHeight << " golden";
+        EXPECT_TRUE(result.passed)
+            << name << ": " << result.mismatchPercent << "% mismatched, max delta "
+            << result.maxChannelDelta << ", PSNR " << result.psnr << " dB, SSIM " << result.ssim;
     }
 
-    GLFWwindow* window = nullptr;
+    static inline GLFWwindow* s_window       = nullptr;
+    static inline GLint s_defaultFramebuffer = 0;
+    static inline char const* s_skipReason   = "";
+
     std::unique_ptr<Renderer> renderer;
 };
 
@@ -87,12 +217,7 @@ TEST_F(VisualRegressionTest, RenderCubeScene)
     renderer->RenderScene(scene, camera);
     renderer->EndFrame();
 
-    // Capture framebuffer
-    std::string output_path = "tests/visual/output/cube_scene.png";
-    ASSERT_TRUE(renderer->SaveFramebufferToFile(output_path));
-
-    // Verify file was created
-    ASSERT_TRUE(fs::exists(output_path));
+    ExpectMatchesGolden("cube_scene");
 }
 
 TEST_F(VisualRegressionTest, RenderSphereScene)
@@ -114,7 +239,1063 @@ TEST_F(VisualRegressionTest, RenderSphereScene)
     renderer->RenderScene(scene, camera);
     renderer->EndFrame();
 
-    std::string output_path = "tests/visual/output/sphere_scene.png";
-    ASSERT_TRUE(renderer->SaveFramebufferToFile(output_path));
-    ASSERT_TRUE(fs::exists(output_path));
+    ExpectMatchesGolden("sphere_scene");
+}
+
+TEST_F(VisualRegressionTest, StateCacheElidesRedundantBinds)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Ten objects sharing one program and one VAO
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 10; ++i)
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.2f - 1.0f, 0, 0));
+        scene.AddObject(cube, shader, transform, glm::vec3(0.2f, 0.2f, 0.8f));
+    }
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+    }
+
+    // Only the first object of the second frame may bind anything
+    GLStateStats const& stats = renderer->GetStateStats();
+    EXPECT_GE(stats.elidedCalls, 2u * 10u - 1u);
+    EXPECT_LE(stats.issuedCalls, 2u);
+}
+
+TEST_F(VisualRegressionTest, RenderStatsCountSubmittedWork)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Ten cubes in view and four behind the camera
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 14; ++i)
+    {
+        float z             = i < 10 ? 0.0f : 10.0f;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.2f - 1.0f, 0, z));
+        scene.AddObject(cube, shader, transform, glm::vec3(0.2f, 0.8f, 0.2f));
+    }
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    renderer->SetOcclusionCulling(true);
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+    }
+
+    // The mesh was uploaded in the first frame; the second only draws
+    RenderStats const& stats = renderer->GetRenderStats();
+    EXPECT_EQ(stats.drawCalls, 10u);
+    EXPECT_EQ(stats.objectsSubmitted, 10u);
+    EXPECT_EQ(stats.objectsCulled, 4u);
+    EXPECT_EQ(stats.triangles, 10u * cube->GetIndexCount() / 3);
+    EXPECT_EQ(stats.vertices, 10u * cube->GetIndexCount());
+    EXPECT_LE(stats.programSwitches, 1u);
+    EXPECT_LE(stats.vertexArrayBinds, 1u);
+    EXPECT_GE(stats.uniformUploads, 2u * 10u);
+
+    // The draw list lives in the frame allocator, which stops growing once warm
+    EXPECT_GE(stats.frameAllocatorHighWater, 14u * sizeof(uint64_t));
+    uint64_t systemAllocations = renderer->GetFrameAllocator().GetSystemAllocations();
+    renderer->BeginFrame();
+    renderer->RenderScene(scene, camera);
+    renderer->EndFrame();
+    EXPECT_EQ(renderer->GetFrameAllocator().GetSystemAllocations(), systemAllocations);
+}
+
+TEST_F(VisualRegressionTest, MeshReuploadReleasesPreviousBuffers)
+{
+    MemoryTracker& memory = MemoryTracker::Get();
+    size_t before         = memory.GetGpuUsage().allocations;
+
+    std::unique_ptr<Mesh> mesh(CreateCubeMesh());
+    mesh->Upload();
+    EXPECT_EQ(memory.GetGpuUsage().allocations, before + 2);
+
+    // New vertices force a second upload, which must replace the VBO and EBO
+    mesh->SetVertices(mesh->GetVertices());
+    mesh->Upload();
+    EXPECT_EQ(memory.GetGpuUsage().allocations, before + 2);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::IndexBuffer).liveBytes,
+              mesh->GetIndexCount() * sizeof(unsigned int));
+
+    mesh.reset();
+    EXPECT_EQ(memory.GetGpuUsage().allocations, before);
+}
+
+TEST_F(VisualRegressionTest, DepthPrepassMatchesForwardRendering)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Overlapping objects added back-to-front, the worst case for overdraw
+    Scene scene;
+    auto cube   = std::shared_ptr<Mesh>(CreateCubeMesh());
+    auto sphere = std::shared_ptr<Mesh>(CreateSphereMesh(24));
+    for (int i = 0; i < 6; ++i)
+    {
+        glm::mat4 transform =
+            glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.15f - 0.4f, 0.0f, -i * 0.4f));
+        scene.AddObject(i % 2 ? sphere : cube, shader, transform, glm::vec3(0.1f * i, 0.5f, 0.8f));
+    }
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    auto renderWith = [&](bool sorting, bool prepass) {
+        renderer->SetDepthSorting(sorting);
+        renderer->SetDepthPrepass(prepass);
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    std::vector<uint8_t> reference = renderWith(false, false);
+    EXPECT_EQ(renderWith(true, false), reference);
+    EXPECT_EQ(renderWith(true, true), reference);
+
+    ExpectMatchesGolden("depth_prepass_scene");
+}
+
+TEST_F(VisualRegressionTest, ClusteredLightsShadeNearbySurfaces)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // A wall facing the camera with a red point light left and a blue spot right
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    scene.AddObject(cube,
+                    shader,
+                    glm::scale(glm::mat4(1.0f), glm::vec3(4.0f, 3.0f, 0.1f)),
+                    glm::vec3(0.5f));
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+    auto pixel = [](std::vector<uint8_t> const& pixels, int x, int y) {
+        return &pixels[(y * 800 + x) * 4];
+    };
+
+    std::vector<uint8_t> unlit = render();
+
+    scene.AddPointLight(glm::vec3(-0.8f, 0.0f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f), 2.0f, 1.5f);
+    scene.AddSpotLight(glm::vec3(0.8f, 0.0f, 1.5f),
+                       glm::vec3(0.0f, 0.0f, -1.0f),
+                       glm::vec3(0.0f, 0.0f, 1.0f),
+                       4.0f,
+                       4.0f,
+                       10.0f,
+                       20.0f);
+    std::vector<uint8_t> lit = render();
+
+    EXPECT_EQ(renderer->GetLightingStats().visibleLights, 2u);
+
+    // Red light only affects the left half, the spot only the right
+    EXPECT_GT(pixel(lit, 204, 300)[0], pixel(unlit, 204, 300)[0] + 20);
+    EXPECT_EQ(pixel(lit, 204, 300)[2], pixel(unlit, 204, 300)[2]);
+    EXPECT_GT(pixel(lit, 596, 300)[2], pixel(unlit, 596, 300)[2] + 20);
+    EXPECT_EQ(pixel(lit, 596, 300)[0], pixel(unlit, 596, 300)[0]);
+    EXPECT_EQ(0, std::memcmp(pixel(lit, 790, 20), pixel(unlit, 790, 20), 4));
+
+    ExpectMatchesGolden("clustered_lights_scene");
+}
+
+TEST_F(VisualRegressionTest, MultiViewMatchesSeparateViews)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube   = std::shared_ptr<Mesh>(CreateCubeMesh());
+    auto sphere = std::shared_ptr<Mesh>(CreateSphereMesh(24));
+    for (int i = 0; i < 5; ++i)
+    {
+        glm::mat4 transform =
+            glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.6f - 1.2f, 0.0f, -i * 0.5f));
+        scene.AddObject(i % 2 ? sphere : cube, shader, transform, glm::vec3(0.2f * i, 0.6f, 0.4f));
+    }
+    scene.AddPointLight(glm::vec3(0.0f, 0.5f, 1.0f), glm::vec3(1.0f, 0.8f, 0.2f), 2.0f, 3.0f);
+
+    // Two eyes, each rendered into half of the 800x600 framebuffer
+    std::vector<Camera> eyes(2);
+    for (int i = 0; i < 2; ++i)
+    {
+        eyes[i].SetPerspective(45.0f, 400.0f / 600.0f, 0.1f, 100.0f);
+        eyes[i].SetPosition(glm::vec3(i ? 0.1f : -0.1f, 0.0f, 4.0f));
+        eyes[i].SetTarget(glm::vec3(i ? 0.1f : -0.1f, 0.0f, 0.0f));
+    }
+
+    renderer->BeginFrame();
+    renderer->Clear();
+    renderer->RenderSceneMultiView(scene, eyes);
+    renderer->EndFrame();
+
+    std::vector<uint8_t> combined;
+    renderer->CaptureFramebuffer(combined);
+    ExpectMatchesGolden("multiview_scene");
+
+    // Reference: each eye on its own at the slot resolution
+    Renderer single(400, 600);
+    ASSERT_TRUE(single.Initialize());
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        single.BeginFrame();
+        single.Clear();
+        single.RenderScene(scene, eyes[eye]);
+        single.EndFrame();
+
+        std::vector<uint8_t> reference;
+        single.CaptureFramebuffer(reference);
+
+        // The slot remap can move edges by a rounding step, so allow a few pixels
+        int mismatched = 0;
+        for (int y = 0; y < 600; ++y)
+        {
+            for (int x = 0; x < 400; ++x)
+            {
+                uint8_t const* a = &combined[(y * 800 + eye * 400 + x) * 4];
+                uint8_t const* b = &reference[(y * 400 + x) * 4];
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (std::abs(a[c] - b[c]) > 2)
+                    {
+                        ++mismatched;
+                        break;
+                    }
+                }
+            }
+        }
+        EXPECT_LT(mismatched, 400 * 600 / 500) << "eye " << eye;
+    }
+    single.Shutdown();
+}
+
+TEST_F(VisualRegressionTest, DynamicResolutionUpscalesToOutput)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    scene.AddObject(cube, shader, glm::mat4(1.0f), glm::vec3(0.8f, 0.3f, 0.2f));
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(2.0f, 2.0f, 3.0f));
+    camera.SetTarget(glm::vec3(0.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    std::vector<uint8_t> reference = render();
+
+    // At full scale the blit is 1:1, so output must match direct rendering
+    renderer->SetDynamicResolution(true, 1000.0f);
+    EXPECT_EQ(render(), reference);
+    EXPECT_FLOAT_EQ(renderer->GetRenderScale(), 1.0f);
+
+    // An unreachable budget drives the scale down to its minimum
+    renderer->SetDynamicResolution(true, 0.001f);
+    std::vector<uint8_t> scaled;
+    for (int i = 0; i < 60 && renderer->GetRenderScale() > 0.5f; ++i)
+    {
+        scaled = render();
+    }
+    scaled = render();
+    EXPECT_FLOAT_EQ(renderer->GetRenderScale(), 0.5f);
+    EXPECT_EQ(renderer->GetRenderWidth(), 400);
+    EXPECT_GT(renderer->GetGpuFrameMs(), 0.0);
+
+    // Upscaled output still covers the full frame: the centre shows the cube
+    uint8_t const* centre = &scaled[(300 * 800 + 400) * 4];
+    EXPECT_GT(centre[0], 40);
+
+    ExpectMatchesGolden("dynamic_resolution");
+
+    // Turning the feature off frees the full-size target; turning it on again rebuilds it
+    MemoryTracker& memory = MemoryTracker::Get();
+    size_t const target   = 2 * 800 * 600 * 4;
+    size_t scaledBytes    = memory.GetUsage(MemoryCategory::Renderbuffer).liveBytes;
+    renderer->SetDynamicResolution(false);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::Renderbuffer).liveBytes, scaledBytes - target);
+    EXPECT_EQ(render(), reference);
+
+    renderer->SetDynamicResolution(true, 1000.0f);
+    EXPECT_EQ(render(), reference);
+    EXPECT_EQ(memory.GetUsage(MemoryCategory::Renderbuffer).liveBytes, scaledBytes);
+    renderer->SetDynamicResolution(false);
+}
+
+TEST_F(VisualRegressionTest, FramesInFlightCycleSlots)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Lights exercise the per-slot upload buffers
+    Scene scene;
+    auto sphere = std::shared_ptr<Mesh>(CreateSphereMesh(24));
+    scene.AddObject(sphere, shader, glm::mat4(1.0f), glm::vec3(0.6f));
+    scene.AddPointLight(glm::vec3(0.5f, 0.5f, 1.5f), glm::vec3(0.2f, 0.4f, 1.0f), 2.0f, 3.0f);
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+    };
+
+    renderer->SetFramesInFlight(3);
+    EXPECT_EQ(renderer->GetFramesInFlight(), 3);
+
+    std::vector<int> slots;
+    std::vector<uint8_t> first;
+    for (int i = 0; i < 6; ++i)
+    {
+        render();
+        slots.push_back(renderer->GetFrameSlot());
+        EXPECT_GE(renderer->GetFrameWaitMs(), 0.0);
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        if (i == 0)
+        {
+            first = pixels;
+        }
+        else
+        {
+            EXPECT_EQ(pixels, first) << "frame " << i;
+        }
+    }
+    EXPECT_EQ(slots, (std::vector<int>{0, 1, 2, 0, 1, 2}));
+
+    // Out-of-range counts are clamped
+    renderer->SetFramesInFlight(0);
+    EXPECT_EQ(renderer->GetFramesInFlight(), 1);
+    renderer->SetFramesInFlight(2);
+}
+
+// Square BC1 texture with a full mip chain, every block one RGB565 color
+static TextureImage CreateSolidBC1Image(uint32_t size, uint16_t color)
+{
+    TextureImage image;
+    image.format = TextureFormat::BC1;
+    for (uint32_t extent = size;; extent /= 2)
+    {
+        size_t bytes = GetTextureLevelBytes(TextureFormat::BC1, extent, extent);
+        image.levels.push_back({extent, extent, image.data.size(), bytes});
+        for (size_t block = 0; block < bytes / 8; ++block)
+        {
+            uint8_t const data[8] = {(uint8_t)color, (uint8_t)(color >> 8), 0, 0, 0, 0, 0, 0};
+            image.data.insert(image.data.end(), data, data + 8);
+        }
+        if (extent == 1)
+            break;
+    }
+    return image;
+}
+
+TEST_F(VisualRegressionTest, TexturesStreamCoarsestFirstUnderBudget)
+{
+    if (!IsTextureFormatSupported(TextureFormat::BC1))
+    {
+        GTEST_SKIP() << "BC1 textures not supported";
+    }
+
+    // 256x256 BC1: 32 KiB for level 0, 43704 bytes for the chain
+    TextureStreamer streamer(60000, 4096);
+    std::shared_ptr<Texture> textures[2];
+    for (auto& texture : textures)
+    {
+        texture = std::make_shared<Texture>();
+        ASSERT_TRUE(texture->Create(CreateSolidBC1Image(256, 0x001F)));
+        EXPECT_FALSE(texture->IsResident());
+        streamer.Add(texture);
+    }
+
+    // One frame's worth covers the small levels of both before either gets detail
+    streamer.Update();
+    for (auto const& texture : textures)
+    {
+        EXPECT_TRUE(texture->IsResident());
+        EXPECT_GE(texture->GetResidentLevel(), 2);
+    }
+    EXPECT_EQ(textures[0]->GetResidentLevel() + textures[1]->GetResidentLevel(), 5);
+    EXPECT_LE(streamer.GetStats().bytesUploaded, 4096u);
+
+    // Both get level 1; only one level 0 fits what is left of the budget
+    streamer.Flush();
+    EXPECT_NE(textures[0]->IsFullyResident(), textures[1]->IsFullyResident());
+    EXPECT_EQ(std::min(textures[0]->GetResidentLevel(), textures[1]->GetResidentLevel()), 0);
+    EXPECT_EQ(std::max(textures[0]->GetResidentLevel(), textures[1]->GetResidentLevel()), 1);
+    EXPECT_EQ(streamer.GetResidentBytes(), 43704u + 43704u - 32768u);
+    EXPECT_EQ(MemoryTracker::Get().GetUsage(MemoryCategory::Texture).liveBytes,
+              streamer.GetResidentBytes());
+
+    // A lower budget drops the one level 0 and nothing else
+    streamer.SetBudget(30000);
+    streamer.Update();
+    EXPECT_EQ(streamer.GetStats().levelsEvicted, 1u);
+    EXPECT_EQ(textures[0]->GetResidentLevel(), 1);
+    EXPECT_EQ(textures[1]->GetResidentLevel(), 1);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+
+    streamer.Shutdown();
+    EXPECT_EQ(MemoryTracker::Get().GetUsage(MemoryCategory::Texture).liveBytes, 0u);
+}
+
+TEST_F(VisualRegressionTest, TexturedObjectsSampleTheirAlbedo)
+{
+    if (!IsTextureFormatSupported(TextureFormat::BC1))
+    {
+        GTEST_SKIP() << "BC1 textures not supported";
+    }
+
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    scene.AddObject(cube,
+                    shader,
+                    glm::scale(glm::mat4(1.0f), glm::vec3(4.0f, 3.0f, 0.1f)),
+                    glm::vec3(0.8f));
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return std::vector<uint8_t>(&pixels[(300 * 800 + 400) * 4],
+                                    &pixels[(300 * 800 + 400) * 4] + 4);
+    };
+
+    std::vector<uint8_t> plain = render();
+
+    // Pure blue albedo; BeginFrame streams it in under the default budget
+    auto texture = std::make_shared<Texture>();
+    ASSERT_TRUE(texture->Create(CreateSolidBC1Image(64, 0x001F)));
+    renderer->GetTextureStreamer().Add(texture);
+    scene.SetTexture(0, texture);
+    std::vector<uint8_t> textured = render();
+
+    EXPECT_TRUE(texture->IsFullyResident());
+    EXPECT_LT(textured[0], plain[0] / 4);
+    EXPECT_LT(textured[1], plain[1] / 4);
+    EXPECT_GT(textured[2], plain[2] / 2);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, MaterialBatchesMatchPerObjectDraws)
+{
+    if (!IsTextureFormatSupported(TextureFormat::BC1))
+    {
+        GTEST_SKIP() << "BC1 textures not supported";
+    }
+
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Two flat colors and two textures, the textures as layers of one array
+    glm::vec3 const colors[4] = {
+        glm::vec3(0.9f, 0.3f, 0.2f), glm::vec3(0.2f, 0.5f, 0.9f), glm::vec3(1.0f), glm::vec3(0.7f)};
+    uint16_t const texels[2] = {0xF800, 0x07E0};
+
+    MaterialLibrary& materials = renderer->GetMaterials();
+    std::shared_ptr<Texture> textures[2];
+    MaterialId ids[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        Material material;
+        material.color = colors[i];
+        if (i >= 2)
+        {
+            material.texture = materials.AddTexture(CreateSolidBC1Image(64, texels[i - 2]));
+            ASSERT_GE(material.texture, 0);
+
+            textures[i - 2] = std::make_shared<Texture>();
+            ASSERT_TRUE(textures[i - 2]->Create(CreateSolidBC1Image(64, texels[i - 2])));
+            textures[i - 2]->UploadAll();
+        }
+        ids[i] = materials.AddMaterial(material);
+    }
+    EXPECT_EQ(materials.GetTextureArrayCount(), 1u);
+
+    // The same grid drawn once with per-object colors and textures, once with materials
+    Scene perObject;
+    Scene batched;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 24; ++i)
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f),
+                                             glm::vec3((i % 6) * 0.5f - 1.25f,
+                                                       (i / 6) * 0.5f - 0.75f,
+                                                       -(i % 3) * 0.3f));
+        transform           = glm::scale(transform, glm::vec3(0.3f));
+        transform           = glm::rotate(transform, i * 0.4f, glm::vec3(0.3f, 1.0f, 0.2f));
+
+        perObject.AddObject(cube, shader, transform, colors[i % 4]);
+        if (i % 4 >= 2)
+        {
+            perObject.SetTexture(i, textures[i % 4 - 2]);
+        }
+        batched.AddObject(cube, shader, transform);
+        batched.SetMaterial(i, ids[i % 4]);
+    }
+    batched.AddPointLight(glm::vec3(0.0f, 0.5f, 1.0f), glm::vec3(1.0f, 0.8f, 0.2f), 2.0f, 3.0f);
+    perObject.AddPointLight(glm::vec3(0.0f, 0.5f, 1.0f), glm::vec3(1.0f, 0.8f, 0.2f), 2.0f, 3.0f);
+
+    std::vector<Camera> eyes(2);
+    for (int i = 0; i < 2; ++i)
+    {
+        eyes[i].SetPerspective(45.0f, 400.0f / 600.0f, 0.1f, 100.0f);
+        eyes[i].SetPosition(glm::vec3(i ? 0.1f : -0.1f, 0.0f, 4.0f));
+        eyes[i].SetTarget(glm::vec3(i ? 0.1f : -0.1f, 0.0f, 0.0f));
+    }
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 4.0f));
+
+    auto render = [&](Scene& scene, bool multiView) {
+        renderer->BeginFrame();
+        renderer->Clear();
+        if (multiView)
+        {
+            renderer->RenderSceneMultiView(scene, eyes);
+        }
+        else
+        {
+            renderer->RenderScene(scene, camera);
+        }
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    std::vector<uint8_t> expected = render(perObject, false);
+    EXPECT_EQ(renderer->GetRenderStats().drawCalls, 24u);
+
+    // Flat and textured materials make two batches of one mesh each
+    std::vector<uint8_t> pixels = render(batched, false);
+    EXPECT_EQ(renderer->GetRenderStats().drawCalls, 2u);
+    EXPECT_EQ(renderer->GetRenderStats().objectsSubmitted, 24u);
+    EXPECT_EQ(pixels, expected);
+
+    // The pre-pass reads the same instance data, so GL_EQUAL still matches
+    renderer->SetDepthPrepass(true);
+    EXPECT_EQ(render(batched, false), expected);
+    renderer->SetDepthPrepass(false);
+
+    // Views and instances share gl_InstanceID
+    expected = render(perObject, true);
+    EXPECT_EQ(render(batched, true), expected);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, FrameGraphCullsOrdersAndAliasesTargets)
+{
+    RenderTargetDesc const full{800, 600, GL_RGBA16F};
+    RenderTargetDesc const depth{800, 600, GL_DEPTH_COMPONENT24};
+    RenderTargetDesc const half{400, 300, GL_RGBA16F};
+
+    std::vector<std::string> ran;
+    auto record = [&](char const* name) {
+        return [&ran, name](FrameGraph::PassContext const&) { ran.push_back(name); };
+    };
+
+    renderer->BeginFrame();
+    FrameGraph& graph         = renderer->GetFrameGraph();
+    FrameGraphResource output = renderer->ImportOutput(graph);
+
+    FrameGraphResource hdr, sceneDepth, debug, downsampled, blurred, blurred2;
+    graph.AddPass(
+        "scene",
+        [&](FrameGraph::PassBuilder& pass) {
+            hdr        = pass.Write(pass.Create("hdr", full));
+            sceneDepth = pass.Write(pass.Create("depth", depth));
+        },
+        record("scene"));
+    // Nothing reads the overlay, so it is culled along with its target
+    graph.AddPass(
+        "debug",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(sceneDepth);
+            debug = pass.Write(pass.Create("debug", full));
+        },
+        record("debug"));
+    graph.AddPass(
+        "downsample",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(hdr);
+            downsampled = pass.Write(pass.Create("half", half));
+        },
+        record("downsample"));
+    graph.AddPass(
+        "blur_x",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(downsampled);
+            blurred = pass.Write(pass.Create("blurred", half));
+        },
+        record("blur_x"));
+    // The first half-size target is dead by now, so this one can take its texture
+    graph.AddPass(
+        "blur_y",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(blurred);
+            blurred2 = pass.Write(pass.Create("blurred2", half));
+        },
+        record("blur_y"));
+    graph.AddPass(
+        "composite",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(hdr);
+            pass.Read(blurred2);
+            pass.Write(output);
+        },
+        record("composite"));
+
+    ASSERT_TRUE(graph.Compile());
+    EXPECT_TRUE(graph.IsCulled("debug"));
+    EXPECT_FALSE(graph.IsCulled("scene"));
+    std::vector<std::string> const order = {"scene", "downsample", "blur_x", "blur_y", "composite"};
+    EXPECT_EQ(graph.GetExecutionOrder(), order);
+
+    FrameGraphStats const& stats = graph.GetStats();
+    EXPECT_EQ(stats.passesDeclared, 6u);
+    EXPECT_EQ(stats.passesCulled, 1u);
+    EXPECT_EQ(stats.transientTargets, 5u);
+    EXPECT_EQ(stats.textures, 4u);
+    EXPECT_EQ(graph.GetTexture(blurred2), graph.GetTexture(downsampled));
+    EXPECT_NE(graph.GetTexture(blurred), graph.GetTexture(downsampled));
+    EXPECT_EQ(graph.GetTexture(debug), 0u);
+    EXPECT_LT(stats.transientBytes, stats.unaliasedBytes);
+
+    ASSERT_TRUE(graph.Execute());
+    EXPECT_EQ(ran, order);
+    EXPECT_EQ(graph.GetStats().targetSwitches, 5u);
+    renderer->EndFrame();
+
+    // Independent passes into the same target run back to back
+    renderer->BeginFrame();
+    output = renderer->ImportOutput(graph);
+    FrameGraphResource a, b;
+    graph.AddPass(
+        "a",
+        [&](FrameGraph::PassBuilder& pass) { a = pass.Write(pass.Create("a", half)); },
+        record("a"));
+    graph.AddPass(
+        "b",
+        [&](FrameGraph::PassBuilder& pass) { b = pass.Write(pass.Create("b", half)); },
+        record("b"));
+    graph.AddPass(
+        "a2",
+        [&](FrameGraph::PassBuilder& pass) { pass.Write(a); },
+        record("a2"));
+    graph.AddPass(
+        "resolve",
+        [&](FrameGraph::PassBuilder& pass) {
+            pass.Read(a);
+            pass.Read(b);
+            pass.Write(output);
+        },
+        record("resolve"));
+
+    ran.clear();
+    ASSERT_TRUE(graph.Execute());
+    std::vector<std::string> const grouped = {"a", "a2", "b", "resolve"};
+    EXPECT_EQ(ran, grouped);
+    EXPECT_EQ(graph.GetStats().targetSwitches, 3u);
+    renderer->EndFrame();
+
+    // Reading a target before anything wrote it is an error
+    renderer->BeginFrame();
+    FrameGraphResource unwritten = kInvalidFrameGraphResource;
+    graph.AddPass(
+        "early",
+        [&](FrameGraph::PassBuilder& pass) {
+            unwritten = pass.Create("late", half);
+            pass.Read(unwritten);
+            pass.SetSideEffect();
+        },
+        nullptr);
+    EXPECT_FALSE(graph.Compile());
+    renderer->EndFrame();
+
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, FrameGraphTransientTargetMatchesDirectRender)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 6; ++i)
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f),
+                                             glm::vec3(i * 0.6f - 1.5f, 0.0f, -(i % 2) * 0.5f));
+        transform           = glm::rotate(transform, i * 0.5f, glm::vec3(0.2f, 1.0f, 0.1f));
+        scene.AddObject(cube, shader, glm::scale(transform, glm::vec3(0.4f)));
+    }
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 4.0f));
+
+    renderer->BeginFrame();
+    renderer->Clear();
+    renderer->RenderScene(scene, camera);
+    renderer->EndFrame();
+    std::vector<uint8_t> expected;
+    renderer->CaptureFramebuffer(expected);
+
+    // The scene goes to a transient color and depth pair, then is copied out
+    RenderTargetPool& pool = renderer->GetRenderTargets();
+    auto renderThroughGraph = [&]() {
+        renderer->BeginFrame();
+        FrameGraph& graph         = renderer->GetFrameGraph();
+        FrameGraphResource output = renderer->ImportOutput(graph);
+        FrameGraphResource color  = kInvalidFrameGraphResource;
+        graph.AddPass(
+            "scene",
+            [&](FrameGraph::PassBuilder& pass) {
+                color = pass.Write(pass.Create("color", {800, 600, GL_RGBA8}));
+                pass.Write(pass.Create("depth", {800, 600, GL_DEPTH_COMPONENT24}));
+            },
+            [&](FrameGraph::PassContext const&) {
+                renderer->Clear();
+                renderer->RenderScene(scene, camera);
+            });
+        graph.AddPass(
+            "present",
+            [&](FrameGraph::PassBuilder& pass) {
+                pass.Read(color);
+                pass.Write(output);
+            },
+            [&](FrameGraph::PassContext const& context) {
+                GLuint texture     = context.GetTexture(color);
+                GLuint framebuffer = pool.GetFramebuffer(&texture, 1, 0);
+                GLStateCache::Get().BindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+                int width  = context.GetWidth();
+                int height = context.GetHeight();
+                glBlitFramebuffer(0,
+                                  0,
+                                  width,
+                                  height,
+                                  0,
+                                  0,
+                                  width,
+                                  height,
+                                  GL_COLOR_BUFFER_BIT,
+                                  GL_NEAREST);
+            });
+        EXPECT_TRUE(graph.Execute());
+        renderer->EndFrame();
+    };
+
+    renderThroughGraph();
+    std::vector<uint8_t> pixels;
+    renderer->CaptureFramebuffer(pixels);
+    EXPECT_EQ(pixels, expected);
+    EXPECT_EQ(pool.GetTextureCount(), 2u);
+    EXPECT_EQ(MemoryTracker::Get().GetUsage(MemoryCategory::RenderTarget).liveBytes,
+              pool.GetBytes());
+
+    // Later frames reuse the pooled targets; a frame without them releases them
+    renderThroughGraph();
+    EXPECT_EQ(pool.GetTextureCount(), 2u);
+    renderer->BeginFrame();
+    renderer->EndFrame();
+    EXPECT_EQ(pool.GetTextureCount(), 0u);
+    EXPECT_EQ(MemoryTracker::Get().GetUsage(MemoryCategory::RenderTarget).liveBytes, 0u);
+
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, RetainedModeReplaysUnchangedScenes)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    // Per-object draws and one material batch, lit
+    MaterialId material = renderer->GetMaterials().AddMaterial({glm::vec3(0.3f, 0.8f, 0.4f), -1});
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 12; ++i)
+    {
+        glm::mat4 transform = glm::translate(
+            glm::mat4(1.0f), glm::vec3((i % 4) * 0.7f - 1.05f, (i / 4) * 0.7f - 0.7f, 0.0f));
+        transform = glm::rotate(transform, i * 0.3f, glm::vec3(0.4f, 1.0f, 0.0f));
+        scene.AddObject(cube, shader, glm::scale(transform, glm::vec3(0.25f)), glm::vec3(0.8f));
+        if (i % 3 == 0)
+        {
+            scene.SetMaterial(i, material);
+        }
+    }
+    scene.AddPointLight(glm::vec3(0.0f, 0.0f, 1.5f), glm::vec3(1.0f, 0.9f, 0.7f), 2.0f, 4.0f);
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 4.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    renderer->SetFramesInFlight(2);
+    std::vector<uint8_t> expected = render();
+    RenderStats const immediate   = renderer->GetRenderStats();
+
+    // The first frame records; later ones replay into alternating frame slots
+    renderer->SetRetainedMode(true);
+    EXPECT_EQ(render(), expected);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        EXPECT_EQ(render(), expected);
+        RenderStats const& stats = renderer->GetRenderStats();
+        EXPECT_EQ(stats.scenesReplayed, 1u);
+        EXPECT_EQ(stats.drawCalls, immediate.drawCalls);
+        EXPECT_EQ(stats.uniformUploads, immediate.uniformUploads);
+        EXPECT_EQ(stats.objectsSubmitted, immediate.objectsSubmitted);
+    }
+
+    // Camera, scene, material and setting changes each force a new recording
+    camera.SetPosition(glm::vec3(0.3f, 0.0f, 4.0f));
+    render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+    render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 1u);
+
+    scene.SetMaterial(1, material);
+    render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+
+    renderer->GetMaterials().SetMaterial(material, {glm::vec3(0.9f, 0.2f, 0.2f), -1});
+    render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+
+    renderer->SetDepthPrepass(true);
+    renderer->SetRetainedMode(false);
+    expected = render();
+    renderer->SetRetainedMode(true);
+    render();
+    EXPECT_EQ(render(), expected);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 1u);
+
+    renderer->InvalidateRecording();
+    EXPECT_EQ(render(), expected);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, RetainedModeNoticesRebuiltResources)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube = std::shared_ptr<Mesh>(CreateCubeMesh());
+    for (int i = 0; i < 4; ++i)
+    {
+        glm::mat4 transform =
+            glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.8f - 1.2f, 0.0f, 0.0f));
+        scene.AddObject(cube, shader, glm::scale(transform, glm::vec3(0.25f)), glm::vec3(0.8f));
+    }
+    scene.AddPointLight(glm::vec3(0.0f, 0.0f, 1.5f), glm::vec3(1.0f, 0.9f, 0.7f), 2.0f, 4.0f);
+
+    Camera camera;
+    camera.SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 4.0f));
+
+    auto render = [&]() {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(scene, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    // The pre-pass records the depth-only vertex arrays as well
+    renderer->SetDepthPrepass(true);
+    renderer->SetRetainedMode(true);
+    render();
+    render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 1u);
+
+    // New vertices replace the mesh's buffers without touching the scene
+    std::vector<Vertex> vertices = cube->GetVertices();
+    for (Vertex& vertex : vertices)
+    {
+        vertex.position *= 1.5f;
+    }
+    cube->SetVertices(std::move(vertices));
+    std::vector<uint8_t> grown = render();
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+    EXPECT_EQ(render(), grown);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 1u);
+
+    renderer->SetRetainedMode(false);
+    EXPECT_EQ(render(), grown);
+    renderer->SetRetainedMode(true);
+    render();
+
+    // A reload deletes the program the recording used
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+    EXPECT_EQ(render(), grown);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 0u);
+    EXPECT_EQ(render(), grown);
+    EXPECT_EQ(renderer->GetRenderStats().scenesReplayed, 1u);
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
+}
+
+TEST_F(VisualRegressionTest, SceneCaptureReplaysSameImages)
+{
+    auto shader = std::make_shared<Shader>();
+    ASSERT_TRUE(
+        shader->LoadFromFiles("shaders/compiled/basic.vert", "shaders/compiled/basic.frag"));
+
+    Scene scene;
+    auto cube   = std::shared_ptr<Mesh>(CreateCubeMesh());
+    auto sphere = std::shared_ptr<Mesh>(CreateSphereMesh(16));
+    for (int i = 0; i < 6; ++i)
+    {
+        glm::mat4 transform =
+            glm::translate(glm::mat4(1.0f), glm::vec3((i % 3) * 0.9f - 0.9f, (i / 3) - 0.5f, 0.0f));
+        scene.AddObject(i % 2 ? sphere : cube,
+                        shader,
+                        glm::scale(transform, glm::vec3(0.3f)),
+                        glm::vec3(0.2f * i, 0.8f, 1.0f - 0.15f * i));
+    }
+    scene.AddPointLight(glm::vec3(0.0f, 0.0f, 1.5f), glm::vec3(1.0f, 0.9f, 0.7f), 2.0f, 4.0f);
+
+    std::vector<Camera> path(3);
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        path[i].SetPerspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+        path[i].SetPosition(glm::vec3(i * 0.4f - 0.4f, 0.2f, 4.0f));
+    }
+
+    auto render = [&](Scene& target, Camera& camera) {
+        renderer->BeginFrame();
+        renderer->Clear();
+        renderer->RenderScene(target, camera);
+        renderer->EndFrame();
+
+        std::vector<uint8_t> pixels;
+        renderer->CaptureFramebuffer(pixels);
+        return pixels;
+    };
+
+    SceneCapture capture;
+    capture.CaptureScene(scene);
+    capture.SetResolution(800, 600);
+    std::vector<std::vector<uint8_t>> expected;
+    for (Camera& camera : path)
+    {
+        expected.push_back(render(scene, camera));
+        capture.AddFrame(camera);
+    }
+
+    std::string const capturePath = "tests/visual/output/scene_capture.srcp";
+    ASSERT_TRUE(capture.Save(capturePath));
+    SceneCapture loaded;
+    ASSERT_TRUE(loaded.Load(capturePath));
+    fs::remove(capturePath);
+    EXPECT_EQ(loaded.GetMeshCount(), 2u);
+    EXPECT_EQ(loaded.GetFrameCount(), path.size());
+
+    Scene replay;
+    ASSERT_TRUE(loaded.BuildScene(replay));
+    ASSERT_EQ(replay.GetObjectCount(), scene.GetObjectCount());
+
+    std::vector<Camera> cameras;
+    for (size_t frame = 0; frame < loaded.GetFrameCount(); ++frame)
+    {
+        loaded.GetFrame(frame, cameras);
+        ASSERT_EQ(cameras.size(), 1u);
+        EXPECT_EQ(render(replay, cameras[0]), expected[frame]);
+    }
+    EXPECT_EQ(glGetError(), (GLenum)GL_NO_ERROR);
 }